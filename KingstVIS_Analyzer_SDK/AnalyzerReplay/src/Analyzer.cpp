@@ -0,0 +1,188 @@
+#include <Analyzer.h>
+#include <AnalyzerChannelData.h>
+#include <AnalyzerHelpers.h>
+#include "ReplayCapture.h"
+
+//The replay host runs the worker thread on the caller's thread: StartProcessing returns once the analyzer
+//has walked off the end of the capture, or was told to exit.
+
+struct AnalyzerData {
+    AnalyzerSettings *mSettings;
+    AnalyzerResults *mResults;
+    DeviceCollection *mCapture;
+
+    std::vector<Channel> mChannels;
+    std::vector<AnalyzerChannelData *> mChannelData;
+    ChannelData mEmptyChannel;
+
+    U64 mProgressSample;
+    bool mThreadMustExit;
+};
+
+Analyzer::Analyzer()
+{
+    mData = new AnalyzerData();
+    mData->mSettings = NULL;
+    mData->mResults = NULL;
+    mData->mCapture = NULL;
+    mData->mProgressSample = 0;
+    mData->mThreadMustExit = false;
+
+    mData->mEmptyChannel.mChannelIndex = 0xFFFFFFFF;
+    mData->mEmptyChannel.mInitialBitState = BIT_LOW;
+    mData->mEmptyChannel.mEdges = NULL;
+    mData->mEmptyChannel.mEdgeCount = 0;
+    mData->mEmptyChannel.mSampleCount = 0;
+}
+
+Analyzer::~Analyzer()
+{
+    for (U32 i = 0; i < mData->mChannelData.size(); i++) {
+        delete mData->mChannelData[i];
+    }
+
+    delete mData;
+}
+
+const char *Analyzer::GetAnalyzerVersion() const
+{
+    return "1.0.0 (replay)";
+}
+
+void Analyzer::SetupResults()
+{
+}
+
+void Analyzer::SetAnalyzerSettings(AnalyzerSettings *settings)
+{
+    mData->mSettings = settings;
+}
+
+void Analyzer::KillThread()
+{
+    mData->mThreadMustExit = true;
+}
+
+AnalyzerChannelData *Analyzer::GetAnalyzerChannelData(Channel &channel)
+{
+    for (U32 i = 0; i < mData->mChannels.size(); i++) {
+        if (mData->mChannels[i] == channel) {
+            return mData->mChannelData[i];
+        }
+    }
+
+    ChannelData *channel_data = NULL;
+    if (mData->mCapture != NULL) {
+        channel_data = mData->mCapture->GetChannelData(channel.mChannelIndex);
+    }
+
+    if (channel_data == NULL) {
+        //a channel that wasn't captured never changes.
+        mData->mEmptyChannel.mSampleCount = (mData->mCapture != NULL) ? mData->mCapture->GetSampleCount() : 0;
+        channel_data = &mData->mEmptyChannel;
+    }
+
+    AnalyzerChannelData *analyzer_channel_data = new AnalyzerChannelData(channel_data);
+    mData->mChannels.push_back(channel);
+    mData->mChannelData.push_back(analyzer_channel_data);
+    return analyzer_channel_data;
+}
+
+void Analyzer::ReportProgress(U64 sample_number)
+{
+    ReplayCallTimer timer(ReplayReportProgress);
+    mData->mProgressSample = sample_number;
+}
+
+void Analyzer::SetAnalyzerResults(AnalyzerResults *results)
+{
+    mData->mResults = results;
+}
+
+U32 Analyzer::GetSimulationSampleRate()
+{
+    return GetSampleRate();
+}
+
+U32 Analyzer::GetSampleRate()
+{
+    return (mData->mCapture != NULL) ? mData->mCapture->GetSampleRate() : 0;
+}
+
+U64 Analyzer::GetTriggerSample()
+{
+    return (mData->mCapture != NULL) ? mData->mCapture->GetTriggerSample() : 0;
+}
+
+void Analyzer::Init(DeviceCollection *device_collection, ConditionManager * /*condition_manager*/, ProgressManager * /*progress_manager*/)
+{
+    mData->mCapture = device_collection;
+}
+
+void Analyzer::StartProcessing()
+{
+    StartProcessing(0);
+}
+
+void Analyzer::StopWorkerThread()
+{
+    SetThreadMustExit();
+}
+
+AnalyzerSettings *Analyzer::GetAnalyzerSettings()
+{
+    return mData->mSettings;
+}
+
+bool Analyzer::DoesAnalyzerUseDevice(U64 /*device_id*/)
+{
+    return true;
+}
+
+bool Analyzer::IsValid(Channel *channel_array, U32 count)
+{
+    return AnalyzerHelpers::DoChannelsOverlap(channel_array, count) == false;
+}
+
+void Analyzer::InitialWorkerThread()
+{
+    try {
+        WorkerThread();
+    } catch (ReplayEndOfData &) {
+    } catch (ReplayThreadExit &) {
+    }
+}
+
+bool Analyzer::GetAnalyzerResults(AnalyzerResults **analyzer_results)
+{
+    *analyzer_results = mData->mResults;
+    return mData->mResults != NULL;
+}
+
+void Analyzer::CheckIfThreadShouldExit()
+{
+    ReplayCallTimer timer(ReplayCheckIfThreadShouldExit);
+    if (mData->mThreadMustExit == true) {
+        throw ReplayThreadExit();
+    }
+}
+
+double Analyzer::GetAnalyzerProgress()
+{
+    if (mData->mCapture == NULL || mData->mCapture->GetSampleCount() == 0) {
+        return 0.0;
+    }
+
+    return double(mData->mProgressSample) / double(mData->mCapture->GetSampleCount());
+}
+
+void Analyzer::SetThreadMustExit()
+{
+    mData->mThreadMustExit = true;
+}
+
+void Analyzer::StartProcessing(U64 /*starting_sample*/)
+{
+    mData->mThreadMustExit = false;
+    InitialWorkerThread();
+}
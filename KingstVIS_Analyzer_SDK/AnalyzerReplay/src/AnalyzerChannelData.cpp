@@ -0,0 +1,313 @@
+#include <AnalyzerChannelData.h>
+#include "ReplayCapture.h"
+#include <cstring>
+#include <vector>
+
+#define EDGE_CURSOR_SPAN_EDGES 4096     //edges per summary of a flat channel
+
+//The edges are walked through a window: the whole array for a flat channel, one decoded block at a time for a
+//channel in blocks, loaded when the walk runs off the end of the one before.
+//
+//A move forward finds its edge in two levels. The first is a summary of the spans of the channel, the first edge of
+//each: of every EDGE_CURSOR_SPAN_EDGES edges of a flat channel, copied together so the summary stays in cache, or the
+//block index of a channel in blocks. A move past the span it starts in is a binary search of the summary. The second
+//is the edges of the span the move ends in, searched galloping out from the next edge, so that the moves to the next
+//sample or the next edge, most of them, take a compare or two and a move past k edges O(log k). The line toggles once
+//for every edge passed, so the edges are counted instead of walked, unless pulse widths are tracked.
+struct AnalyzerChannelDataData {
+    const ChannelData *mChannel;
+    const U64 *mEdges;      //of the window
+    U64 mWindowCount;       //edges in the window
+    U64 mWindowStart;       //index in the channel of the window's first edge
+    U64 mBlock;             //in the window
+    U64 mLastSample;
+
+    U64 mSampleNumber;
+    U64 mNextEdge;   //index in the window of the first edge after mSampleNumber
+    BitState mBitState;
+
+    bool mLinearWalk;       //see SetReplayLinearTraversal
+    std::vector<U64> mSpanFirstEdges;   //the summary of a flat channel
+
+    bool mTrackMinimumPulseWidth;
+    bool mHaveLastEdge;
+    U64 mLastEdge;
+    U64 mMinimumPulseWidth;
+
+    ReplayCallCounter mCalls[ReplayCallCount];  //see ReplayCall
+    bool mCallTiming;
+
+    U64 mBlockEdges[EDGE_FILE_BLOCK_EDGES];
+};
+
+static bool LoadBlock(AnalyzerChannelDataData *data, U64 block)
+{
+    if (data->mChannel->mBlocks == NULL) {
+        return false;
+    }
+
+    U32 count = DecodeEdgeBlock(data->mChannel, block, data->mBlockEdges);
+    if (count == 0) {
+        return false;
+    }
+
+    data->mEdges = data->mBlockEdges;
+    data->mWindowCount = count;
+    data->mWindowStart = block * EDGE_FILE_BLOCK_EDGES;
+    data->mBlock = block;
+    data->mNextEdge = 0;
+    return true;
+}
+
+static inline bool HaveNextEdge(AnalyzerChannelDataData *data)
+{
+    return data->mNextEdge < data->mWindowCount || LoadBlock(data, data->mBlock + 1);
+}
+
+static inline void PassEdge(AnalyzerChannelDataData *data)
+{
+    U64 edge = data->mEdges[data->mNextEdge++];
+    data->mBitState = Toggle(data->mBitState);
+
+    if (data->mTrackMinimumPulseWidth == true) {
+        if (data->mHaveLastEdge == true) {
+            U64 width = edge - data->mLastEdge;
+            if (data->mMinimumPulseWidth == 0 || width < data->mMinimumPulseWidth) {
+                data->mMinimumPulseWidth = width;
+            }
+        }
+        data->mHaveLastEdge = true;
+        data->mLastEdge = edge;
+    }
+}
+
+//first level: on to the span sample_number is in, if that's past the span of the next edge.
+static void SeekSpan(AnalyzerChannelDataData *data, U64 sample_number)
+{
+    const ChannelData *channel = data->mChannel;
+    if (channel->mBlocks != NULL) {
+        U64 block_count = channel->GetBlockCount();
+        if (data->mBlock + 1 < block_count && channel->mBlocks[data->mBlock + 1].mFirstEdge <= sample_number) {
+            LoadBlock(data, FindEdgeBlock(channel, data->mBlock + 1, sample_number));
+        }
+        return;
+    }
+
+    const std::vector<U64> &span_first_edges = data->mSpanFirstEdges;
+    U64 low = data->mNextEdge / EDGE_CURSOR_SPAN_EDGES + 1;
+    U64 high = span_first_edges.size();
+    if (low >= high || span_first_edges[low] > sample_number) {
+        return;
+    }
+
+    //the last span starting at or before sample_number is in [low, high)
+    while (high - low > 1) {
+        U64 middle = low + (high - low) / 2;
+        if (span_first_edges[middle] <= sample_number) {
+            low = middle;
+        } else {
+            high = middle;
+        }
+    }
+    data->mNextEdge = low * EDGE_CURSOR_SPAN_EDGES;
+}
+
+//second level: on to the first edge of the window after sample_number.
+static void SeekEdge(AnalyzerChannelDataData *data, U64 sample_number)
+{
+    const U64 *edges = data->mEdges;
+    U64 count = data->mWindowCount;
+    U64 low = data->mNextEdge;
+    if (low >= count || edges[low] > sample_number) {
+        return;
+    }
+
+    //edges[low] is at or before sample_number; gallop until edges[high] is after it, or high is the end of the window.
+    U64 stride = 1;
+    U64 high = low + 1;
+    while (high < count && edges[high] <= sample_number) {
+        low = high;
+        stride <<= 1;
+        high = low + stride;
+    }
+    if (high > count) {
+        high = count;
+    }
+
+    while (high - low > 1) {
+        U64 middle = low + (high - low) / 2;
+        if (edges[middle] <= sample_number) {
+            low = middle;
+        } else {
+            high = middle;
+        }
+    }
+    data->mNextEdge = high;
+}
+
+AnalyzerChannelData::AnalyzerChannelData(ChannelData *channel_data)
+{
+    mData = new AnalyzerChannelDataData();
+    mData->mChannel = channel_data;
+    mData->mEdges = channel_data->mEdges;
+    mData->mWindowCount = channel_data->mEdges != NULL ? channel_data->mEdgeCount : 0;
+    mData->mWindowStart = 0;
+    mData->mBlock = 0;
+    mData->mLastSample = channel_data->mSampleCount != 0 ? channel_data->mSampleCount - 1 : 0;
+
+    U64 last_edge = 0;
+    if (channel_data->mEdges != NULL && channel_data->mEdgeCount != 0) {
+        last_edge = channel_data->mEdges[channel_data->mEdgeCount - 1];
+    } else if (channel_data->mBlocks != NULL && channel_data->mEdgeCount != 0) {
+        U32 count = DecodeEdgeBlock(channel_data, channel_data->GetBlockCount() - 1, mData->mBlockEdges);
+        last_edge = count != 0 ? mData->mBlockEdges[count - 1] : 0;
+    }
+    if (last_edge > mData->mLastSample) {
+        mData->mLastSample = last_edge;
+    }
+
+    mData->mSampleNumber = 0;
+    mData->mNextEdge = 0;
+    mData->mBitState = channel_data->mInitialBitState;
+
+    mData->mLinearWalk = GetReplayLinearTraversal();
+    if (channel_data->mEdges != NULL) {
+        mData->mSpanFirstEdges.reserve((channel_data->mEdgeCount + EDGE_CURSOR_SPAN_EDGES - 1) / EDGE_CURSOR_SPAN_EDGES);
+        for (U64 i = 0; i < channel_data->mEdgeCount; i += EDGE_CURSOR_SPAN_EDGES) {
+            mData->mSpanFirstEdges.push_back(channel_data->mEdges[i]);
+        }
+    }
+
+    mData->mTrackMinimumPulseWidth = false;
+    mData->mHaveLastEdge = false;
+    mData->mLastEdge = 0;
+    mData->mMinimumPulseWidth = 0;
+
+    memset(mData->mCalls, 0, sizeof(mData->mCalls));
+    mData->mCallTiming = GetReplayCallTiming();
+
+    LoadBlock(mData, 0);
+
+    //an edge on sample 0 is already in effect.
+    while (HaveNextEdge(mData) == true && mData->mEdges[mData->mNextEdge] == 0) {
+        PassEdge(mData);
+    }
+}
+
+AnalyzerChannelData::~AnalyzerChannelData()
+{
+    ReplayCallCounter *counters = GetReplayCallCounters();
+    U64 channel_calls = 0;
+    for (U32 i = 0; i < ReplayCallCount; i++) {
+        counters[i].mCalls += mData->mCalls[i].mCalls;
+        counters[i].mNanoseconds += mData->mCalls[i].mNanoseconds;
+        channel_calls += mData->mCalls[i].mCalls;
+    }
+
+    if (mData->mChannel->mChannelIndex < REPLAY_COUNTED_CHANNELS) {
+        GetReplayChannelCallCounts()[mData->mChannel->mChannelIndex] += channel_calls;
+    }
+
+    delete mData;
+}
+
+U64 AnalyzerChannelData::GetSampleNumber()
+{
+    ReplayCallTimer timer(mData->mCalls[ReplayGetSampleNumber], mData->mCallTiming);
+    return mData->mSampleNumber;
+}
+
+BitState AnalyzerChannelData::GetBitState()
+{
+    ReplayCallTimer timer(mData->mCalls[ReplayGetBitState], mData->mCallTiming);
+    return mData->mBitState;
+}
+
+U32 AnalyzerChannelData::Advance(U32 num_samples)
+{
+    return AdvanceToAbsPosition(mData->mSampleNumber + num_samples);
+}
+
+U32 AnalyzerChannelData::AdvanceToAbsPosition(U64 sample_number)
+{
+    ReplayCallTimer timer(mData->mCalls[ReplayAdvance], mData->mCallTiming);
+    if (sample_number <= mData->mSampleNumber) {
+        return 0;
+    }
+
+    if (sample_number > mData->mLastSample) {
+        throw ReplayEndOfData();
+    }
+
+    U64 transitions = 0;
+    if (mData->mLinearWalk == true || mData->mTrackMinimumPulseWidth == true) {
+        while (HaveNextEdge(mData) == true && mData->mEdges[mData->mNextEdge] <= sample_number) {
+            PassEdge(mData);
+            transitions++;
+        }
+    } else if (mData->mNextEdge >= mData->mWindowCount || mData->mEdges[mData->mNextEdge] <= sample_number) {
+        //most moves, a bit or less, pass no edge and don't get here.
+        U64 first_edge = mData->mWindowStart + mData->mNextEdge;
+        SeekSpan(mData, sample_number);
+        SeekEdge(mData, sample_number);
+        transitions = mData->mWindowStart + mData->mNextEdge - first_edge;
+        if ((transitions & 0x1) != 0) {
+            mData->mBitState = Toggle(mData->mBitState);
+        }
+    }
+
+    mData->mSampleNumber = sample_number;
+    return U32(transitions);
+}
+
+void AnalyzerChannelData::AdvanceToNextEdge()
+{
+    ReplayCallTimer timer(mData->mCalls[ReplayAdvanceToNextEdge], mData->mCallTiming);
+    if (HaveNextEdge(mData) == false) {
+        throw ReplayEndOfData();
+    }
+
+    mData->mSampleNumber = mData->mEdges[mData->mNextEdge];
+    PassEdge(mData);
+}
+
+U64 AnalyzerChannelData::GetSampleOfNextEdge()
+{
+    ReplayCallTimer timer(mData->mCalls[ReplayGetSampleOfNextEdge], mData->mCallTiming);
+    if (HaveNextEdge(mData) == false) {
+        throw ReplayEndOfData();
+    }
+
+    return mData->mEdges[mData->mNextEdge];
+}
+
+bool AnalyzerChannelData::WouldAdvancingCauseTransition(U32 num_samples)
+{
+    return WouldAdvancingToAbsPositionCauseTransition(mData->mSampleNumber + num_samples);
+}
+
+bool AnalyzerChannelData::WouldAdvancingToAbsPositionCauseTransition(U64 sample_number)
+{
+    ReplayCallTimer timer(mData->mCalls[ReplayWouldAdvanceCauseTransition], mData->mCallTiming);
+    if (HaveNextEdge(mData) == false) {
+        return false;
+    }
+
+    return mData->mEdges[mData->mNextEdge] <= sample_number;
+}
+
+void AnalyzerChannelData::TrackMinimumPulseWidth()
+{
+    mData->mTrackMinimumPulseWidth = true;
+}
+
+U64 AnalyzerChannelData::GetMinimumPulseWidthSoFar()
+{
+    return mData->mMinimumPulseWidth;
+}
+
+bool AnalyzerChannelData::DoMoreTransitionsExistInCurrentData()
+{
+    ReplayCallTimer timer(mData->mCalls[ReplayDoMoreTransitionsExist], mData->mCallTiming);
+    return HaveNextEdge(mData);
+}
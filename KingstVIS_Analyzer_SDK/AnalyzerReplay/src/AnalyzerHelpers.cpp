@@ -0,0 +1,525 @@
+#include <AnalyzerHelpers.h>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <string>
+
+bool AnalyzerHelpers::IsEven(U64 value)
+{
+    return (value & 0x1) == 0;
+}
+
+bool AnalyzerHelpers::IsOdd(U64 value)
+{
+    return (value & 0x1) != 0;
+}
+
+U32 AnalyzerHelpers::GetOnesCount(U64 value)
+{
+    U32 count = 0;
+    while (value != 0) {
+        value &= value - 1;
+        count++;
+    }
+
+    return count;
+}
+
+U32 AnalyzerHelpers::Diff32(U32 a, U32 b)
+{
+    return (a > b) ? (a - b) : (b - a);
+}
+
+static void GetHexString(U64 number, U32 num_data_bits, char *result_string, U32 result_string_max_length)
+{
+    U32 num_digits = (num_data_bits + 3) / 4;
+    if (num_digits == 0) {
+        num_digits = 1;
+    }
+
+    snprintf(result_string, result_string_max_length, "0x%0*llX", int(num_digits), number);
+}
+
+void AnalyzerHelpers::GetNumberString(U64 number, DisplayBase display_base, U32 num_data_bits, char *result_string, U32 result_string_max_length)
+{
+    if (num_data_bits < 64) {
+        number &= (1ull << num_data_bits) - 1;
+    }
+
+    switch (display_base) {
+    case Binary: {
+        std::string str = "0b";
+        for (S32 i = S32(num_data_bits) - 1; i >= 0; i--) {
+            str += ((number >> i) & 0x1) ? '1' : '0';
+        }
+        snprintf(result_string, result_string_max_length, "%s", str.c_str());
+        break;
+    }
+
+    case Decimal:
+        snprintf(result_string, result_string_max_length, "%llu", number);
+        break;
+
+    case ASCII:
+        if (number >= 32 && number < 127) {
+            snprintf(result_string, result_string_max_length, "%c", char(number));
+        } else {
+            GetHexString(number, num_data_bits, result_string, result_string_max_length);
+        }
+        break;
+
+    case AsciiHex: {
+        char hex_str[32];
+        GetHexString(number, num_data_bits, hex_str, sizeof(hex_str));
+        if (number >= 32 && number < 127) {
+            snprintf(result_string, result_string_max_length, "'%c' (%s)", char(number), hex_str);
+        } else {
+            snprintf(result_string, result_string_max_length, "%s", hex_str);
+        }
+        break;
+    }
+
+    case Hexadecimal:
+    default:
+        GetHexString(number, num_data_bits, result_string, result_string_max_length);
+        break;
+    }
+}
+
+void AnalyzerHelpers::GetTimeString(U64 sample, U64 trigger_sample, U32 sample_rate_hz, char *result_string, U32 result_string_max_length)
+{
+    S64 relative_sample = S64(sample) - S64(trigger_sample);
+
+    //enough decimals to resolve one sample
+    int decimals = 0;
+    for (U64 rate = 1; rate < sample_rate_hz && decimals < 12; rate *= 10) {
+        decimals++;
+    }
+
+    snprintf(result_string, result_string_max_length, "%.*f", decimals, double(relative_sample) / double(sample_rate_hz));
+}
+
+void AnalyzerHelpers::Assert(const char *message)
+{
+    fprintf(stderr, "analyzer assert: %s\n", message);
+    abort();
+}
+
+U64 AnalyzerHelpers::AdjustSimulationTargetSample(U64 target_sample, U32 sample_rate, U32 simulation_sample_rate)
+{
+    if (sample_rate == simulation_sample_rate || sample_rate == 0) {
+        return target_sample;
+    }
+
+    return U64(double(target_sample) * double(simulation_sample_rate) / double(sample_rate));
+}
+
+bool AnalyzerHelpers::DoChannelsOverlap(const Channel *channel_array, U32 num_channels)
+{
+    for (U32 i = 0; i < num_channels; i++) {
+        if (channel_array[i] == UNDEFINED_CHANNEL) {
+            continue;
+        }
+
+        for (U32 j = i + 1; j < num_channels; j++) {
+            if (channel_array[i] == channel_array[j]) {
+                return true;
+            }
+        }
+    }
+
+    return false;
+}
+
+void AnalyzerHelpers::SaveFile(const char *file_name, const U8 *data, U32 data_length, bool is_binary)
+{
+    void *f = StartFile(file_name, is_binary);
+    AppendToFile(data, data_length, f);
+    EndFile(f);
+}
+
+S64 AnalyzerHelpers::ConvertToSignedNumber(U64 number, U32 num_bits)
+{
+    if (num_bits == 0 || num_bits >= 64) {
+        return S64(number);
+    }
+
+    U64 sign_bit = 1ull << (num_bits - 1);
+    number &= (1ull << num_bits) - 1;
+    if ((number & sign_bit) != 0) {
+        return S64(number | ~((1ull << num_bits) - 1));
+    }
+
+    return S64(number);
+}
+
+void *AnalyzerHelpers::StartFile(const char *file_name, bool /*is_binary*/)
+{
+    FILE *f = fopen(file_name, "wb");
+    if (f == NULL) {
+        Assert("Unable to open export file");
+    }
+
+    return f;
+}
+
+void AnalyzerHelpers::AppendToFile(const U8 *data, U32 data_length, void *file)
+{
+    fwrite(data, 1, data_length, (FILE *)file);
+}
+
+void AnalyzerHelpers::EndFile(void *file)
+{
+    fclose((FILE *)file);
+}
+
+
+struct ClockGeneratorData {
+    double mSampleRateHz;
+    double mHalfPeriodSamples;
+    double mError;      //fraction of a sample carried over to the next advance
+};
+
+ClockGenerator::ClockGenerator()
+{
+    mData = new ClockGeneratorData();
+    mData->mSampleRateHz = 0.0;
+    mData->mHalfPeriodSamples = 0.0;
+    mData->mError = 0.0;
+}
+
+ClockGenerator::~ClockGenerator()
+{
+    delete mData;
+}
+
+void ClockGenerator::Init(double target_frequency, U32 sample_rate_hz)
+{
+    mData->mSampleRateHz = sample_rate_hz;
+    mData->mHalfPeriodSamples = double(sample_rate_hz) / (target_frequency * 2.0);
+    mData->mError = 0.0;
+}
+
+static U32 AdvanceBySamples(ClockGeneratorData *data, double samples)
+{
+    double target = samples + data->mError;
+    U32 whole_samples = U32(floor(target + 0.5));
+    data->mError = target - double(whole_samples);
+    return whole_samples;
+}
+
+U32 ClockGenerator::AdvanceByHalfPeriod(double multiple)
+{
+    return AdvanceBySamples(mData, mData->mHalfPeriodSamples * multiple);
+}
+
+U32 ClockGenerator::AdvanceByTimeS(double time_s)
+{
+    return AdvanceBySamples(mData, mData->mSampleRateHz * time_s);
+}
+
+
+struct BitExtractorData {
+    U64 mData;
+    AnalyzerEnums::ShiftOrder mShiftOrder;
+    U32 mNumBits;
+    U32 mIndex;
+};
+
+BitExtractor::BitExtractor(U64 data, AnalyzerEnums::ShiftOrder shift_order, U32 num_bits)
+{
+    mData = new BitExtractorData();
+    mData->mData = data;
+    mData->mShiftOrder = shift_order;
+    mData->mNumBits = num_bits;
+    mData->mIndex = 0;
+}
+
+BitExtractor::~BitExtractor()
+{
+    delete mData;
+}
+
+BitState BitExtractor::GetNextBit()
+{
+    U32 bit_index;
+    if (mData->mShiftOrder == AnalyzerEnums::MsbFirst) {
+        bit_index = mData->mNumBits - 1 - mData->mIndex;
+    } else {
+        bit_index = mData->mIndex;
+    }
+
+    mData->mIndex++;
+    return ((mData->mData >> bit_index) & 0x1) ? BIT_HIGH : BIT_LOW;
+}
+
+
+struct DataBuilderData {
+    U64 *mData;
+    AnalyzerEnums::ShiftOrder mShiftOrder;
+    U32 mNumBits;
+    U32 mIndex;
+};
+
+DataBuilder::DataBuilder()
+{
+    mData = new DataBuilderData();
+    mData->mData = NULL;
+    mData->mShiftOrder = AnalyzerEnums::MsbFirst;
+    mData->mNumBits = 0;
+    mData->mIndex = 0;
+}
+
+DataBuilder::~DataBuilder()
+{
+    delete mData;
+}
+
+void DataBuilder::Reset(U64 *data, AnalyzerEnums::ShiftOrder shift_order, U32 num_bits)
+{
+    mData->mData = data;
+    mData->mShiftOrder = shift_order;
+    mData->mNumBits = num_bits;
+    mData->mIndex = 0;
+    *data = 0;
+}
+
+void DataBuilder::AddBit(BitState bit)
+{
+    U64 value = (bit == BIT_HIGH) ? 1 : 0;
+    if (mData->mShiftOrder == AnalyzerEnums::MsbFirst) {
+        *mData->mData = (*mData->mData << 1) | value;
+    } else {
+        *mData->mData |= value << mData->mIndex;
+    }
+
+    mData->mIndex++;
+}
+
+
+//Archives are a space separated list of tokens; strings are stored as <length>:<characters>.
+struct SimpleArchiveData {
+    std::string mString;
+    size_t mReadPosition;
+    std::deque<std::string> mStrings;   //keeps strings handed out by operator>> alive
+};
+
+SimpleArchive::SimpleArchive()
+{
+    mData = new SimpleArchiveData();
+    mData->mReadPosition = 0;
+}
+
+SimpleArchive::~SimpleArchive()
+{
+    delete mData;
+}
+
+void SimpleArchive::SetString(const char *archive_string)
+{
+    mData->mString = archive_string;
+    mData->mReadPosition = 0;
+}
+
+const char *SimpleArchive::GetString()
+{
+    return mData->mString.c_str();
+}
+
+static bool AppendToken(SimpleArchiveData *data, const char *token)
+{
+    if (data->mString.empty() == false) {
+        data->mString += ' ';
+    }
+
+    data->mString += token;
+    return true;
+}
+
+static bool ReadToken(SimpleArchiveData *data, std::string &token)
+{
+    size_t length = data->mString.size();
+    size_t position = data->mReadPosition;
+    while (position < length && data->mString[position] == ' ') {
+        position++;
+    }
+
+    if (position >= length) {
+        return false;
+    }
+
+    size_t end = data->mString.find(' ', position);
+    if (end == std::string::npos) {
+        end = length;
+    }
+
+    token = data->mString.substr(position, end - position);
+    data->mReadPosition = end;
+    return true;
+}
+
+static bool ReadUnsigned(SimpleArchiveData *data, U64 &value)
+{
+    std::string token;
+    if (ReadToken(data, token) == false) {
+        return false;
+    }
+
+    char *end;
+    value = strtoull(token.c_str(), &end, 10);
+    return *end == 0;
+}
+
+static bool ReadSigned(SimpleArchiveData *data, S64 &value)
+{
+    std::string token;
+    if (ReadToken(data, token) == false) {
+        return false;
+    }
+
+    char *end;
+    value = strtoll(token.c_str(), &end, 10);
+    return *end == 0;
+}
+
+bool SimpleArchive::operator<<(U64 data)
+{
+    char token[32];
+    snprintf(token, sizeof(token), "%llu", data);
+    return AppendToken(mData, token);
+}
+
+bool SimpleArchive::operator<<(U32 data)
+{
+    return *this << U64(data);
+}
+
+bool SimpleArchive::operator<<(S64 data)
+{
+    char token[32];
+    snprintf(token, sizeof(token), "%lld", data);
+    return AppendToken(mData, token);
+}
+
+bool SimpleArchive::operator<<(S32 data)
+{
+    return *this << S64(data);
+}
+
+bool SimpleArchive::operator<<(double data)
+{
+    char token[64];
+    snprintf(token, sizeof(token), "%.17g", data);
+    return AppendToken(mData, token);
+}
+
+bool SimpleArchive::operator<<(bool data)
+{
+    return AppendToken(mData, data ? "1" : "0");
+}
+
+bool SimpleArchive::operator<<(const char *data)
+{
+    char prefix[32];
+    snprintf(prefix, sizeof(prefix), "%u:", U32(strlen(data)));
+    std::string token = std::string(prefix) + data;
+    return AppendToken(mData, token.c_str());
+}
+
+bool SimpleArchive::operator<<(Channel &data)
+{
+    return (*this << data.mDeviceId) && (*this << data.mChannelIndex);
+}
+
+bool SimpleArchive::operator>>(U64 &data)
+{
+    return ReadUnsigned(mData, data);
+}
+
+bool SimpleArchive::operator>>(U32 &data)
+{
+    U64 value;
+    if (ReadUnsigned(mData, value) == false) {
+        return false;
+    }
+
+    data = U32(value);
+    return true;
+}
+
+bool SimpleArchive::operator>>(S64 &data)
+{
+    return ReadSigned(mData, data);
+}
+
+bool SimpleArchive::operator>>(S32 &data)
+{
+    S64 value;
+    if (ReadSigned(mData, value) == false) {
+        return false;
+    }
+
+    data = S32(value);
+    return true;
+}
+
+bool SimpleArchive::operator>>(double &data)
+{
+    std::string token;
+    if (ReadToken(mData, token) == false) {
+        return false;
+    }
+
+    char *end;
+    data = strtod(token.c_str(), &end);
+    return *end == 0;
+}
+
+bool SimpleArchive::operator>>(bool &data)
+{
+    U64 value;
+    if (ReadUnsigned(mData, value) == false) {
+        return false;
+    }
+
+    data = value != 0;
+    return true;
+}
+
+bool SimpleArchive::operator>>(char const **data)
+{
+    size_t length = mData->mString.size();
+    size_t position = mData->mReadPosition;
+    while (position < length && mData->mString[position] == ' ') {
+        position++;
+    }
+
+    size_t colon = mData->mString.find(':', position);
+    if (colon == std::string::npos) {
+        return false;
+    }
+
+    U32 string_length = U32(strtoul(mData->mString.substr(position, colon - position).c_str(), NULL, 10));
+    if (colon + 1 + string_length > length) {
+        return false;
+    }
+
+    mData->mStrings.push_back(mData->mString.substr(colon + 1, string_length));
+    mData->mReadPosition = colon + 1 + string_length;
+    *data = mData->mStrings.back().c_str();
+    return true;
+}
+
+bool SimpleArchive::operator>>(Channel &data)
+{
+    U64 device_id;
+    U32 channel_index;
+    if ((*this >> device_id) == false || (*this >> channel_index) == false) {
+        return false;
+    }
+
+    data = Channel(device_id, channel_index);
+    return true;
+}
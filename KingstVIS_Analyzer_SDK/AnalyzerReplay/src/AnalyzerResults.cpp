@@ -0,0 +1,354 @@
+#include <AnalyzerResults.h>
+#include "ReplayCapture.h"
+#include <algorithm>
+#include <map>
+#include <vector>
+
+Frame::Frame()
+    :   mStartingSampleInclusive(0),
+        mEndingSampleInclusive(0),
+        mData1(0),
+        mData2(0),
+        mType(0),
+        mFlags(0)
+{
+}
+
+Frame::Frame(const Frame &frame)
+    :   mStartingSampleInclusive(frame.mStartingSampleInclusive),
+        mEndingSampleInclusive(frame.mEndingSampleInclusive),
+        mData1(frame.mData1),
+        mData2(frame.mData2),
+        mType(frame.mType),
+        mFlags(frame.mFlags)
+{
+}
+
+Frame::~Frame()
+{
+}
+
+bool Frame::HasFlag(U8 flag)
+{
+    return (mFlags & flag) != 0;
+}
+
+struct ReplayMarker {
+    U64 mSample;
+    AnalyzerResults::MarkerType mType;
+};
+
+struct ReplayPacket {
+    U64 mFirstFrame;
+    U64 mLastFrame;
+};
+
+struct AnalyzerResultsData {
+    std::vector<Frame> mFrames;
+    std::vector<ReplayPacket> mPackets;
+    U64 mPacketFirstFrame;
+    std::map<U64, U64> mPacketTransactions;
+    std::map<Channel, std::vector<ReplayMarker> > mMarkers;
+    std::vector<Channel> mBubbleChannels;
+
+    std::vector<std::string> mResultStrings;
+    std::vector<const char *> mResultStringPointers;
+    std::string mTabularText;
+    std::vector<U64> mTransactionPackets;
+
+    double mExportProgress;
+    bool mExportCancelled;
+};
+
+static std::string ConcatStrings(const char *str1, const char *str2, const char *str3, const char *str4, const char *str5, const char *str6)
+{
+    std::string result;
+    const char *strings[] = { str1, str2, str3, str4, str5, str6 };
+    for (U32 i = 0; i < 6; i++) {
+        if (strings[i] != NULL) {
+            result += strings[i];
+        }
+    }
+
+    return result;
+}
+
+AnalyzerResults::AnalyzerResults()
+{
+    mData = new AnalyzerResultsData();
+    mData->mPacketFirstFrame = 0;
+    mData->mExportProgress = 0.0;
+    mData->mExportCancelled = false;
+}
+
+AnalyzerResults::~AnalyzerResults()
+{
+    delete mData;
+}
+
+void AnalyzerResults::AddMarker(U64 sample_number, MarkerType marker_type, Channel &channel)
+{
+    ReplayCallTimer timer(ReplayAddMarker);
+    ReplayMarker marker = { sample_number, marker_type };
+    mData->mMarkers[channel].push_back(marker);
+}
+
+U64 AnalyzerResults::AddFrame(const Frame &frame)
+{
+    ReplayCallTimer timer(ReplayAddFrame);
+    mData->mFrames.push_back(frame);
+    return mData->mFrames.size() - 1;
+}
+
+U64 AnalyzerResults::CommitPacketAndStartNewPacket()
+{
+    ReplayCallTimer timer(ReplayCommitPacket);
+    U64 frame_count = mData->mFrames.size();
+    if (frame_count == mData->mPacketFirstFrame) {
+        return INVALID_RESULT_INDEX;    //empty packets aren't recorded.
+    }
+
+    ReplayPacket packet = { mData->mPacketFirstFrame, frame_count - 1 };
+    mData->mPackets.push_back(packet);
+    mData->mPacketFirstFrame = frame_count;
+    return mData->mPackets.size() - 1;
+}
+
+void AnalyzerResults::CancelPacketAndStartNewPacket()
+{
+    mData->mPacketFirstFrame = mData->mFrames.size();
+}
+
+void AnalyzerResults::AddPacketToTransaction(U64 transaction_id, U64 packet_id)
+{
+    mData->mPacketTransactions[packet_id] = transaction_id;
+}
+
+void AnalyzerResults::AddChannelBubblesWillAppearOn(const Channel &channel)
+{
+    mData->mBubbleChannels.push_back(channel);
+}
+
+void AnalyzerResults::CommitResults()
+{
+    ReplayCallTimer timer(ReplayCommitResults);
+}
+
+U64 AnalyzerResults::GetNumFrames()
+{
+    return mData->mFrames.size();
+}
+
+U64 AnalyzerResults::GetNumPackets()
+{
+    return mData->mPackets.size();
+}
+
+Frame AnalyzerResults::GetFrame(U64 frame_id)
+{
+    return mData->mFrames[frame_id];
+}
+
+static bool PacketEndsBefore(const ReplayPacket &packet, U64 frame_id)
+{
+    return packet.mLastFrame < frame_id;
+}
+
+U64 AnalyzerResults::GetPacketContainingFrame(U64 frame_id)
+{
+    std::vector<ReplayPacket>::iterator it = std::lower_bound(mData->mPackets.begin(), mData->mPackets.end(), frame_id, PacketEndsBefore);
+    if (it == mData->mPackets.end() || it->mFirstFrame > frame_id) {
+        return INVALID_RESULT_INDEX;
+    }
+
+    return it - mData->mPackets.begin();
+}
+
+U64 AnalyzerResults::GetPacketContainingFrameSequential(U64 frame_id)
+{
+    return GetPacketContainingFrame(frame_id);
+}
+
+void AnalyzerResults::GetFramesContainedInPacket(U64 packet_id, U64 *first_frame_id, U64 *last_frame_id)
+{
+    if (packet_id >= mData->mPackets.size()) {
+        *first_frame_id = INVALID_RESULT_INDEX;
+        *last_frame_id = INVALID_RESULT_INDEX;
+        return;
+    }
+
+    *first_frame_id = mData->mPackets[packet_id].mFirstFrame;
+    *last_frame_id = mData->mPackets[packet_id].mLastFrame;
+}
+
+U32 AnalyzerResults::GetTransactionContainingPacket(U64 packet_id)
+{
+    std::map<U64, U64>::iterator it = mData->mPacketTransactions.find(packet_id);
+    if (it == mData->mPacketTransactions.end()) {
+        return 0xFFFFFFFF;
+    }
+
+    return U32(it->second);
+}
+
+void AnalyzerResults::GetPacketsContainedInTransaction(U64 transaction_id, U64 **packet_id_array, U64 *packet_id_count)
+{
+    mData->mTransactionPackets.clear();
+    for (std::map<U64, U64>::iterator it = mData->mPacketTransactions.begin(); it != mData->mPacketTransactions.end(); ++it) {
+        if (it->second == transaction_id) {
+            mData->mTransactionPackets.push_back(it->first);
+        }
+    }
+
+    *packet_id_array = mData->mTransactionPackets.empty() ? NULL : &mData->mTransactionPackets[0];
+    *packet_id_count = mData->mTransactionPackets.size();
+}
+
+void AnalyzerResults::ClearResultStrings()
+{
+    mData->mResultStrings.clear();
+}
+
+void AnalyzerResults::AddResultString(const char *str1, const char *str2, const char *str3, const char *str4, const char *str5, const char *str6)
+{
+    mData->mResultStrings.push_back(ConcatStrings(str1, str2, str3, str4, str5, str6));
+}
+
+void AnalyzerResults::GetResultStrings(char const ***result_string_array, U32 *num_strings)
+{
+    mData->mResultStringPointers.clear();
+    for (U32 i = 0; i < mData->mResultStrings.size(); i++) {
+        mData->mResultStringPointers.push_back(mData->mResultStrings[i].c_str());
+    }
+
+    *result_string_array = mData->mResultStringPointers.empty() ? NULL : &mData->mResultStringPointers[0];
+    *num_strings = U32(mData->mResultStringPointers.size());
+}
+
+bool AnalyzerResults::UpdateExportProgressAndCheckForCancel(U64 completed_frames, U64 total_frames)
+{
+    mData->mExportProgress = (total_frames != 0) ? double(completed_frames) / double(total_frames) : 1.0;
+    return mData->mExportCancelled;
+}
+
+bool AnalyzerResults::DoBubblesAppearOnChannel(Channel &channel)
+{
+    return std::find(mData->mBubbleChannels.begin(), mData->mBubbleChannels.end(), channel) != mData->mBubbleChannels.end();
+}
+
+bool AnalyzerResults::DoMarkersAppearOnChannel(Channel &channel)
+{
+    return mData->mMarkers.find(channel) != mData->mMarkers.end();
+}
+
+static bool FrameEndsBefore(const Frame &frame, S64 sample)
+{
+    return frame.mEndingSampleInclusive < sample;
+}
+
+bool AnalyzerResults::GetFramesInRange(S64 starting_sample_inclusive, S64 ending_sample_inclusive, U64 *first_frame_index, U64 *last_frame_index)
+{
+    std::vector<Frame>::iterator first = std::lower_bound(mData->mFrames.begin(), mData->mFrames.end(), starting_sample_inclusive, FrameEndsBefore);
+
+    U64 first_index = first - mData->mFrames.begin();
+    U64 last_index = first_index;
+    while (last_index < mData->mFrames.size() && mData->mFrames[last_index].mStartingSampleInclusive <= ending_sample_inclusive) {
+        last_index++;
+    }
+
+    if (last_index == first_index) {
+        return false;
+    }
+
+    *first_frame_index = first_index;
+    *last_frame_index = last_index - 1;
+    return true;
+}
+
+static bool MarkerBefore(const ReplayMarker &marker, S64 sample)
+{
+    return S64(marker.mSample) < sample;
+}
+
+bool AnalyzerResults::GetMarkersInRange(Channel &channel, S64 starting_sample_inclusive, S64 ending_sample_inclusive, U64 *first_marker_index, U64 *last_marker_index)
+{
+    std::vector<ReplayMarker> &markers = mData->mMarkers[channel];
+    std::vector<ReplayMarker>::iterator first = std::lower_bound(markers.begin(), markers.end(), starting_sample_inclusive, MarkerBefore);
+    std::vector<ReplayMarker>::iterator last = std::lower_bound(markers.begin(), markers.end(), ending_sample_inclusive + 1, MarkerBefore);
+
+    if (first == last) {
+        return false;
+    }
+
+    *first_marker_index = first - markers.begin();
+    *last_marker_index = (last - markers.begin()) - 1;
+    return true;
+}
+
+void AnalyzerResults::GetMarker(Channel &channel, U64 marker_index, MarkerType *marker_type, U64 *marker_sample)
+{
+    ReplayMarker &marker = mData->mMarkers[channel][marker_index];
+    *marker_type = marker.mType;
+    *marker_sample = marker.mSample;
+}
+
+U64 AnalyzerResults::GetNumMarkers(Channel &channel)
+{
+    std::map<Channel, std::vector<ReplayMarker> >::iterator it = mData->mMarkers.find(channel);
+    if (it == mData->mMarkers.end()) {
+        return 0;
+    }
+
+    return it->second.size();
+}
+
+void AnalyzerResults::CancelExport()
+{
+    mData->mExportCancelled = true;
+}
+
+double AnalyzerResults::GetProgress()
+{
+    return mData->mExportProgress;
+}
+
+void AnalyzerResults::StartExportThread(const char *file, DisplayBase display_base, U32 export_type_user_id)
+{
+    //no GUI to keep responsive; export on the caller's thread.
+    mData->mExportCancelled = false;
+    GenerateExportFile(file, display_base, export_type_user_id);
+}
+
+void AnalyzerResults::ClearTabularText()
+{
+    mData->mTabularText.clear();
+}
+
+const char *AnalyzerResults::BuildSearchData(U64 FrameID, DisplayBase disp_base, int /*channel_list_index*/, char *result)
+{
+    GenerateFrameTabularText(FrameID, disp_base);
+    std::string text = GetTabularTextString();
+    text.copy(result, text.size());
+    result[text.size()] = 0;
+    return result;
+}
+
+std::string AnalyzerResults::GetStringForDisplayBase(U64 frame_id, Channel channel, DisplayBase disp_base)
+{
+    GenerateBubbleText(frame_id, channel, disp_base);
+    if (mData->mResultStrings.empty() == true) {
+        return std::string();
+    }
+
+    return mData->mResultStrings.back();
+}
+
+void AnalyzerResults::AddTabularText(const char *str1, const char *str2, const char *str3, const char *str4, const char *str5, const char *str6)
+{
+    mData->mTabularText += ConcatStrings(str1, str2, str3, str4, str5, str6);
+}
+
+std::string AnalyzerResults::GetTabularTextString()
+{
+    return mData->mTabularText;
+}
@@ -0,0 +1,315 @@
+#include <AnalyzerSettingInterface.h>
+#include <new>
+
+struct AnalyzerSettingInterfaceData {
+    std::string mTitle;
+    std::string mToolTip;
+    bool mDisabled;
+};
+
+AnalyzerSettingInterface::AnalyzerSettingInterface()
+{
+    mData = new AnalyzerSettingInterfaceData();
+    mData->mDisabled = false;
+}
+
+AnalyzerSettingInterface::~AnalyzerSettingInterface()
+{
+    delete mData;
+}
+
+void AnalyzerSettingInterface::operator delete (void *p)
+{
+    ::operator delete (p);
+}
+
+void *AnalyzerSettingInterface::operator new (size_t size)
+{
+    return ::operator new (size);
+}
+
+AnalyzerInterfaceTypeId AnalyzerSettingInterface::GetType()
+{
+    return INTERFACE_BASE;
+}
+
+const char *AnalyzerSettingInterface::GetToolTip()
+{
+    return mData->mToolTip.c_str();
+}
+
+const char *AnalyzerSettingInterface::GetTitle()
+{
+    return mData->mTitle.c_str();
+}
+
+bool AnalyzerSettingInterface::IsDisabled()
+{
+    return mData->mDisabled;
+}
+
+void AnalyzerSettingInterface::SetTitleAndTooltip(const char *title, const char *tooltip)
+{
+    mData->mTitle = title;
+    mData->mToolTip = tooltip;
+}
+
+
+struct AnalyzerSettingInterfaceChannelData {
+    Channel mChannel;
+    bool mSelectionOfNoneIsAllowed;
+};
+
+AnalyzerSettingInterfaceChannel::AnalyzerSettingInterfaceChannel()
+{
+    mChannelData = new AnalyzerSettingInterfaceChannelData();
+    mChannelData->mChannel = UNDEFINED_CHANNEL;
+    mChannelData->mSelectionOfNoneIsAllowed = false;
+}
+
+AnalyzerSettingInterfaceChannel::~AnalyzerSettingInterfaceChannel()
+{
+    delete mChannelData;
+}
+
+AnalyzerInterfaceTypeId AnalyzerSettingInterfaceChannel::GetType()
+{
+    return INTERFACE_CHANNEL;
+}
+
+Channel AnalyzerSettingInterfaceChannel::GetChannel()
+{
+    return mChannelData->mChannel;
+}
+
+void AnalyzerSettingInterfaceChannel::SetChannel(const Channel &channel)
+{
+    mChannelData->mChannel = channel;
+}
+
+bool AnalyzerSettingInterfaceChannel::GetSelectionOfNoneIsAllowed()
+{
+    return mChannelData->mSelectionOfNoneIsAllowed;
+}
+
+void AnalyzerSettingInterfaceChannel::SetSelectionOfNoneIsAllowed(bool is_allowed)
+{
+    mChannelData->mSelectionOfNoneIsAllowed = is_allowed;
+}
+
+
+struct AnalyzerSettingInterfaceNumberListData {
+    double mNumber;
+    std::vector<double> mNumbers;
+    std::vector<std::string> mStrings;
+    std::vector<std::string> mTooltips;
+};
+
+AnalyzerSettingInterfaceNumberList::AnalyzerSettingInterfaceNumberList()
+{
+    mNumberListData = new AnalyzerSettingInterfaceNumberListData();
+    mNumberListData->mNumber = 0.0;
+}
+
+AnalyzerSettingInterfaceNumberList::~AnalyzerSettingInterfaceNumberList()
+{
+    delete mNumberListData;
+}
+
+AnalyzerInterfaceTypeId AnalyzerSettingInterfaceNumberList::GetType()
+{
+    return INTERFACE_NUMBER_LIST;
+}
+
+double AnalyzerSettingInterfaceNumberList::GetNumber()
+{
+    return mNumberListData->mNumber;
+}
+
+void AnalyzerSettingInterfaceNumberList::SetNumber(double number)
+{
+    mNumberListData->mNumber = number;
+}
+
+U32 AnalyzerSettingInterfaceNumberList::GetListboxNumbersCount()
+{
+    return U32(mNumberListData->mNumbers.size());
+}
+
+double AnalyzerSettingInterfaceNumberList::GetListboxNumber(U32 index)
+{
+    return mNumberListData->mNumbers[index];
+}
+
+U32 AnalyzerSettingInterfaceNumberList::GetListboxStringsCount()
+{
+    return U32(mNumberListData->mStrings.size());
+}
+
+const char *AnalyzerSettingInterfaceNumberList::GetListboxString(U32 index)
+{
+    return mNumberListData->mStrings[index].c_str();
+}
+
+U32 AnalyzerSettingInterfaceNumberList::GetListboxTooltipsCount()
+{
+    return U32(mNumberListData->mTooltips.size());
+}
+
+const char *AnalyzerSettingInterfaceNumberList::GetListboxTooltip(U32 index)
+{
+    return mNumberListData->mTooltips[index].c_str();
+}
+
+void AnalyzerSettingInterfaceNumberList::AddNumber(double number, const char *str, const char *tooltip)
+{
+    mNumberListData->mNumbers.push_back(number);
+    mNumberListData->mStrings.push_back(str);
+    mNumberListData->mTooltips.push_back(tooltip);
+}
+
+void AnalyzerSettingInterfaceNumberList::ClearNumbers()
+{
+    mNumberListData->mNumbers.clear();
+    mNumberListData->mStrings.clear();
+    mNumberListData->mTooltips.clear();
+}
+
+
+struct AnalyzerSettingInterfaceIntegerData {
+    int mInteger;
+    int mMax;
+    int mMin;
+};
+
+AnalyzerSettingInterfaceInteger::AnalyzerSettingInterfaceInteger()
+{
+    mIntegerData = new AnalyzerSettingInterfaceIntegerData();
+    mIntegerData->mInteger = 0;
+    mIntegerData->mMax = 0x7FFFFFFF;
+    mIntegerData->mMin = -0x7FFFFFFF;
+}
+
+AnalyzerSettingInterfaceInteger::~AnalyzerSettingInterfaceInteger()
+{
+    delete mIntegerData;
+}
+
+AnalyzerInterfaceTypeId AnalyzerSettingInterfaceInteger::GetType()
+{
+    return INTERFACE_INTEGER;
+}
+
+int AnalyzerSettingInterfaceInteger::GetInteger()
+{
+    return mIntegerData->mInteger;
+}
+
+void AnalyzerSettingInterfaceInteger::SetInteger(int integer)
+{
+    mIntegerData->mInteger = integer;
+}
+
+int AnalyzerSettingInterfaceInteger::GetMax()
+{
+    return mIntegerData->mMax;
+}
+
+int AnalyzerSettingInterfaceInteger::GetMin()
+{
+    return mIntegerData->mMin;
+}
+
+void AnalyzerSettingInterfaceInteger::SetMax(int max)
+{
+    mIntegerData->mMax = max;
+}
+
+void AnalyzerSettingInterfaceInteger::SetMin(int min)
+{
+    mIntegerData->mMin = min;
+}
+
+
+struct AnalyzerSettingInterfaceTextData {
+    std::string mText;
+    AnalyzerSettingInterfaceText::TextType mTextType;
+};
+
+AnalyzerSettingInterfaceText::AnalyzerSettingInterfaceText()
+{
+    mTextData = new AnalyzerSettingInterfaceTextData();
+    mTextData->mTextType = NormalText;
+}
+
+AnalyzerSettingInterfaceText::~AnalyzerSettingInterfaceText()
+{
+    delete mTextData;
+}
+
+AnalyzerInterfaceTypeId AnalyzerSettingInterfaceText::GetType()
+{
+    return INTERFACE_TEXT;
+}
+
+const char *AnalyzerSettingInterfaceText::GetText()
+{
+    return mTextData->mText.c_str();
+}
+
+void AnalyzerSettingInterfaceText::SetText(const char *text)
+{
+    mTextData->mText = text;
+}
+
+AnalyzerSettingInterfaceText::TextType AnalyzerSettingInterfaceText::GetTextType()
+{
+    return mTextData->mTextType;
+}
+
+void AnalyzerSettingInterfaceText::SetTextType(TextType text_type)
+{
+    mTextData->mTextType = text_type;
+}
+
+
+struct AnalyzerSettingInterfaceBoolData {
+    bool mValue;
+    std::string mCheckBoxText;
+};
+
+AnalyzerSettingInterfaceBool::AnalyzerSettingInterfaceBool()
+{
+    mBoolData = new AnalyzerSettingInterfaceBoolData();
+    mBoolData->mValue = false;
+}
+
+AnalyzerSettingInterfaceBool::~AnalyzerSettingInterfaceBool()
+{
+    delete mBoolData;
+}
+
+AnalyzerInterfaceTypeId AnalyzerSettingInterfaceBool::GetType()
+{
+    return INTERFACE_BOOL;
+}
+
+bool AnalyzerSettingInterfaceBool::GetValue()
+{
+    return mBoolData->mValue;
+}
+
+void AnalyzerSettingInterfaceBool::SetValue(bool value)
+{
+    mBoolData->mValue = value;
+}
+
+const char *AnalyzerSettingInterfaceBool::GetCheckBoxText()
+{
+    return mBoolData->mCheckBoxText.c_str();
+}
+
+void AnalyzerSettingInterfaceBool::SetCheckBoxText(const char *text)
+{
+    mBoolData->mCheckBoxText = text;
+}
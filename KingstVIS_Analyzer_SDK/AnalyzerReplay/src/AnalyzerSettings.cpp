@@ -0,0 +1,172 @@
+#include <AnalyzerSettings.h>
+#include <string>
+#include <vector>
+
+struct AnalyzerSettingsExportOption {
+    U32 mUserId;
+    std::string mMenuText;
+    std::vector<std::string> mExtensionDescriptions;
+    std::vector<std::string> mExtensions;
+};
+
+struct AnalyzerSettingsChannel {
+    Channel mChannel;
+    std::string mLabel;
+    bool mIsUsed;
+};
+
+struct AnalyzerSettingsData {
+    std::vector<AnalyzerSettingInterface *> mInterfaces;
+    std::vector<AnalyzerSettingsChannel> mChannels;
+    std::vector<AnalyzerSettingsExportOption> mExportOptions;
+    std::string mErrorText;
+    std::string mReturnString;
+    bool mUseSystemDisplayBase;
+    DisplayBase mDisplayBase;
+};
+
+AnalyzerSettings::AnalyzerSettings()
+{
+    mData = new AnalyzerSettingsData();
+    mData->mUseSystemDisplayBase = true;
+    mData->mDisplayBase = Hexadecimal;
+}
+
+AnalyzerSettings::~AnalyzerSettings()
+{
+    delete mData;
+}
+
+const char *AnalyzerSettings::GetSettingBrief()
+{
+    return "";
+}
+
+void AnalyzerSettings::ClearChannels()
+{
+    mData->mChannels.clear();
+}
+
+void AnalyzerSettings::AddChannel(Channel &channel, const char *channel_label, bool is_used)
+{
+    AnalyzerSettingsChannel settings_channel;
+    settings_channel.mChannel = channel;
+    settings_channel.mLabel = channel_label;
+    settings_channel.mIsUsed = is_used;
+    mData->mChannels.push_back(settings_channel);
+}
+
+void AnalyzerSettings::SetErrorText(const char *error_text)
+{
+    mData->mErrorText = error_text;
+}
+
+void AnalyzerSettings::AddInterface(AnalyzerSettingInterface *analyzer_setting_interface)
+{
+    mData->mInterfaces.push_back(analyzer_setting_interface);
+}
+
+static AnalyzerSettingsExportOption *FindExportOption(AnalyzerSettingsData *data, U32 user_id)
+{
+    for (U32 i = 0; i < data->mExportOptions.size(); i++) {
+        if (data->mExportOptions[i].mUserId == user_id) {
+            return &data->mExportOptions[i];
+        }
+    }
+
+    return NULL;
+}
+
+void AnalyzerSettings::AddExportOption(U32 user_id, const char *menu_text)
+{
+    AnalyzerSettingsExportOption option;
+    option.mUserId = user_id;
+    option.mMenuText = menu_text;
+    mData->mExportOptions.push_back(option);
+}
+
+void AnalyzerSettings::AddExportExtension(U32 user_id, const char *extension_description, const char *extension)
+{
+    AnalyzerSettingsExportOption *option = FindExportOption(mData, user_id);
+    if (option == NULL) {
+        return;
+    }
+
+    option->mExtensionDescriptions.push_back(extension_description);
+    option->mExtensions.push_back(extension);
+}
+
+const char *AnalyzerSettings::SetReturnString(const char *str)
+{
+    mData->mReturnString = str;
+    return mData->mReturnString.c_str();
+}
+
+U32 AnalyzerSettings::GetSettingsInterfacesCount()
+{
+    return U32(mData->mInterfaces.size());
+}
+
+AnalyzerSettingInterface *AnalyzerSettings::GetSettingsInterface(U32 index)
+{
+    return mData->mInterfaces[index];
+}
+
+U32 AnalyzerSettings::GetFileExtensionCount(U32 index_id)
+{
+    return U32(mData->mExportOptions[index_id].mExtensions.size());
+}
+
+void AnalyzerSettings::GetFileExtension(U32 index_id, U32 extension_id, char const **extension_description, char const **extension)
+{
+    *extension_description = mData->mExportOptions[index_id].mExtensionDescriptions[extension_id].c_str();
+    *extension = mData->mExportOptions[index_id].mExtensions[extension_id].c_str();
+}
+
+U32 AnalyzerSettings::GetChannelsCount()
+{
+    return U32(mData->mChannels.size());
+}
+
+Channel AnalyzerSettings::GetChannel(U32 index, char const **channel_label, bool *channel_is_used)
+{
+    *channel_label = mData->mChannels[index].mLabel.c_str();
+    *channel_is_used = mData->mChannels[index].mIsUsed;
+    return mData->mChannels[index].mChannel;
+}
+
+U32 AnalyzerSettings::GetExportOptionsCount()
+{
+    return U32(mData->mExportOptions.size());
+}
+
+void AnalyzerSettings::GetExportOption(U32 index, U32 *user_id, char const **menu_text)
+{
+    *user_id = mData->mExportOptions[index].mUserId;
+    *menu_text = mData->mExportOptions[index].mMenuText.c_str();
+}
+
+const char *AnalyzerSettings::GetSaveErrorMessage()
+{
+    return mData->mErrorText.c_str();
+}
+
+bool AnalyzerSettings::GetUseSystemDisplayBase()
+{
+    return mData->mUseSystemDisplayBase;
+}
+
+void AnalyzerSettings::SetUseSystemDisplayBase(bool use_system_display_base)
+{
+    mData->mUseSystemDisplayBase = use_system_display_base;
+}
+
+DisplayBase AnalyzerSettings::GetAnalyzerDisplayBase()
+{
+    return mData->mDisplayBase;
+}
+
+void AnalyzerSettings::SetAnalyzerDisplayBase(DisplayBase analyzer_display_base)
+{
+    mData->mDisplayBase = analyzer_display_base;
+}
@@ -0,0 +1,54 @@
+#include <LogicPublicTypes.h>
+
+Channel::Channel()
+    :   mDeviceId(0xFFFFFFFFFFFFFFFFull),
+        mChannelIndex(0xFFFFFFFF)
+{
+}
+
+Channel::Channel(const Channel &channel)
+    :   mDeviceId(channel.mDeviceId),
+        mChannelIndex(channel.mChannelIndex)
+{
+}
+
+Channel::Channel(U64 device_id, U32 channel_index)
+    :   mDeviceId(device_id),
+        mChannelIndex(channel_index)
+{
+}
+
+Channel::~Channel()
+{
+}
+
+Channel &Channel::operator=(const Channel &channel)
+{
+    mDeviceId = channel.mDeviceId;
+    mChannelIndex = channel.mChannelIndex;
+    return *this;
+}
+
+bool Channel::operator==(const Channel &channel) const
+{
+    return (mDeviceId == channel.mDeviceId) && (mChannelIndex == channel.mChannelIndex);
+}
+
+bool Channel::operator!=(const Channel &channel) const
+{
+    return !(*this == channel);
+}
+
+bool Channel::operator>(const Channel &channel) const
+{
+    return channel < *this;
+}
+
+bool Channel::operator<(const Channel &channel) const
+{
+    if (mDeviceId != channel.mDeviceId) {
+        return mDeviceId < channel.mDeviceId;
+    }
+
+    return mChannelIndex < channel.mChannelIndex;
+}
@@ -0,0 +1,572 @@
+#include "ReplayCapture.h"
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static thread_local ReplayCallCounter gCallCounters[ReplayCallCount];
+static thread_local U64 gChannelCallCounts[REPLAY_COUNTED_CHANNELS];
+static bool gCallTiming = false;
+static bool gLinearTraversal = false;
+
+const char *GetReplayCallName(U32 call)
+{
+    static const char *names[ReplayCallCount] = {
+        "AddFrame", "AddMarker", "CommitPacketAndStartNewPacket", "CommitResults",
+        "ReportProgress", "CheckIfThreadShouldExit", "Advance", "AdvanceToNextEdge", "GetSampleNumber", "GetBitState",
+        "GetSampleOfNextEdge", "WouldAdvancingToAbsPositionCauseTransition", "DoMoreTransitionsExistInCurrentData"
+    };
+
+    return (call < ReplayCallCount) ? names[call] : "";
+}
+
+ReplayCallCounter *GetReplayCallCounters()
+{
+    return gCallCounters;
+}
+
+U64 *GetReplayChannelCallCounts()
+{
+    return gChannelCallCounts;
+}
+
+void ResetReplayCallCounters()
+{
+    memset(gCallCounters, 0, sizeof(gCallCounters));
+    memset(gChannelCallCounts, 0, sizeof(gChannelCallCounts));
+}
+
+void SetReplayCallTiming(bool enabled)
+{
+    gCallTiming = enabled;
+}
+
+bool GetReplayCallTiming()
+{
+    return gCallTiming;
+}
+
+void SetReplayLinearTraversal(bool enabled)
+{
+    gLinearTraversal = enabled;
+}
+
+bool GetReplayLinearTraversal()
+{
+    return gLinearTraversal;
+}
+
+DeviceCollection::DeviceCollection()
+    :   mSampleRate(0),
+        mSampleCount(0),
+        mTriggerSample(0),
+        mMapping(NULL),
+        mMappingLength(0)
+{
+}
+
+DeviceCollection::~DeviceCollection()
+{
+    Close();
+}
+
+bool DeviceCollection::Open(const char *file_name)
+{
+    Close();
+
+    int fd = open(file_name, O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || U64(st.st_size) < sizeof(EdgeFileHeader)) {
+        close(fd);
+        return false;
+    }
+
+    void *mapping = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED) {
+        return false;
+    }
+
+    mMapping = mapping;
+    mMappingLength = st.st_size;
+
+    const U8 *base = (const U8 *)mapping;
+    const EdgeFileHeader *header = (const EdgeFileHeader *)base;
+    if (memcmp(header->mMagic, EDGE_FILE_MAGIC, sizeof(EDGE_FILE_MAGIC)) != 0) {
+        Close();
+        return false;
+    }
+
+    if (header->mVersion == EDGE_FILE_VERSION_BLOCKS) {
+        if (OpenBlocks(base, header) == false) {
+            Close();
+            return false;
+        }
+
+        madvise(mMapping, mMappingLength, MADV_SEQUENTIAL);
+        return true;
+    }
+
+    if (header->mVersion != EDGE_FILE_VERSION) {
+        Close();
+        return false;
+    }
+
+    U64 table_end = sizeof(EdgeFileHeader) + U64(header->mChannelCount) * sizeof(EdgeFileChannel);
+    if (table_end > mMappingLength) {
+        Close();
+        return false;
+    }
+
+    SetCapture(U32(header->mSampleRate), header->mSampleCount, header->mTriggerSample);
+
+    const EdgeFileChannel *table = (const EdgeFileChannel *)(base + sizeof(EdgeFileHeader));
+    for (U32 i = 0; i < header->mChannelCount; i++) {
+        if (table[i].mEdgeOffset + table[i].mEdgeCount * sizeof(U64) > mMappingLength) {
+            Close();
+            return false;
+        }
+
+        AddChannel(table[i].mChannelIndex, table[i].mInitialBitState != 0 ? BIT_HIGH : BIT_LOW, (const U64 *)(base + table[i].mEdgeOffset), table[i].mEdgeCount);
+    }
+
+    //we'll be walking the edges front to back.
+    madvise(mMapping, mMappingLength, MADV_SEQUENTIAL);
+    return true;
+}
+
+bool DeviceCollection::OpenBlocks(const U8 *base, const EdgeFileHeader *header)
+{
+    U64 table_end = sizeof(EdgeFileHeader) + U64(header->mChannelCount) * sizeof(EdgeFileBlockChannel);
+    if (table_end > mMappingLength) {
+        return false;
+    }
+
+    SetCapture(U32(header->mSampleRate), header->mSampleCount, header->mTriggerSample);
+
+    const EdgeFileBlockChannel *table = (const EdgeFileBlockChannel *)(base + sizeof(EdgeFileHeader));
+    for (U32 i = 0; i < header->mChannelCount; i++) {
+        ChannelData channel;
+        channel.mChannelIndex = table[i].mChannelIndex;
+        channel.mInitialBitState = table[i].mInitialBitState != 0 ? BIT_HIGH : BIT_LOW;
+        channel.mEdgeCount = table[i].mEdgeCount;
+        channel.mSampleCount = mSampleCount;
+
+        U64 block_count = channel.GetBlockCount();
+        if ((table[i].mBlockOffset % sizeof(U64)) != 0 || table[i].mBlockOffset > mMappingLength
+                || block_count > (mMappingLength - table[i].mBlockOffset) / sizeof(EdgeFileBlock)
+                || table[i].mDeltaOffset > mMappingLength || table[i].mDeltaLength > mMappingLength - table[i].mDeltaOffset) {
+            return false;
+        }
+
+        channel.mBlocks = (const EdgeFileBlock *)(base + table[i].mBlockOffset);
+        channel.mDeltas = base + table[i].mDeltaOffset;
+        channel.mDeltaLength = table[i].mDeltaLength;
+
+        //DecodeEdgeBlock counts on the index staying in order and inside the gaps; one pass over it is a thousandth of the edges.
+        for (U64 j = 0; j < block_count; j++) {
+            if (channel.mBlocks[j].mDeltaOffset > channel.mDeltaLength) {
+                return false;
+            }
+            if (j != 0 && (channel.mBlocks[j].mDeltaOffset < channel.mBlocks[j - 1].mDeltaOffset || channel.mBlocks[j].mFirstEdge < channel.mBlocks[j - 1].mFirstEdge)) {
+                return false;
+            }
+        }
+
+        mChannels.push_back(channel);
+    }
+
+    return true;
+}
+
+void DeviceCollection::Close()
+{
+    if (mMapping != NULL) {
+        munmap(mMapping, mMappingLength);
+        mMapping = NULL;
+        mMappingLength = 0;
+    }
+
+    mChannels.clear();
+}
+
+void DeviceCollection::SetCapture(U32 sample_rate, U64 sample_count, U64 trigger_sample)
+{
+    mSampleRate = sample_rate;
+    mSampleCount = sample_count;
+    mTriggerSample = trigger_sample;
+}
+
+void DeviceCollection::AddChannel(U32 channel_index, BitState initial_bit_state, const U64 *edges, U64 edge_count)
+{
+    ChannelData channel;
+    channel.mChannelIndex = channel_index;
+    channel.mInitialBitState = initial_bit_state;
+    channel.mEdges = edges;
+    channel.mEdgeCount = edge_count;
+    channel.mSampleCount = mSampleCount;
+    mChannels.push_back(channel);
+}
+
+void DeviceCollection::AddChannel(const ChannelData &channel)
+{
+    mChannels.push_back(channel);
+    mChannels.back().mSampleCount = mSampleCount;
+}
+
+ChannelData *DeviceCollection::GetChannelData(U32 channel_index)
+{
+    U32 count = U32(mChannels.size());
+    for (U32 i = 0; i < count; i++) {
+        if (mChannels[i].mChannelIndex == channel_index) {
+            return &mChannels[i];
+        }
+    }
+
+    return NULL;
+}
+
+U32 DeviceCollection::GetChannelCount()
+{
+    return U32(mChannels.size());
+}
+
+ChannelData *DeviceCollection::GetChannelDataAt(U32 position)
+{
+    return (position < mChannels.size()) ? &mChannels[position] : NULL;
+}
+
+U32 DeviceCollection::GetSampleRate()
+{
+    return mSampleRate;
+}
+
+U64 DeviceCollection::GetSampleCount()
+{
+    return mSampleCount;
+}
+
+U64 DeviceCollection::GetTriggerSample()
+{
+    return mTriggerSample;
+}
+
+U64 DeviceCollection::GetEdgeCount()
+{
+    U64 edge_count = 0;
+    U32 count = U32(mChannels.size());
+    for (U32 i = 0; i < count; i++) {
+        edge_count += mChannels[i].mEdgeCount;
+    }
+
+    return edge_count;
+}
+
+bool DeviceCollection::Save(const char *file_name, U32 sample_rate, U64 sample_count, U64 trigger_sample, std::vector<ChannelData> &channels)
+{
+    FILE *f = fopen(file_name, "wb");
+    if (f == NULL) {
+        return false;
+    }
+
+    EdgeFileHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.mMagic, EDGE_FILE_MAGIC, sizeof(EDGE_FILE_MAGIC));
+    header.mVersion = EDGE_FILE_VERSION;
+    header.mChannelCount = U32(channels.size());
+    header.mSampleRate = sample_rate;
+    header.mSampleCount = sample_count;
+    header.mTriggerSample = trigger_sample;
+
+    bool ok = fwrite(&header, sizeof(header), 1, f) == 1;
+
+    U64 offset = sizeof(EdgeFileHeader) + channels.size() * sizeof(EdgeFileChannel);
+    for (U32 i = 0; i < channels.size(); i++) {
+        EdgeFileChannel table;
+        table.mChannelIndex = channels[i].mChannelIndex;
+        table.mInitialBitState = channels[i].mInitialBitState == BIT_HIGH ? 1 : 0;
+        table.mEdgeCount = channels[i].mEdgeCount;
+        table.mEdgeOffset = offset;
+        ok = ok && fwrite(&table, sizeof(table), 1, f) == 1;
+
+        offset += channels[i].mEdgeCount * sizeof(U64);
+    }
+
+    for (U32 i = 0; i < channels.size(); i++) {
+        if (channels[i].mEdgeCount != 0) {
+            ok = ok && fwrite(channels[i].mEdges, sizeof(U64), channels[i].mEdgeCount, f) == channels[i].mEdgeCount;
+        }
+    }
+
+    return (fclose(f) == 0) && ok;
+}
+
+U32 DecodeEdgeBlock(const ChannelData *channel, U64 block, U64 *edges)
+{
+    U64 block_count = channel->GetBlockCount();
+    if (block >= block_count) {
+        return 0;
+    }
+
+    U32 count = EDGE_FILE_BLOCK_EDGES;
+    const U8 *end = channel->mDeltas + channel->mDeltaLength;
+    if (block + 1 < block_count) {
+        end = channel->mDeltas + channel->mBlocks[block + 1].mDeltaOffset;
+    } else {
+        count = U32(channel->mEdgeCount - block * EDGE_FILE_BLOCK_EDGES);
+    }
+
+    const U8 *gaps = channel->mDeltas + channel->mBlocks[block].mDeltaOffset;
+    U64 edge = channel->mBlocks[block].mFirstEdge;
+    edges[0] = edge;
+
+    U32 decoded = 1;
+    while (decoded < count) {
+        U64 gap = 0;
+        U32 shift = 0;
+        U8 byte;
+        do {
+            if (gaps == end || shift >= 64) {
+                return decoded;
+            }
+            byte = *gaps++;
+            gap |= U64(byte & 0x7F) << shift;
+            shift += 7;
+        } while ((byte & 0x80) != 0);
+
+        edge += gap;
+        edges[decoded++] = edge;
+    }
+
+    return decoded;
+}
+
+U64 FindEdgeBlock(const ChannelData *channel, U64 first_block, U64 sample_number)
+{
+    U64 low = first_block;
+    U64 high = channel->GetBlockCount();
+    if (low >= high) {
+        return first_block;
+    }
+
+    //the answer is in [low, high)
+    while (high - low > 1) {
+        U64 middle = low + (high - low) / 2;
+        if (channel->mBlocks[middle].mFirstEdge <= sample_number) {
+            low = middle;
+        } else {
+            high = middle;
+        }
+    }
+
+    return low;
+}
+
+EdgeFileWriter::EdgeFileWriter()
+    :   mBlockFile(NULL),
+        mGapFile(NULL),
+        mGapFileLength(0),
+        mOk(false)
+{
+}
+
+EdgeFileWriter::~EdgeFileWriter()
+{
+    if (mBlockFile != NULL) {
+        fclose(mBlockFile);
+    }
+    if (mGapFile != NULL) {
+        fclose(mGapFile);
+    }
+}
+
+bool EdgeFileWriter::Open(const char *file_name)
+{
+    mFileName = file_name;
+    mChannels.clear();
+    mBlockFile = tmpfile();
+    mGapFile = tmpfile();
+    mGapFileLength = 0;
+    mOk = mBlockFile != NULL && mGapFile != NULL;
+    return mOk;
+}
+
+U32 EdgeFileWriter::AddChannel(U32 channel_index, BitState initial_bit_state)
+{
+    WriterChannel channel;
+    channel.mChannelIndex = channel_index;
+    channel.mInitialBitState = initial_bit_state;
+    channel.mEdgeCount = 0;
+    channel.mLastEdge = 0;
+    channel.mDeltaLength = 0;
+    channel.mBlock.mFirstEdge = 0;
+    channel.mBlock.mDeltaOffset = 0;
+    mChannels.push_back(channel);
+    mChannels.back().mGaps.reserve(EDGE_FILE_BLOCK_EDGES * 2);
+    return U32(mChannels.size() - 1);
+}
+
+void EdgeFileWriter::SetInitialBitState(U32 position, BitState initial_bit_state)
+{
+    mChannels[position].mInitialBitState = initial_bit_state;
+}
+
+bool EdgeFileWriter::AddEdge(U32 position, U64 sample)
+{
+    WriterChannel &channel = mChannels[position];
+    if (channel.mEdgeCount != 0 && sample < channel.mLastEdge) {
+        return false;
+    }
+
+    if ((channel.mEdgeCount % EDGE_FILE_BLOCK_EDGES) == 0) {
+        //the block before is complete.
+        if (channel.mEdgeCount != 0) {
+            mOk = SpillBlock(position) && mOk;
+        }
+        channel.mBlock.mFirstEdge = sample;
+        channel.mBlock.mDeltaOffset = channel.mDeltaLength;
+    } else {
+        U64 gap = sample - channel.mLastEdge;
+        while (gap >= 0x80) {
+            channel.mGaps.push_back(U8(gap | 0x80));
+            gap >>= 7;
+        }
+        channel.mGaps.push_back(U8(gap));
+    }
+
+    channel.mLastEdge = sample;
+    channel.mEdgeCount++;
+    return true;
+}
+
+bool EdgeFileWriter::SpillBlock(U32 position)
+{
+    WriterChannel &channel = mChannels[position];
+
+    SpilledBlock spilled;
+    spilled.mPosition = position;
+    spilled.mGapLength = U32(channel.mGaps.size());
+    spilled.mBlock = channel.mBlock;
+    spilled.mSpillOffset = mGapFileLength;
+
+    bool ok = fwrite(&spilled, sizeof(spilled), 1, mBlockFile) == 1;
+    if (channel.mGaps.empty() == false) {
+        ok = ok && fwrite(&channel.mGaps[0], 1, channel.mGaps.size(), mGapFile) == channel.mGaps.size();
+    }
+
+    mGapFileLength += channel.mGaps.size();
+    channel.mDeltaLength += channel.mGaps.size();
+    channel.mGaps.clear();
+    return ok;
+}
+
+//writes the index of one channel (index == true) or its gaps, from the spilled blocks.
+bool EdgeFileWriter::CopyChannel(FILE *f, U32 position, bool index)
+{
+    if (fseeko(mBlockFile, 0, SEEK_SET) != 0) {
+        return false;
+    }
+
+    std::vector<U8> gaps;
+    SpilledBlock spilled;
+    bool ok = true;
+    while (ok == true && fread(&spilled, sizeof(spilled), 1, mBlockFile) == 1) {
+        if (spilled.mPosition != position) {
+            continue;
+        }
+
+        if (index == true) {
+            ok = fwrite(&spilled.mBlock, sizeof(spilled.mBlock), 1, f) == 1;
+        } else if (spilled.mGapLength != 0) {
+            gaps.resize(spilled.mGapLength);
+            ok = fseeko(mGapFile, spilled.mSpillOffset, SEEK_SET) == 0 && fread(&gaps[0], 1, gaps.size(), mGapFile) == gaps.size()
+                 && fwrite(&gaps[0], 1, gaps.size(), f) == gaps.size();
+        }
+    }
+
+    return ok;
+}
+
+bool EdgeFileWriter::Close(U32 sample_rate, U64 sample_count, U64 trigger_sample)
+{
+    if (mBlockFile == NULL || mGapFile == NULL) {
+        return false;
+    }
+
+    U32 channel_count = U32(mChannels.size());
+    for (U32 i = 0; i < channel_count; i++) {
+        if (mChannels[i].mEdgeCount != 0) {
+            mOk = SpillBlock(i) && mOk;
+        }
+    }
+
+    FILE *f = fopen(mFileName.c_str(), "wb");
+    if (f == NULL) {
+        return false;
+    }
+
+    EdgeFileHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.mMagic, EDGE_FILE_MAGIC, sizeof(EDGE_FILE_MAGIC));
+    header.mVersion = EDGE_FILE_VERSION_BLOCKS;
+    header.mChannelCount = channel_count;
+    header.mSampleRate = sample_rate;
+    header.mSampleCount = sample_count;
+    header.mTriggerSample = trigger_sample;
+
+    bool ok = mOk && fwrite(&header, sizeof(header), 1, f) == 1;
+
+    //every channel's index, then its gaps padded to 8 bytes so the next index is aligned.
+    std::vector<U64> padding(channel_count);
+    U64 offset = sizeof(EdgeFileHeader) + U64(channel_count) * sizeof(EdgeFileBlockChannel);
+    for (U32 i = 0; i < channel_count; i++) {
+        WriterChannel &channel = mChannels[i];
+
+        EdgeFileBlockChannel table;
+        table.mChannelIndex = channel.mChannelIndex;
+        table.mInitialBitState = channel.mInitialBitState == BIT_HIGH ? 1 : 0;
+        table.mEdgeCount = channel.mEdgeCount;
+        table.mBlockOffset = offset;
+        offset += ((channel.mEdgeCount + EDGE_FILE_BLOCK_EDGES - 1) / EDGE_FILE_BLOCK_EDGES) * sizeof(EdgeFileBlock);
+        table.mDeltaOffset = offset;
+        table.mDeltaLength = channel.mDeltaLength;
+        padding[i] = (sizeof(U64) - channel.mDeltaLength % sizeof(U64)) % sizeof(U64);
+        offset += channel.mDeltaLength + padding[i];
+        ok = ok && fwrite(&table, sizeof(table), 1, f) == 1;
+    }
+
+    const U8 zeros[sizeof(U64)] = { 0 };
+    for (U32 i = 0; i < channel_count; i++) {
+        ok = ok && CopyChannel(f, i, true) && CopyChannel(f, i, false);
+        ok = ok && fwrite(zeros, 1, padding[i], f) == padding[i];
+    }
+
+    fclose(mBlockFile);
+    fclose(mGapFile);
+    mBlockFile = NULL;
+    mGapFile = NULL;
+
+    return (fclose(f) == 0) && ok;
+}
+
+U64 EdgeFileWriter::GetLastEdge(U32 position)
+{
+    return mChannels[position].mLastEdge;
+}
+
+U64 EdgeFileWriter::GetEdgeCount()
+{
+    U64 edge_count = 0;
+    U32 count = U32(mChannels.size());
+    for (U32 i = 0; i < count; i++) {
+        edge_count += mChannels[i].mEdgeCount;
+    }
+
+    return edge_count;
+}
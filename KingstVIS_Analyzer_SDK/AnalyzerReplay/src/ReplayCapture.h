@@ -0,0 +1,286 @@
+#ifndef REPLAY_CAPTURE_H
+#define REPLAY_CAPTURE_H
+
+#include <LogicPublicTypes.h>
+#include <vector>
+#include <string>
+#include <time.h>
+
+//Edge file layout (little endian, 8 byte aligned so it can be mapped and used in place):
+//  EdgeFileHeader
+//  EdgeFileChannel[mChannelCount]
+//  U64 edge samples, one array per channel, at EdgeFileChannel::mEdgeOffset
+//An edge at sample n means the line has its new level from sample n on.
+//
+//Version 2 (what analyzer-import writes) keeps the header and stores every channel in blocks of
+//EDGE_FILE_BLOCK_EDGES edges instead of one flat array:
+//  EdgeFileHeader
+//  EdgeFileBlockChannel[mChannelCount]
+//  per channel, at mBlockOffset: EdgeFileBlock[ceil(mEdgeCount / EDGE_FILE_BLOCK_EDGES)], the sparse index
+//  per channel, at mDeltaOffset: the gaps from each edge of a block to the next, LEB128 coded, block after block
+//A block's first edge is in the index, so a block decodes on its own and a seek is a binary search of the index.
+//Most gaps fit in one or two bytes, a quarter of the flat array or less.
+
+#define EDGE_FILE_MAGIC "KVEDGES"
+#define EDGE_FILE_VERSION 1
+#define EDGE_FILE_VERSION_BLOCKS 2
+#define EDGE_FILE_BLOCK_EDGES 1024
+
+struct EdgeFileHeader {
+    char mMagic[8];
+    U32 mVersion;
+    U32 mChannelCount;
+    U64 mSampleRate;
+    U64 mSampleCount;
+    U64 mTriggerSample;
+};
+
+struct EdgeFileChannel {
+    U32 mChannelIndex;
+    U32 mInitialBitState;
+    U64 mEdgeCount;
+    U64 mEdgeOffset;
+};
+
+struct EdgeFileBlockChannel {
+    U32 mChannelIndex;
+    U32 mInitialBitState;
+    U64 mEdgeCount;
+    U64 mBlockOffset;
+    U64 mDeltaOffset;
+    U64 mDeltaLength;
+};
+
+struct EdgeFileBlock {
+    U64 mFirstEdge;     //sample of the block's first edge
+    U64 mDeltaOffset;   //of the gaps to its other edges, from the channel's mDeltaOffset
+};
+
+//thrown when an analyzer walks past the end of the capture; the real host blocks (and eventually kills the worker thread) instead.
+struct ReplayEndOfData {
+};
+
+//thrown by CheckIfThreadShouldExit once SetThreadMustExit has been called.
+struct ReplayThreadExit {
+};
+
+//one channel of the capture, as seen by AnalyzerChannelData: either a flat array of edges, or (version 2 files) blocks
+class ChannelData
+{
+public:
+    ChannelData()
+        :   mChannelIndex(0),
+            mInitialBitState(BIT_LOW),
+            mEdges(NULL),
+            mEdgeCount(0),
+            mSampleCount(0),
+            mBlocks(NULL),
+            mDeltas(NULL),
+            mDeltaLength(0)
+    {
+    }
+
+    U64 GetBlockCount() const
+    {
+        return (mEdgeCount + EDGE_FILE_BLOCK_EDGES - 1) / EDGE_FILE_BLOCK_EDGES;
+    }
+
+    U32 mChannelIndex;
+    BitState mInitialBitState;
+    const U64 *mEdges;          //NULL when the channel is in blocks
+    U64 mEdgeCount;
+    U64 mSampleCount;
+
+    const EdgeFileBlock *mBlocks;
+    const U8 *mDeltas;
+    U64 mDeltaLength;
+};
+
+//decodes a block of a channel in blocks into edges, which has room for EDGE_FILE_BLOCK_EDGES; returns the edges
+//decoded, fewer than the block should have if it is damaged.
+LOGICAPI U32 DecodeEdgeBlock(const ChannelData *channel, U64 block, U64 *edges);
+
+//the last block whose first edge is at or before sample_number, searching blocks first_block on; first_block if there is none.
+LOGICAPI U64 FindEdgeBlock(const ChannelData *channel, U64 first_block, U64 sample_number);
+
+//the capture being replayed, handed to Analyzer::Init in place of the host's device collection
+class LOGICAPI DeviceCollection
+{
+public:
+    DeviceCollection();
+    ~DeviceCollection();
+
+    bool Open(const char *file_name);
+    void Close();
+
+    //for captures built in memory (simulation); the edge arrays must outlive the collection
+    void SetCapture(U32 sample_rate, U64 sample_count, U64 trigger_sample);
+    void AddChannel(U32 channel_index, BitState initial_bit_state, const U64 *edges, U64 edge_count);
+    void AddChannel(const ChannelData &channel);    //another channel's edges, under its own channel index
+
+    ChannelData *GetChannelData(U32 channel_index);
+    U32 GetChannelCount();
+    ChannelData *GetChannelDataAt(U32 position);     //channels in the order they were added
+    U32 GetSampleRate();
+    U64 GetSampleCount();
+    U64 GetTriggerSample();
+    U64 GetEdgeCount();
+
+    static bool Save(const char *file_name, U32 sample_rate, U64 sample_count, U64 trigger_sample, std::vector<ChannelData> &channels);
+
+protected:
+    bool OpenBlocks(const U8 *base, const EdgeFileHeader *header);
+
+    U32 mSampleRate;
+    U64 mSampleCount;
+    U64 mTriggerSample;
+    std::vector<ChannelData> mChannels;
+
+    void *mMapping;
+    U64 mMappingLength;
+};
+
+//Writes a version 2 edge file from edges that come in sample order per channel, the channels interleaved any way,
+//in memory that doesn't grow with the capture: finished blocks are spilled to temporary files, and Close puts
+//every channel's index and gaps together behind the header.
+class LOGICAPI EdgeFileWriter
+{
+public:
+    EdgeFileWriter();
+    ~EdgeFileWriter();
+
+    bool Open(const char *file_name);
+    U32 AddChannel(U32 channel_index, BitState initial_bit_state);     //returns the channel's position, for the calls below
+    void SetInitialBitState(U32 position, BitState initial_bit_state);
+    bool AddEdge(U32 position, U64 sample);     //false if the edge is before the channel's last one
+    bool Close(U32 sample_rate, U64 sample_count, U64 trigger_sample);
+
+    U64 GetLastEdge(U32 position);
+    U64 GetEdgeCount();
+
+protected:
+    struct WriterChannel {
+        U32 mChannelIndex;
+        BitState mInitialBitState;
+        U64 mEdgeCount;
+        U64 mLastEdge;
+        U64 mDeltaLength;       //of the blocks spilled so far
+        EdgeFileBlock mBlock;   //the block being filled, mDeltaOffset relative to the channel's gaps
+        std::vector<U8> mGaps;
+    };
+
+    //one spilled block: which channel, where it starts, and where its gaps are in the spill file
+    struct SpilledBlock {
+        U32 mPosition;
+        U32 mGapLength;
+        EdgeFileBlock mBlock;
+        U64 mSpillOffset;
+    };
+
+    bool SpillBlock(U32 position);
+    bool CopyChannel(FILE *f, U32 position, bool index);
+
+    std::string mFileName;
+    std::vector<WriterChannel> mChannels;
+    FILE *mBlockFile;       //SpilledBlock records
+    FILE *mGapFile;         //their gaps
+    U64 mGapFileLength;
+    bool mOk;
+};
+
+//SDK calls the stand-in counts, so the benchmark can see how often an analyzer makes them.
+//The counters are per thread, so analyzers replayed side by side don't share them.
+//The AnalyzerChannelData calls, from ReplayAdvance on, are counted by each AnalyzerChannelData and added to the thread's
+//counters, and to its channel's in GetReplayChannelCallCounts, when it is destroyed: the calls that cost the least are
+//made the most, and a counter of their own keeps the count from costing more than the call.
+enum ReplayCall {
+    ReplayAddFrame,
+    ReplayAddMarker,
+    ReplayCommitPacket,
+    ReplayCommitResults,
+    ReplayReportProgress,
+    ReplayCheckIfThreadShouldExit,
+    ReplayAdvance,
+    ReplayAdvanceToNextEdge,
+    ReplayGetSampleNumber,
+    ReplayGetBitState,
+    ReplayGetSampleOfNextEdge,
+    ReplayWouldAdvanceCauseTransition,
+    ReplayDoMoreTransitionsExist,
+    ReplayCallCount
+};
+
+#define REPLAY_COUNTED_CHANNELS 32  //channel indexes with a call count of their own, as many as a device has
+
+struct ReplayCallCounter {
+    U64 mCalls;
+    U64 mNanoseconds;   //only accumulated while call timing is on
+};
+
+LOGICAPI const char *GetReplayCallName(U32 call);
+LOGICAPI ReplayCallCounter *GetReplayCallCounters();
+LOGICAPI U64 *GetReplayChannelCallCounts();    //AnalyzerChannelData calls of the thread, by channel index
+LOGICAPI void ResetReplayCallCounters();
+LOGICAPI void SetReplayCallTiming(bool enabled);
+LOGICAPI bool GetReplayCallTiming();
+
+//AnalyzerChannelData created from now on walk every edge they move past, the way the stand-in did before its edge
+//cursor, for analyzer-bench to compare the two. The cursor is the default.
+LOGICAPI void SetReplayLinearTraversal(bool enabled);
+LOGICAPI bool GetReplayLinearTraversal();
+
+//counts the call it's declared in, and times it when call timing is on.
+class ReplayCallTimer
+{
+public:
+    ReplayCallTimer(ReplayCall call)
+        :   mCounter(GetReplayCallCounters() + call),
+            mStart(0)
+    {
+        mCounter->mCalls++;
+        if (GetReplayCallTiming() == true) {
+            mStart = Now();
+        }
+    }
+
+    //a counter kept by the caller, with call timing as it was when the caller was made
+    ReplayCallTimer(ReplayCallCounter &counter, bool timing)
+        :   mCounter(&counter),
+            mStart(0)
+    {
+        mCounter->mCalls++;
+        if (timing == true) {
+            mStart = Now();
+        }
+    }
+
+    ~ReplayCallTimer()
+    {
+        if (mStart != 0) {
+            mCounter->mNanoseconds += Now() - mStart;
+        }
+    }
+
+protected:
+    static U64 Now()
+    {
+        struct timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return U64(ts.tv_sec) * 1000000000ull + ts.tv_nsec;
+    }
+
+    ReplayCallCounter *mCounter;
+    U64 mStart;
+};
+
+//what SimulationChannelDescriptor::GetData points at; the simulate command turns it into a capture.
+struct SimulationChannelDescriptorData {
+    Channel mChannel;
+    U32 mSampleRate;
+    BitState mInitialBitState;
+    BitState mCurrentBitState;
+    U64 mCurrentSample;
+    std::vector<U64> mEdges;
+};
+
+#endif //REPLAY_CAPTURE_H
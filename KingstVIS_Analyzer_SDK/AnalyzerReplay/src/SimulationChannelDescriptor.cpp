@@ -0,0 +1,144 @@
+#include <SimulationChannelDescriptor.h>
+#include "ReplayCapture.h"
+
+void SimulationChannelDescriptor::Transition()
+{
+    mData->mCurrentBitState = Toggle(mData->mCurrentBitState);
+    mData->mEdges.push_back(mData->mCurrentSample);
+}
+
+void SimulationChannelDescriptor::TransitionIfNeeded(BitState bit_state)
+{
+    if (mData->mCurrentBitState != bit_state) {
+        Transition();
+    }
+}
+
+void SimulationChannelDescriptor::Advance(U32 num_samples_to_advance)
+{
+    mData->mCurrentSample += num_samples_to_advance;
+}
+
+BitState SimulationChannelDescriptor::GetCurrentBitState()
+{
+    return mData->mCurrentBitState;
+}
+
+U64 SimulationChannelDescriptor::GetCurrentSampleNumber()
+{
+    return mData->mCurrentSample;
+}
+
+SimulationChannelDescriptor::SimulationChannelDescriptor()
+{
+    mData = new SimulationChannelDescriptorData();
+    mData->mSampleRate = 0;
+    mData->mInitialBitState = BIT_LOW;
+    mData->mCurrentBitState = BIT_LOW;
+    mData->mCurrentSample = 0;
+}
+
+SimulationChannelDescriptor::SimulationChannelDescriptor(const SimulationChannelDescriptor &other)
+{
+    mData = new SimulationChannelDescriptorData(*other.mData);
+}
+
+SimulationChannelDescriptor::~SimulationChannelDescriptor()
+{
+    delete mData;
+}
+
+SimulationChannelDescriptor &SimulationChannelDescriptor::operator=(const SimulationChannelDescriptor &other)
+{
+    if (this != &other) {
+        *mData = *other.mData;
+    }
+
+    return *this;
+}
+
+void SimulationChannelDescriptor::SetChannel(Channel &channel)
+{
+    mData->mChannel = channel;
+}
+
+void SimulationChannelDescriptor::SetSampleRate(U32 sample_rate_hz)
+{
+    mData->mSampleRate = sample_rate_hz;
+}
+
+void SimulationChannelDescriptor::SetInitialBitState(BitState intial_bit_state)
+{
+    mData->mInitialBitState = intial_bit_state;
+    mData->mCurrentBitState = intial_bit_state;
+}
+
+Channel SimulationChannelDescriptor::GetChannel()
+{
+    return mData->mChannel;
+}
+
+U32 SimulationChannelDescriptor::GetSampleRate()
+{
+    return mData->mSampleRate;
+}
+
+BitState SimulationChannelDescriptor::GetInitialBitState()
+{
+    return mData->mInitialBitState;
+}
+
+void *SimulationChannelDescriptor::GetData()
+{
+    return mData;
+}
+
+
+//descriptors are handed out by pointer and through GetArray, so they live in one block that never moves.
+#define SIMULATION_MAX_CHANNELS 64
+
+struct SimulationChannelDescriptorGroupData {
+    std::vector<SimulationChannelDescriptor> mChannels;
+};
+
+SimulationChannelDescriptorGroup::SimulationChannelDescriptorGroup()
+{
+    mData = new SimulationChannelDescriptorGroupData();
+    mData->mChannels.reserve(SIMULATION_MAX_CHANNELS);
+}
+
+SimulationChannelDescriptorGroup::~SimulationChannelDescriptorGroup()
+{
+    delete mData;
+}
+
+SimulationChannelDescriptor *SimulationChannelDescriptorGroup::Add(Channel &channel, U32 sample_rate, BitState intial_bit_state)
+{
+    if (mData->mChannels.size() >= SIMULATION_MAX_CHANNELS) {
+        return NULL;
+    }
+
+    mData->mChannels.push_back(SimulationChannelDescriptor());
+    SimulationChannelDescriptor *descriptor = &mData->mChannels.back();
+    descriptor->SetChannel(channel);
+    descriptor->SetSampleRate(sample_rate);
+    descriptor->SetInitialBitState(intial_bit_state);
+    return descriptor;
+}
+
+void SimulationChannelDescriptorGroup::AdvanceAll(U32 num_samples_to_advance)
+{
+    for (U32 i = 0; i < mData->mChannels.size(); i++) {
+        mData->mChannels[i].Advance(num_samples_to_advance);
+    }
+}
+
+SimulationChannelDescriptor *SimulationChannelDescriptorGroup::GetArray()
+{
+    return mData->mChannels.empty() ? NULL : &mData->mChannels[0];
+}
+
+U32 SimulationChannelDescriptorGroup::GetCount()
+{
+    return U32(mData->mChannels.size());
+}
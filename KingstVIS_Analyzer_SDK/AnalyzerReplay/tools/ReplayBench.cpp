@@ -0,0 +1,811 @@
+//analyzer-bench: decoder throughput benchmark for the Qi, Serial and SPI analyzers.
+//
+//  analyzer-bench [--sizes 1e5,1e7,1e9] [--analyzers Qi,QiBaseline,Serial,SPI,SPINoCursor,Cursor]
+//                 [--density sparse,dense] [--traversal indexed,linear] [--threads 1,4,16] [--plugins <dir>] [--output <file>]
+//
+//Each case builds a synthetic capture in memory and decodes it twice in a child process.
+//The first pass, untimed, gives throughput and call counts. The second pass times every SDK call.
+//peak_rss_kb is the child's own high water mark. channel_calls is the AnalyzerChannelData calls made on each channel,
+//by channel index, and channel_calls_total their sum; calls has them by call.
+//--traversal runs every case with AnalyzerChannelData's edge cursor (indexed), and again walking every edge (linear).
+//--threads runs the Qi cases once for every Decode Threads setting listed (default 1); the other analyzers have one thread.
+//Cursor isn't an analyzer: it moves through the lines of the SPI capture with Advance strides of 1/10000 of it,
+//the way Serial and Qi skip a stretch of the line they don't need edge by edge, and nothing else.
+//QiBaseline isn't a plugin: it is the Qi decoder from before edges were pulled in chunks, Qi_bit_cal and cal_diff with
+//their limits scaled to the sample rate, one channel call per cell and a frame, commit and progress report per byte, on
+//the Qi capture. It decodes the same frames as Qi.
+//SPINoCursor is the SPI analyzer built with ANALYZER_NO_EDGE_CURSOR, every channel call going to the host, on the SPI
+//capture. When Qi and QiBaseline both run, the two edges/sec figures of each capture are printed side by side at the end,
+//and when SPI and SPINoCursor do, their channel calls.
+//Results are written as JSON to --output, or stdout.
+
+#include "ReplayTool.h"
+#include <AnalyzerChannelData.h>
+#include <AnalyzerHelpers.h>
+#include <AnalyzerResults.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+struct BenchCase {
+    std::string mAnalyzer;
+    U64 mSamples;
+    bool mDense;
+    bool mLinear;
+    U32 mThreads;           //Qi's Decode Threads
+};
+
+//passed back from the child through a pipe, so plain data only.
+struct BenchResult {
+    bool mValid;
+    U32 mSampleRate;
+    U64 mEdges;
+    U64 mFrames;
+    U64 mPackets;
+    double mSeconds;
+    U64 mPeakRssKb;
+    ReplayCallCounter mCalls[ReplayCallCount];
+    U64 mChannelCalls[REPLAY_COUNTED_CHANNELS];
+};
+
+struct BenchCapture {
+    U32 mSampleRate;
+    std::vector<U32> mChannels;
+    std::vector<BitState> mInitialBitStates;
+    std::vector<std::vector<U64> > mEdges;
+    std::vector<std::string> mSettings;
+};
+
+//one line of a capture being built front to back
+class BenchLine
+{
+public:
+    BenchLine(std::vector<U64> &edges, BitState initial_bit_state)
+        :   mEdges(edges),
+            mBitState(initial_bit_state)
+    {
+    }
+
+    void Set(U64 sample, BitState bit_state)
+    {
+        if (bit_state != mBitState) {
+            mEdges.push_back(sample);
+            mBitState = bit_state;
+        }
+    }
+
+    void Flip(U64 sample)
+    {
+        Set(sample, Invert(mBitState));
+    }
+
+protected:
+    std::vector<U64> &mEdges;
+    BitState mBitState;
+};
+
+static U32 NextRandom(U32 &state)
+{
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+}
+
+static void AddChannel(BenchCapture &capture, U32 channel_index, BitState initial_bit_state)
+{
+    capture.mChannels.push_back(channel_index);
+    capture.mInitialBitStates.push_back(initial_bit_state);
+    capture.mEdges.push_back(std::vector<U64>());
+}
+
+static U32 GetQiMessageSize(U8 header)
+{
+    if (header < 0x20) {
+        return 1;
+    } else if (header < 0x80) {
+        return 2 + (header - 0x20) / 16;
+    } else if (header < 0xE0) {
+        return 8 + (header - 0x80) / 8;
+    }
+
+    return 20 + (header - 0xE0) / 4;
+}
+
+//Qi: 2 kb/s differential bi-phase; 11 preamble ones, then start, 8 data bits lsb first, odd parity and stop per byte.
+static void BuildQiCapture(BenchCapture &capture, U64 samples, bool dense)
+{
+    const U8 headers[] = { 0x01, 0x02, 0x03, 0x05, 0x06, 0x51, 0x71, 0x22 };
+    capture.mSampleRate = dense ? 200000 : 100000000;
+    U64 bit_period = capture.mSampleRate / 2000;
+    U64 idle_bits = dense ? 4 : 40;
+    AddChannel(capture, 0, BIT_LOW);
+    capture.mSettings.push_back("Data=0");
+
+    BenchLine line(capture.mEdges[0], BIT_LOW);
+    U32 random = 0x1234567;
+    U64 sample = bit_period * 8;
+    for (U32 packet = 0;; packet++) {
+        std::vector<U8> bytes;
+        bytes.push_back(headers[packet % sizeof(headers)]);
+        U32 message_size = GetQiMessageSize(bytes[0]);
+        U8 checksum = bytes[0];
+        for (U32 i = 0; i < message_size; i++) {
+            bytes.push_back(U8(NextRandom(random)));
+            checksum ^= bytes.back();
+        }
+        bytes.push_back(checksum);
+
+        std::vector<bool> bits(11, true);
+        for (U32 i = 0; i < bytes.size(); i++) {
+            bits.push_back(false);
+            U32 ones = 0;
+            for (U32 j = 0; j < 8; j++) {
+                bool bit = ((bytes[i] >> j) & 0x1) != 0;
+                ones += bit ? 1 : 0;
+                bits.push_back(bit);
+            }
+            bits.push_back((ones & 0x1) == 0);
+            bits.push_back(true);
+        }
+
+        if (sample + (bits.size() + idle_bits) * bit_period >= samples) {
+            break;
+        }
+
+        for (U32 i = 0; i < bits.size(); i++) {
+            line.Flip(sample);
+            if (bits[i] == true) {
+                line.Flip(sample + bit_period / 2);
+            }
+            sample += bit_period;
+        }
+        line.Flip(sample);
+        sample += idle_bits * bit_period;
+    }
+
+    //an edge after the last idle gap, which a decoder may look for before it gives up the last byte
+    line.Flip(sample);
+}
+
+//Serial: 8N1, idle high, lsb first.
+static void BuildSerialCapture(BenchCapture &capture, U64 samples, bool dense)
+{
+    capture.mSampleRate = 100000000;
+    U64 bit_period = dense ? 32 : 868;
+    U64 idle_bits = dense ? 0 : 20;
+    AddChannel(capture, 0, BIT_HIGH);
+
+    char bit_rate[64];
+    snprintf(bit_rate, sizeof(bit_rate), "Bit Rate (Bits/s)=%u", U32(capture.mSampleRate / bit_period));
+    capture.mSettings.push_back("Data=0");
+    capture.mSettings.push_back(bit_rate);
+
+    BenchLine line(capture.mEdges[0], BIT_HIGH);
+    U32 random = 0x2345678;
+    U64 sample = bit_period * 16;
+    while (sample + (10 + idle_bits) * bit_period < samples) {
+        U32 value = NextRandom(random) & 0xFF;
+        U32 frame = (value << 1) | (1 << 9);
+        for (U32 i = 0; i < 10; i++) {
+            line.Set(sample, ((frame >> i) & 0x1) ? BIT_HIGH : BIT_LOW);
+            sample += bit_period;
+        }
+        sample += idle_bits * bit_period;
+    }
+}
+
+//SPI: the analyzer's defaults (CPOL = 1, CPHA = 1, msb first, enable active low).
+//Data changes on the falling clock edge and is sampled on the rising one.
+static void BuildSpiCapture(BenchCapture &capture, U64 samples, bool dense)
+{
+    capture.mSampleRate = 100000000;
+    U64 half_period = dense ? 16 : 500;
+    U32 bytes_per_transfer = dense ? 256 : 4;
+    U64 gap = (dense ? 8 : 200) * half_period * 2;
+
+    AddChannel(capture, 0, BIT_LOW);
+    AddChannel(capture, 1, BIT_LOW);
+    AddChannel(capture, 2, BIT_HIGH);
+    AddChannel(capture, 3, BIT_HIGH);
+    capture.mSettings.push_back("MOSI=0");
+    capture.mSettings.push_back("MISO=1");
+    capture.mSettings.push_back("Clock=2");
+    capture.mSettings.push_back("Enable=3");
+
+    BenchLine mosi(capture.mEdges[0], BIT_LOW);
+    BenchLine miso(capture.mEdges[1], BIT_LOW);
+    BenchLine clock(capture.mEdges[2], BIT_HIGH);
+    BenchLine enable(capture.mEdges[3], BIT_HIGH);
+
+    U32 random = 0x3456789;
+    U64 transfer_length = bytes_per_transfer * 8 * half_period * 2 + half_period * 4;
+    U64 sample = gap;
+    while (sample + transfer_length + gap < samples) {
+        enable.Set(sample, BIT_LOW);
+        sample += half_period * 2;
+
+        for (U32 i = 0; i < bytes_per_transfer; i++) {
+            U32 random_value = NextRandom(random);
+            for (S32 bit = 7; bit >= 0; bit--) {
+                clock.Set(sample, BIT_LOW);
+                mosi.Set(sample, ((random_value >> bit) & 0x1) ? BIT_HIGH : BIT_LOW);
+                miso.Set(sample, ((random_value >> (bit + 8)) & 0x1) ? BIT_HIGH : BIT_LOW);
+                sample += half_period;
+                clock.Set(sample, BIT_HIGH);
+                sample += half_period;
+            }
+        }
+
+        sample += half_period * 2;
+        enable.Set(sample, BIT_HIGH);
+        sample += gap;
+    }
+}
+
+static bool BuildCapture(const BenchCase &bench_case, BenchCapture &capture)
+{
+    if (bench_case.mAnalyzer == "Qi") {
+        BuildQiCapture(capture, bench_case.mSamples, bench_case.mDense);
+        capture.mSettings.push_back("Decode Threads=" + std::to_string(bench_case.mThreads));
+    } else if (bench_case.mAnalyzer == "QiBaseline") {
+        BuildQiCapture(capture, bench_case.mSamples, bench_case.mDense);
+    } else if (bench_case.mAnalyzer == "Serial") {
+        BuildSerialCapture(capture, bench_case.mSamples, bench_case.mDense);
+    } else if (bench_case.mAnalyzer == "SPI" || bench_case.mAnalyzer == "SPINoCursor" || bench_case.mAnalyzer == "Cursor") {
+        BuildSpiCapture(capture, bench_case.mSamples, bench_case.mDense);
+    } else {
+        return false;
+    }
+
+    return true;
+}
+
+static bool DecodeOnce(ReplayPlugin &plugin, BenchCapture &capture, DeviceCollection &device_collection, BenchResult &result)
+{
+    Analyzer *analyzer = plugin.CreateAnalyzer();
+    if (ApplySettings(analyzer->GetAnalyzerSettings(), capture.mSettings) == false) {
+        plugin.DestroyAnalyzer(analyzer);
+        return false;
+    }
+
+    analyzer->Init(&device_collection, NULL, NULL);
+    analyzer->SetupResults();
+
+    ResetReplayCallCounters();
+    double start = GetTimeS();
+    analyzer->StartProcessing();
+    result.mSeconds = GetTimeS() - start;
+
+    AnalyzerResults *results;
+    if (analyzer->GetAnalyzerResults(&results) == true) {
+        result.mFrames = results->GetNumFrames();
+        result.mPackets = results->GetNumPackets();
+    }
+
+    plugin.DestroyAnalyzer(analyzer);
+    return true;
+}
+
+static void StrideOnce(DeviceCollection &device_collection, BenchResult &result)
+{
+    U32 stride = U32(device_collection.GetSampleCount() / 10000) + 1;
+
+    ResetReplayCallCounters();
+    double start = GetTimeS();
+    for (U32 i = 0; i < device_collection.GetChannelCount(); i++) {
+        AnalyzerChannelData line(device_collection.GetChannelDataAt(i));
+        try {
+            for (;;) {
+                line.Advance(stride);
+            }
+        } catch (ReplayEndOfData &) {
+        }
+    }
+    result.mSeconds = GetTimeS() - start;
+}
+
+//holds the markers and frames of QiBaseline, which has no analyzer plugin of its own.
+class BenchMarkerResults : public AnalyzerResults
+{
+public:
+    virtual void GenerateBubbleText(U64 /*frame_index*/, Channel & /*channel*/, DisplayBase /*display_base*/) {}
+    virtual void GenerateExportFile(const char * /*file*/, DisplayBase /*display_base*/, U32 /*export_type_user_id*/) {}
+    virtual void GenerateFrameTabularText(U64 /*frame_index*/, DisplayBase /*display_base*/) {}
+    virtual void GeneratePacketTabularText(U64 /*packet_id*/, DisplayBase /*display_base*/) {}
+    virtual void GenerateTransactionTabularText(U64 /*transaction_id*/, DisplayBase /*display_base*/) {}
+};
+
+//The Qi decoder as it was before edges were pulled in chunks: cal_diff, Qi_bit_cal and the WorkerThread loop,
+//with the Windows types made plain and the settings at the analyzer's defaults (8 bits, lsb first, not inverted).
+//Its cell limits were sample counts for 100 MHz; they are scaled to the capture's sample rate, and are the same there.
+class BenchQiBaseline : public Analyzer
+{
+public:
+    BenchQiBaseline(const Channel &channel)
+        :   mInputChannel(channel)
+    {
+        SetAnalyzerResults(&mResults);
+    }
+
+    virtual ~BenchQiBaseline()
+    {
+        KillThread();
+    }
+
+    virtual void WorkerThread()
+    {
+        U64 sample_rate = GetSampleRate();
+        mHalfCellMin = 23000 * sample_rate / 100000000;
+        mHalfCellMax = 27000 * sample_rate / 100000000;
+        mFullCellMin = 47000 * sample_rate / 100000000;
+        mFullCellMax = 53000 * sample_rate / 100000000;
+        U64 idle_gap = 80000 * sample_rate / 100000000;
+        U32 num_bits = 8;
+        bool should_detect_preamble = true;
+
+        mQi = GetAnalyzerChannelData(mInputChannel);
+        mQi->TrackMinimumPulseWidth();
+
+        //find start data frame
+        for (;;) {
+            if (mQi->GetBitState() == BIT_HIGH) {
+                mQi->AdvanceToNextEdge();
+            }
+
+            U64 frame_starting_pos = mQi->GetSampleNumber();
+            mQi->AdvanceToNextEdge();
+            if (mQi->GetSampleNumber() - frame_starting_pos > idle_gap) {
+                break;
+            }
+        }
+
+        for (;;) {
+            U64 frame_starting_sample = mQi->GetSampleNumber();
+            U64 data = 0;
+
+            DataBuilder data_builder;
+            data_builder.Reset(&data, AnalyzerEnums::LsbFirst, num_bits);
+
+            if (should_detect_preamble == true) {
+                for (int i = 0; i < 25; i++) {
+                    if (BitCal() == 0) {
+                        break;
+                    }
+                }
+            }
+
+            for (U32 i = 0; i < num_bits; i++) {
+                data_builder.AddBit((BitCal() != 0) ? BIT_HIGH : BIT_LOW);
+            }
+
+            //parity and stop bits
+            BitCal();
+            BitCal();
+
+            if (mQi->GetSampleOfNextEdge() - mQi->GetSampleNumber() > idle_gap) {
+                should_detect_preamble = true;
+            } else {
+                should_detect_preamble = false;
+                BitCal();
+            }
+
+            Frame frame;
+            frame.mStartingSampleInclusive = frame_starting_sample;
+            frame.mEndingSampleInclusive = mQi->GetSampleNumber();
+            frame.mData1 = data;
+            frame.mFlags = 0;
+
+            mResults.AddFrame(frame);
+            mResults.CommitResults();
+
+            ReportProgress(frame.mEndingSampleInclusive);
+            CheckIfThreadShouldExit();
+        }
+    }
+
+    virtual U32 GenerateSimulationData(U64 /*newest_sample_requested*/, U32 /*sample_rate*/, SimulationChannelDescriptor ** /*simulation_channels*/)
+    {
+        return 0;
+    }
+
+    virtual U32 GetMinimumSampleRateHz()
+    {
+        return 0;
+    }
+
+    virtual const char *GetAnalyzerName() const
+    {
+        return "QiBaseline";
+    }
+
+    virtual bool NeedsRerun()
+    {
+        return false;
+    }
+
+protected:
+    //cal_diff: 1 for a half cell, 0 for a full one, -1 for anything else.
+    int ClassifyCell(U64 cnt1, U64 cnt2)
+    {
+        U64 dif = (cnt1 > cnt2) ? cnt1 - cnt2 : cnt2 - cnt1;
+        if (dif < mHalfCellMax && dif > mHalfCellMin) {
+            return 1;
+        } else if (dif < mFullCellMax && dif > mFullCellMin) {
+            return 0;
+        }
+        return -1;
+    }
+
+    //Qi_bit_cal: one bit cell, a marker on its last edge.
+    int BitCal()
+    {
+        U64 frame_cnt1 = mQi->GetSampleNumber();
+        mQi->AdvanceToNextEdge();
+        U64 frame_cnt2 = mQi->GetSampleNumber();
+        if (ClassifyCell(frame_cnt1, frame_cnt2) == 0) {
+            mResults.AddMarker(frame_cnt2, AnalyzerResults::Dot, mInputChannel);
+            return 0;
+        } else if (ClassifyCell(frame_cnt1, frame_cnt2) == 1) {
+            frame_cnt1 = mQi->GetSampleNumber();
+            mQi->AdvanceToNextEdge();
+            frame_cnt2 = mQi->GetSampleNumber();
+            if (ClassifyCell(frame_cnt1, frame_cnt2) == 1) {
+                mResults.AddMarker(frame_cnt2, AnalyzerResults::Dot, mInputChannel);
+                return 1;
+            }
+        }
+
+        mResults.AddMarker(frame_cnt2, AnalyzerResults::Dot, mInputChannel);
+        return -1;
+    }
+
+    Channel mInputChannel;
+    BenchMarkerResults mResults;
+    AnalyzerChannelData *mQi;
+    U64 mHalfCellMin;
+    U64 mHalfCellMax;
+    U64 mFullCellMin;
+    U64 mFullCellMax;
+};
+
+static void DecodeQiBaselineOnce(BenchCapture &capture, DeviceCollection &device_collection, BenchResult &result)
+{
+    BenchQiBaseline analyzer(Channel(0, capture.mChannels[0]));
+    analyzer.Init(&device_collection, NULL, NULL);
+
+    ResetReplayCallCounters();
+    double start = GetTimeS();
+    analyzer.StartProcessing();
+    result.mSeconds = GetTimeS() - start;
+
+    AnalyzerResults *results;
+    if (analyzer.GetAnalyzerResults(&results) == true) {
+        result.mFrames = results->GetNumFrames();
+        result.mPackets = results->GetNumPackets();
+    }
+}
+
+static bool RunOnce(const BenchCase &bench_case, ReplayPlugin &plugin, BenchCapture &capture, DeviceCollection &device_collection, BenchResult &result)
+{
+    if (bench_case.mAnalyzer == "Cursor") {
+        StrideOnce(device_collection, result);
+        return true;
+    } else if (bench_case.mAnalyzer == "QiBaseline") {
+        DecodeQiBaselineOnce(capture, device_collection, result);
+        return true;
+    }
+
+    return DecodeOnce(plugin, capture, device_collection, result);
+}
+
+static void RunCase(const BenchCase &bench_case, const std::string &plugin_directory, BenchResult &result)
+{
+    memset(&result, 0, sizeof(result));
+
+    BenchCapture capture;
+    if (BuildCapture(bench_case, capture) == false) {
+        return;
+    }
+
+    DeviceCollection device_collection;
+    device_collection.SetCapture(capture.mSampleRate, bench_case.mSamples, 0);
+    for (U32 i = 0; i < capture.mChannels.size(); i++) {
+        std::vector<U64> &edges = capture.mEdges[i];
+        device_collection.AddChannel(capture.mChannels[i], capture.mInitialBitStates[i], edges.empty() ? NULL : &edges[0], edges.size());
+    }
+
+    ReplayPlugin plugin;
+    std::string plugin_file = plugin_directory + "/lib" + bench_case.mAnalyzer + ".so";
+    if (bench_case.mAnalyzer != "Cursor" && bench_case.mAnalyzer != "QiBaseline" && plugin.Load(plugin_file.c_str()) == false) {
+        return;
+    }
+
+    result.mSampleRate = capture.mSampleRate;
+    result.mEdges = device_collection.GetEdgeCount();
+
+    SetReplayLinearTraversal(bench_case.mLinear);
+
+    //untimed pass: throughput and call counts.
+    SetReplayCallTiming(false);
+    if (RunOnce(bench_case, plugin, capture, device_collection, result) == false) {
+        return;
+    }
+    memcpy(result.mCalls, GetReplayCallCounters(), sizeof(result.mCalls));
+    memcpy(result.mChannelCalls, GetReplayChannelCallCounts(), sizeof(result.mChannelCalls));
+
+    //timed pass: per call cost.
+    BenchResult timed_result = result;
+    SetReplayCallTiming(true);
+    if (RunOnce(bench_case, plugin, capture, device_collection, timed_result) == false) {
+        return;
+    }
+    SetReplayCallTiming(false);
+
+    ReplayCallCounter *timed_calls = GetReplayCallCounters();
+    for (U32 i = 0; i < ReplayCallCount; i++) {
+        result.mCalls[i].mNanoseconds = timed_calls[i].mNanoseconds;
+    }
+
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    result.mPeakRssKb = usage.ru_maxrss;
+    result.mValid = true;
+}
+
+//each case runs in its own process so peak RSS is per case, and a crash only loses that case.
+static void RunCaseInChild(const BenchCase &bench_case, const std::string &plugin_directory, BenchResult &result)
+{
+    memset(&result, 0, sizeof(result));
+    fflush(NULL);
+
+    int fds[2];
+    if (pipe(fds) != 0) {
+        return;
+    }
+
+    pid_t pid = fork();
+    if (pid == 0) {
+        close(fds[0]);
+        BenchResult child_result;
+        RunCase(bench_case, plugin_directory, child_result);
+        ssize_t written = write(fds[1], &child_result, sizeof(child_result));
+        _exit(written == ssize_t(sizeof(child_result)) ? 0 : 1);
+    }
+
+    close(fds[1]);
+    if (pid > 0) {
+        size_t received = 0;
+        while (received < sizeof(result)) {
+            ssize_t count = read(fds[0], (char *)&result + received, sizeof(result) - received);
+            if (count <= 0) {
+                break;
+            }
+            received += count;
+        }
+
+        if (received != sizeof(result)) {
+            memset(&result, 0, sizeof(result));
+        }
+
+        int status;
+        waitpid(pid, &status, 0);
+    }
+    close(fds[0]);
+}
+
+static U64 GetChannelCallTotal(const BenchResult &result)
+{
+    U64 total = 0;
+    for (U32 i = 0; i < REPLAY_COUNTED_CHANNELS; i++) {
+        total += result.mChannelCalls[i];
+    }
+    return total;
+}
+
+static void WriteResult(FILE *f, const BenchCase &bench_case, const BenchResult &result, bool last)
+{
+    fprintf(f, "    {\"analyzer\": \"%s\", \"samples\": %llu, \"density\": \"%s\", \"traversal\": \"%s\", \"threads\": %u, \"valid\": %s",
+            bench_case.mAnalyzer.c_str(), bench_case.mSamples, bench_case.mDense ? "dense" : "sparse", bench_case.mLinear ? "linear" : "indexed",
+            bench_case.mThreads, result.mValid ? "true" : "false");
+
+    if (result.mValid == true) {
+        double seconds = result.mSeconds > 0.0 ? result.mSeconds : 1e-9;
+        fprintf(f, ",\n     \"sample_rate\": %u, \"edges\": %llu, \"frames\": %llu, \"packets\": %llu, \"seconds\": %.6f,\n",
+                result.mSampleRate, result.mEdges, result.mFrames, result.mPackets, result.mSeconds);
+        fprintf(f, "     \"edges_per_second\": %.0f, \"frames_per_second\": %.0f, \"commits_per_second\": %.0f, \"peak_rss_kb\": %llu,\n",
+                result.mEdges / seconds, result.mFrames / seconds, result.mCalls[ReplayCommitResults].mCalls / seconds, result.mPeakRssKb);
+        fprintf(f, "     \"calls\": {");
+        for (U32 i = 0; i < ReplayCallCount; i++) {
+            const ReplayCallCounter &counter = result.mCalls[i];
+            double ns_per_call = counter.mCalls != 0 ? double(counter.mNanoseconds) / double(counter.mCalls) : 0.0;
+            fprintf(f, "%s\n       \"%s\": {\"count\": %llu, \"ns_per_call\": %.1f}", (i == 0) ? "" : ",",
+                    GetReplayCallName(i), counter.mCalls, ns_per_call);
+        }
+        fprintf(f, "},\n");
+
+        fprintf(f, "     \"channel_calls\": {");
+        bool first_channel = true;
+        for (U32 i = 0; i < REPLAY_COUNTED_CHANNELS; i++) {
+            if (result.mChannelCalls[i] != 0) {
+                fprintf(f, "%s\"%u\": %llu", first_channel ? "" : ", ", i, result.mChannelCalls[i]);
+                first_channel = false;
+            }
+        }
+        fprintf(f, "}, \"channel_calls_total\": %llu", GetChannelCallTotal(result));
+    }
+
+    fprintf(f, "}%s\n", last ? "" : ",");
+}
+
+static void SplitList(const char *text, std::vector<std::string> &items)
+{
+    items.clear();
+    std::string list = text;
+    size_t start = 0;
+    while (start <= list.size()) {
+        size_t comma = list.find(',', start);
+        if (comma == std::string::npos) {
+            comma = list.size();
+        }
+        if (comma > start) {
+            items.push_back(list.substr(start, comma - start));
+        }
+        start = comma + 1;
+    }
+}
+
+//the chunked Qi decode against the baseline one, on each capture both ran on.
+static void CompareQiDecodes(const std::vector<BenchCase> &cases, const std::vector<BenchResult> &results)
+{
+    for (U32 i = 0; i < cases.size(); i++) {
+        if (cases[i].mAnalyzer != "QiBaseline" || results[i].mValid == false) {
+            continue;
+        }
+
+        for (U32 j = 0; j < cases.size(); j++) {
+            if (cases[j].mAnalyzer != "Qi" || results[j].mValid == false || cases[j].mSamples != cases[i].mSamples ||
+                    cases[j].mDense != cases[i].mDense || cases[j].mLinear != cases[i].mLinear || cases[j].mThreads != 1) {
+                continue;
+            }
+
+            double baseline = results[i].mSeconds > 0.0 ? results[i].mEdges / results[i].mSeconds / 1e6 : 0.0;
+            double chunked = results[j].mSeconds > 0.0 ? results[j].mEdges / results[j].mSeconds / 1e6 : 0.0;
+            fprintf(stderr, "Qi        %6s %-7s %.0e samples: %10llu edges, baseline %7.1f Medges/s, chunked %7.1f Medges/s\n",
+                    cases[i].mDense ? "dense" : "sparse", cases[i].mLinear ? "linear" : "indexed", double(cases[i].mSamples),
+                    results[i].mEdges, baseline, chunked);
+        }
+    }
+}
+
+//the SPI analyzer's channel calls without its edge cursor and with it, on each capture both ran on.
+static void CompareSpiCursors(const std::vector<BenchCase> &cases, const std::vector<BenchResult> &results)
+{
+    for (U32 i = 0; i < cases.size(); i++) {
+        if (cases[i].mAnalyzer != "SPINoCursor" || results[i].mValid == false) {
+            continue;
+        }
+
+        for (U32 j = 0; j < cases.size(); j++) {
+            if (cases[j].mAnalyzer != "SPI" || results[j].mValid == false || cases[j].mSamples != cases[i].mSamples ||
+                    cases[j].mDense != cases[i].mDense || cases[j].mLinear != cases[i].mLinear) {
+                continue;
+            }
+
+            fprintf(stderr, "SPI       %6s %-7s %.0e samples: %10llu channel calls without the cursor, %10llu with it, %7.3f s and %7.3f s\n",
+                    cases[i].mDense ? "dense" : "sparse", cases[i].mLinear ? "linear" : "indexed", double(cases[i].mSamples),
+                    GetChannelCallTotal(results[i]), GetChannelCallTotal(results[j]), results[i].mSeconds, results[j].mSeconds);
+        }
+    }
+}
+
+static void Usage()
+{
+    fprintf(stderr, "usage: analyzer-bench [--sizes 1e5,1e7,1e9] [--analyzers Qi,QiBaseline,Serial,SPI,SPINoCursor,Cursor]\n");
+    fprintf(stderr, "                      [--density sparse,dense] [--traversal indexed,linear] [--threads 1,4,16]\n");
+    fprintf(stderr, "                      [--plugins dir] [--output file]\n");
+}
+
+int main(int argc, char *argv[])
+{
+    std::vector<std::string> sizes;
+    std::vector<std::string> analyzers;
+    std::vector<std::string> densities;
+    std::vector<std::string> traversals;
+    std::vector<std::string> thread_counts;
+    SplitList("1e5,1e7,1e9", sizes);
+    SplitList("Qi,QiBaseline,Serial,SPI,SPINoCursor,Cursor", analyzers);
+    SplitList("sparse,dense", densities);
+    SplitList("indexed,linear", traversals);
+    SplitList("1", thread_counts);
+    std::string plugin_directory = ".";
+    std::string output_file;
+
+    for (int i = 1; i < argc; i++) {
+        std::string option = argv[i];
+        if (i + 1 >= argc) {
+            Usage();
+            return 2;
+        }
+
+        const char *value = argv[++i];
+        if (option == "--sizes") {
+            SplitList(value, sizes);
+        } else if (option == "--analyzers") {
+            SplitList(value, analyzers);
+        } else if (option == "--density") {
+            SplitList(value, densities);
+        } else if (option == "--traversal") {
+            SplitList(value, traversals);
+        } else if (option == "--threads") {
+            SplitList(value, thread_counts);
+        } else if (option == "--plugins") {
+            plugin_directory = value;
+        } else if (option == "--output") {
+            output_file = value;
+        } else {
+            Usage();
+            return 2;
+        }
+    }
+
+    std::vector<BenchCase> cases;
+    for (U32 a = 0; a < analyzers.size(); a++) {
+        for (U32 s = 0; s < sizes.size(); s++) {
+            for (U32 d = 0; d < densities.size(); d++) {
+                for (U32 t = 0; t < traversals.size(); t++) {
+                    U32 thread_case_count = (analyzers[a] == "Qi") ? U32(thread_counts.size()) : 1;
+                    for (U32 n = 0; n < thread_case_count; n++) {
+                        BenchCase bench_case;
+                        bench_case.mAnalyzer = analyzers[a];
+                        bench_case.mSamples = U64(strtod(sizes[s].c_str(), NULL));
+                        bench_case.mDense = densities[d] == "dense";
+                        bench_case.mLinear = traversals[t] == "linear";
+                        bench_case.mThreads = (analyzers[a] == "Qi") ? U32(strtoul(thread_counts[n].c_str(), NULL, 0)) : 1;
+                        cases.push_back(bench_case);
+                    }
+                }
+            }
+        }
+    }
+
+    FILE *f = output_file.empty() ? stdout : fopen(output_file.c_str(), "w");
+    if (f == NULL) {
+        fprintf(stderr, "unable to open %s\n", output_file.c_str());
+        return 1;
+    }
+
+    bool all_valid = true;
+    std::vector<BenchResult> results(cases.size());
+    fprintf(f, "{\"benchmark\": \"analyzer-bench\", \"cases\": [\n");
+    for (U32 i = 0; i < cases.size(); i++) {
+        BenchResult &result = results[i];
+        RunCaseInChild(cases[i], plugin_directory, result);
+        WriteResult(f, cases[i], result, i + 1 == cases.size());
+        fflush(f);
+
+        if (result.mValid == true) {
+            fprintf(stderr, "%-9s %6s %-7s %2u threads %.0e samples: %10llu frames %8.3f s %7.1f Medges/s %8llu KB\n",
+                    cases[i].mAnalyzer.c_str(), cases[i].mDense ? "dense" : "sparse", cases[i].mLinear ? "linear" : "indexed", cases[i].mThreads,
+                    double(cases[i].mSamples), result.mFrames, result.mSeconds, result.mSeconds > 0.0 ? result.mEdges / result.mSeconds / 1e6 : 0.0, result.mPeakRssKb);
+        } else {
+            fprintf(stderr, "%-9s %6s %-7s %.0e samples: failed\n", cases[i].mAnalyzer.c_str(), cases[i].mDense ? "dense" : "sparse",
+                    cases[i].mLinear ? "linear" : "indexed", double(cases[i].mSamples));
+            all_valid = false;
+        }
+    }
+    fprintf(f, "]}\n");
+    CompareQiDecodes(cases, results);
+    CompareSpiCursors(cases, results);
+
+    if (f != stdout) {
+        fclose(f);
+    }
+
+    return all_valid ? 0 : 1;
+}
@@ -0,0 +1,708 @@
+//analyzer-fuzz: round trip of the Qi, Serial and SPI simulation generators through their own decoders.
+//
+//  analyzer-fuzz [--runs 30] [--seed 1] [--frames 20000] [--analyzers Qi,Serial,SPI] [--plugins <dir>] [--output <file>]
+//
+//Every run picks random settings for one analyzer (bit order, bits per transfer, parity, inversion, CPOL/CPHA,
+//rates, ...), has the analyzer simulate a capture of at least --frames frames, decodes that capture with a second
+//analyzer of the same plugin and checks the frames against what the generator sends with those settings.
+//Run i uses seed --seed + i and the analyzers in turn; a failing run is printed with the options that repeat it alone.
+//Simulation and decode are timed, so the JSON written to --output tracks throughput along with correctness.
+//Each run is in its own process, so a crash only fails that run.
+
+#include "ReplayTool.h"
+#include <AnalyzerResults.h>
+#include <QiAnalyzerResults.h>
+#include <QiSimulationDataGenerator.h>
+#include <SerialAnalyzerResults.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+struct FuzzRun {
+    std::string mAnalyzer;
+    U32 mSeed;
+    U64 mFrames;
+    U32 mSampleRate;
+    U64 mSamples;
+    std::vector<std::string> mSettings;
+
+    //what the checks need to know of the settings
+    U32 mBitsPerTransfer;
+    bool mMpMode;
+    bool mUseMosi;
+    bool mUseMiso;
+    bool mJitter;
+};
+
+//passed back from the child through a pipe, so plain data only.
+struct FuzzResult {
+    bool mCompleted;
+    bool mPassed;
+    U64 mEdges;
+    U64 mFrames;
+    double mSimulateSeconds;
+    double mDecodeSeconds;
+    char mError[256];
+};
+
+static U32 NextRandom(U32 &state)
+{
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+}
+
+static U32 RandomBelow(U32 &state, U32 count)
+{
+    return NextRandom(state) % count;
+}
+
+static void AddSetting(FuzzRun &run, const char *name, const std::string &value)
+{
+    run.mSettings.push_back(std::string(name) + "=" + value);
+}
+
+static void AddSetting(FuzzRun &run, const char *name, S64 value)
+{
+    AddSetting(run, name, std::to_string(value));
+}
+
+static U64 GetMask(U32 bits)
+{
+    return (bits >= 64) ? 0xFFFFFFFFFFFFFFFFull : ((1ull << bits) - 1);
+}
+
+//Serial: in this SDK a bit lasts half a period of the bit rate's clock, see ClockGenerator.
+static void RandomizeSerialRun(FuzzRun &run, U32 &random)
+{
+    const U32 bit_rates[] = { 300, 1200, 9600, 19200, 57600, 115200, 230400, 460800, 921600, 1000000, 3000000 };
+    const char *stop_bits[] = { "1", "1.5", "2" };
+    const double stop_bit_lengths[] = { 1.0, 1.5, 2.0 };
+    const char *parities[] = { "No Parity Bit (Standard)", "Even Parity Bit", "Odd Parity Bit" };
+    const char *shift_orders[] = { "Least Significant Bit Sent First (Standard)", "Most Significant Bit Sent First" };
+    const char *modes[] = { "None", "MP Mode: Address indicated by MSB=0", "MDB Mode: Address indicated by MSB=1" };
+
+    U32 bit_rate = bit_rates[RandomBelow(random, sizeof(bit_rates) / sizeof(bit_rates[0]))];
+    U32 samples_per_bit = 4 + RandomBelow(random, 37);
+    //MP mode has no parity, and the generator's addresses 1 and 2 need two bits.
+    U32 mode = RandomBelow(random, 3);
+    U32 bits = (mode == 0) ? 1 + RandomBelow(random, 64) : 2 + RandomBelow(random, 62);
+    U32 stop = RandomBelow(random, 3);
+    U32 parity = (mode == 0) ? RandomBelow(random, 3) : 0;
+
+    run.mSampleRate = bit_rate * 2 * samples_per_bit;
+    run.mBitsPerTransfer = bits;
+    run.mMpMode = mode != 0;
+
+    AddSetting(run, "Data", 0);
+    AddSetting(run, "Bit Rate (Bits/s)", bit_rate);
+    AddSetting(run, "Specify if the serial signal is inverted", RandomBelow(random, 2));
+    AddSetting(run, "Select the number of bits per frame", bits);
+    AddSetting(run, "Specify the number of stop bits.", stop_bits[stop]);
+    AddSetting(run, "Specify None, Even, or Odd Parity.", parities[parity]);
+    AddSetting(run, "Select if the most significant bit or least significant bit is transmitted first", shift_orders[RandomBelow(random, 2)]);
+    AddSetting(run, "Special Mode", modes[mode]);
+
+    //normal: a frame and 10 bits of idle; MP: an address and 4 data frames, with 2 bits between them and 20 after, twice.
+    double frame_bits = 1 + bits + (run.mMpMode ? 1 : 0) + (parity != 0 ? 1 : 0) + stop_bit_lengths[stop];
+    double group_bits = run.mMpMode ? frame_bits * 10 + 56 : frame_bits + 10;
+    U64 groups = (run.mFrames + (run.mMpMode ? 9 : 0)) / (run.mMpMode ? 10 : 1) + 2;
+    run.mSamples = U64((10 + groups * group_bits) * samples_per_bit);
+}
+
+static bool CheckSerialFrames(const FuzzRun &run, AnalyzerResults *results, char *error, U32 error_size)
+{
+    U64 mask = GetMask(run.mBitsPerTransfer);
+    U64 value = 0;
+    for (U64 i = 0; i < run.mFrames; i++) {
+        Frame frame = results->GetFrame(i);
+
+        //MP mode: address 1, four data frames, address 2, four data frames.
+        U64 expected;
+        bool address = run.mMpMode && (i % 5) == 0;
+        if (address == true) {
+            expected = ((i / 5) % 2 == 0) ? 1 : 2;
+        } else {
+            expected = value++ & mask;
+        }
+
+        if ((frame.mFlags & DISPLAY_AS_ERROR_FLAG) != 0 || frame.mData1 != expected ||
+                ((frame.mFlags & MP_MODE_ADDRESS_FLAG) != 0) != address) {
+            snprintf(error, error_size, "frame %llu at sample %lld: 0x%llX flags 0x%02X, expected 0x%llX%s", i,
+                     frame.mStartingSampleInclusive, frame.mData1, frame.mFlags, expected, address ? " (address)" : "");
+            return false;
+        }
+    }
+
+    return true;
+}
+
+//SPI: the generator clocks a bit every 100 samples whatever the sample rate; 4 words per enable,
+//each followed by 200 samples, and 2000 samples of idle after every transaction.
+static void RandomizeSpiRun(FuzzRun &run, U32 &random)
+{
+    const U32 sample_rates[] = { 1000000, 10000000, 50000000, 100000000 };
+    const char *shift_orders[] = { "Most Significant Bit First (Standard)", "Least Significant Bit First" };
+    const char *clock_states[] = { "Clock is Low when inactive (CPOL = 0)", "Clock is High when inactive (CPOL = 1)" };
+    const char *valid_edges[] = { "Data is Valid on Clock Leading Edge (CPHA = 0)", "Data is Valid on Clock Trailing Edge (CPHA = 1)" };
+    const char *enable_states[] = { "Enable line is Active Low (Standard)", "Enable line is Active High" };
+
+    U32 bits = 1 + RandomBelow(random, 64);
+    U32 lines = 1 + RandomBelow(random, 3);
+    run.mSampleRate = sample_rates[RandomBelow(random, sizeof(sample_rates) / sizeof(sample_rates[0]))];
+    run.mBitsPerTransfer = bits;
+    run.mUseMosi = (lines & 0x1) != 0;
+    run.mUseMiso = (lines & 0x2) != 0;
+
+    AddSetting(run, "MOSI", run.mUseMosi ? "0" : "none");
+    AddSetting(run, "MISO", run.mUseMiso ? "1" : "none");
+    AddSetting(run, "Clock", 2);
+    AddSetting(run, "Enable", (RandomBelow(random, 4) != 0) ? "3" : "none");
+    AddSetting(run, "#4", shift_orders[RandomBelow(random, 2)]);
+    AddSetting(run, "#5", bits);
+    AddSetting(run, "#6", clock_states[RandomBelow(random, 2)]);
+    AddSetting(run, "#7", valid_edges[RandomBelow(random, 2)]);
+    AddSetting(run, "#8", enable_states[RandomBelow(random, 2)]);
+
+    U64 transaction_samples = 200 + 4 * (bits * 100 + 200) + 2000;
+    run.mSamples = 1000 + ((run.mFrames + 3) / 4 + 2) * transaction_samples;
+}
+
+static bool CheckSpiFrames(const FuzzRun &run, AnalyzerResults *results, char *error, U32 error_size)
+{
+    //word i is i on MOSI and i + 1 on MISO.
+    U64 mask = GetMask(run.mBitsPerTransfer);
+    for (U64 i = 0; i < run.mFrames; i++) {
+        Frame frame = results->GetFrame(i);
+        bool mosi_good = run.mUseMosi == false || frame.mData1 == (i & mask);
+        bool miso_good = run.mUseMiso == false || frame.mData2 == ((i + 1) & mask);
+        if ((frame.mFlags & DISPLAY_AS_ERROR_FLAG) != 0 || mosi_good == false || miso_good == false) {
+            snprintf(error, error_size, "frame %llu at sample %lld: MOSI 0x%llX MISO 0x%llX flags 0x%02X, expected 0x%llX 0x%llX", i,
+                     frame.mStartingSampleInclusive, frame.mData1, frame.mData2, frame.mFlags, i & mask, (i + 1) & mask);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+//Qi: about 3 frames per packet, a preamble, 11 bits per byte and 20 ms of silence after each; every 200
+//control errors the transmitter is off for half a second.
+static void RandomizeQiRun(FuzzRun &run, U32 &random)
+{
+    const char *marker_modes[] = { "None", "Packet boundaries", "Errors only", "All" };
+
+    U32 bit_rate = 1000 + RandomBelow(random, 3001);
+    bool autobaud = RandomBelow(random, 2) != 0;
+    S32 deviation = autobaud ? S32(RandomBelow(random, 301)) - 150 : S32(RandomBelow(random, 41)) - 20;
+    U32 jitter = RandomBelow(random, 3);
+    run.mSampleRate = bit_rate * (64 + RandomBelow(random, 2000));
+    run.mBitsPerTransfer = 8;
+    run.mJitter = jitter != 0;
+
+    AddSetting(run, "Data", 0);
+    AddSetting(run, "Bit Rate (Bits/s)", bit_rate);
+    AddSetting(run, "Autobaud", autobaud ? 1 : 0);
+    AddSetting(run, "Decode Threads", 1 + RandomBelow(random, 4));
+    AddSetting(run, "Markers", marker_modes[RandomBelow(random, 4)]);
+    AddSetting(run, "Simulated Bit Rate Offset (0.1%)", deviation);
+    AddSetting(run, "Simulated Jitter (%)", jitter);
+
+    //a glitch filter well below the half cell must not change anything.
+    if (RandomBelow(random, 2) != 0) {
+        AddSetting(run, "Glitch Filter (ns)", U64(1000000000) / (U64(bit_rate) * 2 * 10));
+    }
+
+    double simulated_bit_rate = bit_rate * (1000 + deviation) / 1000.0;
+    double packet_seconds = (QI_SIM_PREAMBLE_BITS + 3 * 11) / simulated_bit_rate + QI_SIM_CONTROL_GAP_MS / 1000.0;
+    double session_seconds = (QI_SIM_CONTROL_ERRORS + QI_SIM_CONTROL_ERRORS / QI_SIM_RECEIVED_POWER_INTERVAL) * packet_seconds + 0.6;
+    double seconds = (run.mFrames / 3.0) * packet_seconds * (1.0 + 0.6 / session_seconds) * 1.2 + 1.0;
+    run.mSamples = U64(seconds * run.mSampleRate);
+}
+
+//Qi: a replay of QiSimulationDataGenerator::BuildNextPacket. The payloads come from the same xorshift32 as
+//the jitter, which takes one draw per edge, so with jitter on the edges of every packet are skipped as well.
+struct QiPacketReplay {
+    U32 mRandom;
+    bool mJitter;
+    U32 mBitsPerByte;
+    QiSimulationPhase mPhase;
+    U32 mSession;
+    U32 mControlErrors;
+    S32 mControlError;
+    U8 mReceivedPower;
+};
+
+static void StartQiPacketReplay(QiPacketReplay &replay, const FuzzRun &run)
+{
+    replay.mRandom = QI_SIM_RANDOM_SEED;
+    replay.mJitter = run.mJitter;
+    replay.mBitsPerByte = run.mBitsPerTransfer;
+    replay.mPhase = QiSimPing;
+    replay.mSession = 0;
+    replay.mControlErrors = 0;
+    replay.mControlError = 0;
+    replay.mReceivedPower = 0;
+}
+
+//bi-phase: one edge per bit and one more per one; start bit, data bits, odd parity and stop bit.
+static U32 GetQiByteEdges(const QiPacketReplay &replay, U8 value)
+{
+    U32 ones = 0;
+    for (U32 i = 0; i < 8 && i < replay.mBitsPerByte; i++) {
+        ones += (value >> i) & 0x1;
+    }
+
+    U32 parity = ((ones & 0x1) == 0) ? 1 : 0;
+    return 1 + replay.mBitsPerByte + ones + 1 + parity + 2;
+}
+
+static U32 ReplayNextQiPacket(QiPacketReplay &replay, U8 *packet)
+{
+    U32 size = 0;
+
+    switch (replay.mPhase) {
+    case QiSimPing:
+        packet[size++] = 0x01;
+        packet[size++] = U8(0x80 + (NextRandom(replay.mRandom) & 0x3F));
+        replay.mPhase = QiSimIdentification;
+        break;
+
+    case QiSimIdentification:
+        packet[size++] = 0x71;
+        packet[size++] = 0x12;
+        packet[size++] = 0x00;
+        packet[size++] = 0x2A;
+        packet[size++] = U8((replay.mSession >> 24) & 0x7F);
+        packet[size++] = U8(replay.mSession >> 16);
+        packet[size++] = U8(replay.mSession >> 8);
+        packet[size++] = U8(replay.mSession);
+        replay.mPhase = QiSimConfiguration;
+        break;
+
+    case QiSimConfiguration:
+        packet[size++] = 0x51;
+        packet[size++] = 0x0A;
+        packet[size++] = 0x00;
+        packet[size++] = 0x00;
+        packet[size++] = 0x41;
+        packet[size++] = 0x00;
+        replay.mControlErrors = 0;
+        replay.mControlError = 40 + S32(NextRandom(replay.mRandom) % 40);
+        replay.mPhase = QiSimPowerTransfer;
+        break;
+
+    case QiSimPowerTransfer:
+        if (replay.mControlErrors != 0 && (replay.mControlErrors % QI_SIM_RECEIVED_POWER_INTERVAL) == 0 && replay.mReceivedPower != 0) {
+            packet[size++] = 0x04;
+            packet[size++] = replay.mReceivedPower;
+            replay.mReceivedPower = 0;
+            break;
+        }
+
+        packet[size++] = 0x03;
+        packet[size++] = U8(S8(replay.mControlError));
+
+        replay.mControlError -= replay.mControlError / 4;
+        replay.mControlError += S32(NextRandom(replay.mRandom) % 5) - 2;
+        if (replay.mControlError > 127) {
+            replay.mControlError = 127;
+        } else if (replay.mControlError < -128) {
+            replay.mControlError = -128;
+        }
+
+        if (++replay.mControlErrors == QI_SIM_CONTROL_ERRORS) {
+            replay.mPhase = QiSimEndPowerTransfer;
+        } else if ((replay.mControlErrors % QI_SIM_RECEIVED_POWER_INTERVAL) == 0) {
+            replay.mReceivedPower = U8(96 - replay.mControlError / 2 + S32(NextRandom(replay.mRandom) & 0x3));
+        }
+        break;
+
+    case QiSimEndPowerTransfer:
+    default:
+        packet[size++] = 0x02;
+        packet[size++] = 0x01;
+        replay.mSession++;
+        replay.mPhase = QiSimPing;
+        break;
+    }
+
+    U8 checksum = 0;
+    for (U32 i = 0; i < size; i++) {
+        checksum ^= packet[i];
+    }
+    packet[size++] = checksum;
+
+    if (replay.mJitter == true) {
+        U32 edges = QI_SIM_PREAMBLE_BITS * 2;
+        for (U32 i = 0; i < size; i++) {
+            edges += GetQiByteEdges(replay, packet[i]);
+        }
+        for (U32 i = 0; i < edges; i++) {
+            NextRandom(replay.mRandom);
+        }
+    }
+
+    return size;
+}
+
+static bool CheckQiPackets(const FuzzRun &run, AnalyzerResults *results, char *error, U32 error_size)
+{
+    QiPacketReplay replay;
+    StartQiPacketReplay(replay, run);
+
+    U64 frames = 0;
+    U64 packet_count = results->GetNumPackets();
+    for (U64 packet = 0; frames < run.mFrames; packet++) {
+        if (packet >= packet_count) {
+            snprintf(error, error_size, "%llu packets, %llu frames, expected at least %llu frames", packet_count, frames, run.mFrames);
+            return false;
+        }
+
+        U64 first_frame;
+        U64 last_frame;
+        results->GetFramesContainedInPacket(packet, &first_frame, &last_frame);
+
+        U8 expected[QI_SIM_MAX_PACKET_BYTES];
+        U32 expected_frames = ReplayNextQiPacket(replay, expected);
+        bool good = last_frame - first_frame + 1 == expected_frames &&
+                    QiAnalyzerResults::GetMessageSize(expected[0]) + 2 == expected_frames;
+        U32 bad_byte = 0;
+        for (U64 i = first_frame; i <= last_frame && good == true; i++) {
+            Frame frame = results->GetFrame(i);
+            U32 type = QI_FRAME_TYPE(frame.mType);
+            U32 expected_type = (i == first_frame) ? QiHeaderFrame : (i == last_frame) ? QiChecksumFrame : QiMessageFrame;
+            bad_byte = U32(i - first_frame);
+            good = (frame.mFlags & DISPLAY_AS_ERROR_FLAG) == 0 && type == expected_type && frame.mData1 == expected[bad_byte];
+        }
+
+        if (good == false) {
+            Frame frame = results->GetFrame(first_frame + bad_byte);
+            snprintf(error, error_size, "packet %llu at sample %lld: %llu frames, byte %u 0x%02llX flags 0x%02X, expected header 0x%02X, %u frames, byte 0x%02X, no errors",
+                     packet, frame.mStartingSampleInclusive, last_frame - first_frame + 1, bad_byte, frame.mData1, frame.mFlags,
+                     expected[0], expected_frames, expected[bad_byte]);
+            return false;
+        }
+
+        frames += expected_frames;
+    }
+
+    return true;
+}
+
+static bool RandomizeRun(FuzzRun &run)
+{
+    U32 random = run.mSeed * 2654435761u + 0x9E3779B9u;
+    if (random == 0) {
+        random = 1;
+    }
+
+    if (run.mAnalyzer == "Qi") {
+        RandomizeQiRun(run, random);
+    } else if (run.mAnalyzer == "Serial") {
+        RandomizeSerialRun(run, random);
+    } else if (run.mAnalyzer == "SPI") {
+        RandomizeSpiRun(run, random);
+    } else {
+        return false;
+    }
+
+    return true;
+}
+
+static bool CheckFrames(const FuzzRun &run, AnalyzerResults *results, char *error, U32 error_size)
+{
+    if (run.mAnalyzer != "Qi" && results->GetNumFrames() < run.mFrames) {
+        snprintf(error, error_size, "%llu frames, expected at least %llu", results->GetNumFrames(), run.mFrames);
+        return false;
+    }
+
+    if (run.mAnalyzer == "Qi") {
+        return CheckQiPackets(run, results, error, error_size);
+    } else if (run.mAnalyzer == "Serial") {
+        return CheckSerialFrames(run, results, error, error_size);
+    }
+
+    return CheckSpiFrames(run, results, error, error_size);
+}
+
+//the simulation is asked for in slices, the way the GUI does, and its edges are copied out before the analyzer goes.
+static bool Simulate(ReplayPlugin &plugin, const FuzzRun &run, std::vector<ChannelData> &channels, std::vector<std::vector<U64> > &edges)
+{
+    Analyzer *analyzer = plugin.CreateAnalyzer();
+    if (ApplySettings(analyzer->GetAnalyzerSettings(), run.mSettings) == false) {
+        plugin.DestroyAnalyzer(analyzer);
+        return false;
+    }
+
+    DeviceCollection capture;
+    capture.SetCapture(run.mSampleRate, run.mSamples, 0);
+    analyzer->Init(&capture, NULL, NULL);
+
+    SimulationChannelDescriptor *simulation_channels = NULL;
+    U32 channel_count = 0;
+    U64 slice = run.mSampleRate / 100 + 1;
+    for (U64 requested = 0; requested < run.mSamples;) {
+        requested += slice;
+        if (requested > run.mSamples) {
+            requested = run.mSamples;
+        }
+        channel_count = analyzer->GenerateSimulationData(requested, run.mSampleRate, &simulation_channels);
+    }
+
+    edges.resize(channel_count);
+    for (U32 i = 0; i < channel_count; i++) {
+        SimulationChannelDescriptorData *data = (SimulationChannelDescriptorData *)simulation_channels[i].GetData();
+        for (U64 j = 0; j < data->mEdges.size() && data->mEdges[j] < run.mSamples; j++) {
+            edges[i].push_back(data->mEdges[j]);
+        }
+
+        ChannelData channel;
+        channel.mChannelIndex = data->mChannel.mChannelIndex;
+        channel.mInitialBitState = data->mInitialBitState;
+        channel.mEdges = NULL;
+        channel.mEdgeCount = edges[i].size();
+        channel.mSampleCount = run.mSamples;
+        channels.push_back(channel);
+    }
+
+    plugin.DestroyAnalyzer(analyzer);
+    return true;
+}
+
+static void RunFuzz(const FuzzRun &run, const std::string &plugin_directory, FuzzResult &result)
+{
+    memset(&result, 0, sizeof(result));
+
+    ReplayPlugin plugin;
+    std::string plugin_file = plugin_directory + "/lib" + run.mAnalyzer + ".so";
+    if (plugin.Load(plugin_file.c_str()) == false) {
+        snprintf(result.mError, sizeof(result.mError), "unable to load %s", plugin_file.c_str());
+        return;
+    }
+
+    std::vector<ChannelData> channels;
+    std::vector<std::vector<U64> > edges;
+    double start = GetTimeS();
+    if (Simulate(plugin, run, channels, edges) == false) {
+        snprintf(result.mError, sizeof(result.mError), "settings rejected");
+        return;
+    }
+    result.mSimulateSeconds = GetTimeS() - start;
+
+    DeviceCollection capture;
+    capture.SetCapture(run.mSampleRate, run.mSamples, 0);
+    for (U32 i = 0; i < channels.size(); i++) {
+        capture.AddChannel(channels[i].mChannelIndex, channels[i].mInitialBitState, edges[i].empty() ? NULL : &edges[i][0], edges[i].size());
+    }
+    result.mEdges = capture.GetEdgeCount();
+
+    Analyzer *analyzer = plugin.CreateAnalyzer();
+    if (ApplySettings(analyzer->GetAnalyzerSettings(), run.mSettings) == true) {
+        analyzer->Init(&capture, NULL, NULL);
+        analyzer->SetupResults();
+
+        start = GetTimeS();
+        analyzer->StartProcessing();
+        result.mDecodeSeconds = GetTimeS() - start;
+
+        AnalyzerResults *results;
+        if (analyzer->GetAnalyzerResults(&results) == true) {
+            result.mFrames = results->GetNumFrames();
+            result.mPassed = CheckFrames(run, results, result.mError, sizeof(result.mError));
+        } else {
+            snprintf(result.mError, sizeof(result.mError), "analyzer produced no results");
+        }
+    }
+    plugin.DestroyAnalyzer(analyzer);
+
+    result.mCompleted = true;
+}
+
+static void RunFuzzInChild(const FuzzRun &run, const std::string &plugin_directory, FuzzResult &result)
+{
+    memset(&result, 0, sizeof(result));
+    snprintf(result.mError, sizeof(result.mError), "crashed");
+    fflush(NULL);
+
+    int fds[2];
+    if (pipe(fds) != 0) {
+        return;
+    }
+
+    pid_t pid = fork();
+    if (pid == 0) {
+        close(fds[0]);
+        FuzzResult child_result;
+        RunFuzz(run, plugin_directory, child_result);
+        ssize_t written = write(fds[1], &child_result, sizeof(child_result));
+        _exit(written == ssize_t(sizeof(child_result)) ? 0 : 1);
+    }
+
+    close(fds[1]);
+    if (pid > 0) {
+        FuzzResult child_result;
+        size_t received = 0;
+        while (received < sizeof(child_result)) {
+            ssize_t count = read(fds[0], (char *)&child_result + received, sizeof(child_result) - received);
+            if (count <= 0) {
+                break;
+            }
+            received += count;
+        }
+
+        if (received == sizeof(child_result)) {
+            result = child_result;
+        }
+
+        int status;
+        waitpid(pid, &status, 0);
+    }
+    close(fds[0]);
+}
+
+static void WriteSettings(FILE *f, const FuzzRun &run, const char *separator, bool quoted)
+{
+    for (U32 i = 0; i < run.mSettings.size(); i++) {
+        fprintf(f, "%s%s%s%s", (i == 0) ? "" : separator, quoted ? "\"" : "", run.mSettings[i].c_str(), quoted ? "\"" : "");
+    }
+}
+
+static void WriteResult(FILE *f, const FuzzRun &run, const FuzzResult &result, bool last)
+{
+    double decode_seconds = result.mDecodeSeconds > 0.0 ? result.mDecodeSeconds : 1e-9;
+    fprintf(f, "    {\"analyzer\": \"%s\", \"seed\": %u, \"passed\": %s, \"sample_rate\": %u, \"samples\": %llu,\n",
+            run.mAnalyzer.c_str(), run.mSeed, result.mPassed ? "true" : "false", run.mSampleRate, run.mSamples);
+    fprintf(f, "     \"edges\": %llu, \"frames\": %llu, \"simulate_seconds\": %.6f, \"decode_seconds\": %.6f, \"frames_per_second\": %.0f,\n",
+            result.mEdges, result.mFrames, result.mSimulateSeconds, result.mDecodeSeconds, result.mFrames / decode_seconds);
+    fprintf(f, "     \"settings\": [");
+    WriteSettings(f, run, ", ", true);
+    fprintf(f, "]");
+    if (result.mPassed == false) {
+        fprintf(f, ",\n     \"error\": \"%s\"", result.mError);
+    }
+    fprintf(f, "}%s\n", last ? "" : ",");
+}
+
+static void SplitList(const char *text, std::vector<std::string> &items)
+{
+    items.clear();
+    std::string list = text;
+    size_t start = 0;
+    while (start <= list.size()) {
+        size_t comma = list.find(',', start);
+        if (comma == std::string::npos) {
+            comma = list.size();
+        }
+        if (comma > start) {
+            items.push_back(list.substr(start, comma - start));
+        }
+        start = comma + 1;
+    }
+}
+
+static void Usage()
+{
+    fprintf(stderr, "usage: analyzer-fuzz [--runs n] [--seed n] [--frames n] [--analyzers Qi,Serial,SPI]\n");
+    fprintf(stderr, "                     [--plugins dir] [--output file]\n");
+}
+
+int main(int argc, char *argv[])
+{
+    U32 runs = 30;
+    U32 seed = 1;
+    U64 frames = 20000;
+    std::vector<std::string> analyzers;
+    SplitList("Qi,Serial,SPI", analyzers);
+    std::string plugin_directory = ".";
+    std::string output_file;
+
+    for (int i = 1; i < argc; i++) {
+        std::string option = argv[i];
+        if (i + 1 >= argc) {
+            Usage();
+            return 2;
+        }
+
+        const char *value = argv[++i];
+        if (option == "--runs") {
+            runs = U32(strtoul(value, NULL, 10));
+        } else if (option == "--seed") {
+            seed = U32(strtoul(value, NULL, 10));
+        } else if (option == "--frames") {
+            frames = U64(strtod(value, NULL));
+        } else if (option == "--analyzers") {
+            SplitList(value, analyzers);
+        } else if (option == "--plugins") {
+            plugin_directory = value;
+        } else if (option == "--output") {
+            output_file = value;
+        } else {
+            Usage();
+            return 2;
+        }
+    }
+
+    if (analyzers.empty() == true || frames == 0) {
+        Usage();
+        return 2;
+    }
+
+    FILE *f = output_file.empty() ? stdout : fopen(output_file.c_str(), "w");
+    if (f == NULL) {
+        fprintf(stderr, "unable to open %s\n", output_file.c_str());
+        return 1;
+    }
+
+    U32 failures = 0;
+    U64 total_frames = 0;
+    double total_seconds = 0.0;
+    fprintf(f, "{\"benchmark\": \"analyzer-fuzz\", \"runs\": [\n");
+    for (U32 i = 0; i < runs; i++) {
+        FuzzRun run;
+        run.mAnalyzer = analyzers[i % analyzers.size()];
+        run.mSeed = seed + i;
+        run.mFrames = frames;
+        run.mBitsPerTransfer = 8;
+        run.mMpMode = false;
+        run.mUseMosi = false;
+        run.mUseMiso = false;
+        run.mJitter = false;
+
+        FuzzResult result;
+        if (RandomizeRun(run) == false) {
+            memset(&result, 0, sizeof(result));
+            snprintf(result.mError, sizeof(result.mError), "no such analyzer");
+        } else {
+            RunFuzzInChild(run, plugin_directory, result);
+        }
+        WriteResult(f, run, result, i + 1 == runs);
+        fflush(f);
+
+        total_frames += result.mFrames;
+        total_seconds += result.mSimulateSeconds + result.mDecodeSeconds;
+        fprintf(stderr, "%-6s seed %6u: %10llu frames, simulate %7.3f s, decode %7.3f s, %6.2f Mframes/s  %s\n", run.mAnalyzer.c_str(),
+                run.mSeed, result.mFrames, result.mSimulateSeconds, result.mDecodeSeconds,
+                result.mDecodeSeconds > 0.0 ? result.mFrames / result.mDecodeSeconds / 1e6 : 0.0, result.mPassed ? "ok" : "FAILED");
+
+        if (result.mPassed == false) {
+            failures++;
+            fprintf(stderr, "    %s\n    settings: ", result.mError);
+            WriteSettings(stderr, run, " ", true);
+            fprintf(stderr, "\n    repeat with: --analyzers %s --seed %u --runs 1 --frames %llu\n", run.mAnalyzer.c_str(), run.mSeed, frames);
+        }
+    }
+    fprintf(f, "]}\n");
+
+    if (f != stdout) {
+        fclose(f);
+    }
+
+    fprintf(stderr, "%u runs, %u failed, %llu frames in %.3f s\n", runs, failures, total_frames, total_seconds);
+    return failures != 0 ? 1 : 0;
+}
@@ -0,0 +1,832 @@
+//analyzer-import: turn a capture recorded elsewhere into an edge file analyzer-replay can decode.
+//
+//  analyzer-import <capture> <capture.edges> [--format vcd|sr|csv|edges] [--rate <Hz>]
+//
+//  vcd     value change dump, from a simulator. Every 1 bit wire or reg is a channel, in the order declared;
+//          x and z read as low, vectors and reals are left out. The sample rate is one sample per time unit
+//          unless --rate says otherwise.
+//  sr      sigrok session (a zip of a metadata file and logic-1-n chunks). Probe n is channel n - 1.
+//  csv     KingstVIS export of raw channels: a header row, then a time column in seconds (or sample numbers, if
+//          the header says "Sample") and a 0 or 1 column per channel, one row per sample or per change.
+//          Channel n is the column headed "Channel n", or the n-th channel column. Seconds need --rate.
+//  edges   another edge file, to put a flat one in blocks.
+//The format comes from the file's extension unless --format is given.
+//
+//The edge file written is version 2 (see ReplayCapture.h): every channel delta coded in blocks of 1024 edges with
+//an index of the blocks, so AnalyzerChannelData seeks with a binary search. The input is read once, front to back,
+//and the memory used doesn't grow with the capture. Pulses shorter than a sample are dropped.
+
+#include "ReplayTool.h"
+#include <zlib.h>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#define IMPORT_BUFFER_SIZE ( 1 << 16 )
+
+struct ImportCapture {
+    U32 mSampleRate;
+    U64 mSampleCount;
+    U64 mTriggerSample;
+};
+
+//one line of the capture being imported. A pulse shorter than a sample comes out as two changes on the same sample;
+//the edge waits for the next change of its line so the two can cancel out.
+class ImportLine
+{
+public:
+    ImportLine(EdgeFileWriter &writer, U32 channel_index)
+        :   mWriter(&writer),
+            mPosition(writer.AddChannel(channel_index, BIT_LOW)),
+            mHaveLevel(false),
+            mLevel(BIT_LOW),
+            mPending(false),
+            mPendingSample(0)
+    {
+    }
+
+    //false if sample is before the line's last change.
+    bool Set(U64 sample, BitState level)
+    {
+        if (mHaveLevel == false) {
+            //the line is taken to have had its first level from the start.
+            mWriter->SetInitialBitState(mPosition, level);
+            mHaveLevel = true;
+            mLevel = level;
+            return true;
+        }
+
+        if (level == mLevel) {
+            return true;
+        }
+        mLevel = level;
+
+        if (mPending == true) {
+            if (sample == mPendingSample) {
+                mPending = false;
+                return true;
+            }
+            if (sample < mPendingSample || mWriter->AddEdge(mPosition, mPendingSample) == false) {
+                return false;
+            }
+        }
+
+        mPending = true;
+        mPendingSample = sample;
+        return true;
+    }
+
+    bool Finish()
+    {
+        if (mPending == true) {
+            mPending = false;
+            return mWriter->AddEdge(mPosition, mPendingSample);
+        }
+        return true;
+    }
+
+protected:
+    EdgeFileWriter *mWriter;
+    U32 mPosition;
+    bool mHaveLevel;
+    BitState mLevel;
+    bool mPending;
+    U64 mPendingSample;
+};
+
+static bool FinishLines(std::vector<ImportLine> &lines)
+{
+    for (U32 i = 0; i < lines.size(); i++) {
+        if (lines[i].Finish() == false) {
+            return false;
+        }
+    }
+    return true;
+}
+
+//VCD
+
+static bool ReadToken(FILE *in, std::string &token)
+{
+    token.clear();
+
+    int c = getc_unlocked(in);
+    while (c == ' ' || c == '\t' || c == '\r' || c == '\n') {
+        c = getc_unlocked(in);
+    }
+    while (c != EOF && c != ' ' && c != '\t' && c != '\r' && c != '\n') {
+        token.push_back(char(c));
+        c = getc_unlocked(in);
+    }
+
+    return token.empty() == false;
+}
+
+static bool SkipToEnd(FILE *in, std::string &token)
+{
+    while (ReadToken(in, token) == true) {
+        if (token == "$end") {
+            return true;
+        }
+    }
+    return false;
+}
+
+//"1ns", or "10 us" split over two tokens; in femtoseconds.
+static bool ParseTimescale(const std::string &text, U64 &timescale_fs)
+{
+    const char *units[] = { "s", "ms", "us", "ns", "ps", "fs" };
+    const U64 femtoseconds[] = { 1000000000000000ull, 1000000000000ull, 1000000000ull, 1000000ull, 1000ull, 1ull };
+
+    char *unit;
+    U64 count = strtoull(text.c_str(), &unit, 10);
+    for (U32 i = 0; i < 6; i++) {
+        if (count != 0 && strcmp(unit, units[i]) == 0) {
+            timescale_fs = count * femtoseconds[i];
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool ImportVcd(FILE *in, EdgeFileWriter &writer, U32 rate, ImportCapture &capture)
+{
+    std::unordered_map<std::string, U32> lines_by_id;
+    std::vector<ImportLine> lines;
+    U32 vectors = 0;
+    U64 timescale_fs = 1000000;
+    std::string token;
+
+    for (;;) {
+        if (ReadToken(in, token) == false) {
+            fprintf(stderr, "no $enddefinitions\n");
+            return false;
+        }
+
+        if (token == "$enddefinitions") {
+            SkipToEnd(in, token);
+            break;
+        } else if (token == "$timescale") {
+            std::string text;
+            while (ReadToken(in, token) == true && token != "$end") {
+                text += token;
+            }
+            if (ParseTimescale(text, timescale_fs) == false) {
+                fprintf(stderr, "unknown timescale %s\n", text.c_str());
+                return false;
+            }
+        } else if (token == "$var") {
+            std::string type;
+            std::string width;
+            std::string id;
+            if (ReadToken(in, type) == false || ReadToken(in, width) == false || ReadToken(in, id) == false) {
+                return false;
+            }
+
+            if (width != "1") {
+                vectors++;
+            } else if (lines_by_id.find(id) == lines_by_id.end()) {
+                //the same id in another scope is the same signal.
+                lines_by_id[id] = U32(lines.size());
+                lines.push_back(ImportLine(writer, U32(lines.size())));
+            }
+            SkipToEnd(in, token);
+        } else if (token[0] == '$') {
+            //$scope, $upscope, $date, $version, $comment: nothing a channel needs
+            SkipToEnd(in, token);
+        }
+    }
+
+    if (vectors != 0) {
+        fprintf(stderr, "left out %u vector and real variables\n", vectors);
+    }
+
+    if (rate == 0) {
+        if (1000000000000000ull / timescale_fs > 0xFFFFFFFFull) {
+            fprintf(stderr, "the timescale is finer than the largest sample rate, set --rate\n");
+            return false;
+        }
+        rate = U32(1000000000000000ull / timescale_fs);
+    }
+
+    //time units to samples, rounded to the nearest one
+    unsigned __int128 scale = (unsigned __int128)timescale_fs * rate;
+    const unsigned __int128 femtoseconds = 1000000000000000ull;
+
+    U64 time = 0;
+    U64 sample = 0;
+    bool dump_off = false;
+    while (ReadToken(in, token) == true) {
+        char c = token[0];
+        if (c == '#') {
+            U64 next_time = strtoull(token.c_str() + 1, NULL, 10);
+            if (next_time < time) {
+                fprintf(stderr, "time #%llu goes back\n", next_time);
+                return false;
+            }
+            time = next_time;
+            sample = U64((time * scale + femtoseconds / 2) / femtoseconds);
+        } else if (c == '0' || c == '1' || c == 'x' || c == 'X' || c == 'z' || c == 'Z') {
+            if (dump_off == true) {
+                continue;
+            }
+
+            std::unordered_map<std::string, U32>::iterator line = lines_by_id.find(token.substr(1));
+            if (line != lines_by_id.end() && lines[line->second].Set(sample, c == '1' ? BIT_HIGH : BIT_LOW) == false) {
+                fprintf(stderr, "time #%llu goes back\n", time);
+                return false;
+            }
+        } else if (c == 'b' || c == 'B' || c == 'r' || c == 'R') {
+            ReadToken(in, token);
+        } else if (token == "$dumpoff") {
+            //every variable reads x until $end; that's not a change of the line.
+            dump_off = true;
+        } else if (token == "$end") {
+            dump_off = false;
+        } else if (token == "$comment") {
+            SkipToEnd(in, token);
+        }
+    }
+
+    capture.mSampleRate = rate;
+    capture.mSampleCount = sample + 1;
+    capture.mTriggerSample = 0;
+    return FinishLines(lines);
+}
+
+//CSV
+
+static void SplitCsv(const char *line, std::vector<std::string> &fields)
+{
+    fields.clear();
+    std::string field;
+    for (const char *c = line;; c++) {
+        if (*c == ',' || *c == '\0' || *c == '\r' || *c == '\n') {
+            //trimmed of spaces and quotes
+            size_t first = field.find_first_not_of(" \t\"");
+            size_t last = field.find_last_not_of(" \t\"");
+            fields.push_back(first == std::string::npos ? std::string() : field.substr(first, last - first + 1));
+            field.clear();
+            if (*c != ',') {
+                break;
+            }
+        } else {
+            field.push_back(*c);
+        }
+    }
+}
+
+static bool ImportCsv(FILE *in, EdgeFileWriter &writer, U32 rate, ImportCapture &capture)
+{
+    char *line = NULL;
+    size_t line_size = 0;
+    std::vector<std::string> fields;
+
+    if (getline(&line, &line_size, in) < 0) {
+        fprintf(stderr, "empty file\n");
+        free(line);
+        return false;
+    }
+
+    SplitCsv(line, fields);
+    std::string time_title = fields[0];
+    std::transform(time_title.begin(), time_title.end(), time_title.begin(), ::tolower);
+    bool sample_numbers = time_title.find("sample") != std::string::npos;
+    if (sample_numbers == false && rate == 0) {
+        fprintf(stderr, "the time column is in seconds, set --rate\n");
+        free(line);
+        return false;
+    }
+
+    std::vector<ImportLine> lines;
+    for (U32 i = 1; i < fields.size(); i++) {
+        //"Channel 3" is channel 3; a title without a number takes the column's place.
+        size_t digits = fields[i].find_last_not_of("0123456789");
+        U32 channel_index = i - 1;
+        if (digits != std::string::npos && digits + 1 < fields[i].size()) {
+            channel_index = U32(strtoul(fields[i].c_str() + digits + 1, NULL, 10));
+        }
+        lines.push_back(ImportLine(writer, channel_index));
+    }
+
+    bool ok = true;
+    bool first_row = true;
+    double first_time = 0.0;
+    U64 sample = 0;
+    U64 row = 1;
+    while (ok == true && getline(&line, &line_size, in) >= 0) {
+        row++;
+        SplitCsv(line, fields);
+        if (fields.size() == 1 && fields[0].empty() == true) {
+            continue;
+        }
+        if (fields.size() != lines.size() + 1) {
+            fprintf(stderr, "row %llu has %u columns, the header has %u\n", row, U32(fields.size()), U32(lines.size() + 1));
+            ok = false;
+            break;
+        }
+
+        if (sample_numbers == true) {
+            sample = strtoull(fields[0].c_str(), NULL, 10);
+        } else {
+            //samples count from the first row; a first row before the trigger (negative time) puts the trigger in the capture.
+            double time = strtod(fields[0].c_str(), NULL);
+            if (first_row == true) {
+                first_time = time;
+            }
+            sample = U64(llround((time - first_time) * rate));
+        }
+
+        if (first_row == true) {
+            capture.mTriggerSample = (sample_numbers == false && first_time < 0.0) ? U64(llround(-first_time * rate)) : 0;
+            first_row = false;
+        }
+
+        for (U32 i = 0; i < lines.size(); i++) {
+            if (lines[i].Set(sample, fields[i + 1] == "1" ? BIT_HIGH : BIT_LOW) == false) {
+                fprintf(stderr, "row %llu goes back in time\n", row);
+                ok = false;
+                break;
+            }
+        }
+    }
+
+    free(line);
+
+    capture.mSampleRate = (rate != 0) ? rate : 1;
+    capture.mSampleCount = sample + 1;
+    return ok && FinishLines(lines);
+}
+
+//sigrok session
+
+struct ZipEntry {
+    std::string mName;
+    U32 mMethod;
+    U64 mCompressedSize;
+    U64 mLocalOffset;
+};
+
+static U32 ReadLe(const U8 *data, U32 size)
+{
+    U32 value = 0;
+    for (U32 i = 0; i < size; i++) {
+        value |= U32(data[i]) << (8 * i);
+    }
+    return value;
+}
+
+//the central directory; zip64 isn't supported, sigrok writes it for sessions past 4 GB only.
+static bool ReadZipDirectory(FILE *in, std::vector<ZipEntry> &entries)
+{
+    if (fseeko(in, 0, SEEK_END) != 0) {
+        return false;
+    }
+    U64 file_size = ftello(in);
+
+    //the end of central directory record is in the last 64 kB, behind the archive comment.
+    U64 tail_size = std::min<U64>(file_size, 65536 + 22);
+    std::vector<U8> tail(tail_size);
+    if (tail_size < 22 || fseeko(in, file_size - tail_size, SEEK_SET) != 0 || fread(&tail[0], 1, tail_size, in) != tail_size) {
+        return false;
+    }
+
+    S64 end = -1;
+    for (S64 i = S64(tail_size) - 22; i >= 0; i--) {
+        if (ReadLe(&tail[i], 4) == 0x06054b50) {
+            end = i;
+            break;
+        }
+    }
+    if (end < 0) {
+        return false;
+    }
+
+    U32 entry_count = ReadLe(&tail[end + 10], 2);
+    U32 directory_size = ReadLe(&tail[end + 12], 4);
+    U32 directory_offset = ReadLe(&tail[end + 16], 4);
+    if (directory_offset == 0xFFFFFFFF || U64(directory_offset) + directory_size > file_size) {
+        return false;
+    }
+
+    std::vector<U8> directory(directory_size + 1);
+    if (fseeko(in, directory_offset, SEEK_SET) != 0 || fread(&directory[0], 1, directory_size, in) != directory_size) {
+        return false;
+    }
+
+    U32 offset = 0;
+    for (U32 i = 0; i < entry_count; i++) {
+        if (offset + 46 > directory_size || ReadLe(&directory[offset], 4) != 0x02014b50) {
+            return false;
+        }
+
+        U32 name_length = ReadLe(&directory[offset + 28], 2);
+        U32 extra_length = ReadLe(&directory[offset + 30], 2);
+        U32 comment_length = ReadLe(&directory[offset + 32], 2);
+        if (offset + 46 + name_length > directory_size) {
+            return false;
+        }
+
+        ZipEntry entry;
+        entry.mMethod = ReadLe(&directory[offset + 10], 2);
+        entry.mCompressedSize = ReadLe(&directory[offset + 20], 4);
+        entry.mLocalOffset = ReadLe(&directory[offset + 42], 4);
+        entry.mName.assign((const char *)&directory[offset + 46], name_length);
+        entries.push_back(entry);
+
+        offset += 46 + name_length + extra_length + comment_length;
+    }
+
+    return true;
+}
+
+//reads an entry front to back, inflating it if it's deflated.
+class ZipEntryReader
+{
+public:
+    ZipEntryReader(FILE *in)
+        :   mIn(in),
+            mMethod(0),
+            mRemaining(0),
+            mInflating(false),
+            mInput(IMPORT_BUFFER_SIZE)
+    {
+        memset(&mStream, 0, sizeof(mStream));
+    }
+
+    ~ZipEntryReader()
+    {
+        if (mInflating == true) {
+            inflateEnd(&mStream);
+        }
+    }
+
+    bool Open(const ZipEntry &entry)
+    {
+        U8 local[30];
+        if (fseeko(mIn, entry.mLocalOffset, SEEK_SET) != 0 || fread(local, 1, 30, mIn) != 30 || ReadLe(local, 4) != 0x04034b50) {
+            return false;
+        }
+        if (fseeko(mIn, entry.mLocalOffset + 30 + ReadLe(&local[26], 2) + ReadLe(&local[28], 2), SEEK_SET) != 0) {
+            return false;
+        }
+
+        mMethod = entry.mMethod;
+        mRemaining = entry.mCompressedSize;
+        if (mMethod == 8) {
+            mInflating = inflateInit2(&mStream, -MAX_WBITS) == Z_OK;
+            return mInflating;
+        }
+        return mMethod == 0;
+    }
+
+    //returns the bytes read, 0 at the end of the entry, -1 if it's damaged.
+    S64 Read(U8 *buffer, U32 size)
+    {
+        if (mMethod == 0) {
+            U32 count = U32(std::min<U64>(size, mRemaining));
+            if (count != 0 && fread(buffer, 1, count, mIn) != count) {
+                return -1;
+            }
+            mRemaining -= count;
+            return count;
+        }
+
+        mStream.next_out = buffer;
+        mStream.avail_out = size;
+        while (mStream.avail_out == size) {
+            if (mStream.avail_in == 0 && mRemaining != 0) {
+                U32 count = U32(std::min<U64>(mInput.size(), mRemaining));
+                if (fread(&mInput[0], 1, count, mIn) != count) {
+                    return -1;
+                }
+                mRemaining -= count;
+                mStream.next_in = &mInput[0];
+                mStream.avail_in = count;
+            }
+
+            int result = inflate(&mStream, Z_NO_FLUSH);
+            if (result == Z_STREAM_END) {
+                break;
+            }
+            if (result != Z_OK && !(result == Z_BUF_ERROR && mRemaining != 0)) {
+                return -1;
+            }
+        }
+        return S64(size - mStream.avail_out);
+    }
+
+protected:
+    FILE *mIn;
+    U32 mMethod;
+    U64 mRemaining;
+    bool mInflating;
+    z_stream mStream;
+    std::vector<U8> mInput;
+};
+
+//"1 MHz", "250 kHz" or plain Hz
+static U64 ParseSampleRate(const std::string &text)
+{
+    char *unit;
+    double rate = strtod(text.c_str(), &unit);
+    while (*unit == ' ') {
+        unit++;
+    }
+    if (*unit == 'k' || *unit == 'K') {
+        rate *= 1e3;
+    } else if (*unit == 'M') {
+        rate *= 1e6;
+    } else if (*unit == 'G') {
+        rate *= 1e9;
+    }
+    return U64(rate + 0.5);
+}
+
+//logic-1-2 comes after logic-1-1 and before logic-1-10.
+static bool CompareChunks(const std::pair<U64, ZipEntry> &a, const std::pair<U64, ZipEntry> &b)
+{
+    return a.first < b.first;
+}
+
+static bool ImportSigrok(FILE *in, EdgeFileWriter &writer, U32 rate, ImportCapture &capture)
+{
+    std::vector<ZipEntry> entries;
+    if (ReadZipDirectory(in, entries) == false) {
+        fprintf(stderr, "not a zip file, or a zip64 one\n");
+        return false;
+    }
+
+    //the metadata: an ini file, with the logic probes of [device 1]
+    std::string metadata;
+    for (U32 i = 0; i < entries.size(); i++) {
+        if (entries[i].mName == "metadata") {
+            ZipEntryReader reader(in);
+            U8 buffer[4096];
+            S64 count;
+            if (reader.Open(entries[i]) == false) {
+                return false;
+            }
+            while ((count = reader.Read(buffer, sizeof(buffer))) > 0) {
+                metadata.append((const char *)buffer, size_t(count));
+            }
+        }
+    }
+
+    std::string capture_file;
+    U32 unit_size = 1;
+    U64 probe_mask = 0;
+    U64 metadata_rate = 0;
+    bool in_device = false;
+    size_t start = 0;
+    while (start < metadata.size()) {
+        size_t end = metadata.find('\n', start);
+        if (end == std::string::npos) {
+            end = metadata.size();
+        }
+        std::string line = metadata.substr(start, end - start);
+        start = end + 1;
+        if (line.empty() == false && line[line.size() - 1] == '\r') {
+            line.erase(line.size() - 1);
+        }
+
+        if (line.empty() == false && line[0] == '[') {
+            in_device = line == "[device 1]";
+            continue;
+        }
+
+        size_t equals = line.find('=');
+        if (in_device == false || equals == std::string::npos) {
+            continue;
+        }
+        std::string key = line.substr(0, equals);
+        std::string value = line.substr(equals + 1);
+
+        if (key == "capturefile") {
+            capture_file = value;
+        } else if (key == "unitsize") {
+            unit_size = U32(strtoul(value.c_str(), NULL, 10));
+        } else if (key == "samplerate") {
+            metadata_rate = ParseSampleRate(value);
+        } else if (key.compare(0, 5, "probe") == 0) {
+            U32 probe = U32(strtoul(key.c_str() + 5, NULL, 10));
+            if (probe >= 1 && probe <= 64) {
+                probe_mask |= 1ull << (probe - 1);
+            }
+        }
+    }
+
+    if (capture_file.empty() == true || unit_size == 0 || unit_size > 8 || probe_mask == 0) {
+        fprintf(stderr, "no logic probes in the metadata\n");
+        return false;
+    }
+
+    if (rate == 0) {
+        if (metadata_rate == 0 || metadata_rate > 0xFFFFFFFFull) {
+            fprintf(stderr, "the session's sample rate doesn't fit, set --rate\n");
+            return false;
+        }
+        rate = U32(metadata_rate);
+    }
+
+    std::vector<std::pair<U64, ZipEntry> > chunks;
+    for (U32 i = 0; i < entries.size(); i++) {
+        const std::string &name = entries[i].mName;
+        if (name == capture_file) {
+            chunks.push_back(std::make_pair(U64(0), entries[i]));
+        } else if (name.compare(0, capture_file.size() + 1, capture_file + "-") == 0) {
+            chunks.push_back(std::make_pair(U64(strtoull(name.c_str() + capture_file.size() + 1, NULL, 10)), entries[i]));
+        }
+    }
+    std::sort(chunks.begin(), chunks.end(), CompareChunks);
+
+    std::vector<ImportLine> lines;
+    std::vector<U32> line_of_bit(64, 0);
+    for (U32 bit = 0; bit < 64; bit++) {
+        if ((probe_mask & (1ull << bit)) != 0) {
+            line_of_bit[bit] = U32(lines.size());
+            lines.push_back(ImportLine(writer, bit));
+        }
+    }
+
+    //samples can straddle two reads; what's left of one is moved to the front for the next.
+    std::vector<U8> buffer(IMPORT_BUFFER_SIZE);
+    U64 sample = 0;
+    U64 previous = 0;
+    for (U32 i = 0; i < chunks.size(); i++) {
+        ZipEntryReader reader(in);
+        if (reader.Open(chunks[i].second) == false) {
+            fprintf(stderr, "unable to read %s\n", chunks[i].second.mName.c_str());
+            return false;
+        }
+
+        U32 carried = 0;
+        S64 count;
+        while ((count = reader.Read(&buffer[carried], U32(buffer.size() - carried))) > 0) {
+            U32 available = carried + U32(count);
+            U32 used = available - available % unit_size;
+            for (U32 offset = 0; offset < used; offset += unit_size, sample++) {
+                U64 value = 0;
+                memcpy(&value, &buffer[offset], unit_size);
+
+                U64 changed = (sample == 0) ? probe_mask : (value ^ previous) & probe_mask;
+                previous = value;
+                while (changed != 0) {
+                    U32 bit = __builtin_ctzll(changed);
+                    changed &= changed - 1;
+                    lines[line_of_bit[bit]].Set(sample, ((value >> bit) & 0x1) != 0 ? BIT_HIGH : BIT_LOW);
+                }
+            }
+
+            carried = available - used;
+            memmove(&buffer[0], &buffer[used], carried);
+        }
+
+        if (count < 0) {
+            fprintf(stderr, "%s is damaged\n", chunks[i].second.mName.c_str());
+            return false;
+        }
+    }
+
+    capture.mSampleRate = rate;
+    capture.mSampleCount = sample;
+    capture.mTriggerSample = 0;
+    return FinishLines(lines);
+}
+
+//edge file
+
+static bool ImportEdges(const char *file_name, EdgeFileWriter &writer, ImportCapture &capture)
+{
+    DeviceCollection source;
+    if (source.Open(file_name) == false) {
+        fprintf(stderr, "not an edge file\n");
+        return false;
+    }
+
+    std::vector<U64> block_edges(EDGE_FILE_BLOCK_EDGES);
+    U32 channel_count = source.GetChannelCount();
+    for (U32 i = 0; i < channel_count; i++) {
+        ChannelData *channel = source.GetChannelDataAt(i);
+        U32 position = writer.AddChannel(channel->mChannelIndex, channel->mInitialBitState);
+
+        if (channel->mEdges != NULL) {
+            for (U64 j = 0; j < channel->mEdgeCount; j++) {
+                if (writer.AddEdge(position, channel->mEdges[j]) == false) {
+                    return false;
+                }
+            }
+        } else {
+            U64 block_count = channel->GetBlockCount();
+            for (U64 block = 0; block < block_count; block++) {
+                U32 count = DecodeEdgeBlock(channel, block, &block_edges[0]);
+                for (U32 j = 0; j < count; j++) {
+                    if (writer.AddEdge(position, block_edges[j]) == false) {
+                        return false;
+                    }
+                }
+            }
+        }
+    }
+
+    capture.mSampleRate = source.GetSampleRate();
+    capture.mSampleCount = source.GetSampleCount();
+    capture.mTriggerSample = source.GetTriggerSample();
+    return true;
+}
+
+static void Usage()
+{
+    fprintf(stderr, "usage: analyzer-import <capture> <capture.edges> [--format vcd|sr|csv|edges] [--rate Hz]\n");
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc < 3) {
+        Usage();
+        return 2;
+    }
+
+    std::string input_file = argv[1];
+    std::string output_file = argv[2];
+    std::string format;
+    U32 rate = 0;
+
+    size_t dot = input_file.find_last_of('.');
+    if (dot != std::string::npos) {
+        format = input_file.substr(dot + 1);
+    }
+
+    for (int i = 3; i < argc; i++) {
+        std::string option = argv[i];
+        if (i + 1 >= argc) {
+            Usage();
+            return 2;
+        }
+
+        const char *value = argv[++i];
+        if (option == "--format") {
+            format = value;
+        } else if (option == "--rate") {
+            rate = U32(strtoul(value, NULL, 0));
+        } else {
+            Usage();
+            return 2;
+        }
+    }
+
+    if (format != "vcd" && format != "sr" && format != "csv" && format != "edges") {
+        fprintf(stderr, "unknown format \"%s\", set --format\n", format.c_str());
+        return 2;
+    }
+
+    EdgeFileWriter writer;
+    if (writer.Open(output_file.c_str()) == false) {
+        fprintf(stderr, "unable to write %s\n", output_file.c_str());
+        return 1;
+    }
+
+    ImportCapture capture;
+    memset(&capture, 0, sizeof(capture));
+    double start = GetTimeS();
+
+    bool imported;
+    if (format == "edges") {
+        imported = ImportEdges(input_file.c_str(), writer, capture);
+    } else {
+        FILE *in = fopen(input_file.c_str(), format == "sr" ? "rb" : "r");
+        if (in == NULL) {
+            fprintf(stderr, "unable to open %s\n", input_file.c_str());
+            return 1;
+        }
+        setvbuf(in, NULL, _IOFBF, IMPORT_BUFFER_SIZE);
+
+        if (format == "vcd") {
+            imported = ImportVcd(in, writer, rate, capture);
+        } else if (format == "sr") {
+            imported = ImportSigrok(in, writer, rate, capture);
+        } else {
+            imported = ImportCsv(in, writer, rate, capture);
+        }
+        fclose(in);
+    }
+
+    if (imported == false) {
+        fprintf(stderr, "unable to import %s\n", input_file.c_str());
+        return 1;
+    }
+
+    if (writer.Close(capture.mSampleRate, capture.mSampleCount, capture.mTriggerSample) == false) {
+        fprintf(stderr, "unable to write %s\n", output_file.c_str());
+        return 1;
+    }
+
+    fprintf(stderr, "%s: %llu edges, %llu samples at %u Hz, imported in %.3f s\n", output_file.c_str(), writer.GetEdgeCount(),
+            capture.mSampleCount, capture.mSampleRate, GetTimeS() - start);
+    return 0;
+}
@@ -0,0 +1,467 @@
+//analyzer-replay: run an analyzer plugin over a recorded edge file without the KingstVIS GUI.
+//
+//  analyzer-replay run <analyzer.so> <capture.edges> [options]
+//      --set "Title=value"     set a settings interface, matched by title, checkbox text, tooltip or #index.
+//                              channels take a channel index or "none"; lists take the item text or its number.
+//      --export <file>         write the analyzer's export file
+//      --export-type <n>       export option user id (default 0)
+//      --display <base>        hex, dec, bin, ascii or asciihex (default hex)
+//      --frames <file>         write one line per frame: start, end, type, flags, data1, data2, tabular text
+//      --markers <file>        write one line per marker: channel, sample, marker type
+//      --packets <file>        write one line per packet: first frame, last frame, packet tabular text
+//
+//  analyzer-replay simulate <analyzer.so> <capture.edges> [--set ...] [--rate <Hz>] [--samples <n>]
+//      write the analyzer's own simulation data to an edge file
+//
+//  analyzer-replay concurrent <analyzer.so> <capture.edges> [--set ...] [--instances <n>] [--channel "Title"] [--seconds <s>]
+//      decode with n analyzers at once (default 8), each on its own channel, and check that every one of them
+//      gets the same frames, packets and markers as it does decoding its channel alone, one after another. Instance i decodes
+//      the i-th channel of the capture; a capture with fewer channels gets them again under new indices.
+//      --channel is the title of the channel setting to change (default the analyzer's first channel).
+//      --seconds keeps every instance decoding its channel again, with a new analyzer each time, until it has run for
+//      that long (default 3, 0 for a single decode), and the run fails unless all the instances were running at the same time.
+//
+//A short summary (frames, packets, edges and decode time) goes to stderr.
+
+#include "ReplayTool.h"
+#include <AnalyzerResults.h>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct ReplayOptions {
+    std::string mCommand;
+    std::string mAnalyzerFile;
+    std::string mCaptureFile;
+    std::vector<std::string> mSettings;
+    std::string mExportFile;
+    U32 mExportType;
+    DisplayBase mDisplayBase;
+    std::string mFramesFile;
+    std::string mMarkersFile;
+    std::string mPacketsFile;
+    U32 mSimulationRate;
+    U64 mSimulationSamples;
+    U32 mInstances;
+    std::string mChannelSetting;
+    double mMinimumSeconds;
+};
+
+static void Usage()
+{
+    fprintf(stderr, "usage: analyzer-replay run <analyzer.so> <capture.edges> [--set \"Title=value\"]... [--export file] [--export-type n]\n");
+    fprintf(stderr, "                           [--display hex|dec|bin|ascii|asciihex] [--frames file] [--markers file]\n");
+    fprintf(stderr, "                           [--packets file]\n");
+    fprintf(stderr, "       analyzer-replay simulate <analyzer.so> <capture.edges> [--set \"Title=value\"]... [--rate Hz] [--samples n]\n");
+    fprintf(stderr, "       analyzer-replay concurrent <analyzer.so> <capture.edges> [--set \"Title=value\"]... [--instances n]\n");
+    fprintf(stderr, "                           [--channel \"Title\"] [--seconds s]\n");
+}
+
+static bool ParseDisplayBase(const char *text, DisplayBase &display_base)
+{
+    const char *names[] = { "bin", "dec", "hex", "ascii", "asciihex" };
+    const DisplayBase bases[] = { Binary, Decimal, Hexadecimal, ASCII, AsciiHex };
+    for (U32 i = 0; i < 5; i++) {
+        if (strcmp(text, names[i]) == 0) {
+            display_base = bases[i];
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static bool ParseOptions(int argc, char *argv[], ReplayOptions &options)
+{
+    if (argc < 4) {
+        return false;
+    }
+
+    options.mCommand = argv[1];
+    options.mAnalyzerFile = argv[2];
+    options.mCaptureFile = argv[3];
+    options.mExportType = 0;
+    options.mDisplayBase = Hexadecimal;
+    options.mSimulationRate = 10000000;
+    options.mSimulationSamples = 100000000;
+    options.mInstances = 8;
+    options.mMinimumSeconds = 3.0;
+
+    if (options.mCommand != "run" && options.mCommand != "simulate" && options.mCommand != "concurrent") {
+        return false;
+    }
+
+    for (int i = 4; i < argc; i++) {
+        std::string option = argv[i];
+        if (i + 1 >= argc) {
+            return false;
+        }
+
+        const char *value = argv[++i];
+        if (option == "--set") {
+            options.mSettings.push_back(value);
+        } else if (option == "--export") {
+            options.mExportFile = value;
+        } else if (option == "--export-type") {
+            options.mExportType = U32(strtoul(value, NULL, 0));
+        } else if (option == "--display") {
+            if (ParseDisplayBase(value, options.mDisplayBase) == false) {
+                return false;
+            }
+        } else if (option == "--frames") {
+            options.mFramesFile = value;
+        } else if (option == "--markers") {
+            options.mMarkersFile = value;
+        } else if (option == "--packets") {
+            options.mPacketsFile = value;
+        } else if (option == "--rate") {
+            options.mSimulationRate = U32(strtoul(value, NULL, 0));
+        } else if (option == "--samples") {
+            options.mSimulationSamples = strtoull(value, NULL, 0);
+        } else if (option == "--instances") {
+            options.mInstances = U32(strtoul(value, NULL, 0));
+            if (options.mInstances == 0) {
+                return false;
+            }
+        } else if (option == "--channel") {
+            options.mChannelSetting = value;
+        } else if (option == "--seconds") {
+            options.mMinimumSeconds = strtod(value, NULL);
+        } else {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static void WriteFrames(AnalyzerResults *results, FILE *f, DisplayBase display_base)
+{
+    U64 num_frames = results->GetNumFrames();
+    for (U64 i = 0; i < num_frames; i++) {
+        Frame frame = results->GetFrame(i);
+        results->GenerateFrameTabularText(i, display_base);
+        fprintf(f, "%llu %llu %u 0x%02X 0x%llX 0x%llX %s\n", frame.mStartingSampleInclusive, frame.mEndingSampleInclusive,
+                U32(frame.mType), U32(frame.mFlags), frame.mData1, frame.mData2, results->GetTabularTextString().c_str());
+    }
+}
+
+static void WritePackets(AnalyzerResults *results, FILE *f, DisplayBase display_base)
+{
+    U64 num_packets = results->GetNumPackets();
+    for (U64 i = 0; i < num_packets; i++) {
+        U64 first_frame_id;
+        U64 last_frame_id;
+        results->GetFramesContainedInPacket(i, &first_frame_id, &last_frame_id);
+        results->GeneratePacketTabularText(i, display_base);
+        fprintf(f, "%llu %llu %s\n", first_frame_id, last_frame_id, results->GetTabularTextString().c_str());
+    }
+}
+
+static void WriteMarkers(AnalyzerResults *results, AnalyzerSettings *settings, FILE *f)
+{
+    U32 channel_count = settings->GetChannelsCount();
+    for (U32 i = 0; i < channel_count; i++) {
+        const char *label;
+        bool is_used;
+        Channel channel = settings->GetChannel(i, &label, &is_used);
+
+        U64 num_markers = results->GetNumMarkers(channel);
+        for (U64 j = 0; j < num_markers; j++) {
+            AnalyzerResults::MarkerType marker_type;
+            U64 marker_sample;
+            results->GetMarker(channel, j, &marker_type, &marker_sample);
+            fprintf(f, "%u %llu %u\n", channel.mChannelIndex, marker_sample, U32(marker_type));
+        }
+    }
+}
+
+static FILE *OpenOutput(const std::string &file_name)
+{
+    FILE *f = fopen(file_name.c_str(), "w");
+    if (f == NULL) {
+        fprintf(stderr, "unable to open %s\n", file_name.c_str());
+    }
+    return f;
+}
+
+static int Run(Analyzer *analyzer, const ReplayOptions &options)
+{
+    DeviceCollection capture;
+    if (capture.Open(options.mCaptureFile.c_str()) == false) {
+        fprintf(stderr, "unable to open capture %s\n", options.mCaptureFile.c_str());
+        return 1;
+    }
+
+    analyzer->Init(&capture, NULL, NULL);
+    analyzer->SetupResults();
+
+    double start = GetTimeS();
+    analyzer->StartProcessing();
+    double elapsed = GetTimeS() - start;
+
+    AnalyzerResults *results;
+    if (analyzer->GetAnalyzerResults(&results) == false) {
+        fprintf(stderr, "analyzer produced no results\n");
+        return 1;
+    }
+
+    U64 edges = capture.GetEdgeCount();
+    U64 commits = GetReplayCallCounters()[ReplayCommitResults].mCalls;
+    fprintf(stderr, "%s: %llu frames, %llu packets, %llu edges in %.3f s (%.1f Medges/s, %llu commits, %.0f commits/s)\n",
+            analyzer->GetAnalyzerName(), results->GetNumFrames(), results->GetNumPackets(), edges, elapsed,
+            elapsed > 0.0 ? edges / elapsed / 1e6 : 0.0, commits, elapsed > 0.0 ? commits / elapsed : 0.0);
+
+    FILE *f;
+    if (options.mFramesFile.empty() == false && (f = OpenOutput(options.mFramesFile)) != NULL) {
+        WriteFrames(results, f, options.mDisplayBase);
+        fclose(f);
+    }
+
+    if (options.mPacketsFile.empty() == false && (f = OpenOutput(options.mPacketsFile)) != NULL) {
+        WritePackets(results, f, options.mDisplayBase);
+        fclose(f);
+    }
+
+    if (options.mMarkersFile.empty() == false && (f = OpenOutput(options.mMarkersFile)) != NULL) {
+        WriteMarkers(results, analyzer->GetAnalyzerSettings(), f);
+        fclose(f);
+    }
+
+    if (options.mExportFile.empty() == false) {
+        start = GetTimeS();
+        results->StartExportThread(options.mExportFile.c_str(), options.mDisplayBase, options.mExportType);
+        elapsed = GetTimeS() - start;
+        fprintf(stderr, "exported %s in %.3f s\n", options.mExportFile.c_str(), elapsed);
+    }
+
+    return 0;
+}
+
+static int Simulate(Analyzer *analyzer, const ReplayOptions &options)
+{
+    DeviceCollection capture;
+    capture.SetCapture(options.mSimulationRate, options.mSimulationSamples, 0);
+    analyzer->Init(&capture, NULL, NULL);
+
+    //ask for the data in slices, the way the GUI does.
+    SimulationChannelDescriptor *simulation_channels = NULL;
+    U32 channel_count = 0;
+    U64 slice = options.mSimulationRate / 100 + 1;
+    for (U64 requested = 0; requested < options.mSimulationSamples;) {
+        requested += slice;
+        if (requested > options.mSimulationSamples) {
+            requested = options.mSimulationSamples;
+        }
+        channel_count = analyzer->GenerateSimulationData(requested, options.mSimulationRate, &simulation_channels);
+    }
+
+    std::vector<ChannelData> channels;
+    for (U32 i = 0; i < channel_count; i++) {
+        SimulationChannelDescriptorData *data = (SimulationChannelDescriptorData *)simulation_channels[i].GetData();
+
+        //edges past the requested range aren't part of the capture.
+        U64 edge_count = data->mEdges.size();
+        while (edge_count > 0 && data->mEdges[edge_count - 1] >= options.mSimulationSamples) {
+            edge_count--;
+        }
+
+        ChannelData channel;
+        channel.mChannelIndex = data->mChannel.mChannelIndex;
+        channel.mInitialBitState = data->mInitialBitState;
+        channel.mEdges = edge_count != 0 ? &data->mEdges[0] : NULL;
+        channel.mEdgeCount = edge_count;
+        channel.mSampleCount = options.mSimulationSamples;
+        channels.push_back(channel);
+    }
+
+    if (DeviceCollection::Save(options.mCaptureFile.c_str(), options.mSimulationRate, options.mSimulationSamples, 0, channels) == false) {
+        fprintf(stderr, "unable to write %s\n", options.mCaptureFile.c_str());
+        return 1;
+    }
+
+    fprintf(stderr, "%s: wrote %u channels, %llu samples at %u Hz\n", analyzer->GetAnalyzerName(), channel_count,
+            options.mSimulationSamples, options.mSimulationRate);
+    return 0;
+}
+
+//decodes one channel with an analyzer of its own and keeps its frames, packets and markers as text.
+static bool DecodeChannel(ReplayPlugin *plugin, DeviceCollection *capture, const ReplayOptions *options, U32 channel_index, std::string *output)
+{
+    Analyzer *analyzer = plugin->CreateAnalyzer();
+
+    std::vector<std::string> settings = options->mSettings;
+    settings.push_back(options->mChannelSetting + "=" + std::to_string(channel_index));
+
+    bool decoded = false;
+    if (ApplySettings(analyzer->GetAnalyzerSettings(), settings) == true) {
+        analyzer->Init(capture, NULL, NULL);
+        analyzer->SetupResults();
+        analyzer->StartProcessing();
+
+        AnalyzerResults *results;
+        if (analyzer->GetAnalyzerResults(&results) == true) {
+            char *buffer = NULL;
+            size_t size = 0;
+            FILE *f = open_memstream(&buffer, &size);
+            if (f != NULL) {
+                WriteFrames(results, f, options->mDisplayBase);
+                WritePackets(results, f, options->mDisplayBase);
+                WriteMarkers(results, analyzer->GetAnalyzerSettings(), f);
+                fclose(f);
+                output->assign(buffer, size);
+                free(buffer);
+                decoded = true;
+            }
+        }
+    }
+
+    plugin->DestroyAnalyzer(analyzer);
+    return decoded;
+}
+
+//one analyzer thread of the concurrent test, and when it ran.
+struct ReplayInstance {
+    U32 mChannelIndex;
+    std::string mReference;
+    U32 mDecodes;
+    U32 mMismatches;
+    double mStart;
+    double mEnd;
+};
+
+//decodes the instance's channel until options->mMinimumSeconds have passed, at least once, checking every decode.
+static void DecodeInstance(ReplayPlugin *plugin, DeviceCollection *capture, const ReplayOptions *options, ReplayInstance *instance)
+{
+    instance->mStart = GetTimeS();
+    do {
+        std::string output;
+        if (DecodeChannel(plugin, capture, options, instance->mChannelIndex, &output) == false || output != instance->mReference) {
+            instance->mMismatches++;
+        }
+        instance->mDecodes++;
+    } while (GetTimeS() - instance->mStart < options->mMinimumSeconds);
+    instance->mEnd = GetTimeS();
+}
+
+static int Concurrent(ReplayPlugin &plugin, Analyzer *analyzer, const ReplayOptions &options)
+{
+    DeviceCollection capture;
+    if (capture.Open(options.mCaptureFile.c_str()) == false) {
+        fprintf(stderr, "unable to open capture %s\n", options.mCaptureFile.c_str());
+        return 1;
+    }
+
+    ReplayOptions instance_options = options;
+    if (instance_options.mChannelSetting.empty() == true) {
+        const char *label;
+        bool is_used;
+        analyzer->GetAnalyzerSettings()->GetChannel(0, &label, &is_used);
+        instance_options.mChannelSetting = label;
+    }
+
+    U32 captured_count = capture.GetChannelCount();
+    if (captured_count == 0) {
+        fprintf(stderr, "capture %s has no channels\n", options.mCaptureFile.c_str());
+        return 1;
+    }
+
+    //every instance gets a channel of its own; all of them are added before any analyzer holds on to one.
+    std::vector<U32> channel_indexes;
+    U32 next_index = 0;
+    for (U32 i = 0; i < captured_count; i++) {
+        U32 channel_index = capture.GetChannelDataAt(i)->mChannelIndex;
+        channel_indexes.push_back(channel_index);
+        if (channel_index >= next_index) {
+            next_index = channel_index + 1;
+        }
+    }
+    for (U32 i = captured_count; i < options.mInstances; i++) {
+        ChannelData channel = *capture.GetChannelDataAt(i % captured_count);
+        channel.mChannelIndex = next_index;
+        capture.AddChannel(channel);
+        channel_indexes.push_back(next_index++);
+    }
+
+    //what each channel decodes to with nothing else running
+    std::vector<ReplayInstance> instances(options.mInstances);
+    for (U32 i = 0; i < options.mInstances; i++) {
+        ReplayInstance &instance = instances[i];
+        instance.mChannelIndex = channel_indexes[i];
+        instance.mDecodes = 0;
+        instance.mMismatches = 0;
+        if (DecodeChannel(&plugin, &capture, &instance_options, instance.mChannelIndex, &instance.mReference) == false) {
+            fprintf(stderr, "channel %u: analyzer produced no results\n", instance.mChannelIndex);
+            return 1;
+        }
+    }
+
+    std::vector<std::thread> threads;
+    double start = GetTimeS();
+    for (U32 i = 0; i < options.mInstances; i++) {
+        threads.push_back(std::thread(DecodeInstance, &plugin, &capture, &instance_options, &instances[i]));
+    }
+    for (U32 i = 0; i < options.mInstances; i++) {
+        threads[i].join();
+    }
+    double elapsed = GetTimeS() - start;
+
+    //the instances only tested each other if they all ran at once: the last to start has to start before the first ends.
+    U32 mismatches = 0;
+    double last_start = instances[0].mStart;
+    double first_end = instances[0].mEnd;
+    for (U32 i = 0; i < options.mInstances; i++) {
+        const ReplayInstance &instance = instances[i];
+        fprintf(stderr, "instance %u on channel %u: %u decodes from %.3f to %.3f s, %u mismatches\n", i, instance.mChannelIndex,
+                instance.mDecodes, instance.mStart - start, instance.mEnd - start, instance.mMismatches);
+        if (instance.mMismatches != 0) {
+            fprintf(stderr, "instance %u on channel %u: results differ from a single analyzer's\n", i, instance.mChannelIndex);
+        }
+        mismatches += instance.mMismatches;
+        last_start = std::max(last_start, instance.mStart);
+        first_end = std::min(first_end, instance.mEnd);
+    }
+
+    bool overlapped = last_start < first_end;
+    fprintf(stderr, "%s: %u instances on %u channels in %.3f s, %u mismatches, all running from %.3f to %.3f s\n",
+            analyzer->GetAnalyzerName(), options.mInstances, U32(channel_indexes.size()), elapsed, mismatches,
+            last_start - start, first_end - start);
+    if (overlapped == false) {
+        fprintf(stderr, "the instances did not run at the same time; raise --seconds\n");
+    }
+    return (mismatches != 0 || overlapped == false) ? 1 : 0;
+}
+
+int main(int argc, char *argv[])
+{
+    ReplayOptions options;
+    if (ParseOptions(argc, argv, options) == false) {
+        Usage();
+        return 2;
+    }
+
+    ReplayPlugin plugin;
+    if (plugin.Load(options.mAnalyzerFile.c_str()) == false) {
+        return 1;
+    }
+
+    Analyzer *analyzer = plugin.CreateAnalyzer();
+
+    int result = 1;
+    if (ApplySettings(analyzer->GetAnalyzerSettings(), options.mSettings) == true) {
+        if (options.mCommand == "run") {
+            result = Run(analyzer, options);
+        } else if (options.mCommand == "concurrent") {
+            result = Concurrent(plugin, analyzer, options);
+        } else {
+            result = Simulate(analyzer, options);
+        }
+    }
+
+    plugin.DestroyAnalyzer(analyzer);
+    return result;
+}
@@ -0,0 +1,151 @@
+#include "ReplayTool.h"
+#include <dlfcn.h>
+#include <sys/time.h>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+ReplayPlugin::ReplayPlugin()
+    :   mLibrary(NULL),
+        mCreateAnalyzer(NULL),
+        mDestroyAnalyzer(NULL)
+{
+}
+
+ReplayPlugin::~ReplayPlugin()
+{
+    if (mLibrary != NULL) {
+        dlclose(mLibrary);
+    }
+}
+
+bool ReplayPlugin::Load(const char *file_name)
+{
+    mLibrary = dlopen(file_name, RTLD_NOW | RTLD_LOCAL);
+    if (mLibrary == NULL) {
+        fprintf(stderr, "unable to load %s: %s\n", file_name, dlerror());
+        return false;
+    }
+
+    mCreateAnalyzer = (CreateAnalyzerFunction)dlsym(mLibrary, "CreateAnalyzer");
+    mDestroyAnalyzer = (DestroyAnalyzerFunction)dlsym(mLibrary, "DestroyAnalyzer");
+    if (mCreateAnalyzer == NULL || mDestroyAnalyzer == NULL) {
+        fprintf(stderr, "%s is not an analyzer plugin\n", file_name);
+        return false;
+    }
+
+    return true;
+}
+
+Analyzer *ReplayPlugin::CreateAnalyzer()
+{
+    return mCreateAnalyzer();
+}
+
+void ReplayPlugin::DestroyAnalyzer(Analyzer *analyzer)
+{
+    mDestroyAnalyzer(analyzer);
+}
+
+double GetTimeS()
+{
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec + tv.tv_usec * 1e-6;
+}
+
+static bool MatchesInterface(AnalyzerSettingInterface *setting_interface, U32 index, const std::string &name)
+{
+    if (name.size() > 1 && name[0] == '#') {
+        return strtoul(name.c_str() + 1, NULL, 10) == index;
+    }
+
+    if (name == setting_interface->GetTitle() || name == setting_interface->GetToolTip()) {
+        return true;
+    }
+
+    if (setting_interface->GetType() == INTERFACE_BOOL) {
+        return name == ((AnalyzerSettingInterfaceBool *)setting_interface)->GetCheckBoxText();
+    }
+
+    return false;
+}
+
+static bool SetInterfaceValue(AnalyzerSettingInterface *setting_interface, const std::string &value)
+{
+    switch (setting_interface->GetType()) {
+    case INTERFACE_CHANNEL: {
+        AnalyzerSettingInterfaceChannel *channel_interface = (AnalyzerSettingInterfaceChannel *)setting_interface;
+        if (value == "none") {
+            channel_interface->SetChannel(UNDEFINED_CHANNEL);
+        } else {
+            channel_interface->SetChannel(Channel(0, U32(strtoul(value.c_str(), NULL, 0))));
+        }
+        return true;
+    }
+
+    case INTERFACE_NUMBER_LIST: {
+        AnalyzerSettingInterfaceNumberList *list_interface = (AnalyzerSettingInterfaceNumberList *)setting_interface;
+        U32 count = list_interface->GetListboxNumbersCount();
+        for (U32 i = 0; i < count; i++) {
+            if (value == list_interface->GetListboxString(i)) {
+                list_interface->SetNumber(list_interface->GetListboxNumber(i));
+                return true;
+            }
+        }
+
+        list_interface->SetNumber(strtod(value.c_str(), NULL));
+        return true;
+    }
+
+    case INTERFACE_INTEGER:
+        ((AnalyzerSettingInterfaceInteger *)setting_interface)->SetInteger(int(strtol(value.c_str(), NULL, 0)));
+        return true;
+
+    case INTERFACE_TEXT:
+        ((AnalyzerSettingInterfaceText *)setting_interface)->SetText(value.c_str());
+        return true;
+
+    case INTERFACE_BOOL:
+        ((AnalyzerSettingInterfaceBool *)setting_interface)->SetValue(value == "1" || value == "true" || value == "yes");
+        return true;
+
+    default:
+        return false;
+    }
+}
+
+bool ApplySettings(AnalyzerSettings *settings, const std::vector<std::string> &assignments)
+{
+    for (U32 i = 0; i < assignments.size(); i++) {
+        size_t equals = assignments[i].find('=');
+        if (equals == std::string::npos) {
+            fprintf(stderr, "bad setting '%s', expected Title=value\n", assignments[i].c_str());
+            return false;
+        }
+
+        std::string name = assignments[i].substr(0, equals);
+        std::string value = assignments[i].substr(equals + 1);
+
+        bool found = false;
+        U32 count = settings->GetSettingsInterfacesCount();
+        for (U32 j = 0; j < count && found == false; j++) {
+            AnalyzerSettingInterface *setting_interface = settings->GetSettingsInterface(j);
+            if (MatchesInterface(setting_interface, j, name) == true) {
+                found = SetInterfaceValue(setting_interface, value);
+            }
+        }
+
+        if (found == false) {
+            fprintf(stderr, "unknown setting '%s'\n", name.c_str());
+            return false;
+        }
+    }
+
+    if (settings->SetSettingsFromInterfaces() == false) {
+        fprintf(stderr, "settings rejected: %s\n", settings->GetSaveErrorMessage());
+        return false;
+    }
+
+    return true;
+}
@@ -0,0 +1,37 @@
+#ifndef REPLAY_TOOL_H
+#define REPLAY_TOOL_H
+
+#include <Analyzer.h>
+#include <AnalyzerSettings.h>
+#include "ReplayCapture.h"
+#include <string>
+#include <vector>
+
+//an analyzer plugin loaded with dlopen
+class ReplayPlugin
+{
+public:
+    ReplayPlugin();
+    ~ReplayPlugin();
+
+    bool Load(const char *file_name);
+
+    Analyzer *CreateAnalyzer();
+    void DestroyAnalyzer(Analyzer *analyzer);
+
+protected:
+    typedef Analyzer *(*CreateAnalyzerFunction)();
+    typedef void (*DestroyAnalyzerFunction)(Analyzer *analyzer);
+
+    void *mLibrary;
+    CreateAnalyzerFunction mCreateAnalyzer;
+    DestroyAnalyzerFunction mDestroyAnalyzer;
+};
+
+//applies "Title=value" assignments to the settings interfaces, then SetSettingsFromInterfaces.
+//an interface is matched by title, checkbox text, tooltip or #index.
+bool ApplySettings(AnalyzerSettings *settings, const std::vector<std::string> &assignments);
+
+double GetTimeS();
+
+#endif //REPLAY_TOOL_H
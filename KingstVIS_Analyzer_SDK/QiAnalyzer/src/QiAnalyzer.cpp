@@ -1,12 +1,13 @@
 #include "QiAnalyzer.h"
 #include "QiAnalyzerSettings.h"
 #include <AnalyzerChannelData.h>
-#include <windows.h>
+#include <string.h>
 
 QiAnalyzer::QiAnalyzer()
     : Analyzer(),
       mSettings(new QiAnalyzerSettings()),
-      mSimulationInitilized(false)
+      mSimulationInitilized(false),
+      mDecoding(false)
 {
     SetAnalyzerSettings(mSettings.get());
 }
@@ -17,255 +18,809 @@ QiAnalyzer::~QiAnalyzer()
 }
 
 
-static INT8 cal_diff(U64 cnt1, U64 cnt2)
+void QiAnalyzer::SetupResults()
 {
-    U64 dif;
-    if (cnt1 > cnt2)
-        dif = cnt1 -cnt2;
-    else
-        dif = cnt2 - cnt1;
+    //Unlike the worker thread, this function is called from the GUI thread
+    //we need to reset the Results object here because it is exposed for direct access by the GUI, and it can't be deleted from the WorkerThread
 
-    if (dif < 27000 && dif > 23000)
-        return 1;
-    else if (dif < 53000 && dif > 47000)
-        return 0;
-    else
-        return -1;
+    mResults.reset(new QiAnalyzerResults(this, mSettings.get()));
+    SetAnalyzerResults(mResults.get());
+    mResults->AddChannelBubblesWillAppearOn(mSettings->mInputChannel);
+    if (mSettings->mFskMode != QiAnalyzerEnums::FskOff && mSettings->mCarrierChannel != mSettings->mInputChannel) {
+        mResults->AddChannelBubblesWillAppearOn(mSettings->mCarrierChannel);
+    }
+    for (U32 i = 1; i < QI_MAX_COILS; i++) {
+        if (mSettings->GetCoilChannel(i) != UNDEFINED_CHANNEL) {
+            mResults->AddChannelBubblesWillAppearOn(mSettings->GetCoilChannel(i));
+        }
+    }
 }
 
-void QiAnalyzer::ComputeSampleOffsets()
-{
-    ClockGenerator clock_generator;
-    U64 tmp;
-    clock_generator.Init(mSettings->mBitRate, mSampleRateHz);
 
-    mSampleOffsets.clear();
+void QiAnalyzer::WorkerThread()
+{
+    //a chunk still in flight when the last run was cancelled, using the decoder about to be reset
+    if (mDecoding == true) {
+        mParallelDecoder.FinishDecodeEdges();
+        mDecoding = false;
+    }
 
+    mSampleRateHz = GetSampleRate();
     U32 num_bits = mSettings->mBitsPerTransfer;
 
     if (mSettings->mQiMode != QiAnalyzerEnums::Normal) {
         num_bits++;
     }
 
-    mSampleOffsets.push_back(clock_generator.AdvanceByTimeS(250e-6));  //point to the center of the 1st bit (past the start bit)
+    mQi = GetAnalyzerChannelData(mSettings->mInputChannel);
+
+    //bi-phase coding only cares about the time between edges, not the level.
+    mDecoder.Init(mSampleRateHz, mSettings->mBitRate, mSettings->mBitTolerance, num_bits, mSettings->mShiftOrder);
+    mDecoder.Reset(mQi->GetSampleNumber());
+
+    U32 marker_categories;
+    switch (mSettings->mMarkerMode) {
+    case QiAnalyzerEnums::NoMarkers:
+        marker_categories = 0;
+        break;
+    case QiAnalyzerEnums::PacketMarkers:
+        marker_categories = QI_MARKER_PACKETS;
+        break;
+    case QiAnalyzerEnums::ErrorMarkers:
+        marker_categories = QI_MARKER_ERRORS;
+        break;
+    default:
+        marker_categories = QI_MARKER_ALL;
+        break;
+    }
+    mDecoder.SetMarkerCategories(marker_categories);
+
+    mAskFromCarrier = mSettings->mAskInput == QiAnalyzerEnums::AskFromCarrier;
+    if (mAskFromCarrier == true) {
+        mAskDemodulator.Init(mSampleRateHz, mSettings->mBitRate, mSettings->mAskThreshold, mSettings->mBitTolerance, num_bits, mSettings->mShiftOrder);
+        mAskDemodulator.Reset(mQi->GetSampleNumber());
+        mAskDemodulator.GetDecoder().SetMarkerCategories(marker_categories);
+    }
 
-    for (U32 i = 0; i < num_bits; i++) {
-        tmp = clock_generator.AdvanceByHalfPeriod();
-        mSampleOffsets.push_back(clock_generator.AdvanceByTimeS(250e-6));
+    //the envelope has a few edges per bit, too few to be worth splitting up.
+    mDecodeInParallel = false;
+    if (mSettings->mDecodeThreads != 1 && mAskFromCarrier == false) {
+        mParallelDecoder.Init(mDecoder, mSettings->mDecodeThreads);
+        mDecodeInParallel = mParallelDecoder.GetThreadCount() > 1;
     }
 
-    if (mSettings->mParity != AnalyzerEnums::None) {
-        mParityBitOffset = clock_generator.AdvanceByTimeS(250e-6);
+    mEdgeChunkSize = (mDecodeInParallel == true) ? QI_PARALLEL_EDGE_CHUNK_SIZE : QI_EDGE_CHUNK_SIZE;
+    mEdges.mDeltas.reserve(mEdgeChunkSize);
+    if (mDecodeInParallel == true) {
+        mDecodingDeltas.reserve(mEdgeChunkSize);
+    }
+    mDecodedSample = mQi->GetSampleNumber();
+    mEdges.mNextEdgeFetched = false;
+    mEdges.mMinimumPulseWidth = 0;
+    mEdges.mEdgeHeld = false;
+    mEdges.mGlitchSamples.clear();
+
+    mEstimateBitRate = mSettings->mUseAutobaud;
+    if (mEstimateBitRate == true) {
+        mBitRateEstimator.Init(mSampleRateHz, mSettings->mBitRate);
+        mHeldEdges.mDeltas.reserve(QI_AUTOBAUD_EDGES + mEdgeChunkSize);
+        mHoldingEdges = false;
     }
 
-    //to check for framing errors, we also want to check
-    //1/2 bit after the beginning of the stop bit
-    mStartOfStopBitOffset = clock_generator.AdvanceByTimeS(250e-6);   //i.e. moving from the center of the last data bit (where we left off) to 1/2 period into the stop bit
+    mDecodeFsk = mSettings->mFskMode != QiAnalyzerEnums::FskOff;
+    mTrackCarrier = mSettings->mCarrierInterval != 0;
+    mPullCarrier = mSettings->UsesCarrier();
+    mSharedCarrier = mPullCarrier == true && mSettings->mCarrierChannel == mSettings->mInputChannel;
+    if (mPullCarrier == true) {
+        mCarrier = (mSharedCarrier == true) ? mQi : GetAnalyzerChannelData(mSettings->mCarrierChannel);
+        mCarrierEdges.mDeltas.reserve(QI_CARRIER_EDGE_CHUNK_SIZE);
+        mCarrierEdges.mNextEdgeFetched = false;
+        mCarrierEdges.mMinimumPulseWidth = 0;
+        mCarrierEdges.mEdgeHeld = false;
+        mCarrierEdges.mGlitchSamples.clear();
+    }
 
-    //and 1/2 bit before end of the stop bit period
-    mEndOfStopBitOffset = clock_generator.AdvanceByHalfPeriod(mSettings->mStopBits - 1.0);  //if stopbits == 1.0, this will be 0
+    //every coil is a data line of its own, the data channel being the first; see DecodeCoilSlice.
+    mMultiCoil = mSettings->IsMultiCoil();
+    mCoils.clear();
+    if (mMultiCoil == true) {
+        for (U32 i = 0; i < QI_MAX_COILS; i++) {
+            if (mSettings->GetCoilChannel(i) == UNDEFINED_CHANNEL) {
+                continue;
+            }
+
+            QiCoil coil;
+            coil.mCoil = i;
+            coil.mChannel = mSettings->GetCoilChannel(i);
+            coil.mData = (i == 0) ? mQi : GetAnalyzerChannelData(coil.mChannel);
+            coil.mEdges.mNextEdgeFetched = false;
+            coil.mEdges.mMinimumPulseWidth = 0;
+            coil.mEdges.mEdgeHeld = false;
+            coil.mDecoder = mDecoder;
+            coil.mDecoder.Reset(coil.mData->GetSampleNumber());
+            mCoils.push_back(coil);
+        }
+
+        mSliceWidth = U64(QI_COIL_SLICE_BITS) * mSampleRateHz / mSettings->mBitRate;
+        if (mSliceWidth == 0) {
+            mSliceWidth = 1;
+        }
+        mSliceEnd = mQi->GetSampleNumber();
+    }
+
+    //the filter is for the line the receiver's data is on, which is the carrier itself when they are shared.
+    if (mSettings->mGlitchFilter != 0) {
+        U64 minimum_pulse_width = U64(mSettings->mGlitchFilter) * mSampleRateHz / 1000000000;
+        if (minimum_pulse_width == 0) {
+            minimum_pulse_width = 1;
+        }
+
+        QiEdgeBuffer &filtered_edges = (mSharedCarrier == true) ? mCarrierEdges : mEdges;
+        filtered_edges.mMinimumPulseWidth = minimum_pulse_width;
+        for (U32 i = 0; i < mCoils.size(); i++) {
+            mCoils[i].mEdges.mMinimumPulseWidth = minimum_pulse_width;
+        }
+    }
+    mGlitchWindow = U64(QI_GLITCH_WINDOW_BITS) * mSampleRateHz / mSettings->mBitRate;
+
+    if (mDecodeFsk == true) {
+        mFskDemodulator.Init(mSampleRateHz, mSettings->mFskThreshold, mSettings->mBitTolerance, num_bits, mSettings->mShiftOrder);
+        mFskDemodulator.Reset(mCarrier->GetSampleNumber());
+        mFskDemodulator.GetDecoder().SetMarkerCategories(marker_categories);
+    }
+
+    mMergePackets = mDecodeFsk == true || mMultiCoil == true;
+    if (mMergePackets == true) {
+        mPacketMerger.Init((mMultiCoil == true) ? U32(mCoils.size()) : QI_STREAM_COUNT);
+    }
+
+    if (mTrackCarrier == true) {
+        mCarrierTracker.Init(mSampleRateHz, mSettings->mCarrierInterval);
+        mCarrierTracker.Reset(mCarrier->GetSampleNumber(), mCarrier->GetBitState());
+    }
+
+    mPacketBytes.clear();
+    mPacketStartingSample = 0;
+    mPacketFlags = 0;
+    memset(mMaximumPowerMilliwatts, 0, sizeof(mMaximumPowerMilliwatts));
+    memset(&mErrorSummary, 0, sizeof(mErrorSummary));
+    mErrorSummary.mBitRate = mSettings->mBitRate;
+
+    mResults->CommitPacketAndStartNewPacket();
+
+    mInstrumentation.Reset();
+    mCommitPolicy.Reset(this, mResults.get(), &mInstrumentation);
+    AnalyzerCommitPolicy::FlushOnExit flush_on_exit(mCommitPolicy);
+
+    for (; ;) {
+        U32 result_count;
+        U64 progress_sample;
+        if (mPullCarrier == true) {
+            mCommitPolicy.FlushIfWaiting(mCarrier);
+            result_count = DecodeCarrierEdges();
+            progress_sample = mCarrier->GetSampleNumber();
+        } else if (mMultiCoil == true) {
+            mCommitPolicy.FlushIfWaiting(mQi);
+            result_count = DecodeCoilSlice();
+            progress_sample = mQi->GetSampleNumber();
+        } else if (mDecodeInParallel == true && mEstimateBitRate == false) {
+            mCommitPolicy.FlushIfWaiting(mQi);
+            result_count = DecodeEdgesOverlapped();
+            progress_sample = mDecodedSample;
+        } else {
+            mCommitPolicy.FlushIfWaiting(mQi);
+            FillEdgeBuffer(mQi, mEdges, mEdgeChunkSize);
+            if (mEstimateBitRate == true) {
+                result_count = HoldEdgesForBitRate();
+            } else {
+                result_count = DecodeEdgeBuffer(mEdges, GetAskDecoder(), QI_ASK_STREAM, mSettings->mInputChannel);
+            }
+            progress_sample = mQi->GetSampleNumber();
+        }
+
+        mResults->SetErrorSummary(mErrorSummary);
+        if (result_count != 0) {
+            mCommitPolicy.ResultsAdded(progress_sample, result_count);
+        } else {
+            mCommitPolicy.ProgressMade(progress_sample);
+        }
+
+        CheckIfThreadShouldExit();
+    }
 }
 
-void QiAnalyzer::SetupResults()
+void QiAnalyzer::FillEdgeBuffer(AnalyzerChannelData *channel, QiEdgeBuffer &buffer, U32 max_edges)
 {
-    //Unlike the worker thread, this function is called from the GUI thread
-    //we need to reset the Results object here because it is exposed for direct access by the GUI, and it can't be deleted from the WorkerThread
+    //wait for at least one edge, then take every edge that has already been captured, up to max_edges.
+    AnalyzerInstrumentation::StageTimer traversal_timer(mInstrumentation, StageEdgeTraversal);
+    buffer.mDeltas.clear();
+
+    bool started = false;
+    if (buffer.mNextEdgeFetched == true) {
+        buffer.mStart = buffer.mNextEdge;
+        buffer.mNextEdgeFetched = false;
+        started = true;
+    }
 
-    mResults.reset(new QiAnalyzerResults(this, mSettings.get()));
-    SetAnalyzerResults(mResults.get());
-    mResults->AddChannelBubblesWillAppearOn(mSettings->mInputChannel);
+    while (started == false) {
+        channel->AdvanceToNextEdge();
+        started = FilterEdge(buffer, channel->GetSampleNumber(), buffer.mStart);
+    }
+
+    U64 edge = buffer.mStart;
+
+    if (buffer.mMinimumPulseWidth == 0) {
+        PullEdges(channel, buffer, edge, max_edges);
+        mInstrumentation.Count(CounterEdges, buffer.mDeltas.size() + 1);
+        return;
+    }
+
+    while (buffer.mDeltas.size() < max_edges) {
+        U64 next_edge;
+        if (channel->DoMoreTransitionsExistInCurrentData() == true) {
+            channel->AdvanceToNextEdge();
+            if (FilterEdge(buffer, channel->GetSampleNumber(), next_edge) == false) {
+                continue;
+            }
+        } else if (ReleaseHeldEdge(channel, buffer, 0xFFFFFFFFFFFFFFFFull, next_edge) == false) {
+            break;
+        }
+
+        if (AppendEdge(buffer, edge, next_edge) == false) {
+            break;
+        }
+    }
+
+    mInstrumentation.Count(CounterEdges, buffer.mDeltas.size() + 1);
 }
 
+void QiAnalyzer::PullEdges(AnalyzerChannelData *channel, QiEdgeBuffer &buffer, U64 edge, U32 max_edges)
+{
+    //without the glitch filter every edge goes straight in: the three channel calls it takes, and a subtraction.
+    buffer.mDeltas.resize(max_edges);
+    U32 *deltas = buffer.mDeltas.data();
+    U32 count = 0;
+
+    while (count < max_edges && channel->DoMoreTransitionsExistInCurrentData() == true) {
+        channel->AdvanceToNextEdge();
+        U64 next_edge = channel->GetSampleNumber();
+        if (next_edge - edge > 0xFFFFFFFFull) {
+            //too long for a delta, it starts the next chunk instead.
+            buffer.mNextEdge = next_edge;
+            buffer.mNextEdgeFetched = true;
+            break;
+        }
+
+        deltas[count++] = U32(next_edge - edge);
+        edge = next_edge;
+    }
+
+    buffer.mDeltas.resize(count);
+}
 
-int QiAnalyzer::Qi_bit_cal(AnalyzerChannelData * pQi)
+bool QiAnalyzer::FillEdgeBufferUntil(AnalyzerChannelData *channel, QiEdgeBuffer &buffer, U32 max_edges, U64 sample)
 {
-    U64 frame_cnt1, frame_cnt2;
-    frame_cnt1 = pQi->GetSampleNumber();
-    /* 0->1 */
-    pQi->AdvanceToNextEdge();
-    frame_cnt2 = pQi->GetSampleNumber();
-    if (cal_diff(frame_cnt1, frame_cnt2) == 0) {
-        mResults->AddMarker(frame_cnt2, AnalyzerResults::Dot, mSettings->mInputChannel);
-        return 0;
-    } else if (cal_diff(frame_cnt1, frame_cnt2) == 1) {
-        frame_cnt1 = pQi->GetSampleNumber();
-        /* 0->1 */
-        pQi->AdvanceToNextEdge();
-        frame_cnt2 = pQi->GetSampleNumber();
-        if (cal_diff(frame_cnt1, frame_cnt2) == 1) {
-            mResults->AddMarker(frame_cnt2, AnalyzerResults::Dot, mSettings->mInputChannel);
-            return 1;
+    //like FillEdgeBuffer, but only the edges up to sample, which another channel has already reached; false if there are none.
+    AnalyzerInstrumentation::StageTimer traversal_timer(mInstrumentation, StageEdgeTraversal);
+    buffer.mDeltas.clear();
+
+    bool started = false;
+    if (buffer.mNextEdgeFetched == true) {
+        if (buffer.mNextEdge > sample) {
+            return false;
         }
+        buffer.mStart = buffer.mNextEdge;
+        buffer.mNextEdgeFetched = false;
+        started = true;
     }
 
-    mResults->AddMarker(frame_cnt2, AnalyzerResults::Dot, mSettings->mInputChannel);
-    return -1;
+    U64 edge = buffer.mStart;
+
+    while (started == false || buffer.mDeltas.size() < max_edges) {
+        U64 next_edge;
+        if (channel->WouldAdvancingToAbsPositionCauseTransition(sample) == true) {
+            channel->AdvanceToNextEdge();
+            if (FilterEdge(buffer, channel->GetSampleNumber(), next_edge) == false) {
+                continue;
+            }
+        } else if (ReleaseHeldEdge(channel, buffer, sample, next_edge) == false) {
+            break;
+        }
+
+        if (started == false) {
+            buffer.mStart = next_edge;
+            edge = next_edge;
+            started = true;
+            continue;
+        }
+
+        if (AppendEdge(buffer, edge, next_edge) == false) {
+            break;
+        }
+    }
+
+    if (started == true) {
+        mInstrumentation.Count(CounterEdges, buffer.mDeltas.size() + 1);
+    }
+    return started;
 }
 
-void QiAnalyzer::WorkerThread()
+bool QiAnalyzer::AppendEdge(QiEdgeBuffer &buffer, U64 &edge, U64 next_edge)
 {
-    mSampleRateHz = GetSampleRate();
-    /* Sets the length of each bit of the protocol */
-    ComputeSampleOffsets();
-    U32 num_bits = mSettings->mBitsPerTransfer;
-    static bool should_detect_preamble = true;
+    if (next_edge - edge > 0xFFFFFFFFull) {
+        //too long for a delta, it starts the next chunk instead.
+        buffer.mNextEdge = next_edge;
+        buffer.mNextEdgeFetched = true;
+        return false;
+    }
 
-    should_detect_preamble = true;
-    if (mSettings->mQiMode != QiAnalyzerEnums::Normal) {
-        num_bits++;
+    buffer.mDeltas.push_back(U32(next_edge - edge));
+    edge = next_edge;
+    return true;
+}
+
+bool QiAnalyzer::FilterEdge(QiEdgeBuffer &buffer, U64 pulled_edge, U64 &edge)
+{
+    if (buffer.mMinimumPulseWidth == 0) {
+        edge = pulled_edge;
+        return true;
     }
 
-    if (mSettings->mInverted == false) {
-        mBitHigh = BIT_HIGH;
-        mBitLow = BIT_LOW;
-    } else {
-        mBitHigh = BIT_LOW;
-        mBitLow = BIT_HIGH;
+    //every edge is held until the next one shows it doesn't start a runt. A runt takes both its edges
+    //with it, which merges it into the pulses on either side before the decoder sees any of them.
+    if (buffer.mEdgeHeld == false) {
+        buffer.mHeldEdge = pulled_edge;
+        buffer.mEdgeHeld = true;
+        return false;
     }
 
-    U64 bit_mask = 0;
-    U64 mask = 0x1ULL;
-    BOOL start;
-    for (U32 i = 0; i < num_bits; i++) {
-        bit_mask |= mask;
-        mask <<= 1;
+    if (pulled_edge - buffer.mHeldEdge < buffer.mMinimumPulseWidth) {
+        buffer.mGlitchSamples.push_back(buffer.mHeldEdge);
+        mErrorSummary.mGlitches++;
+        buffer.mEdgeHeld = false;
+        return false;
     }
 
-    mQi = GetAnalyzerChannelData(mSettings->mInputChannel);
-    mQi->TrackMinimumPulseWidth();
+    edge = buffer.mHeldEdge;
+    buffer.mHeldEdge = pulled_edge;
+    return true;
+}
 
-    /* find start data frame */
-retry:
-    if (mQi->GetBitState() == mBitHigh) {
-        mQi->AdvanceToNextEdge();
+bool QiAnalyzer::ReleaseHeldEdge(AnalyzerChannelData *channel, QiEdgeBuffer &buffer, U64 last_sample, U64 &edge)
+{
+    //no edge after the held one yet; it goes on once the line has been quiet for a whole pulse after it,
+    //otherwise the edge that ends the last packet would wait for an edge that may never come.
+    if (buffer.mEdgeHeld == false) {
+        return false;
     }
 
+    U64 pulse_end = buffer.mHeldEdge + buffer.mMinimumPulseWidth - 1;
+    if (pulse_end > last_sample || channel->WouldAdvancingToAbsPositionCauseTransition(pulse_end) == true) {
+        return false;
+    }
 
-    U64 frame_starting_pos = mQi->GetSampleNumber();
-    /* 0->1 */
-    mQi->AdvanceToNextEdge();
-    U64 frame_starting_pos_2 = mQi->GetSampleNumber();
-    if (frame_starting_pos_2 - frame_starting_pos > 80000) {
-        start = true;
-    } else {
-        start = false;
-        goto retry;
+    edge = buffer.mHeldEdge;
+    buffer.mEdgeHeld = false;
+    return true;
+}
+
+U64 QiAnalyzer::GetQuietSample(const QiEdgeBuffer &buffer, U64 sample) const
+{
+    return (buffer.mEdgeHeld == true) ? buffer.mHeldEdge : sample;
+}
+
+void QiAnalyzer::DropOldGlitches(QiEdgeBuffer &buffer, U64 edge_sample)
+{
+    //keeps glitches outside of any packet from piling up over a long capture.
+    while (buffer.mGlitchSamples.empty() == false && buffer.mGlitchSamples.front() + mGlitchWindow < edge_sample) {
+        buffer.mGlitchSamples.pop_front();
     }
+}
 
-    /* if goto here, start parsing protocol */
-    for (; ;) {
-        //we're now at the beginning of the start bit.  We can start collecting the data.
-        U64 frame_starting_sample = mQi->GetSampleNumber();
-        static U8 preamble_cnt;
-        U64 data = 0;
-        BOOL last_status, current_status;
-        bool framing_error = false;
-        bool mp_is_address = false;
-
-
-        DataBuilder data_builder;
-        data_builder.Reset(&data, mSettings->mShiftOrder, num_bits);
-        U64 marker_location = frame_starting_sample;
-        U64 frame_cnt1, frame_cnt2;
-        
-        preamble_cnt = 0;
-        if (should_detect_preamble == true) {
-            for (INT i = 0; i < 25; i++) {
-                BOOL tmp_preamble_bit;
-                tmp_preamble_bit = Qi_bit_cal(mQi);
-                if (tmp_preamble_bit == 0) {
-                    /* find start bit */
-                    break;
-                } else if (tmp_preamble_bit == 1) {
-                    preamble_cnt++;
-                }
+QiEdgeBuffer &QiAnalyzer::GetFilteredEdges(U32 coil)
+{
+    if (mMultiCoil == true) {
+        for (U32 i = 0; i < mCoils.size(); i++) {
+            if (mCoils[i].mCoil == coil) {
+                return mCoils[i].mEdges;
             }
         }
+    }
 
-        BOOL tmp_start_bit;
+    return (mSharedCarrier == true) ? mCarrierEdges : mEdges;
+}
 
-        /* parsing 8bit */
-        for (U32 i = 0; i < num_bits; i++) {
-            tmp_start_bit = Qi_bit_cal(mQi);
-            if (tmp_start_bit) {
-                data_builder.AddBit(BIT_HIGH);
-            } else {
-                data_builder.AddBit(BIT_LOW);
-            }
+U32 QiAnalyzer::DecodeEdgeBuffer(QiEdgeBuffer &buffer, QiDecoder &decoder, U32 stream, Channel &channel)
+{
+    //decoder is the one of the data line, the ASK demodulator's when the data line is a carrier.
+    AnalyzerInstrumentation::StageTimer bit_timer(mInstrumentation, StageBitDecode);
+    U32 result_count;
+    if (mAskFromCarrier == true) {
+        mAskDemodulator.DecodeEdges(buffer.mStart, buffer.mDeltas.data(), U32(buffer.mDeltas.size()));
+        result_count = CommitDecoderOutput(decoder, stream, channel);
+    } else if (mDecodeInParallel == true) {
+        mParallelDecoder.DecodeEdges(decoder, buffer.mStart, buffer.mDeltas.data(), U32(buffer.mDeltas.size()));
+        result_count = CommitSegmentOutput(decoder, stream, channel);
+    } else {
+        decoder.DecodeEdges(buffer.mStart, buffer.mDeltas.data(), U32(buffer.mDeltas.size()));
+        result_count = CommitDecoderOutput(decoder, stream, channel);
+    }
+
+    DropOldGlitches(buffer, decoder.GetEdgeSample());
+    return result_count;
+}
+
+U32 QiAnalyzer::CommitSegmentOutput(QiDecoder &decoder, U32 stream, Channel &channel)
+{
+    //segments are in sample order, so committing them one after the other matches the sequential decode.
+    U32 result_count = 0;
+    U32 segment_count = mParallelDecoder.GetSegmentCount();
+    for (U32 i = 0; i < segment_count; i++) {
+        result_count += CommitDecoderOutput(mParallelDecoder.GetSegmentDecoder(i), stream, channel);
+    }
+
+    mParallelDecoder.CarryState(decoder);
+    return result_count;
+}
+
+U32 QiAnalyzer::DecodeEdgesOverlapped()
+{
+    //Only this thread may call the channel, so on several threads the edges are still pulled one at a time here;
+    //the pool decodes the chunk pulled before in the meantime, and the pull and decode overlap instead of taking turns.
+    //The output of a chunk is committed once the next one has been pulled, in order, so it is the same as DecodeEdgeBuffer's.
+    //A pull that would wait for more of the capture finishes the chunk in flight first, so its results don't wait too.
+    if (mDecoding == true && mQi->DoMoreTransitionsExistInCurrentData() == false) {
+        return FinishOverlappedDecode();
+    }
+
+    FillEdgeBuffer(mQi, mEdges, mEdgeChunkSize);
+
+    U32 result_count = 0;
+    if (mDecoding == true) {
+        result_count = FinishOverlappedDecode();
+    }
+
+    mDecodingDeltas.swap(mEdges.mDeltas);
+    mDecodingStart = mEdges.mStart;
+    mDecodingEnd = mQi->GetSampleNumber();
+    mParallelDecoder.StartDecodeEdges(mDecoder, mDecodingStart, mDecodingDeltas.data(), U32(mDecodingDeltas.size()));
+    mDecoding = true;
+    return result_count;
+}
+
+U32 QiAnalyzer::FinishOverlappedDecode()
+{
+    AnalyzerInstrumentation::StageTimer bit_timer(mInstrumentation, StageBitDecode);
+    mParallelDecoder.FinishDecodeEdges();
+    mDecoding = false;
+
+    U32 result_count = CommitSegmentOutput(mDecoder, QI_ASK_STREAM, mSettings->mInputChannel);
+    DropOldGlitches(mEdges, mDecoder.GetEdgeSample());
+    mDecodedSample = mDecodingEnd;
+    return result_count;
+}
+
+U32 QiAnalyzer::HoldEdgesForBitRate()
+{
+    //the chunk just pulled joins the edges held so far, unless the gap before it is too long for a delta.
+    AnalyzerInstrumentation::StageTimer bit_timer(mInstrumentation, StageBitDecode);
+    bool gap_too_long = false;
+    if (mHoldingEdges == false) {
+        mHeldEdges.mStart = mEdges.mStart;
+        mHeldEdges.mDeltas.clear();
+        mHeldEdgesEnd = mEdges.mStart;
+        mHoldingEdges = true;
+    } else if (mEdges.mStart - mHeldEdgesEnd > 0xFFFFFFFFull) {
+        gap_too_long = true;
+    } else {
+        U32 delta = U32(mEdges.mStart - mHeldEdgesEnd);
+        mHeldEdges.mDeltas.push_back(delta);
+        mBitRateEstimator.AddWidth(delta);
+        mHeldEdgesEnd = mEdges.mStart;
+    }
+
+    if (gap_too_long == false) {
+        U32 count = U32(mEdges.mDeltas.size());
+        mHeldEdges.mDeltas.insert(mHeldEdges.mDeltas.end(), mEdges.mDeltas.begin(), mEdges.mDeltas.end());
+        mBitRateEstimator.AddDeltas(mEdges.mDeltas.data(), count);
+        for (U32 i = 0; i < count; i++) {
+            mHeldEdgesEnd += mEdges.mDeltas[i];
         }
+    }
+
+    //the estimate is made once there are enough edges, or once the capture has no more of them for now,
+    //so that a short capture isn't held back for good.
+    if (gap_too_long == false && mBitRateEstimator.GetWidthCount() < QI_AUTOBAUD_EDGES && mQi->DoMoreTransitionsExistInCurrentData() == true) {
+        return 0;
+    }
 
-        /* get parity bit */
-        Qi_bit_cal(mQi);
+    SetBitRate(mBitRateEstimator.GetBitRate());
+    mEstimateBitRate = false;
 
-        /* get stop bit */
-        tmp_start_bit = Qi_bit_cal(mQi);
+    //the held edges go through mEdges, which has the glitches the filter took out of them.
+    std::vector<U32> chunk;
+    U64 chunk_start = mEdges.mStart;
+    if (gap_too_long == true) {
+        chunk.swap(mEdges.mDeltas);
+    }
 
-        U64 this_bit_length = mQi->GetSampleNumber();
-        U64 next_bit_length = mQi->GetSampleOfNextEdge();
+    mEdges.mDeltas.swap(mHeldEdges.mDeltas);
+    mEdges.mStart = mHeldEdges.mStart;
+    U32 result_count = DecodeEdgeBuffer(mEdges, GetAskDecoder(), QI_ASK_STREAM, mSettings->mInputChannel);
 
-        if (next_bit_length - this_bit_length > 80000) {
-            should_detect_preamble = true;
-        } else {
-            should_detect_preamble = false;
-            Qi_bit_cal(mQi);
+    if (gap_too_long == true) {
+        mEdges.mDeltas.swap(chunk);
+        mEdges.mStart = chunk_start;
+        result_count += DecodeEdgeBuffer(mEdges, GetAskDecoder(), QI_ASK_STREAM, mSettings->mInputChannel);
+    }
+
+    std::vector<U32>().swap(mHeldEdges.mDeltas);
+    return result_count;
+}
+
+void QiAnalyzer::SetBitRate(U32 bit_rate)
+{
+    mDecoder.SetBitRate(mSampleRateHz, bit_rate, mSettings->mBitTolerance);
+    if (mDecodeInParallel == true) {
+        mParallelDecoder.Init(mDecoder, mSettings->mDecodeThreads);
+    }
+
+    mGlitchWindow = U64(QI_GLITCH_WINDOW_BITS) * mSampleRateHz / bit_rate;
+    mErrorSummary.mBitRate = bit_rate;
+}
+
+U32 QiAnalyzer::DecodeCarrierEdges()
+{
+    //a chunk of the carrier, then the data line up to the same sample.
+    AnalyzerInstrumentation::StageTimer bit_timer(mInstrumentation, StageBitDecode);
+    FillEdgeBuffer(mCarrier, mCarrierEdges, QI_CARRIER_EDGE_CHUNK_SIZE);
+    const U32 *deltas = mCarrierEdges.mDeltas.data();
+    U32 count = U32(mCarrierEdges.mDeltas.size());
+    if (mDecodeFsk == true) {
+        mFskDemodulator.DecodeEdges(mCarrierEdges.mStart, deltas, count);
+    }
+    if (mTrackCarrier == true) {
+        mCarrierTracker.AddEdges(mCarrierEdges.mStart, deltas, count);
+    }
+    U64 sample = mCarrier->GetSampleNumber();
+
+    U32 result_count = 0;
+    if (mSharedCarrier == true) {
+        mAskDemodulator.DecodeEdges(mCarrierEdges.mStart, deltas, count);
+    } else {
+        while (FillEdgeBufferUntil(mQi, mEdges, mEdgeChunkSize, sample) == true) {
+            result_count += DecodeEdgeBuffer(mEdges, GetAskDecoder(), QI_ASK_STREAM, mSettings->mInputChannel);
         }
+    }
 
-        //ok now record the value!
-        //note that we're not using the mData2 or mType fields for anything, so we won't bother to set them.
-        Frame frame;
-        frame.mStartingSampleInclusive = frame_starting_sample;
-        frame.mEndingSampleInclusive = mQi->GetSampleNumber();
-        frame.mData1 = data;
-        frame.mFlags = 0;
+    if (mDecodeFsk == true) {
+        //both decoders are told how far the lines are known to be quiet, so held packets can go out in order.
+        //an edge held by the glitch filter hasn't been decoded yet, the line is only known to be quiet up to it.
+        if (mAskFromCarrier == true) {
+            U64 quiet_sample = GetQuietSample((mSharedCarrier == true) ? mCarrierEdges : mEdges, sample);
+            mPacketMerger.SetHorizon(QI_ASK_STREAM, mAskDemodulator.DecodeSilence(quiet_sample));
+        } else {
+            U64 quiet_sample = GetQuietSample(mEdges, sample);
+            mPacketMerger.SetHorizon(QI_ASK_STREAM, mDecoder.DecodeSilence(quiet_sample - mDecoder.GetEdgeSample(), quiet_sample));
+        }
+        mPacketMerger.SetHorizon(QI_FSK_STREAM, mFskDemodulator.DecodeSilence());
+    }
 
-        mResults->AddFrame(frame);
+    result_count += CommitDecoderOutput(GetAskDecoder(), QI_ASK_STREAM, mSettings->mInputChannel);
+    if (mDecodeFsk == true) {
+        result_count += CommitDecoderOutput(mFskDemodulator.GetDecoder(), QI_FSK_STREAM, mSettings->mCarrierChannel);
+        result_count += CommitMergedPackets();
+    }
+    if (mTrackCarrier == true) {
+        result_count += CommitCarrierPoints();
+    }
+    if (mSharedCarrier == true) {
+        DropOldGlitches(mCarrierEdges, GetAskDecoder().GetEdgeSample());
+    }
+    return result_count;
+}
 
-        mResults->CommitResults();
+U32 QiAnalyzer::DecodeCoilSlice()
+{
+    //every coil is decoded up to the end of the slice, so each decoder can say how far it is known to be
+    //quiet, and the packets no other coil can start before any more go out in the order they started.
+    //Every edge up to the end of the last slice has been taken, this only moves the data channel along to it.
+    AnalyzerInstrumentation::StageTimer bit_timer(mInstrumentation, StageBitDecode);
+    mQi->AdvanceToAbsPosition(mSliceEnd);
+
+    mSliceEnd += mSliceWidth;
+    U64 sample = mSliceEnd;
+    U32 result_count = 0;
+
+    U32 coil_count = U32(mCoils.size());
+    for (U32 i = 0; i < coil_count; i++) {
+        QiCoil &coil = mCoils[i];
+        while (FillEdgeBufferUntil(coil.mData, coil.mEdges, mEdgeChunkSize, sample) == true) {
+            result_count += DecodeEdgeBuffer(coil.mEdges, coil.mDecoder, i, coil.mChannel);
+        }
 
-        ReportProgress(frame.mEndingSampleInclusive);
-        CheckIfThreadShouldExit();
+        U64 quiet_sample = GetQuietSample(coil.mEdges, sample);
+        mPacketMerger.SetHorizon(i, coil.mDecoder.DecodeSilence(quiet_sample - coil.mDecoder.GetEdgeSample(), quiet_sample));
+        result_count += CommitDecoderOutput(coil.mDecoder, i, coil.mChannel);
     }
+
+    result_count += CommitMergedPackets();
+    return result_count;
 }
 
-bool QiAnalyzer::NeedsRerun()
+U32 QiAnalyzer::CommitDecoderOutput(QiDecoder &decoder, U32 stream, Channel &channel)
 {
-    if (mSettings->mUseAutobaud == false) {
-        return false;
+    const QiDecoderWork &work = decoder.GetWork();
+    mInstrumentation.Count(CounterBits, work.mBits);
+    mInstrumentation.Count(CounterResyncs, work.mResyncs);
+    mInstrumentation.Count(CounterResyncEdges, work.mResyncWidths);
+
+    const QiMarkerCounts &marker_counts = decoder.GetMarkerCounts();
+    mErrorSummary.mMarkersEmitted += marker_counts.mEmitted;
+    mErrorSummary.mMarkersSuppressed += marker_counts.mSuppressed;
+
+    const std::vector<QiMarker> &markers = decoder.GetMarkers();
+    U32 marker_count = U32(markers.size());
+    AnalyzerStage previous_stage = mInstrumentation.EnterStage(StageMarkers);
+    for (U32 i = 0; i < marker_count; i++) {
+        mResults->AddMarker(markers[i].mSample, markers[i].mType, channel);
     }
+    mInstrumentation.Count(CounterMarkers, marker_count);
+
+    //in FSK and multi-coil mode the bytes wait in the merger until their packet's turn.
+    mInstrumentation.EnterStage(StageFrames);
+    const std::vector<QiDecodedByte> &bytes = decoder.GetBytes();
+    U32 byte_count = 0;
+    if (mMergePackets == true) {
+        mPacketMerger.AddBytes(stream, bytes);
+    } else {
+        byte_count = U32(bytes.size());
+        for (U32 i = 0; i < byte_count; i++) {
+            CommitByte(bytes[i], 0, 0);
+        }
+    }
+
+    mInstrumentation.LeaveStage(previous_stage);
 
-    //ok, lets see if we should change the bit rate, base on mShortestActivePulse
+    decoder.ClearOutput();
+    return marker_count + byte_count;
+}
 
-    U64 shortest_pulse = mQi->GetMinimumPulseWidthSoFar();
+QiDecoder &QiAnalyzer::GetAskDecoder()
+{
+    return (mAskFromCarrier == true) ? mAskDemodulator.GetDecoder() : mDecoder;
+}
+
+U32 QiAnalyzer::CommitMergedPackets()
+{
+    AnalyzerInstrumentation::StageTimer frame_timer(mInstrumentation, StageFrames);
+    U32 result_count = 0;
+    U32 stream;
+    while (mPacketMerger.GetNextPacket(stream, mMergedPacket) == true) {
+        U8 flags = 0;
+        U32 coil = 0;
+        if (mMultiCoil == true) {
+            coil = mCoils[stream].mCoil;
+        } else if (stream == QI_FSK_STREAM) {
+            flags = TRANSMITTER_FRAME_FLAG;
+        }
 
-    if (shortest_pulse == 0) {
-        AnalyzerHelpers::Assert("Alg problem, shortest_pulse was 0");
+        U32 byte_count = U32(mMergedPacket.size());
+        for (U32 i = 0; i < byte_count; i++) {
+            CommitByte(mMergedPacket[i], flags, coil);
+        }
+        result_count += byte_count;
     }
 
-    U32 computed_bit_rate = U32(double(mSampleRateHz) / double(shortest_pulse));
+    return result_count;
+}
 
-    if (computed_bit_rate > mSampleRateHz) {
-        AnalyzerHelpers::Assert("Alg problem, computed_bit_rate is higer than sample rate");    //just checking the obvious...
+U32 QiAnalyzer::CommitCarrierPoints()
+{
+    const std::vector<QiCarrierPoint> &points = mCarrierTracker.GetPoints();
+    U32 point_count = U32(points.size());
+    if (point_count != 0) {
+        mResults->AddCarrierPoints(points);
+        mCarrierTracker.ClearPoints();
     }
+    return point_count;
+}
 
-    if (computed_bit_rate > (mSampleRateHz / 4)) {
-        return false;    //the baud rate is too fast.
+void QiAnalyzer::CommitByte(const QiDecodedByte &byte, U8 flags, U32 coil)
+{
+    Frame frame;
+    frame.mStartingSampleInclusive = byte.mStartingSample;
+    frame.mEndingSampleInclusive = byte.mEndingSample;
+    frame.mData1 = byte.mValue;
+    frame.mData2 = byte.mExpected;
+    frame.mType = U8(byte.mType | (coil << QI_FRAME_COIL_SHIFT));
+    frame.mFlags = byte.mFlags | flags;
+    mResults->AddFrame(frame);
+    mInstrumentation.Count(CounterFrames);
+
+    //the packet's bytes are kept until it ends, it may span several chunks.
+    if (byte.mType == QiHeaderFrame) {
+        mPacketBytes.clear();
+        mPacketStartingSample = byte.mStartingSample;
     }
-    if (computed_bit_rate == 0) {
-        //bad result, this is not good data, don't bother to re-run.
-        return false;
+    if (byte.mType == QiHeaderFrame || byte.mType == QiMessageFrame) {
+        mPacketBytes.push_back(byte.mValue);
     }
+    mPacketFlags |= frame.mFlags;
 
-    U32 specified_bit_rate = mSettings->mBitRate;
+    if (byte.mType != QiBitErrorFrame) {
+        mErrorSummary.mBytes++;
+    }
+    if ((frame.mFlags & PARITY_ERROR_FLAG) != 0) {
+        mErrorSummary.mParityErrors++;
+    }
+    if ((frame.mFlags & FRAMING_ERROR_FLAG) != 0) {
+        mErrorSummary.mFramingErrors++;
+    }
 
-    double error = double(AnalyzerHelpers::Diff32(computed_bit_rate, specified_bit_rate)) / double(specified_bit_rate);
+    if (byte.mEndsPacket == true) {
+        mErrorSummary.mPackets++;
+        if ((mPacketFlags & QI_PACKET_ERROR_FLAGS) != 0) {
+            mErrorSummary.mErrorPackets++;
+        }
+        if ((frame.mFlags & CHECKSUM_ERROR_FLAG) != 0) {
+            mErrorSummary.mChecksumErrors++;
+        }
+        if ((frame.mFlags & TRUNCATED_PACKET_FLAG) != 0) {
+            mErrorSummary.mTruncatedPackets++;
+        }
+        if (byte.mType == QiBitErrorFrame) {
+            mErrorSummary.mBitErrors++;
+        }
 
-    if (error > 0.1) {
-        mSettings->mBitRate = computed_bit_rate;
-        mSettings->UpdateInterfacesFromSettings();
-        return true;
-    } else {
-        return false;
+        U64 packet_id = mResults->CommitPacketAndStartNewPacket();
+        CommitPacketRecord(packet_id, mPacketFlags, byte.mEndingSample, coil);
+        mPacketFlags = 0;
+    }
+}
+
+void QiAnalyzer::CommitPacketRecord(U64 packet_id, U8 flags, U64 ending_sample, U32 coil)
+{
+    if (mPacketBytes.empty() == true) {
+        return;
     }
+
+    QiPacketRecord record;
+    QiMessage::Decode(mPacketBytes.data(), U32(mPacketBytes.size()), flags, mMaximumPowerMilliwatts[coil], record);
+    record.mCoil = U8(coil);
+    mPacketBytes.clear();
+
+    //the glitches filtered out of the receiver's packet; those before it were in no packet.
+    if ((flags & TRANSMITTER_FRAME_FLAG) == 0) {
+        std::deque<U64> &glitch_samples = GetFilteredEdges(coil).mGlitchSamples;
+        while (glitch_samples.empty() == false && glitch_samples.front() < mPacketStartingSample) {
+            glitch_samples.pop_front();
+        }
+        while (glitch_samples.empty() == false && glitch_samples.front() <= ending_sample) {
+            if (record.mGlitchCount != 0xFF) {
+                record.mGlitchCount++;
+            }
+            glitch_samples.pop_front();
+        }
+    }
+
+    //received power is scaled by the maximum power of the coil's last good configuration packet.
+    if (record.mType == QiConfigurationPacket && (record.mFlags & QI_PACKET_ERROR_FLAGS) == 0) {
+        mMaximumPowerMilliwatts[coil] = QiMessage::GetMaximumPowerMilliwatts(record);
+    }
+
+    mResults->AddPacketRecord(packet_id, record);
+}
+
+AnalyzerInstrumentation &QiAnalyzer::GetInstrumentation()
+{
+    return mInstrumentation;
+}
+
+bool QiAnalyzer::NeedsRerun()
+{
+    //autobaud estimates the bit rate from the first edges before decoding them, see HoldEdgesForBitRate.
+    return false;
 }
 
 U32 QiAnalyzer::GenerateSimulationData(U64 minimum_sample_index, U32 device_sample_rate, SimulationChannelDescriptor **simulation_channels)
@@ -280,7 +835,25 @@ U32 QiAnalyzer::GenerateSimulationData(U64 minimum_sample_index, U32 device_samp
 
 U32 QiAnalyzer::GetMinimumSampleRateHz()
 {
-    return mSettings->mBitRate * 4;
+    U64 minimum_sample_rate = U64(mSettings->mBitRate) * 4;
+
+    if (mSettings->mAskInput == QiAnalyzerEnums::AskFromCarrier) {
+        //the duty threshold has to be at least 2 samples over a measurement window of a 200 kHz carrier.
+        U64 sample_rate = 2000ull * 200000 / (U64(mSettings->mAskThreshold) * QI_ASK_WINDOW_CYCLES);
+        if (sample_rate > minimum_sample_rate) {
+            minimum_sample_rate = sample_rate;
+        }
+    }
+
+    if (mSettings->mFskMode != QiAnalyzerEnums::FskOff) {
+        //the FSK threshold has to be at least 2 samples over a measurement window.
+        U64 sample_rate = 2000000000ull / (U64(mSettings->mFskThreshold) * QI_FSK_WINDOW_CYCLES);
+        if (sample_rate > minimum_sample_rate) {
+            minimum_sample_rate = sample_rate;
+        }
+    }
+
+    return U32(minimum_sample_rate);
 }
 
 const char *QiAnalyzer::GetAnalyzerName() const
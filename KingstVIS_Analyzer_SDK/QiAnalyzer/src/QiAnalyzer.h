@@ -4,14 +4,55 @@
 #include <Analyzer.h>
 #include "QiAnalyzerResults.h"
 #include "QiSimulationDataGenerator.h"
+#include "QiDecoder.h"
+#include "QiParallelDecoder.h"
+#include "QiFskDemodulator.h"
+#include "QiAskDemodulator.h"
+#include "QiPacketMerger.h"
+#include "QiCarrierTracker.h"
+#include "QiBitRateEstimator.h"
+#include "QiAnalyzerSettings.h"
+#include "AnalyzerCommitPolicy.h"
+#include <deque>
 
-class QiAnalyzerSettings;
+#define QI_EDGE_CHUNK_SIZE 65536  //number of edges pulled from the channel per decode pass
+#define QI_PARALLEL_EDGE_CHUNK_SIZE (1 << 20)    //larger chunks when decoding on several threads, so each has enough to do
+#define QI_CARRIER_EDGE_CHUNK_SIZE (1 << 18)     //carrier edges pulled per pass; the data line follows up to the same sample
+#define QI_GLITCH_WINDOW_BITS 4096  //glitches this many bit cells before the last edge decoded can't be in a packet still to come
+#define QI_COIL_SLICE_BITS 1024     //in multi-coil mode, every coil is decoded up to the same sample, this many bit cells at a time
+
+//packet streams merged in FSK mode
+#define QI_ASK_STREAM 0
+#define QI_FSK_STREAM 1
+#define QI_STREAM_COUNT 2
+
+//edges pulled from a channel, as the widths between them
+struct QiEdgeBuffer {
+    std::vector<U32> mDeltas;
+    U64 mStart;
+    U64 mNextEdge;
+    bool mNextEdgeFetched;  //an edge too far from the last one for a delta, it starts the next buffer
+
+    //glitch filter: pulses shorter than this are dropped with both their edges, 0 = off
+    U64 mMinimumPulseWidth;
+    bool mEdgeHeld;         //the last edge pulled, not passed on until the pulse it starts is known to be long enough
+    U64 mHeldEdge;
+    std::deque<U64> mGlitchSamples;     //absorbed by the filter, until the packet they fell in is committed
+};
+
+//one coil of a multi-coil transmitter: a demodulated data line with a decoder of its own
+struct QiCoil {
+    U32 mCoil;          //0 is the data channel, i is "Coil i+1"
+    Channel mChannel;
+    AnalyzerChannelData *mData;
+    QiEdgeBuffer mEdges;
+    QiDecoder mDecoder;
+};
 
 class ANALYZER_EXPORT QiAnalyzer : public Analyzer
 {
 public:
     QiAnalyzer();
-    int Qi_bit_cal(AnalyzerChannelData * pQi);
     virtual ~QiAnalyzer();
     virtual void SetupResults();
     virtual void WorkerThread();
@@ -22,29 +63,107 @@ public:
     virtual const char *GetAnalyzerName() const;
     virtual bool NeedsRerun();
 
+    //read by the instrumentation report export, see AnalyzerInstrumentation.h
+    AnalyzerInstrumentation &GetInstrumentation();
+
 
 #pragma warning( push )
 #pragma warning( disable : 4251 ) //warning C4251: 'QiAnalyzer::<...>' : class <...> needs to have dll-interface to be used by clients of class
 
 protected: //functions
-    void ComputeSampleOffsets();
+    void FillEdgeBuffer(AnalyzerChannelData *channel, QiEdgeBuffer &buffer, U32 max_edges);
+    void PullEdges(AnalyzerChannelData *channel, QiEdgeBuffer &buffer, U64 edge, U32 max_edges);
+    bool FillEdgeBufferUntil(AnalyzerChannelData *channel, QiEdgeBuffer &buffer, U32 max_edges, U64 sample);
+    bool AppendEdge(QiEdgeBuffer &buffer, U64 &edge, U64 next_edge);
+    bool FilterEdge(QiEdgeBuffer &buffer, U64 pulled_edge, U64 &edge);
+    bool ReleaseHeldEdge(AnalyzerChannelData *channel, QiEdgeBuffer &buffer, U64 last_sample, U64 &edge);
+    U64 GetQuietSample(const QiEdgeBuffer &buffer, U64 sample) const;
+    void DropOldGlitches(QiEdgeBuffer &buffer, U64 edge_sample);
+    QiEdgeBuffer &GetFilteredEdges(U32 coil);
+    U32 DecodeEdgeBuffer(QiEdgeBuffer &buffer, QiDecoder &decoder, U32 stream, Channel &channel);
+    U32 DecodeEdgesOverlapped();
+    U32 FinishOverlappedDecode();
+    U32 CommitSegmentOutput(QiDecoder &decoder, U32 stream, Channel &channel);
+    U32 DecodeCarrierEdges();
+    U32 DecodeCoilSlice();
+    U32 HoldEdgesForBitRate();
+    void SetBitRate(U32 bit_rate);
+    U32 CommitDecoderOutput(QiDecoder &decoder, U32 stream, Channel &channel);
+    QiDecoder &GetAskDecoder();
+    U32 CommitMergedPackets();
+    U32 CommitCarrierPoints();
+    void CommitByte(const QiDecodedByte &byte, U8 flags, U32 coil);
+    void CommitPacketRecord(U64 packet_id, U8 flags, U64 ending_sample, U32 coil);
 
 protected: //vars
     std::auto_ptr< QiAnalyzerSettings > mSettings;
     std::auto_ptr< QiAnalyzerResults > mResults;
     AnalyzerChannelData *mQi;
+    AnalyzerChannelData *mCarrier;
 
     QiSimulationDataGenerator mSimulationDataGenerator;
     bool mSimulationInitilized;
 
     //Qi analysis vars:
     U32 mSampleRateHz;
-    std::vector<U32> mSampleOffsets;
-    U32 mParityBitOffset;
-    U32 mStartOfStopBitOffset;
-    U32 mEndOfStopBitOffset;
-    BitState mBitLow;
-    BitState mBitHigh;
+
+    //edges are pulled in chunks and decoded from the widths between them
+    QiDecoder mDecoder;
+    std::vector<U32> mDecodingDeltas;   //on several threads, the chunk the pool is decoding while the next is pulled
+    U64 mDecodingStart;
+    U64 mDecodingEnd;       //where the channel was when the chunk had been pulled
+    bool mDecoding;
+    U64 mDecodedSample;     //mDecodingEnd of the last chunk committed
+    QiParallelDecoder mParallelDecoder;     //after what its threads use, which has to outlive them
+    bool mDecodeInParallel;
+    U32 mEdgeChunkSize;
+    QiEdgeBuffer mEdges;
+
+    //autobaud: the first edges are held back until the bit rate has been estimated from them
+    bool mEstimateBitRate;
+    QiBitRateEstimator mBitRateEstimator;
+    QiEdgeBuffer mHeldEdges;
+    bool mHoldingEdges;
+    U64 mHeldEdgesEnd;      //the last edge held
+
+    //when the carrier is used, it drives the decode and the data line follows
+    bool mPullCarrier;
+    QiEdgeBuffer mCarrierEdges;
+
+    //FSK mode: the packets of both directions are merged in time order
+    bool mDecodeFsk;
+    QiFskDemodulator mFskDemodulator;
+
+    //multi-coil mode: the coils are decoded in slices of the capture and their packets merged in time order
+    bool mMultiCoil;
+    std::vector<QiCoil> mCoils;     //stream i of the merger
+    U64 mSliceWidth;
+    U64 mSliceEnd;
+
+    bool mMergePackets;     //FSK or multi-coil
+    QiPacketMerger mPacketMerger;
+    std::vector<QiDecodedByte> mMergedPacket;
+
+    //ASK from the carrier: the data channel is a comparator output, demodulated from its pulse width
+    bool mAskFromCarrier;
+    bool mSharedCarrier;    //FSK and ASK from the same channel, every edge is pulled once for both
+    QiAskDemodulator mAskDemodulator;
+
+    bool mTrackCarrier;
+    QiCarrierTracker mCarrierTracker;
+
+    //typed packet records, see QiMessage
+    std::vector<U8> mPacketBytes;   //header and message of the packet being committed
+    U64 mPacketStartingSample;
+    U8 mPacketFlags;                //of all its frames so far
+    U32 mMaximumPowerMilliwatts[QI_MAX_COILS];  //every coil has a receiver of its own
+
+    U64 mGlitchWindow;
+
+    QiErrorSummary mErrorSummary;
+
+    AnalyzerCommitPolicy mCommitPolicy;
+    AnalyzerInstrumentation mInstrumentation;
 
 #pragma warning( pop )
 };
@@ -1,29 +1,46 @@
 #include "QiAnalyzerResults.h"
 #include <AnalyzerHelpers.h>
+#include "AnalyzerBinaryExport.h"
+#include "AnalyzerExportWriter.h"
 #include "QiAnalyzer.h"
 #include "QiAnalyzerSettings.h"
 #include <iostream>
 #include <sstream>
 #include <stdio.h>
+#include <string.h>
 
 QiAnalyzerResults::QiAnalyzerResults(QiAnalyzer *analyzer, QiAnalyzerSettings *settings)
     :   AnalyzerResults(),
         mSettings(settings),
         mAnalyzer(analyzer)
 {
+    memset(&mErrorSummary, 0, sizeof(mErrorSummary));
 }
 
 QiAnalyzerResults::~QiAnalyzerResults()
 {
 }
 
-void QiAnalyzerResults::GenerateBubbleText(U64 frame_index, Channel & /*channel*/, DisplayBase display_base)   //unrefereced vars commented out to remove warnings.
+void QiAnalyzerResults::GenerateBubbleText(U64 frame_index, Channel &channel, DisplayBase display_base)
 {
 #if 1
     //we only need to pay attention to 'channel' if we're making bubbles for more than one channel (as set by AddChannelBubblesWillAppearOn)
     ClearResultStrings();
     Frame frame = GetFrame(frame_index);
 
+    //in FSK mode, transmitter frames go on the carrier and receiver frames on the data channel.
+    if (mSettings->mFskMode != QiAnalyzerEnums::FskOff) {
+        bool transmitter_frame = (frame.mFlags & TRANSMITTER_FRAME_FLAG) != 0;
+        if (channel != (transmitter_frame == true ? mSettings->mCarrierChannel : mSettings->mInputChannel)) {
+            return;
+        }
+    }
+
+    //in multi-coil mode, every frame goes on the channel of the coil it was decoded from.
+    if (mSettings->IsMultiCoil() == true && channel != mSettings->GetCoilChannel(QI_FRAME_COIL(frame.mType))) {
+        return;
+    }
+
     bool framing_error = false;
     if ((frame.mFlags & FRAMING_ERROR_FLAG) != 0) {
         framing_error = true;
@@ -69,6 +86,31 @@ void QiAnalyzerResults::GenerateBubbleText(U64 frame_index, Channel & /*channel*
         return;
     }
 
+    if (QI_FRAME_TYPE(frame.mType) == QiBitErrorFrame) {
+        AddResultString("!");
+        AddResultString("Bit error");
+        AddResultString("Bit error, packet dropped");
+        return;
+    }
+
+    //packet level errors are reported on the last frame of the packet:
+    if ((frame.mFlags & CHECKSUM_ERROR_FLAG) != 0) {
+        char expected_str[128];
+        AnalyzerHelpers::GetNumberString(frame.mData2, display_base, bits_per_transfer, expected_str, 128);
+
+        AddResultString("!");
+
+        AddResultString(number_str, " (checksum error)");
+        AddResultString("Checksum: ", number_str, " (error, expected ", expected_str, ")");
+        return;
+    }
+
+    if ((frame.mFlags & TRUNCATED_PACKET_FLAG) != 0) {
+        AddResultString("!");
+        AddResultString(number_str, " (truncated packet)");
+        return;
+    }
+
     //normal case:
     if ((parity_error == true) || (framing_error == true)) {
         AddResultString("!");
@@ -86,66 +128,131 @@ void QiAnalyzerResults::GenerateBubbleText(U64 frame_index, Channel & /*channel*
 
         AddResultString(result_str);
 
+    } else if (QI_FRAME_TYPE(frame.mType) == QiHeaderFrame) {
+        QiPacketRecord record;
+        if (GetHeaderFrameRecord(frame_index, record) == true && record.mType != QiUnknownPacket) {
+            AddResultString(QiMessage::GetAbbreviation(record));
+            AddResultString("Header: ", number_str);
+
+            char summary_str[256];
+            QiMessage::GetSummary(record, summary_str, sizeof(summary_str));
+            AddResultString(summary_str);
+        } else {
+            AddResultString(number_str);
+            AddResultString("Header: ", number_str);
+        }
+    } else if (QI_FRAME_TYPE(frame.mType) == QiChecksumFrame) {
+        AddResultString(number_str);
+        AddResultString("Checksum: ", number_str);
     } else {
         AddResultString(number_str);
     }
 #endif
 }
 
-void QiAnalyzerResults::GenerateExportFile(const char *file, DisplayBase display_base, U32 /*export_type_user_id*/)
+void QiAnalyzerResults::GenerateExportFile(const char *file, DisplayBase display_base, U32 export_type_user_id)
 {
+    if (export_type_user_id == ANALYZER_BINARY_EXPORT_ID) {
+        AnalyzerBinaryExport::WriteFrames(this, file, mAnalyzer->GetSampleRate(), mAnalyzer->GetTriggerSample());
+        return;
+    }
+
+    if (export_type_user_id == QI_PACKET_EXPORT_ID) {
+        GeneratePacketExportFile(file, display_base);
+        return;
+    }
+
+    if (export_type_user_id == QI_CARRIER_EXPORT_ID) {
+        GenerateCarrierExportFile(file);
+        return;
+    }
+
+    if (export_type_user_id == QI_ERROR_SUMMARY_EXPORT_ID) {
+        GenerateErrorSummaryExportFile(file);
+        return;
+    }
+
+    if (export_type_user_id == ANALYZER_INSTRUMENTATION_EXPORT_ID) {
+        mAnalyzer->GetInstrumentation().WriteReport(file);
+        return;
+    }
+
 #if 1
-    //export_type_user_id is only important if we have more than one export type.
-    std::stringstream ss;
+    //text/csv export
+    AnalyzerExportWriter writer;
 
     U64 trigger_sample = mAnalyzer->GetTriggerSample();
     U32 sample_rate = mAnalyzer->GetSampleRate();
     U64 num_frames = GetNumFrames();
 
-    void *f = AnalyzerHelpers::StartFile(file);
+    writer.Start(file);
+    writer.SetTimeBase(trigger_sample, sample_rate);
 
     if (mSettings->mQiMode == QiAnalyzerEnums::Normal) {
-        //Normal case -- not MP mode.
-        ss << "Time [s],Value,Parity Error,Framing Error" << std::endl;
+        //Normal case -- not MP mode. Both directions are told apart in FSK mode.
+        bool fsk = mSettings->mFskMode != QiAnalyzerEnums::FskOff;
+        bool multi_coil = mSettings->IsMultiCoil();
+        if (fsk == true) {
+            writer.Append("Time [s],Packet ID,Value,Parity Error,Framing Error,Checksum Error,Direction\n");
+        } else if (multi_coil == true) {
+            writer.Append("Time [s],Packet ID,Value,Parity Error,Framing Error,Checksum Error,Coil\n");
+        } else {
+            writer.Append("Time [s],Packet ID,Value,Parity Error,Framing Error,Checksum Error\n");
+        }
 
         for (U32 i = 0; i < num_frames; i++) {
-            Frame frame = GetFrame(i);
-
-            //static void GetTimeString( U64 sample, U64 trigger_sample, U32 sample_rate_hz, char* result_string, U32 result_string_max_length );
-            char time_str[128];
-            AnalyzerHelpers::GetTimeString(frame.mStartingSampleInclusive, trigger_sample, sample_rate, time_str, 128);
+            if ((i % ANALYZER_EXPORT_CANCEL_INTERVAL) == 0 && UpdateExportProgressAndCheckForCancel(i, num_frames) == true) {
+                writer.End();
+                return;
+            }
 
-            char number_str[128];
-            AnalyzerHelpers::GetNumberString(frame.mData1, display_base, mSettings->mBitsPerTransfer, number_str, 128);
+            Frame frame = GetFrame(i);
 
-            ss << time_str << "," << number_str;
+            U64 packet_id = GetPacketContainingFrameSequential(i);
+            writer.AppendTime(frame.mStartingSampleInclusive);
+            writer.Append(',');
+            if (packet_id != INVALID_RESULT_INDEX) {
+                writer.AppendNumber(packet_id);
+            }
+            writer.Append(',');
+            writer.AppendValue(frame.mData1, display_base, mSettings->mBitsPerTransfer);
 
             if ((frame.mFlags & PARITY_ERROR_FLAG) != 0) {
-                ss << ",Error,";
+                writer.Append(",Error,");
             } else {
-                ss << ",,";
+                writer.Append(",,");
             }
 
             if ((frame.mFlags & FRAMING_ERROR_FLAG) != 0) {
-                ss << "Error";
+                writer.Append("Error");
             }
 
-            ss << std::endl;
-
-            AnalyzerHelpers::AppendToFile((U8 *)ss.str().c_str(), ss.str().length(), f);
-            ss.str(std::string());
+            if ((frame.mFlags & (CHECKSUM_ERROR_FLAG | TRUNCATED_PACKET_FLAG)) != 0) {
+                writer.Append(",Error");
+            } else {
+                writer.Append(',');
+            }
 
-            if (UpdateExportProgressAndCheckForCancel(i, num_frames) == true) {
-                AnalyzerHelpers::EndFile(f);
-                return;
+            if (fsk == true) {
+                writer.Append(((frame.mFlags & TRANSMITTER_FRAME_FLAG) != 0) ? ",FSK" : ",ASK");
+            } else if (multi_coil == true) {
+                writer.Append(',');
+                writer.AppendNumber(QI_FRAME_COIL(frame.mType) + 1);
             }
+
+            writer.EndLine();
         }
     } else {
         //MP mode.
-        ss << "Time [s],Packet ID,Address,Data,Framing Error" << std::endl;
+        writer.Append("Time [s],Packet ID,Address,Data,Framing Error\n");
         U64 address = 0;
 
         for (U32 i = 0; i < num_frames; i++) {
+            if ((i % ANALYZER_EXPORT_CANCEL_INTERVAL) == 0 && UpdateExportProgressAndCheckForCancel(i, num_frames) == true) {
+                writer.End();
+                return;
+            }
+
             Frame frame = GetFrame(i);
 
             if ((frame.mFlags & MP_MODE_ADDRESS_FLAG) != 0) {
@@ -155,40 +262,241 @@ void QiAnalyzerResults::GenerateExportFile(const char *file, DisplayBase display
 
             U64 packet_id = GetPacketContainingFrameSequential(i);
 
-            //static void GetTimeString( U64 sample, U64 trigger_sample, U32 sample_rate_hz, char* result_string, U32 result_string_max_length );
-            char time_str[128];
-            AnalyzerHelpers::GetTimeString(frame.mStartingSampleInclusive, trigger_sample, sample_rate, time_str, 128);
+            writer.AppendTime(frame.mStartingSampleInclusive);
+            writer.Append(',');
+            if (packet_id != INVALID_RESULT_INDEX) {
+                writer.AppendNumber(packet_id);
+            }
+            writer.Append(',');
+            writer.AppendValue(address, display_base, mSettings->mBitsPerTransfer - 1);
+            writer.Append(',');
+            writer.AppendValue(frame.mData1, display_base, mSettings->mBitsPerTransfer - 1);
+            writer.Append(',');
+
+            if ((frame.mFlags & FRAMING_ERROR_FLAG) != 0) {
+                writer.Append("Error");
+            }
+
+            writer.EndLine();
+        }
+    }
+
+    UpdateExportProgressAndCheckForCancel(num_frames, num_frames);
+    writer.End();
+#endif
+}
 
-            char address_str[128];
-            AnalyzerHelpers::GetNumberString(address, display_base, mSettings->mBitsPerTransfer - 1, address_str, 128);
+void QiAnalyzerResults::GeneratePacketExportFile(const char *file, DisplayBase display_base)
+{
+    //one row per packet, with the decoded message next to the raw bytes.
+    AnalyzerExportWriter writer;
+
+    U64 num_packets = GetNumPackets();
+    bool fsk = mSettings->mFskMode != QiAnalyzerEnums::FskOff;
+    bool multi_coil = mSettings->IsMultiCoil();
+    bool glitch_filter = mSettings->mGlitchFilter != 0;
+
+    writer.Start(file);
+    writer.SetTimeBase(mAnalyzer->GetTriggerSample(), mAnalyzer->GetSampleRate());
+    if (fsk == true) {
+        writer.Append("Time [s],Packet ID,Direction,Header,Packet,Decoded,Message,Error");
+    } else if (multi_coil == true) {
+        writer.Append("Time [s],Packet ID,Coil,Header,Packet,Decoded,Message,Error");
+    } else {
+        writer.Append("Time [s],Packet ID,Header,Packet,Decoded,Message,Error");
+    }
+    writer.Append((glitch_filter == true) ? ",Glitches\n" : "\n");
 
-            char number_str[128];
-            AnalyzerHelpers::GetNumberString(frame.mData1, display_base, mSettings->mBitsPerTransfer - 1, number_str, 128);
-            if (packet_id == INVALID_RESULT_INDEX) {
-                ss << time_str << "," << "" << "," << address_str << "," << number_str << ",";
-            } else {
-                ss << time_str << "," << packet_id << "," << address_str << "," << number_str << ",";
+    for (U64 i = 0; i < num_packets; i++) {
+        if ((i % ANALYZER_EXPORT_CANCEL_INTERVAL) == 0 && UpdateExportProgressAndCheckForCancel(i, num_packets) == true) {
+            writer.End();
+            return;
+        }
+
+        U64 first_frame_id;
+        U64 last_frame_id;
+        GetFramesContainedInPacket(i, &first_frame_id, &last_frame_id);
+        if (first_frame_id == INVALID_RESULT_INDEX) {
+            continue;
+        }
+
+        QiPacketRecord record;
+        if (GetPacketRecord(i, record) == false) {
+            continue;
+        }
+
+        Frame frame = GetFrame(first_frame_id);
+        writer.AppendTime(frame.mStartingSampleInclusive);
+        writer.Append(',');
+        writer.AppendNumber(i);
+        writer.Append(',');
+        if (fsk == true) {
+            writer.Append(((record.mFlags & TRANSMITTER_FRAME_FLAG) != 0) ? "FSK," : "ASK,");
+        } else if (multi_coil == true) {
+            writer.AppendNumber(record.mCoil + 1);
+            writer.Append(',');
+        }
+        writer.AppendValue(record.mHeader, display_base, 8);
+        writer.Append(',');
+        writer.Append(QiMessage::GetName(record));
+
+        //the details have commas of their own
+        char details_str[256];
+        QiMessage::GetDetails(record, details_str, sizeof(details_str));
+        writer.Append(",\"");
+        writer.Append(details_str);
+        writer.Append("\",");
+
+        for (U64 j = first_frame_id + 1; j <= last_frame_id; j++) {
+            frame = GetFrame(j);
+            if (QI_FRAME_TYPE(frame.mType) != QiMessageFrame) {
+                continue;
             }
 
-            if ((frame.mFlags & FRAMING_ERROR_FLAG) != 0) {
-                ss << "Error";
+            if (j != first_frame_id + 1) {
+                writer.Append(' ');
             }
+            writer.AppendValue(frame.mData1, display_base, 8);
+        }
 
-            ss << std::endl;
+        if ((record.mFlags & TRUNCATED_PACKET_FLAG) != 0) {
+            writer.Append(",Truncated");
+        } else if ((record.mFlags & CHECKSUM_ERROR_FLAG) != 0) {
+            writer.Append(",Checksum");
+        } else if ((record.mFlags & FRAMING_ERROR_FLAG) != 0) {
+            writer.Append(",Framing");
+        } else if ((record.mFlags & PARITY_ERROR_FLAG) != 0) {
+            writer.Append(",Parity");
+        } else {
+            writer.Append(',');
+        }
 
-            AnalyzerHelpers::AppendToFile((U8 *)ss.str().c_str(), ss.str().length(), f);
-            ss.str(std::string());
+        if (glitch_filter == true) {
+            writer.Append(',');
+            writer.AppendNumber(record.mGlitchCount);
+        }
 
-            if (UpdateExportProgressAndCheckForCancel(i, num_frames) == true) {
-                AnalyzerHelpers::EndFile(f);
-                return;
+        writer.EndLine();
+    }
+
+    UpdateExportProgressAndCheckForCancel(num_packets, num_packets);
+    writer.End();
+}
+
+void QiAnalyzerResults::GenerateCarrierExportFile(const char *file)
+{
+    //one row per carrier point, with the last control error the transmitter had received by then.
+    AnalyzerExportWriter writer;
+
+    U32 sample_rate = mAnalyzer->GetSampleRate();
+    U64 num_points = GetNumCarrierPoints();
+    U64 num_packets = GetNumPackets();
+
+    writer.Start(file);
+    writer.SetTimeBase(mAnalyzer->GetTriggerSample(), sample_rate);
+    writer.Append("Time [s],Frequency [Hz],Duty [%],Periods,Control Error\n");
+
+    U64 next_packet_id = 0;
+    U64 next_packet_sample = 0;
+    bool next_packet_found = false;
+    QiPacketRecord next_record;
+    bool have_control_error = false;
+    S8 control_error = 0;
+
+    for (U64 i = 0; i < num_points; i++) {
+        if ((i % ANALYZER_EXPORT_CANCEL_INTERVAL) == 0 && UpdateExportProgressAndCheckForCancel(i, num_points) == true) {
+            writer.End();
+            return;
+        }
+
+        QiCarrierPoint point;
+        if (GetCarrierPoint(i, point) == false) {
+            break;
+        }
+
+        //the receiver's packets don't overlap, so the last control error is found by walking them along.
+        //The transmitter's are skipped; one may end after packets that start later.
+        for (; next_packet_id < num_packets; next_packet_id++) {
+            if (next_packet_found == false) {
+                if (GetPacketRecord(next_packet_id, next_record) == false || (next_record.mFlags & TRANSMITTER_FRAME_FLAG) != 0) {
+                    continue;
+                }
+
+                U64 first_frame_id;
+                U64 last_frame_id;
+                GetFramesContainedInPacket(next_packet_id, &first_frame_id, &last_frame_id);
+                if (first_frame_id == INVALID_RESULT_INDEX) {
+                    continue;
+                }
+                next_packet_sample = GetFrame(last_frame_id).mEndingSampleInclusive;
+                next_packet_found = true;
+            }
+
+            if (next_packet_sample > point.mStartingSample) {
+                break;
+            }
+
+            if (next_record.mType == QiControlErrorPacket && (next_record.mFlags & QI_PACKET_ERROR_FLAGS) == 0) {
+                control_error = next_record.mControlError;
+                have_control_error = true;
             }
+            next_packet_found = false;
         }
+
+        char number_str[64];
+        writer.AppendTime(point.mStartingSample);
+        snprintf(number_str, sizeof(number_str), ",%.1f,%.2f,", QiCarrierTracker::GetFrequencyHz(point, sample_rate), QiCarrierTracker::GetDutyPercent(point));
+        writer.Append(number_str);
+        writer.AppendNumber(point.mPeriodCount);
+        writer.Append(',');
+        if (have_control_error == true) {
+            snprintf(number_str, sizeof(number_str), "%d", int(control_error));
+            writer.Append(number_str);
+        }
+        writer.EndLine();
     }
 
-    UpdateExportProgressAndCheckForCancel(num_frames, num_frames);
-    AnalyzerHelpers::EndFile(f);
-#endif
+    UpdateExportProgressAndCheckForCancel(num_points, num_points);
+    writer.End();
+}
+
+void QiAnalyzerResults::GenerateErrorSummaryExportFile(const char *file)
+{
+    //one row per counter, for scripts that only need to know how clean a capture decoded.
+    AnalyzerExportWriter writer;
+
+    QiErrorSummary summary;
+    GetErrorSummary(summary);
+
+    writer.Start(file);
+    writer.Append("Counter,Count\n");
+
+    const char *names[] = { "Packets", "Packets with errors", "Bytes", "Parity errors", "Framing errors", "Checksum errors",
+                            "Truncated packets", "Bit errors", "Glitches filtered", "Markers emitted", "Markers suppressed" };
+    U64 counts[] = { summary.mPackets, summary.mErrorPackets, summary.mBytes, summary.mParityErrors, summary.mFramingErrors,
+                     summary.mChecksumErrors, summary.mTruncatedPackets, summary.mBitErrors, summary.mGlitches,
+                     summary.mMarkersEmitted, summary.mMarkersSuppressed };
+
+    for (U32 i = 0; i < sizeof(counts) / sizeof(counts[0]); i++) {
+        writer.Append(names[i]);
+        writer.Append(',');
+        writer.AppendNumber(counts[i]);
+        writer.EndLine();
+    }
+
+    char rate_str[64];
+    double error_rate = (summary.mPackets != 0) ? double(summary.mErrorPackets) * 100.0 / double(summary.mPackets) : 0.0;
+    snprintf(rate_str, sizeof(rate_str), "Packet error rate [%%],%.3f", error_rate);
+    writer.Append(rate_str);
+    writer.EndLine();
+
+    if (mSettings->mUseAutobaud == true) {
+        writer.Append("Bit rate [bits/s],");
+        writer.AppendNumber(summary.mBitRate);
+        writer.EndLine();
+    }
+
+    writer.End();
 }
 
 void QiAnalyzerResults::GenerateFrameTabularText(U64 frame_index, DisplayBase display_base)
@@ -197,6 +505,16 @@ void QiAnalyzerResults::GenerateFrameTabularText(U64 frame_index, DisplayBase di
     ClearTabularText();
     Frame frame = GetFrame(frame_index);
 
+    if ((frame.mFlags & TRANSMITTER_FRAME_FLAG) != 0) {
+        AddTabularText("TX ");
+    }
+
+    if (mSettings->IsMultiCoil() == true) {
+        char coil_str[32];
+        snprintf(coil_str, sizeof(coil_str), "Coil %u ", QI_FRAME_COIL(frame.mType) + 1);
+        AddTabularText(coil_str);
+    }
+
     bool framing_error = false;
     if ((frame.mFlags & FRAMING_ERROR_FLAG) != 0) {
         framing_error = true;
@@ -233,6 +551,25 @@ void QiAnalyzerResults::GenerateFrameTabularText(U64 frame_index, DisplayBase di
         return;
     }
 
+    if (QI_FRAME_TYPE(frame.mType) == QiBitErrorFrame) {
+        AddTabularText("Bit error, packet dropped");
+        return;
+    }
+
+    //packet level errors:
+    if ((frame.mFlags & CHECKSUM_ERROR_FLAG) != 0) {
+        char expected_str[128];
+        AnalyzerHelpers::GetNumberString(frame.mData2, display_base, bits_per_transfer, expected_str, 128);
+
+        AddTabularText("Checksum: ", number_str, " (error, expected ", expected_str, ")");
+        return;
+    }
+
+    if ((frame.mFlags & TRUNCATED_PACKET_FLAG) != 0) {
+        AddTabularText(number_str, " (truncated packet)");
+        return;
+    }
+
     //normal case:
     if ((parity_error == true) || (framing_error == true)) {
         if (parity_error == true && framing_error == false) {
@@ -245,16 +582,144 @@ void QiAnalyzerResults::GenerateFrameTabularText(U64 frame_index, DisplayBase di
 
         AddTabularText(result_str);
 
+    } else if (QI_FRAME_TYPE(frame.mType) == QiHeaderFrame) {
+        QiPacketRecord record;
+        if (GetHeaderFrameRecord(frame_index, record) == true && record.mType != QiUnknownPacket) {
+            char summary_str[256];
+            QiMessage::GetSummary(record, summary_str, sizeof(summary_str));
+            AddTabularText("Header: ", number_str, ", ", summary_str);
+        } else {
+            AddTabularText("Header: ", number_str);
+        }
+    } else if (QI_FRAME_TYPE(frame.mType) == QiChecksumFrame) {
+        AddTabularText("Checksum: ", number_str);
     } else {
         AddTabularText(number_str);
     }
 #endif
 }
 
-void QiAnalyzerResults::GeneratePacketTabularText(U64 /*packet_id*/, DisplayBase /*display_base*/)    //unrefereced vars commented out to remove warnings.
+void QiAnalyzerResults::GeneratePacketTabularText(U64 packet_id, DisplayBase display_base)
 {
-    ClearResultStrings();
-    AddResultString("not supported");
+    ClearTabularText();
+
+    U64 first_frame_id;
+    U64 last_frame_id;
+    GetFramesContainedInPacket(packet_id, &first_frame_id, &last_frame_id);
+
+    if (first_frame_id == INVALID_RESULT_INDEX) {
+        return;
+    }
+
+    //the decoded message, then header, message bytes and checksum, in that order
+    std::stringstream ss;
+    bool packet_error = false;
+
+    QiPacketRecord record;
+    bool have_record = GetPacketRecord(packet_id, record);
+    if (have_record == true && (record.mFlags & TRANSMITTER_FRAME_FLAG) != 0) {
+        ss << "TX ";
+    }
+    if (mSettings->IsMultiCoil() == true) {
+        ss << "Coil " << QI_FRAME_COIL(GetFrame(first_frame_id).mType) + 1 << " ";
+    }
+
+    if (have_record == true && record.mType != QiUnknownPacket) {
+        char summary_str[256];
+        QiMessage::GetSummary(record, summary_str, sizeof(summary_str));
+        ss << summary_str << ";  ";
+    }
+
+    for (U64 i = first_frame_id; i <= last_frame_id; i++) {
+        Frame frame = GetFrame(i);
+
+        char number_str[128];
+        AnalyzerHelpers::GetNumberString(frame.mData1, display_base, 8, number_str, 128);
+
+        if (QI_FRAME_TYPE(frame.mType) == QiBitErrorFrame) {
+            ss << ((i == first_frame_id) ? "Bit error" : ";  Bit error");
+        } else if (i == first_frame_id) {
+            ss << "Header: " << number_str << ";  Message:";
+        } else if (QI_FRAME_TYPE(frame.mType) == QiChecksumFrame) {
+            ss << ";  Checksum: " << number_str;
+        } else {
+            ss << " " << number_str;
+        }
+
+        if ((frame.mFlags & QI_PACKET_ERROR_FLAGS) != 0) {
+            packet_error = true;
+        }
+    }
+
+    if (packet_error == true) {
+        ss << " (error)";
+    }
+
+    if (have_record == true && record.mGlitchCount != 0) {
+        ss << " (" << U32(record.mGlitchCount) << " glitches filtered)";
+    }
+
+    AddTabularText(ss.str().c_str());
+}
+
+void QiAnalyzerResults::AddPacketRecord(U64 packet_id, const QiPacketRecord &record)
+{
+    if (packet_id == INVALID_RESULT_INDEX) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(mPacketRecordsMutex);
+    if (packet_id >= mPacketRecords.size()) {
+        QiPacketRecord no_record;
+        memset(&no_record, 0, sizeof(no_record));
+        no_record.mType = QiNoPacket;
+        mPacketRecords.resize(size_t(packet_id + 1), no_record);
+    }
+    mPacketRecords[size_t(packet_id)] = record;
+}
+
+bool QiAnalyzerResults::GetPacketRecord(U64 packet_id, QiPacketRecord &record)
+{
+    std::lock_guard<std::mutex> lock(mPacketRecordsMutex);
+    if (packet_id >= mPacketRecords.size() || mPacketRecords[size_t(packet_id)].mType == QiNoPacket) {
+        return false;
+    }
+
+    record = mPacketRecords[size_t(packet_id)];
+    return true;
+}
+
+void QiAnalyzerResults::AddCarrierPoints(const std::vector<QiCarrierPoint> &points)
+{
+    std::lock_guard<std::mutex> lock(mCarrierPointsMutex);
+    mCarrierPoints.insert(mCarrierPoints.end(), points.begin(), points.end());
+}
+
+U64 QiAnalyzerResults::GetNumCarrierPoints()
+{
+    std::lock_guard<std::mutex> lock(mCarrierPointsMutex);
+    return mCarrierPoints.size();
+}
+
+bool QiAnalyzerResults::GetCarrierPoint(U64 index, QiCarrierPoint &point)
+{
+    std::lock_guard<std::mutex> lock(mCarrierPointsMutex);
+    if (index >= mCarrierPoints.size()) {
+        return false;
+    }
+
+    point = mCarrierPoints[size_t(index)];
+    return true;
+}
+
+bool QiAnalyzerResults::GetHeaderFrameRecord(U64 frame_index, QiPacketRecord &record)
+{
+    U64 packet_id = GetPacketContainingFrame(frame_index);
+    if (packet_id == INVALID_RESULT_INDEX) {
+        return false;
+    }
+
+    return GetPacketRecord(packet_id, record);
 }
 
 void QiAnalyzerResults::GenerateTransactionTabularText(U64 /*transaction_id*/, DisplayBase /*display_base*/)    //unrefereced vars commented out to remove warnings.
@@ -262,3 +727,15 @@ void QiAnalyzerResults::GenerateTransactionTabularText(U64 /*transaction_id*/, D
     ClearResultStrings();
     AddResultString("not supported");
 }
+
+void QiAnalyzerResults::SetErrorSummary(const QiErrorSummary &summary)
+{
+    std::lock_guard<std::mutex> lock(mErrorSummaryMutex);
+    mErrorSummary = summary;
+}
+
+void QiAnalyzerResults::GetErrorSummary(QiErrorSummary &summary)
+{
+    std::lock_guard<std::mutex> lock(mErrorSummaryMutex);
+    summary = mErrorSummary;
+}
@@ -2,16 +2,55 @@
 #define Qi_ANALYZER_RESULTS
 
 #include <AnalyzerResults.h>
+#include "QiMessage.h"
+#include "QiCarrierTracker.h"
+#include <mutex>
+#include <vector>
 
 #define FRAMING_ERROR_FLAG ( 1 << 0 )
 #define PARITY_ERROR_FLAG ( 1 << 1 )
 #define MP_MODE_ADDRESS_FLAG ( 1 << 2 )
+#define CHECKSUM_ERROR_FLAG ( 1 << 3 )
+#define TRUNCATED_PACKET_FLAG ( 1 << 4 )
+#define TRANSMITTER_FRAME_FLAG ( 1 << 5 )   //FSK, sent by the power transmitter
+
+//a packet with any of these in one of its frames can't be trusted
+#define QI_PACKET_ERROR_FLAGS ( PARITY_ERROR_FLAG | FRAMING_ERROR_FLAG | CHECKSUM_ERROR_FLAG | TRUNCATED_PACKET_FLAG )
+
+#define QI_PACKET_EXPORT_ID 2   //export_type_user_id of the decoded packet export
+#define QI_CARRIER_EXPORT_ID 3  //export_type_user_id of the carrier frequency and duty export
+#define QI_ERROR_SUMMARY_EXPORT_ID 4    //export_type_user_id of the error summary export
+
+enum QiFrameType { QiHeaderFrame, QiMessageFrame, QiChecksumFrame, QiBitErrorFrame };  //QiBitErrorFrame ends a packet a bad bit cell broke off
+
+//a frame's mType is its QiFrameType, and in multi-coil mode the coil it was decoded from in the upper bits
+#define QI_FRAME_COIL_SHIFT 4
+#define QI_FRAME_TYPE(type) ( (type) & ((1 << QI_FRAME_COIL_SHIFT) - 1) )
+#define QI_FRAME_COIL(type) ( U32(type) >> QI_FRAME_COIL_SHIFT )
+
+//error counts over the whole capture, both directions together
+struct QiErrorSummary {
+    U64 mPackets;
+    U64 mErrorPackets;      //packets with any of QI_PACKET_ERROR_FLAGS
+    U64 mBytes;
+    U64 mParityErrors;      //bytes
+    U64 mFramingErrors;     //bytes
+    U64 mChecksumErrors;    //packets
+    U64 mTruncatedPackets;  //cut short by an idle gap or a bit error
+    U64 mBitErrors;         //packets a bad bit cell broke off
+    U64 mGlitches;          //pulses taken out by the glitch filter
+    U64 mMarkersEmitted;    //by every decoder: data line, carrier, coils
+    U64 mMarkersSuppressed; //left out by the marker categories setting
+    U32 mBitRate;           //decoded at, the estimate when autobaud is on
+};
 
 class QiAnalyzer;
 class QiAnalyzerSettings;
 
 class QiAnalyzerResults : public AnalyzerResults
 {
+    friend class AnalyzerBinaryExport;   //for UpdateExportProgressAndCheckForCancel
+
 public:
     QiAnalyzerResults(QiAnalyzer *analyzer, QiAnalyzerSettings *settings);
     virtual ~QiAnalyzerResults();
@@ -23,11 +62,50 @@ public:
     virtual void GeneratePacketTabularText(U64 packet_id, DisplayBase display_base);
     virtual void GenerateTransactionTabularText(U64 transaction_id, DisplayBase display_base);
 
+    //message size as a function of the header value, see the WPC packet structure.
+    static U32 GetMessageSize(U8 header)
+    {
+        if (header < 0x20) {
+            return 1;
+        } else if (header < 0x80) {
+            return 2 + (header - 0x20) / 16;
+        } else if (header < 0xE0) {
+            return 8 + (header - 0x80) / 8;
+        } else {
+            return 20 + (header - 0xE0) / 4;
+        }
+    }
+
+    //called by the worker thread for every committed packet; read back by the GUI thread.
+    void AddPacketRecord(U64 packet_id, const QiPacketRecord &record);
+    bool GetPacketRecord(U64 packet_id, QiPacketRecord &record);
+
+    //carrier frequency and duty, in time order; see QiCarrierTracker.
+    void AddCarrierPoints(const std::vector<QiCarrierPoint> &points);
+    U64 GetNumCarrierPoints();
+    bool GetCarrierPoint(U64 index, QiCarrierPoint &point);
+
+    void SetErrorSummary(const QiErrorSummary &summary);
+    void GetErrorSummary(QiErrorSummary &summary);
+
 protected: //functions
+    void GeneratePacketExportFile(const char *file, DisplayBase display_base);
+    void GenerateCarrierExportFile(const char *file);
+    void GenerateErrorSummaryExportFile(const char *file);
+    bool GetHeaderFrameRecord(U64 frame_index, QiPacketRecord &record);
 
 protected:  //vars
     QiAnalyzerSettings *mSettings;
     QiAnalyzer *mAnalyzer;
+
+    std::mutex mPacketRecordsMutex;
+    std::vector<QiPacketRecord> mPacketRecords;    //indexed by packet id
+
+    std::mutex mCarrierPointsMutex;
+    std::vector<QiCarrierPoint> mCarrierPoints;
+
+    std::mutex mErrorSummaryMutex;
+    QiErrorSummary mErrorSummary;
 };
 
 #endif //Qi_ANALYZER_RESULTS
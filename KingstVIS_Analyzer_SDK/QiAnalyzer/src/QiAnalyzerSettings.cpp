@@ -1,11 +1,17 @@
 ﻿#include "QiAnalyzerSettings.h"
 
 #include <AnalyzerHelpers.h>
+#include "AnalyzerBinaryExport.h"
+#include "AnalyzerInstrumentation.h"
+#include "QiAnalyzerResults.h"
 #include <sstream>
 #include <cstring>
 
 #pragma warning(disable: 4800) //warning C4800: 'U32' : forcing value to bool 'true' or 'false' (performance warning)
 #define CHANNEL_NAME "Data"
+#define CARRIER_CHANNEL_NAME "Carrier"
+
+static const char *const COIL_CHANNEL_NAMES[QI_MAX_COILS - 1] = { "Coil 2", "Coil 3", "Coil 4", "Coil 5", "Coil 6" };
 
 QiAnalyzerSettings::QiAnalyzerSettings()
     :   mInputChannel(UNDEFINED_CHANNEL),
@@ -16,22 +22,165 @@ QiAnalyzerSettings::QiAnalyzerSettings()
         mParity(AnalyzerEnums::None),
         mInverted(false),
         mUseAutobaud(false),
-        mQiMode(QiAnalyzerEnums::Normal)
+        mQiMode(QiAnalyzerEnums::Normal),
+        mBitTolerance(8),
+        mDecodeThreads(1),
+        mMarkerMode(QiAnalyzerEnums::AllMarkers),
+        mFskMode(QiAnalyzerEnums::FskOff),
+        mCarrierChannel(UNDEFINED_CHANNEL),
+        mFskThreshold(16),
+        mAskInput(QiAnalyzerEnums::AskFromDataLine),
+        mAskThreshold(20),
+        mCarrierInterval(0),
+        mGlitchFilter(0),
+        mSimulationDeviation(0),
+        mSimulationJitter(0)
 {
     mInputChannelInterface.reset(new AnalyzerSettingInterfaceChannel());
     mInputChannelInterface->SetTitleAndTooltip(CHANNEL_NAME, " Qi");
     mInputChannelInterface->SetChannel(mInputChannel);
 
+    mBitRateInterface.reset(new AnalyzerSettingInterfaceInteger());
+    mBitRateInterface->SetTitleAndTooltip("Bit Rate (Bits/s)",  "Specify the bit rate in bits per second (2000 for Qi).");
+    mBitRateInterface->SetMax(QI_MAX_BIT_RATE);
+    mBitRateInterface->SetMin(QI_MIN_BIT_RATE);
+    mBitRateInterface->SetInteger(mBitRate);
+
+    mUseAutobaudInterface.reset(new AnalyzerSettingInterfaceBool());
+    mUseAutobaudInterface->SetTitleAndTooltip("Autobaud", "Estimate the bit rate from the widths of the first edges on the data line, for transmitters that run off the bit rate above.");
+    mUseAutobaudInterface->SetCheckBoxText("Use Autobaud");
+    mUseAutobaudInterface->SetValue(mUseAutobaud);
+
+    mBitToleranceInterface.reset(new AnalyzerSettingInterfaceInteger());
+    mBitToleranceInterface->SetTitleAndTooltip("Bit Tolerance (%)",  "Specify how far a half or full bit cell may deviate from its nominal width.");
+    mBitToleranceInterface->SetMax(QI_MAX_BIT_TOLERANCE);
+    mBitToleranceInterface->SetMin(QI_MIN_BIT_TOLERANCE);
+    mBitToleranceInterface->SetInteger(mBitTolerance);
+
+    mDecodeThreadsInterface.reset(new AnalyzerSettingInterfaceInteger());
+    mDecodeThreadsInterface->SetTitleAndTooltip("Decode Threads",  "Decode the packets between idle gaps on this many threads (0 = one per processor core, 1 = sequential).");
+    mDecodeThreadsInterface->SetMax(64);
+    mDecodeThreadsInterface->SetMin(0);
+    mDecodeThreadsInterface->SetInteger(mDecodeThreads);
+
+    mMarkerModeInterface.reset(new AnalyzerSettingInterfaceNumberList());
+    mMarkerModeInterface->SetTitleAndTooltip("Markers", "Specify which markers are drawn on the channel; long captures stay responsive with fewer markers.");
+    mMarkerModeInterface->AddNumber(QiAnalyzerEnums::NoMarkers, "None", "");
+    mMarkerModeInterface->AddNumber(QiAnalyzerEnums::PacketMarkers, "Packet boundaries", "Start and end of every packet, errors at a truncated packet or bad checksum");
+    mMarkerModeInterface->AddNumber(QiAnalyzerEnums::ErrorMarkers, "Errors only", "Bit cells that could not be decoded, parity and framing errors, truncated packets and bad checksums");
+    mMarkerModeInterface->AddNumber(QiAnalyzerEnums::AllMarkers, "All", "Every bit, packet boundary and error");
+    mMarkerModeInterface->SetNumber(mMarkerMode);
+
+    mFskModeInterface.reset(new AnalyzerSettingInterfaceNumberList());
+    mFskModeInterface->SetTitleAndTooltip("Transmitter FSK", "Also decode the power transmitter's FSK packets from the power carrier.");
+    mFskModeInterface->AddNumber(QiAnalyzerEnums::FskOff, "Off", "Only the power receiver's ASK packets on the data channel");
+    mFskModeInterface->AddNumber(QiAnalyzerEnums::FskFromCarrier, "Decode from carrier", "ASK packets on the data channel and FSK packets on the carrier channel");
+    mFskModeInterface->SetNumber(mFskMode);
+
+    mCarrierChannelInterface.reset(new AnalyzerSettingInterfaceChannel());
+    mCarrierChannelInterface->SetTitleAndTooltip(CARRIER_CHANNEL_NAME, "The power carrier, e.g. the coil voltage through a comparator; needed for FSK.");
+    mCarrierChannelInterface->SetChannel(mCarrierChannel);
+    mCarrierChannelInterface->SetSelectionOfNoneIsAllowed(true);
+
+    mFskThresholdInterface.reset(new AnalyzerSettingInterfaceInteger());
+    mFskThresholdInterface->SetTitleAndTooltip("FSK Threshold (ns)",  "Specify the smallest change of the carrier period that is an FSK frequency change.");
+    mFskThresholdInterface->SetMax(10000);
+    mFskThresholdInterface->SetMin(1);
+    mFskThresholdInterface->SetInteger(mFskThreshold);
+
+    mAskInputInterface.reset(new AnalyzerSettingInterfaceNumberList());
+    mAskInputInterface->SetTitleAndTooltip("ASK Input", "Specify what the data channel carries.");
+    mAskInputInterface->AddNumber(QiAnalyzerEnums::AskFromDataLine, "Demodulated", "The ASK signal itself, e.g. from the receiver's modulation pin");
+    mAskInputInterface->AddNumber(QiAnalyzerEnums::AskFromCarrier, "Carrier pulse width", "The coil voltage through a comparator; the modulation is taken from the pulse width. May be the carrier channel too");
+    mAskInputInterface->SetNumber(mAskInput);
+
+    mAskThresholdInterface.reset(new AnalyzerSettingInterfaceInteger());
+    mAskThresholdInterface->SetTitleAndTooltip("ASK Duty Threshold (0.1%)",  "Specify the smallest change of the carrier duty, in tenths of a percent, that is an ASK modulation edge.");
+    mAskThresholdInterface->SetMax(500);
+    mAskThresholdInterface->SetMin(1);
+    mAskThresholdInterface->SetInteger(mAskThreshold);
 
+    mCarrierIntervalInterface.reset(new AnalyzerSettingInterfaceInteger());
+    mCarrierIntervalInterface->SetTitleAndTooltip("Carrier Tracking (us)",  "Track the carrier frequency and duty, one point per this many microseconds (0 = off); exported as text/csv.");
+    mCarrierIntervalInterface->SetMax(1000000);
+    mCarrierIntervalInterface->SetMin(0);
+    mCarrierIntervalInterface->SetInteger(mCarrierInterval);
+
+    mGlitchFilterInterface.reset(new AnalyzerSettingInterfaceInteger());
+    mGlitchFilterInterface->SetTitleAndTooltip("Glitch Filter (ns)",  "Pulses on the data line shorter than this are merged into their neighbours before decoding (0 = off).");
+    mGlitchFilterInterface->SetMax(100000);
+    mGlitchFilterInterface->SetMin(0);
+    mGlitchFilterInterface->SetInteger(mGlitchFilter);
 
     AddInterface(mInputChannelInterface.get());
+    AddInterface(mBitRateInterface.get());
+    AddInterface(mUseAutobaudInterface.get());
+    AddInterface(mBitToleranceInterface.get());
+    AddInterface(mDecodeThreadsInterface.get());
+    AddInterface(mMarkerModeInterface.get());
+    AddInterface(mFskModeInterface.get());
+    AddInterface(mCarrierChannelInterface.get());
+    AddInterface(mFskThresholdInterface.get());
+    AddInterface(mAskInputInterface.get());
+    AddInterface(mAskThresholdInterface.get());
+    AddInterface(mCarrierIntervalInterface.get());
+    AddInterface(mGlitchFilterInterface.get());
+
+    for (U32 i = 0; i < QI_MAX_COILS - 1; i++) {
+        mCoilChannels[i] = UNDEFINED_CHANNEL;
+        mCoilChannelInterfaces[i].reset(new AnalyzerSettingInterfaceChannel());
+        mCoilChannelInterfaces[i]->SetTitleAndTooltip(COIL_CHANNEL_NAMES[i], "Another coil of a multi-coil transmitter, decoded like the data channel; its packets are merged with the other coils' in time order.");
+        mCoilChannelInterfaces[i]->SetChannel(mCoilChannels[i]);
+        mCoilChannelInterfaces[i]->SetSelectionOfNoneIsAllowed(true);
+        AddInterface(mCoilChannelInterfaces[i].get());
+    }
+
+    mSimulationDeviationInterface.reset(new AnalyzerSettingInterfaceInteger());
+    mSimulationDeviationInterface->SetTitleAndTooltip("Simulated Bit Rate Offset (0.1%)",  "Simulate a transmitter whose bit rate is off the bit rate above by this many tenths of a percent.");
+    mSimulationDeviationInterface->SetMax(200);
+    mSimulationDeviationInterface->SetMin(-200);
+    mSimulationDeviationInterface->SetInteger(mSimulationDeviation);
+
+    mSimulationJitterInterface.reset(new AnalyzerSettingInterfaceInteger());
+    mSimulationJitterInterface->SetTitleAndTooltip("Simulated Jitter (%)",  "Shift every simulated edge at random by up to this many percent of a half bit cell; a cell between two edges varies by twice that.");
+    mSimulationJitterInterface->SetMax(25);
+    mSimulationJitterInterface->SetMin(0);
+    mSimulationJitterInterface->SetInteger(mSimulationJitter);
+
+    AddInterface(mSimulationDeviationInterface.get());
+    AddInterface(mSimulationJitterInterface.get());
 
     AddExportOption(0, "Export as text/csv file");
     AddExportExtension(0, "Text file", "txt");
     AddExportExtension(0, "CSV file", "csv");
 
+    AddExportOption(ANALYZER_BINARY_EXPORT_ID, "Export as columnar binary file");
+    AddExportExtension(ANALYZER_BINARY_EXPORT_ID, "Binary file", "bin");
+
+    AddExportOption(QI_PACKET_EXPORT_ID, "Export decoded packets as text/csv file");
+    AddExportExtension(QI_PACKET_EXPORT_ID, "Text file", "txt");
+    AddExportExtension(QI_PACKET_EXPORT_ID, "CSV file", "csv");
+
+    AddExportOption(QI_CARRIER_EXPORT_ID, "Export carrier frequency and duty as text/csv file");
+    AddExportExtension(QI_CARRIER_EXPORT_ID, "Text file", "txt");
+    AddExportExtension(QI_CARRIER_EXPORT_ID, "CSV file", "csv");
+
+    AddExportOption(QI_ERROR_SUMMARY_EXPORT_ID, "Export error summary as text/csv file");
+    AddExportExtension(QI_ERROR_SUMMARY_EXPORT_ID, "Text file", "txt");
+    AddExportExtension(QI_ERROR_SUMMARY_EXPORT_ID, "CSV file", "csv");
+
+#ifdef ANALYZER_INSTRUMENTATION
+    AddExportOption(ANALYZER_INSTRUMENTATION_EXPORT_ID, "Export instrumentation report as text/csv file");
+    AddExportExtension(ANALYZER_INSTRUMENTATION_EXPORT_ID, "Text file", "txt");
+    AddExportExtension(ANALYZER_INSTRUMENTATION_EXPORT_ID, "CSV file", "csv");
+#endif
+
     ClearChannels();
     AddChannel(mInputChannel, CHANNEL_NAME, false);
+    AddChannel(mCarrierChannel, CARRIER_CHANNEL_NAME, false);
+    for (U32 i = 0; i < QI_MAX_COILS - 1; i++) {
+        AddChannel(mCoilChannels[i], COIL_CHANNEL_NAMES[i], false);
+    }
 }
 
 QiAnalyzerSettings::~QiAnalyzerSettings()
@@ -41,17 +190,145 @@ QiAnalyzerSettings::~QiAnalyzerSettings()
 bool QiAnalyzerSettings::SetSettingsFromInterfaces()
 {
     mInputChannel = mInputChannelInterface->GetChannel();
+    mBitRate = mBitRateInterface->GetInteger();
+    bool use_autobaud = mUseAutobaudInterface->GetValue();
+    mBitTolerance = mBitToleranceInterface->GetInteger();
+    mDecodeThreads = mDecodeThreadsInterface->GetInteger();
+    mMarkerMode = QiAnalyzerEnums::MarkerMode(U32(mMarkerModeInterface->GetNumber()));
+
+    QiAnalyzerEnums::FskMode fsk_mode = QiAnalyzerEnums::FskMode(U32(mFskModeInterface->GetNumber()));
+    Channel carrier_channel = mCarrierChannelInterface->GetChannel();
+    QiAnalyzerEnums::AskInput ask_input = QiAnalyzerEnums::AskInput(U32(mAskInputInterface->GetNumber()));
+    U32 carrier_interval = mCarrierIntervalInterface->GetInteger();
+    if (fsk_mode != QiAnalyzerEnums::FskOff || carrier_interval != 0) {
+        if (carrier_channel == UNDEFINED_CHANNEL) {
+            SetErrorText("Please select a carrier channel to decode FSK or track the carrier.");
+            return false;
+        }
+
+        //the data channel can only double as the carrier when the ASK is taken from the carrier too.
+        if (carrier_channel == mInputChannel && ask_input != QiAnalyzerEnums::AskFromCarrier) {
+            SetErrorText("Please select different channels for the data and the carrier.");
+            return false;
+        }
+    }
 
+    Channel coil_channels[QI_MAX_COILS - 1];
+    bool multi_coil = false;
+    for (U32 i = 0; i < QI_MAX_COILS - 1; i++) {
+        coil_channels[i] = mCoilChannelInterfaces[i]->GetChannel();
+        if (coil_channels[i] == UNDEFINED_CHANNEL) {
+            continue;
+        }
+        multi_coil = true;
 
+        if (coil_channels[i] == mInputChannel || (carrier_channel != UNDEFINED_CHANNEL && coil_channels[i] == carrier_channel)) {
+            SetErrorText("Please select a channel of its own for every coil.");
+            return false;
+        }
+        for (U32 j = 0; j < i; j++) {
+            if (coil_channels[j] == coil_channels[i]) {
+                SetErrorText("Please select a channel of its own for every coil.");
+                return false;
+            }
+        }
+    }
+
+    //the bit rate is estimated from one demodulated data line, before any of it is decoded.
+    if (use_autobaud == true && (multi_coil == true || fsk_mode != QiAnalyzerEnums::FskOff || carrier_interval != 0 || ask_input != QiAnalyzerEnums::AskFromDataLine)) {
+        SetErrorText("Autobaud works on a single demodulated data line; please turn off FSK, carrier tracking and the other coils, and set the ASK input to demodulated.");
+        return false;
+    }
+
+    //every coil is decoded like a demodulated data line; there is no carrier to go with each of them.
+    if (multi_coil == true && (fsk_mode != QiAnalyzerEnums::FskOff || carrier_interval != 0 || ask_input != QiAnalyzerEnums::AskFromDataLine)) {
+        SetErrorText("Multi-coil decoding takes the demodulated data line of every coil; please turn off FSK and carrier tracking, and set the ASK input to demodulated.");
+        return false;
+    }
+
+    mUseAutobaud = use_autobaud;
+    mFskMode = fsk_mode;
+    mCarrierChannel = carrier_channel;
+    mFskThreshold = mFskThresholdInterface->GetInteger();
+    mAskInput = ask_input;
+    mAskThreshold = mAskThresholdInterface->GetInteger();
+    mCarrierInterval = carrier_interval;
+    mGlitchFilter = mGlitchFilterInterface->GetInteger();
+    for (U32 i = 0; i < QI_MAX_COILS - 1; i++) {
+        mCoilChannels[i] = coil_channels[i];
+    }
+    mSimulationDeviation = mSimulationDeviationInterface->GetInteger();
+    mSimulationJitter = mSimulationJitterInterface->GetInteger();
+
+    AddChannels();
+
+    return true;
+}
+
+void QiAnalyzerSettings::AddChannels()
+{
     ClearChannels();
     AddChannel(mInputChannel, CHANNEL_NAME, true);
+    AddChannel(mCarrierChannel, CARRIER_CHANNEL_NAME, UsesCarrier());
+    for (U32 i = 0; i < QI_MAX_COILS - 1; i++) {
+        AddChannel(mCoilChannels[i], COIL_CHANNEL_NAMES[i], mCoilChannels[i] != UNDEFINED_CHANNEL);
+    }
+}
 
-    return true;
+bool QiAnalyzerSettings::UsesCarrier() const
+{
+    return mFskMode != QiAnalyzerEnums::FskOff || mCarrierInterval != 0;
+}
+
+bool QiAnalyzerSettings::IsMultiCoil() const
+{
+    for (U32 i = 0; i < QI_MAX_COILS - 1; i++) {
+        if (mCoilChannels[i] != UNDEFINED_CHANNEL) {
+            return true;
+        }
+    }
+    return false;
+}
+
+Channel QiAnalyzerSettings::GetCoilChannel(U32 coil) const
+{
+    if (coil == 0) {
+        return mInputChannel;
+    }
+    return (coil < QI_MAX_COILS) ? mCoilChannels[coil - 1] : UNDEFINED_CHANNEL;
 }
 
 void QiAnalyzerSettings::UpdateInterfacesFromSettings()
 {
     mInputChannelInterface->SetChannel(mInputChannel);
+    mBitRateInterface->SetInteger(mBitRate);
+    mUseAutobaudInterface->SetValue(mUseAutobaud);
+    mBitToleranceInterface->SetInteger(mBitTolerance);
+    mDecodeThreadsInterface->SetInteger(mDecodeThreads);
+    mMarkerModeInterface->SetNumber(mMarkerMode);
+    mFskModeInterface->SetNumber(mFskMode);
+    mCarrierChannelInterface->SetChannel(mCarrierChannel);
+    mFskThresholdInterface->SetInteger(mFskThreshold);
+    mAskInputInterface->SetNumber(mAskInput);
+    mAskThresholdInterface->SetInteger(mAskThreshold);
+    mCarrierIntervalInterface->SetInteger(mCarrierInterval);
+    mGlitchFilterInterface->SetInteger(mGlitchFilter);
+    for (U32 i = 0; i < QI_MAX_COILS - 1; i++) {
+        mCoilChannelInterfaces[i]->SetChannel(mCoilChannels[i]);
+    }
+    mSimulationDeviationInterface->SetInteger(mSimulationDeviation);
+    mSimulationJitterInterface->SetInteger(mSimulationJitter);
+}
+
+static U32 ClampSetting(U32 value, U32 min, U32 max)
+{
+    if (value < min) {
+        return min;
+    } else if (value > max) {
+        return max;
+    }
+
+    return value;
 }
 
 void QiAnalyzerSettings::LoadSettings(const char *settings)
@@ -84,8 +361,67 @@ void QiAnalyzerSettings::LoadSettings(const char *settings)
         mQiMode = mode;
     }
 
-    ClearChannels();
-    AddChannel(mInputChannel, CHANNEL_NAME, true);
+    U32 bit_tolerance;
+    if (text_archive >> bit_tolerance) {
+        mBitTolerance = bit_tolerance;
+    }
+
+    //a hand-edited or corrupt archive can hold anything; the decoder divides by the bit rate and sets its cell
+    //limits from the tolerance, so both are kept to what the interfaces allow.
+    mBitRate = ClampSetting(mBitRate, QI_MIN_BIT_RATE, QI_MAX_BIT_RATE);
+    mBitTolerance = ClampSetting(mBitTolerance, QI_MIN_BIT_TOLERANCE, QI_MAX_BIT_TOLERANCE);
+
+    U32 decode_threads;
+    if (text_archive >> decode_threads) {
+        mDecodeThreads = decode_threads;
+    }
+
+    U32 marker_mode;
+    if (text_archive >> marker_mode) {
+        mMarkerMode = static_cast<QiAnalyzerEnums::MarkerMode>(marker_mode);
+    }
+
+    U32 fsk_mode;
+    Channel carrier_channel;
+    U32 fsk_threshold;
+    if ((text_archive >> fsk_mode) && (text_archive >> carrier_channel) && (text_archive >> fsk_threshold)) {
+        mFskMode = static_cast<QiAnalyzerEnums::FskMode>(fsk_mode);
+        mCarrierChannel = carrier_channel;
+        mFskThreshold = fsk_threshold;
+    }
+
+    U32 ask_input;
+    U32 ask_threshold;
+    if ((text_archive >> ask_input) && (text_archive >> ask_threshold)) {
+        mAskInput = static_cast<QiAnalyzerEnums::AskInput>(ask_input);
+        mAskThreshold = ask_threshold;
+    }
+
+    U32 carrier_interval;
+    if (text_archive >> carrier_interval) {
+        mCarrierInterval = carrier_interval;
+    }
+
+    U32 glitch_filter;
+    if (text_archive >> glitch_filter) {
+        mGlitchFilter = glitch_filter;
+    }
+
+    for (U32 i = 0; i < QI_MAX_COILS - 1; i++) {
+        Channel coil_channel;
+        if (text_archive >> coil_channel) {
+            mCoilChannels[i] = coil_channel;
+        }
+    }
+
+    S32 simulation_deviation;
+    U32 simulation_jitter;
+    if ((text_archive >> simulation_deviation) && (text_archive >> simulation_jitter)) {
+        mSimulationDeviation = simulation_deviation;
+        mSimulationJitter = simulation_jitter;
+    }
+
+    AddChannels();
 
     UpdateInterfacesFromSettings();
 }
@@ -104,6 +440,21 @@ const char *QiAnalyzerSettings::SaveSettings()
     text_archive << mInverted;
     text_archive << mUseAutobaud;
     text_archive << mQiMode;
+    text_archive << mBitTolerance;
+    text_archive << mDecodeThreads;
+    text_archive << mMarkerMode;
+    text_archive << mFskMode;
+    text_archive << mCarrierChannel;
+    text_archive << mFskThreshold;
+    text_archive << mAskInput;
+    text_archive << mAskThreshold;
+    text_archive << mCarrierInterval;
+    text_archive << mGlitchFilter;
+    for (U32 i = 0; i < QI_MAX_COILS - 1; i++) {
+        text_archive << mCoilChannels[i];
+    }
+    text_archive << mSimulationDeviation;
+    text_archive << mSimulationJitter;
 
     return SetReturnString(text_archive.GetString());
 }
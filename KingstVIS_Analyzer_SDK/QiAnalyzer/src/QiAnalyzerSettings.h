@@ -4,9 +4,18 @@
 #include <AnalyzerSettings.h>
 #include <AnalyzerTypes.h>
 
+#define QI_MAX_COILS 6  //data channels of a multi-coil transmitter, the data channel being the first
+#define QI_MIN_BIT_RATE 1
+#define QI_MAX_BIT_RATE 100000
+#define QI_MIN_BIT_TOLERANCE 1  //percent
+#define QI_MAX_BIT_TOLERANCE 30
+
 namespace QiAnalyzerEnums
 {
     enum Mode { Normal, MpModeMsbZeroMeansAddress, MpModeMsbOneMeansAddress };
+    enum MarkerMode { NoMarkers, PacketMarkers, ErrorMarkers, AllMarkers };
+    enum FskMode { FskOff, FskFromCarrier };
+    enum AskInput { AskFromDataLine, AskFromCarrier };
 };
 
 class QiAnalyzerSettings : public AnalyzerSettings
@@ -28,11 +37,45 @@ public:
     double mStopBits;
     AnalyzerEnums::Parity mParity;
     bool mInverted;
-    bool mUseAutobaud;
+    bool mUseAutobaud;      //the bit rate is estimated from the data line, mBitRate is only where the search starts
     QiAnalyzerEnums::Mode mQiMode;
+    U32 mBitTolerance;
+    U32 mDecodeThreads;
+    QiAnalyzerEnums::MarkerMode mMarkerMode;
+    QiAnalyzerEnums::FskMode mFskMode;
+    Channel mCarrierChannel;
+    U32 mFskThreshold;
+    QiAnalyzerEnums::AskInput mAskInput;
+    U32 mAskThreshold;
+    U32 mCarrierInterval;
+    U32 mGlitchFilter;      //shortest pulse on the data line, in ns; 0 = off
+    Channel mCoilChannels[QI_MAX_COILS - 1];    //coils 2 and up, UNDEFINED_CHANNEL if not used
+    S32 mSimulationDeviation;   //of the simulated transmitter's bit rate from mBitRate, in tenths of a percent
+    U32 mSimulationJitter;      //of every simulated edge, in percent of a half bit cell
+
+    bool UsesCarrier() const;
+    bool IsMultiCoil() const;
+    Channel GetCoilChannel(U32 coil) const;     //coil 0 is the data channel
 
 protected:
     std::auto_ptr< AnalyzerSettingInterfaceChannel >    mInputChannelInterface;
+    std::auto_ptr< AnalyzerSettingInterfaceInteger >    mBitRateInterface;
+    std::auto_ptr< AnalyzerSettingInterfaceBool >       mUseAutobaudInterface;
+    std::auto_ptr< AnalyzerSettingInterfaceInteger >    mBitToleranceInterface;
+    std::auto_ptr< AnalyzerSettingInterfaceInteger >    mDecodeThreadsInterface;
+    std::auto_ptr< AnalyzerSettingInterfaceNumberList > mMarkerModeInterface;
+    std::auto_ptr< AnalyzerSettingInterfaceNumberList > mFskModeInterface;
+    std::auto_ptr< AnalyzerSettingInterfaceChannel >    mCarrierChannelInterface;
+    std::auto_ptr< AnalyzerSettingInterfaceInteger >    mFskThresholdInterface;
+    std::auto_ptr< AnalyzerSettingInterfaceNumberList > mAskInputInterface;
+    std::auto_ptr< AnalyzerSettingInterfaceInteger >    mAskThresholdInterface;
+    std::auto_ptr< AnalyzerSettingInterfaceInteger >    mCarrierIntervalInterface;
+    std::auto_ptr< AnalyzerSettingInterfaceInteger >    mGlitchFilterInterface;
+    std::auto_ptr< AnalyzerSettingInterfaceChannel >    mCoilChannelInterfaces[QI_MAX_COILS - 1];
+    std::auto_ptr< AnalyzerSettingInterfaceInteger >    mSimulationDeviationInterface;
+    std::auto_ptr< AnalyzerSettingInterfaceInteger >    mSimulationJitterInterface;
+
+    void AddChannels();
 };
 
 #endif //Qi_ANALYZER_SETTINGS
@@ -0,0 +1,155 @@
+#include "QiAskDemodulator.h"
+
+QiAskDemodulator::QiAskDemodulator()
+    :   mThreshold(1),
+        mCarrierGap(0)
+{
+    Reset(0);
+}
+
+QiAskDemodulator::~QiAskDemodulator()
+{
+}
+
+void QiAskDemodulator::Init(U32 sample_rate_hz, U32 bit_rate, U32 threshold_permille, U32 tolerance_percent, U32 bits_per_byte, AnalyzerEnums::ShiftOrder shift_order)
+{
+    mDecoder.Init(sample_rate_hz, bit_rate, tolerance_percent, bits_per_byte, shift_order);
+    mDecoder.SetMinimumPreambleBits(QI_ASK_MIN_PREAMBLE_BITS);
+
+    mThreshold = (U64(threshold_permille) << 16) / 1000;
+    if (mThreshold == 0) {
+        mThreshold = 1;
+    }
+
+    //a carrier that stops for as long as an idle gap can't be carrying a packet either.
+    mCarrierGap = mDecoder.GetIdleGapWidth();
+}
+
+void QiAskDemodulator::Reset(U64 starting_sample)
+{
+    mDecoder.Reset(starting_sample);
+
+    for (U32 i = 0; i < QI_ASK_WINDOW_CYCLES; i++) {
+        mPeriodEdges[i] = starting_sample;
+        mPulseWidths[i] = 0;
+    }
+    mPulseSum = 0;
+    mPulseWidth = 0;
+    mPeriodCount = 0;
+    mOddEdge = false;
+
+    mLevel = 0;
+    mSettling = QI_ASK_WINDOW_CYCLES + 1;   //the first period starts at the first edge, not at starting_sample
+    mLastChangeEdge = starting_sample;
+    mChangePending = false;
+}
+
+void QiAskDemodulator::DecodeEdges(U64 first_edge, const U32 *deltas, U32 count)
+{
+    U64 edge = first_edge;
+    if (mOddEdge == false) {
+        DecodePeriod(edge);
+    } else {
+        mPulseWidth = U32(edge - mPeriodEdges[(mPeriodCount - 1) & (QI_ASK_WINDOW_CYCLES - 1)]);
+    }
+
+    for (U32 i = 0; i < count; i++) {
+        edge += deltas[i];
+        mOddEdge = !mOddEdge;
+        if (mOddEdge == false) {
+            DecodePeriod(edge);
+        } else {
+            //the first pulse of the period is the delta that ends at this edge.
+            mPulseWidth = deltas[i];
+        }
+    }
+
+    mOddEdge = !mOddEdge;
+}
+
+void QiAskDemodulator::DecodePeriod(U64 edge)
+{
+    U32 slot = U32(mPeriodCount & (QI_ASK_WINDOW_CYCLES - 1));
+    U64 previous_edge = mPeriodEdges[(mPeriodCount - 1) & (QI_ASK_WINDOW_CYCLES - 1)];
+    U64 window = edge - mPeriodEdges[slot];
+    mPeriodEdges[slot] = edge;
+    mPulseSum = mPulseSum - mPulseWidths[slot] + mPulseWidth;
+    mPulseWidths[slot] = mPulseWidth;
+    mPeriodCount++;
+
+    if (mPeriodCount > 1 && edge - previous_edge > mCarrierGap) {
+        //the carrier stopped; the window has to fill again once this period has left it.
+        mSettling = QI_ASK_WINDOW_CYCLES + 1;
+    }
+
+    if (mSettling != 0) {
+        if (--mSettling == 0) {
+            U64 duty = (mPulseSum << 16) / window;
+            mLevel = duty << 8;
+            if (mChangePending == true) {
+                EndChange(duty);
+            }
+        }
+        return;
+    }
+
+    U64 duty = (mPulseSum << 16) / window;
+    U64 level = mLevel >> 8;
+    U64 difference = (duty > level) ? duty - level : level - duty;
+    if (difference <= mThreshold) {
+        //follows slow drift, e.g. the coil voltage rising with the power, but not the window sliding over an
+        //edge, which would only delay when a shallow modulation crosses the threshold.
+        mLevel = mLevel - (mLevel >> 8) + duty;
+        return;
+    }
+
+    //the window is partly at the new level; where it changed is worked out once the new level is known.
+    mChangePending = true;
+    mChangeEdge = edge;
+    mChangeWindow = window;
+    mChangeDuty = duty;
+    mChangeLevel = level;
+
+    //the change is found early on its slope, and the coil takes a few periods to settle at the new amplitude.
+    mSettling = QI_ASK_WINDOW_CYCLES * 2;
+}
+
+void QiAskDemodulator::EndChange(U64 new_level)
+{
+    //the duty moves from the old level to the new one as the window slides over the change, so how far it
+    //had moved when the change was found says how far back in the window the change is.
+    U64 step = (new_level > mChangeLevel) ? new_level - mChangeLevel : mChangeLevel - new_level;
+    U64 part = (mChangeDuty > mChangeLevel) ? mChangeDuty - mChangeLevel : mChangeLevel - mChangeDuty;
+    if (part > step || (new_level > mChangeLevel) != (mChangeDuty > mChangeLevel)) {
+        part = step;
+    }
+
+    U64 change_edge = mChangeEdge - ((step != 0) ? mChangeWindow * part / step : mChangeWindow);
+    if (change_edge < mLastChangeEdge) {
+        change_edge = mLastChangeEdge;
+    }
+
+    mDecoder.DecodeTransition(change_edge, change_edge - mLastChangeEdge);
+    mLastChangeEdge = change_edge;
+    mChangePending = false;
+}
+
+U64 QiAskDemodulator::DecodeSilence(U64 sample)
+{
+    //the next change can't be placed before the window it is found in.
+    U64 quiet_edge = (mChangePending == true) ? mChangeEdge - mChangeWindow : mPeriodEdges[mPeriodCount & (QI_ASK_WINDOW_CYCLES - 1)];
+
+    U64 last_edge = mPeriodEdges[(mPeriodCount - 1) & (QI_ASK_WINDOW_CYCLES - 1)];
+    if (mChangePending == false && sample - last_edge > mCarrierGap) {
+        //the carrier stopped, nothing changes before it comes back.
+        quiet_edge = sample;
+    }
+
+    U64 quiet_width = (quiet_edge > mLastChangeEdge) ? quiet_edge - mLastChangeEdge : 0;
+    return mDecoder.DecodeSilence(quiet_width, quiet_edge);
+}
+
+QiDecoder &QiAskDemodulator::GetDecoder()
+{
+    return mDecoder;
+}
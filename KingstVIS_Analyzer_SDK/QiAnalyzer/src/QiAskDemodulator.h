@@ -0,0 +1,64 @@
+#ifndef Qi_ASK_DEMODULATOR_H
+#define Qi_ASK_DEMODULATOR_H
+
+#include "QiDecoder.h"
+
+#define QI_ASK_WINDOW_CYCLES 8  //carrier periods per duty measurement, a power of two well below half a bit cell
+#define QI_ASK_MIN_PREAMBLE_BITS (QI_MIN_PREAMBLE_BITS - 1)    //the coil is still settling during the first bit after a gap
+
+//ASK demodulator for a carrier that has only been through a comparator, e.g. the coil voltage.
+//When the power receiver modulates, the amplitude of the coil voltage changes, and with it the width of the
+//pulses the comparator makes of it. The duty of the last QI_ASK_WINDOW_CYCLES carrier periods is measured at
+//every period, and a change larger than the threshold is an edge of the modulation envelope. It is placed
+//within the window by how far the duty had moved towards the new level when it was found.
+//It doesn't matter which of the two pulses of a period is the high one: the duty of one changes exactly as
+//much as the other's, and bi-phase coding only cares about the time between envelope edges.
+//The envelope edges are fed to a QiDecoder with widths in samples, as if they came from a demodulated data line.
+class QiAskDemodulator
+{
+public:
+    QiAskDemodulator();
+    ~QiAskDemodulator();
+
+    //threshold_permille is the smallest change of the duty, in 1/1000 of a carrier period, that is a modulation edge.
+    void Init(U32 sample_rate_hz, U32 bit_rate, U32 threshold_permille, U32 tolerance_percent, U32 bits_per_byte, AnalyzerEnums::ShiftOrder shift_order);
+    void Reset(U64 starting_sample);
+
+    //edge i of the carrier is at first_edge + deltas[0] + ... + deltas[i - 1], rising and falling edges alike.
+    void DecodeEdges(U64 first_edge, const U32 *deltas, U32 count);
+
+    //the carrier has been decoded up to sample; returns the earliest sample that output still to come can
+    //start at, see QiDecoder::DecodeSilence.
+    U64 DecodeSilence(U64 sample);
+
+    QiDecoder &GetDecoder();
+
+protected:
+    void DecodePeriod(U64 edge);
+    void EndChange(U64 new_level);
+
+    QiDecoder mDecoder;
+    U64 mThreshold;     //in 1/65536 of a period
+    U64 mCarrierGap;    //a period longer than this means the carrier stopped
+
+    //the edges and first pulses of the last QI_ASK_WINDOW_CYCLES periods, indexed by period number
+    U64 mPeriodEdges[QI_ASK_WINDOW_CYCLES];
+    U32 mPulseWidths[QI_ASK_WINDOW_CYCLES];
+    U64 mPulseSum;
+    U32 mPulseWidth;    //of the period in progress
+    U64 mPeriodCount;
+    bool mOddEdge;      //only every other edge starts a period
+
+    U64 mLevel;             //duty of the current envelope level, in 1/256 of mThreshold's unit
+    U32 mSettling;          //periods until the window holds only the new level
+    U64 mLastChangeEdge;
+
+    //a change that has been found, waiting for the new level
+    bool mChangePending;
+    U64 mChangeEdge;        //the period it was found at
+    U64 mChangeWindow;
+    U64 mChangeDuty;
+    U64 mChangeLevel;       //the level before
+};
+
+#endif //Qi_ASK_DEMODULATOR_H
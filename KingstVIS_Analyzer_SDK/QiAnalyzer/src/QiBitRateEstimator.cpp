@@ -0,0 +1,115 @@
+#include "QiBitRateEstimator.h"
+#include "QiDecoder.h"
+#include <string.h>
+
+QiBitRateEstimator::QiBitRateEstimator()
+    :   mSampleRateHz(0),
+        mNominalBitRate(1),
+        mBinWidth(1)
+{
+    Init(0, 1);
+}
+
+QiBitRateEstimator::~QiBitRateEstimator()
+{
+}
+
+void QiBitRateEstimator::Init(U32 sample_rate_hz, U32 nominal_bit_rate)
+{
+    mSampleRateHz = sample_rate_hz;
+    mNominalBitRate = nominal_bit_rate;
+
+    U64 half_cell = (U64(sample_rate_hz) << QI_CELL_FRACTION_BITS) / (U64(nominal_bit_rate) * 2);
+    mBinWidth = half_cell / QI_AUTOBAUD_BIN_DIVISOR;
+    if (mBinWidth == 0) {
+        mBinWidth = 1;
+    }
+
+    memset(mCounts, 0, sizeof(mCounts));
+    memset(mSums, 0, sizeof(mSums));
+    mWidthCount = 0;
+}
+
+void QiBitRateEstimator::AddWidth(U64 width)
+{
+    //longer widths are idle gaps, or cells of a bit rate too slow to be found.
+    U64 bin = (width << QI_CELL_FRACTION_BITS) / mBinWidth;
+    if (bin < QI_AUTOBAUD_BINS) {
+        mCounts[bin]++;
+        mSums[bin] += width;
+    }
+    mWidthCount++;
+}
+
+void QiBitRateEstimator::AddDeltas(const U32 *deltas, U32 count)
+{
+    for (U32 i = 0; i < count; i++) {
+        AddWidth(deltas[i]);
+    }
+}
+
+U32 QiBitRateEstimator::GetWidthCount() const
+{
+    return mWidthCount;
+}
+
+void QiBitRateEstimator::SumCluster(U64 center, U64 &count, U64 &sum) const
+{
+    count = 0;
+    sum = 0;
+    for (U64 bin = 0; bin < QI_AUTOBAUD_BINS; bin++) {
+        U64 bin_center = bin * mBinWidth + mBinWidth / 2;
+        U64 distance = (bin_center > center) ? bin_center - center : center - bin_center;
+        if (distance * 4 <= center) {
+            count += mCounts[bin];
+            sum += mSums[bin];
+        }
+    }
+}
+
+U32 QiBitRateEstimator::GetBitRate() const
+{
+    //the first bin only has runts in it.
+    U32 peak = 1;
+    for (U32 bin = 2; bin < QI_AUTOBAUD_BINS; bin++) {
+        if (mCounts[bin] > mCounts[peak]) {
+            peak = bin;
+        }
+    }
+
+    if (mCounts[peak] == 0) {
+        return mNominalBitRate;
+    }
+
+    //the cluster around the tallest bin, centered on its mean so that a cluster split over two bins is found whole.
+    U64 count;
+    U64 sum;
+    SumCluster(peak * mBinWidth + mBinWidth / 2, count, sum);
+    U64 center = (sum << QI_CELL_FRACTION_BITS) / count;
+    SumCluster(center, count, sum);
+    center = (sum << QI_CELL_FRACTION_BITS) / count;
+
+    //a run of zero bits has more full cells than half cells; a run of ones never has a cluster at half a half cell.
+    U64 half_count;
+    U64 half_sum;
+    U64 full_count;
+    U64 full_sum;
+    SumCluster(center / 2, half_count, half_sum);
+    if (half_count * 8 >= count) {
+        full_count = count;
+        full_sum = sum;
+    } else {
+        half_count = count;
+        half_sum = sum;
+        SumCluster(center * 2, full_count, full_sum);
+    }
+
+    if (half_count + full_count < QI_AUTOBAUD_MIN_WIDTHS) {
+        return mNominalBitRate;
+    }
+
+    //a full cell counts as two half cells.
+    U64 half_cells = half_count + full_count * 2;
+    U64 bit_rate = (U64(mSampleRateHz) * half_cells + (half_sum + full_sum)) / ((half_sum + full_sum) * 2);
+    return (bit_rate != 0) ? U32(bit_rate) : mNominalBitRate;
+}
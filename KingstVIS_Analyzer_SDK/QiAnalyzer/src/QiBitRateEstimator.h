@@ -0,0 +1,44 @@
+#ifndef Qi_BIT_RATE_ESTIMATOR_H
+#define Qi_BIT_RATE_ESTIMATOR_H
+
+#include <LogicPublicTypes.h>
+
+#define QI_AUTOBAUD_EDGES 4096      //edge widths the bit rate is estimated from
+#define QI_AUTOBAUD_MIN_WIDTHS 64   //fewer widths in the cell clusters than this, and the nominal bit rate is kept
+#define QI_AUTOBAUD_BIN_DIVISOR 16  //histogram bins per nominal half cell
+#define QI_AUTOBAUD_BINS 64         //the histogram covers two nominal full cells
+
+//Estimates the bit rate of a bi-phase line from a histogram of its edge widths, in one pass over the first
+//edges of the capture. Every width is either a half cell (two per one bit) or a full cell (a zero bit),
+//so the histogram has a cluster at each of them. The tallest cluster is the full cells if there is another
+//one at half its width, otherwise it is the half cells, and the half cell is the mean of both clusters
+//together. Transmitters at anything from about 0.6 to 2 times the nominal bit rate are found.
+class QiBitRateEstimator
+{
+public:
+    QiBitRateEstimator();
+    ~QiBitRateEstimator();
+
+    void Init(U32 sample_rate_hz, U32 nominal_bit_rate);
+
+    void AddWidth(U64 width);
+    void AddDeltas(const U32 *deltas, U32 count);
+    U32 GetWidthCount() const;
+
+    //the nominal bit rate if the widths don't have a clear half cell cluster.
+    U32 GetBitRate() const;
+
+protected:
+    //widths within a quarter of center, which is in 24.8 fixed point samples like the bins
+    void SumCluster(U64 center, U64 &count, U64 &sum) const;
+
+    U32 mSampleRateHz;
+    U32 mNominalBitRate;
+    U64 mBinWidth;      //24.8 fixed point samples
+
+    U64 mCounts[QI_AUTOBAUD_BINS];
+    U64 mSums[QI_AUTOBAUD_BINS];   //of the widths in each bin, in samples
+    U32 mWidthCount;
+};
+
+#endif //Qi_BIT_RATE_ESTIMATOR_H
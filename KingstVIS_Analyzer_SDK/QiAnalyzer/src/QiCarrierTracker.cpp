@@ -0,0 +1,116 @@
+#include "QiCarrierTracker.h"
+#include <string.h>
+
+QiCarrierTracker::QiCarrierTracker()
+    :   mInterval(1),
+        mMaxPeriod(0)
+{
+    Reset(0, BIT_LOW);
+}
+
+QiCarrierTracker::~QiCarrierTracker()
+{
+}
+
+void QiCarrierTracker::Init(U32 sample_rate_hz, U32 interval_us)
+{
+    mMaxPeriod = sample_rate_hz / QI_CARRIER_MIN_FREQUENCY_HZ;
+
+    mInterval = U64(sample_rate_hz) * interval_us / 1000000;
+    if (mInterval == 0) {
+        mInterval = 1;
+    }
+
+    //the sums of a point are 32 bits wide, and its first period may start in the interval before.
+    if (mInterval > 0xFFFFFFFFull - mMaxPeriod) {
+        mInterval = 0xFFFFFFFFull - mMaxPeriod;
+    }
+}
+
+void QiCarrierTracker::Reset(U64 starting_sample, BitState initial_bit_state)
+{
+    mIntervalEnd = starting_sample + mInterval;
+    mHigh = initial_bit_state == BIT_HIGH;
+    mRisingEdgeSeen = false;
+    mRisingEdge = starting_sample;
+    mFallingEdge = starting_sample;
+
+    memset(&mPoint, 0, sizeof(mPoint));
+    mPoints.clear();
+}
+
+void QiCarrierTracker::AddEdges(U64 first_edge, const U32 *deltas, U32 count)
+{
+    U64 edge = first_edge;
+    AddEdge(edge);
+
+    for (U32 i = 0; i < count; i++) {
+        edge += deltas[i];
+        AddEdge(edge);
+    }
+}
+
+void QiCarrierTracker::AddEdge(U64 edge)
+{
+    if (edge >= mIntervalEnd) {
+        EndInterval(edge);
+    }
+
+    mHigh = !mHigh;
+    if (mHigh == false) {
+        mFallingEdge = edge;
+        return;
+    }
+
+    //a rising edge ends a period, unless the carrier stopped in between.
+    if (mRisingEdgeSeen == true && edge - mRisingEdge <= mMaxPeriod && mFallingEdge > mRisingEdge) {
+        if (mPoint.mPeriodCount == 0) {
+            mPoint.mStartingSample = mRisingEdge;
+        }
+        mPoint.mPeriodCount++;
+        mPoint.mPeriodSamples += U32(edge - mRisingEdge);
+        mPoint.mHighSamples += U32(mFallingEdge - mRisingEdge);
+    }
+
+    mRisingEdge = edge;
+    mRisingEdgeSeen = true;
+}
+
+void QiCarrierTracker::EndInterval(U64 edge)
+{
+    //intervals without a carrier don't get a point.
+    if (mPoint.mPeriodCount != 0) {
+        mPoints.push_back(mPoint);
+        memset(&mPoint, 0, sizeof(mPoint));
+    }
+
+    mIntervalEnd += ((edge - mIntervalEnd) / mInterval + 1) * mInterval;
+}
+
+const std::vector<QiCarrierPoint> &QiCarrierTracker::GetPoints() const
+{
+    return mPoints;
+}
+
+void QiCarrierTracker::ClearPoints()
+{
+    mPoints.clear();
+}
+
+double QiCarrierTracker::GetFrequencyHz(const QiCarrierPoint &point, U32 sample_rate_hz)
+{
+    if (point.mPeriodSamples == 0) {
+        return 0.0;
+    }
+
+    return double(point.mPeriodCount) * sample_rate_hz / point.mPeriodSamples;
+}
+
+double QiCarrierTracker::GetDutyPercent(const QiCarrierPoint &point)
+{
+    if (point.mPeriodSamples == 0) {
+        return 0.0;
+    }
+
+    return double(point.mHighSamples) * 100.0 / point.mPeriodSamples;
+}
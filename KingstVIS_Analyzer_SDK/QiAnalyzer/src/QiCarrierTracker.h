@@ -0,0 +1,57 @@
+#ifndef Qi_CARRIER_TRACKER_H
+#define Qi_CARRIER_TRACKER_H
+
+#include <LogicPublicTypes.h>
+#include <vector>
+
+#define QI_CARRIER_MIN_FREQUENCY_HZ 10000   //longer periods are gaps in the carrier, not part of it
+
+//the carrier over one interval: the periods that ended in it, and how long the carrier was high in them
+struct QiCarrierPoint {
+    U64 mStartingSample;    //start of the first period
+    U32 mPeriodCount;
+    U32 mPeriodSamples;     //total length of the periods
+    U32 mHighSamples;
+    U32 mReserved;
+};
+
+//Tracks the operating frequency and duty of the power carrier, one point per interval, in a single pass over
+//the carrier's edges. A period runs from a rising edge to the next one and belongs to the interval it ends in;
+//the tracker only keeps the point being summed up, so it needs the same memory however long the capture is.
+class QiCarrierTracker
+{
+public:
+    QiCarrierTracker();
+    ~QiCarrierTracker();
+
+    void Init(U32 sample_rate_hz, U32 interval_us);
+    void Reset(U64 starting_sample, BitState initial_bit_state);
+
+    //edge i of the carrier is at first_edge + deltas[0] + ... + deltas[i - 1], rising and falling edges alike.
+    void AddEdges(U64 first_edge, const U32 *deltas, U32 count);
+
+    //points of the intervals that have ended
+    const std::vector<QiCarrierPoint> &GetPoints() const;
+    void ClearPoints();
+
+    static double GetFrequencyHz(const QiCarrierPoint &point, U32 sample_rate_hz);
+    static double GetDutyPercent(const QiCarrierPoint &point);
+
+protected:
+    void AddEdge(U64 edge);
+    void EndInterval(U64 edge);
+
+    U64 mInterval;      //in samples
+    U64 mMaxPeriod;
+    U64 mIntervalEnd;
+
+    bool mHigh;         //level after the last edge
+    bool mRisingEdgeSeen;
+    U64 mRisingEdge;
+    U64 mFallingEdge;
+
+    QiCarrierPoint mPoint;
+    std::vector<QiCarrierPoint> mPoints;
+};
+
+#endif //Qi_CARRIER_TRACKER_H
@@ -0,0 +1,641 @@
+#include "QiDecoder.h"
+#include "QiAnalyzerResults.h"
+#include <string.h>
+
+#define QI_MAX_PREAMBLE_BITS 25
+
+QiDecoder::QiDecoder()
+    :   mHalfCellMin(0),
+        mHalfCellMax(0),
+        mFullCellMin(0),
+        mFullCellMax(0),
+        mIdleGapMin(0),
+        mBitsPerByte(8),
+        mShiftOrder(AnalyzerEnums::LsbFirst),
+        mMinimumPreambleBits(QI_MIN_PREAMBLE_BITS),
+        mMarkerCategories(QI_MARKER_ALL)
+{
+    Reset(0);
+}
+
+QiDecoder::~QiDecoder()
+{
+}
+
+void QiDecoder::Init(U32 sample_rate_hz, U32 bit_rate, U32 tolerance_percent, U32 bits_per_byte, AnalyzerEnums::ShiftOrder shift_order)
+{
+    SetBitRate(sample_rate_hz, bit_rate, tolerance_percent);
+
+    mBitsPerByte = bits_per_byte;
+    mShiftOrder = shift_order;
+}
+
+void QiDecoder::SetBitRate(U32 sample_rate_hz, U32 bit_rate, U32 tolerance_percent)
+{
+    //a 2kHz bi-phase bit is either one full cell (0) or two half cells (1).
+    //the limits are kept in fixed point so that low sample rates don't lose the fraction of a sample.
+    U64 half_cell = (U64(sample_rate_hz) << QI_CELL_FRACTION_BITS) / (U64(bit_rate) * 2);
+    U64 full_cell = half_cell * 2;
+    U64 tolerance = tolerance_percent;
+
+    mHalfCellMin = half_cell * (100 - tolerance) / 100;
+    mHalfCellMax = half_cell * (100 + tolerance) / 100;
+    mFullCellMin = full_cell * (100 - tolerance) / 100;
+    mFullCellMax = full_cell * (100 + tolerance) / 100;
+
+    //the line is idle if nothing happens for 1.6 bit periods (80000 samples at 100MHz)
+    mIdleGapMin = full_cell * 8 / 5;
+}
+
+void QiDecoder::SetMinimumPreambleBits(U32 bits)
+{
+    mMinimumPreambleBits = bits;
+}
+
+void QiDecoder::Reset(U64 starting_sample)
+{
+    mState = HuntIdle;
+    mEdgeSample = starting_sample;
+    mPreviousEdgeSample = starting_sample;
+    mBitStartingSample = starting_sample;
+    mHalfCellSeen = false;
+    mPreambleBits = 0;
+    mPreambleHalfCells = 0;
+
+    mByteStartingSample = starting_sample;
+    mData = 0;
+    mBitCount = 0;
+    mOddOnes = false;
+    mByteFlags = 0;
+    mBytePending = false;
+
+    mInPacket = false;
+    mPacketByteCount = 0;
+    mPacketSize = 0;
+    mPacketChecksum = 0;
+
+    ClearOutput();
+}
+
+void QiDecoder::ResumeAfterIdleGap(U64 edge_sample)
+{
+    //same state DecodeWidth leaves behind for an idle gap
+    Reset(edge_sample);
+    mState = Preamble;
+}
+
+void QiDecoder::SetMarkerCategories(U32 categories)
+{
+    mMarkerCategories = categories;
+}
+
+const QiMarkerCounts &QiDecoder::GetMarkerCounts() const
+{
+    return mMarkerCounts;
+}
+
+U64 QiDecoder::GetEdgeSample() const
+{
+    return mEdgeSample;
+}
+
+S8 QiDecoder::ClassifyCell(U64 width) const
+{
+    U64 width_fp = width << QI_CELL_FRACTION_BITS;
+
+    if (width_fp > mHalfCellMin && width_fp < mHalfCellMax) {
+        return 1;
+    } else if (width_fp > mFullCellMin && width_fp < mFullCellMax) {
+        return 0;
+    } else {
+        return -1;
+    }
+}
+
+bool QiDecoder::IsIdleGap(U64 width) const
+{
+    return (width << QI_CELL_FRACTION_BITS) > mIdleGapMin;
+}
+
+U64 QiDecoder::GetIdleGapWidth() const
+{
+    return mIdleGapMin >> QI_CELL_FRACTION_BITS;
+}
+
+void QiDecoder::DecodeEdges(U64 first_edge, const U32 *deltas, U32 count)
+{
+    U64 width = first_edge - mEdgeSample;
+    mPreviousEdgeSample = mEdgeSample;
+    mEdgeSample = first_edge;
+    DecodeWidth(width);
+
+    DecodeDeltas(deltas, count);
+}
+
+void QiDecoder::DecodeDeltas(const U32 *deltas, U32 count)
+{
+    U32 i = 0;
+    while (i < count) {
+        if (mState == Resync) {
+            i += ScanForPreamble(deltas + i, count - i);
+            if (i == count) {
+                break;
+            }
+        } else if (mState != HuntIdle) {
+            i += DecodePacketCells(deltas + i, count - i);
+            if (i == count) {
+                break;
+            }
+        }
+
+        mPreviousEdgeSample = mEdgeSample;
+        mEdgeSample += deltas[i];
+        DecodeWidth(deltas[i]);
+        i++;
+    }
+}
+
+void QiDecoder::DecodeTransition(U64 edge_sample, U64 width)
+{
+    mPreviousEdgeSample = mEdgeSample;
+    mEdgeSample = edge_sample;
+    DecodeWidth(width);
+}
+
+U64 QiDecoder::DecodeSilence(U64 width, U64 sample)
+{
+    if (IsIdleGap(width) == true) {
+        //what the next edge would do, minus starting a bit at it; the next edge repeats this harmlessly.
+        EndIdleGap(mEdgeSample, mEdgeSample);
+        return sample;
+    }
+
+    if (mBytePending == true) {
+        return mPendingByte.mStartingSample;
+    }
+
+    switch (mState) {
+    case HuntIdle:
+        return sample;
+    case Preamble:
+        return mBitStartingSample;
+    case ByteGap:
+    case Resync:
+        return mEdgeSample;
+    default:
+        return mByteStartingSample;
+    }
+}
+
+void QiDecoder::DecodeWidth(U64 width)
+{
+    //mEdgeSample is the edge that ends this width, mPreviousEdgeSample the one that starts it.
+    if (IsIdleGap(width) == true) {
+        EndIdleGap(mPreviousEdgeSample, mEdgeSample);
+        return;
+    }
+
+    if (mState == HuntIdle) {
+        return;
+    }
+
+    if (mState == Resync) {
+        if (EndsPreamble(width) == false) {
+            ANALYZER_INSTRUMENT(mWork.mResyncWidths++);
+            return;
+        }
+
+        //a full cell after the preamble, the start bit of the next header.
+        mState = Preamble;
+        mPreambleBits = mPreambleHalfCells / 2;
+        mHalfCellSeen = false;
+        mBitStartingSample = mPreviousEdgeSample;
+    }
+
+    if (mState == ByteGap) {
+        //bytes are sent back to back, this is the start bit of the next one.
+        mState = StartBit;
+        mByteStartingSample = mPreviousEdgeSample;
+        mBitStartingSample = mByteStartingSample;
+    }
+
+    S8 cell = ClassifyCell(width);
+    int bit;
+
+    if (mHalfCellSeen == false) {
+        if (cell == 1) {
+            mHalfCellSeen = true;
+            return;
+        }
+        bit = (cell == 0) ? 0 : -1;
+    } else {
+        mHalfCellSeen = false;
+        bit = (cell == 1) ? 1 : -1;
+    }
+
+    if (bit < 0) {
+        if (mState != Preamble) {
+            AbandonPacket();
+            return;
+        }
+
+        //a bad cell breaks the run of ones, and the cells after it may pair up out of step with the bits.
+        //The preamble is counted again in half cells, which finds the start bit whichever way they pair up.
+        AddMarker(mEdgeSample, AnalyzerResults::ErrorX, QI_MARKER_BITS | QI_MARKER_ERRORS);
+        mState = Resync;
+        ANALYZER_INSTRUMENT(mWork.mResyncs++);
+        mPreambleHalfCells = 0;
+        mHalfCellSeen = false;
+        return;
+    }
+
+    //the bit goes first: a packet start marker it adds lies before the end of the bit.
+    EndBit(bit);
+    AddMarker(mEdgeSample, AnalyzerResults::Dot, QI_MARKER_BITS);
+}
+
+void QiDecoder::AbandonPacket()
+{
+    //the cells after a bad one are out of step with the bits, so decoding on only turns noise into bytes.
+    //The packet ends here with an error frame over the byte it broke, and nothing more is decoded until
+    //the next preamble. Noise after the end of a packet has no packet to end.
+    if (mInPacket == true || mPacketByteCount != 0) {
+        if (mBytePending == true) {
+            mBytes.push_back(mPendingByte);
+            mBytePending = false;
+        }
+
+        QiDecodedByte byte;
+        byte.mStartingSample = mByteStartingSample;
+        byte.mEndingSample = mEdgeSample;
+        byte.mValue = 0;
+        byte.mExpected = 0;
+        byte.mType = QiBitErrorFrame;
+        byte.mFlags = TRUNCATED_PACKET_FLAG | DISPLAY_AS_ERROR_FLAG;
+        byte.mEndsPacket = true;
+        mBytes.push_back(byte);
+    }
+
+    AddMarker(mEdgeSample, AnalyzerResults::ErrorX, QI_MARKER_BITS | QI_MARKER_PACKETS | QI_MARKER_ERRORS);
+
+    mInPacket = false;
+    mPacketByteCount = 0;
+    mState = Resync;
+    ANALYZER_INSTRUMENT(mWork.mResyncs++);
+    mPreambleHalfCells = 0;
+    mHalfCellSeen = false;
+}
+
+bool QiDecoder::EndsPreamble(U64 width)
+{
+    //counts half cells in a row; true for the full cell that follows enough of them, or an idle gap.
+    U64 width_fp = width << QI_CELL_FRACTION_BITS;
+
+    if (width_fp > mHalfCellMin && width_fp < mHalfCellMax) {
+        mPreambleHalfCells++;
+        return false;
+    }
+
+    if (width_fp > mIdleGapMin) {
+        return true;
+    }
+
+    if (width_fp > mFullCellMin && width_fp < mFullCellMax && mPreambleHalfCells >= mMinimumPreambleBits * 2) {
+        return true;
+    }
+
+    mPreambleHalfCells = 0;
+    return false;
+}
+
+U32 QiDecoder::ScanForPreamble(const U32 *deltas, U32 count)
+{
+    //only the widths matter until the next preamble, so they are skipped over without making bits, bytes or markers.
+    //Returns how many were skipped; the one that ends the preamble is left to DecodeWidth.
+    U64 edge_sample = mEdgeSample;
+
+    U32 i;
+    for (i = 0; i < count; i++) {
+        if (EndsPreamble(deltas[i]) == true) {
+            break;
+        }
+        edge_sample += deltas[i];
+    }
+
+    mEdgeSample = edge_sample;
+    ANALYZER_INSTRUMENT(mWork.mResyncWidths += i);
+    return i;
+}
+
+U32 QiDecoder::DecodePacketCells(const U32 *deltas, U32 count)
+{
+    //The cells of the preamble and the bytes are most of the work, so they get a loop of their own, with the same
+    //result as DecodeWidth and EndBit but the bit state in locals and a call only per byte. Returns how many widths
+    //were decoded; the one it stopped at, an idle gap, a bad cell or any width while hunting, is left to DecodeWidth.
+    bool bit_markers = (mMarkerCategories & QI_MARKER_BITS) != 0;
+    State state = mState;
+    U64 edge_sample = mEdgeSample;
+    U64 bit_starting_sample = mBitStartingSample;
+    bool half_cell_seen = mHalfCellSeen;
+    U32 preamble_bits = mPreambleBits;
+    U64 data = mData;
+    U32 bit_count = mBitCount;
+    bool odd_ones = mOddOnes;
+
+    U32 i;
+    for (i = 0; i < count; i++) {
+        if (state == HuntIdle || state == Resync) {
+            break;
+        }
+
+        U64 width_fp = U64(deltas[i]) << QI_CELL_FRACTION_BITS;
+        if (width_fp > mIdleGapMin) {
+            break;
+        }
+
+        if (state == ByteGap) {
+            //bytes are sent back to back, this is the start bit of the next one.
+            state = StartBit;
+            mByteStartingSample = edge_sample;
+            bit_starting_sample = edge_sample;
+        }
+
+        bool half_cell = width_fp > mHalfCellMin && width_fp < mHalfCellMax;
+        U32 bit;
+        if (half_cell_seen == false) {
+            if (half_cell == true) {
+                half_cell_seen = true;
+                edge_sample += deltas[i];
+                continue;
+            }
+            if (width_fp <= mFullCellMin || width_fp >= mFullCellMax) {
+                break;
+            }
+            bit = 0;
+        } else {
+            if (half_cell == false) {
+                break;
+            }
+            half_cell_seen = false;
+            bit = 1;
+        }
+
+        edge_sample += deltas[i];
+        ANALYZER_INSTRUMENT(mWork.mBits++);
+        U64 previous_bit_starting_sample = bit_starting_sample;
+        bit_starting_sample = edge_sample;
+
+        switch (state) {
+        case Preamble:
+            if (bit == 0 && preamble_bits < mMinimumPreambleBits) {
+                preamble_bits = 0;
+            } else if (bit == 0) {
+                mInPacket = true;
+                AddMarker(previous_bit_starting_sample, AnalyzerResults::Start, QI_MARKER_PACKETS);
+                mByteStartingSample = previous_bit_starting_sample;
+                data = 0;
+                bit_count = 0;
+                odd_ones = false;
+                state = DataBits;
+            } else if (++preamble_bits >= QI_MAX_PREAMBLE_BITS) {
+                state = HuntIdle;
+            }
+            break;
+
+        case StartBit:
+            data = 0;
+            bit_count = 0;
+            odd_ones = false;
+            state = DataBits;
+            break;
+
+        case DataBits:
+            odd_ones = odd_ones != (bit != 0);
+            if (mShiftOrder == AnalyzerEnums::LsbFirst) {
+                data |= U64(bit) << bit_count;
+            } else {
+                data = (data << 1) | bit;
+            }
+            if (++bit_count == mBitsPerByte) {
+                state = ParityBit;
+            }
+            break;
+
+        case ParityBit:
+            mByteFlags = (odd_ones == (bit != 0)) ? PARITY_ERROR_FLAG : 0;
+            state = StopBit;
+            break;
+
+        case StopBit:
+            if (bit != 1) {
+                mByteFlags |= FRAMING_ERROR_FLAG;
+            }
+            mEdgeSample = edge_sample;
+            mData = data;
+            AddByte();
+            state = ByteGap;
+            break;
+
+        default:
+            break;
+        }
+
+        if (bit_markers == true) {
+            QiMarker marker = { edge_sample, AnalyzerResults::Dot };
+            mMarkers.push_back(marker);
+            mMarkerCounts.mEmitted++;
+        } else {
+            mMarkerCounts.mSuppressed++;
+        }
+    }
+
+    mState = state;
+    mEdgeSample = edge_sample;
+    mBitStartingSample = bit_starting_sample;
+    mHalfCellSeen = half_cell_seen;
+    mPreambleBits = preamble_bits;
+    mData = data;
+    mBitCount = bit_count;
+    mOddOnes = odd_ones;
+    return i;
+}
+
+void QiDecoder::EndIdleGap(U64 gap_start, U64 gap_end)
+{
+    if (mBytePending == true) {
+        //the transmitter went quiet before the checksum arrived.
+        mPendingByte.mFlags |= TRUNCATED_PACKET_FLAG | DISPLAY_AS_ERROR_FLAG;
+        mPendingByte.mEndsPacket = true;
+        mBytes.push_back(mPendingByte);
+        mBytePending = false;
+    }
+
+    if (mInPacket == true) {
+        //the packet stopped at the last edge before the gap.
+        AddMarker(gap_start, AnalyzerResults::ErrorX, QI_MARKER_PACKETS | QI_MARKER_ERRORS);
+        mInPacket = false;
+    }
+
+    mPacketByteCount = 0;
+    mState = Preamble;
+    mPreambleBits = 0;
+    mHalfCellSeen = false;
+    mBitStartingSample = gap_end;
+}
+
+void QiDecoder::EndBit(int bit)
+{
+    ANALYZER_INSTRUMENT(mWork.mBits++);
+
+    U64 bit_starting_sample = mBitStartingSample;
+    mBitStartingSample = mEdgeSample;
+
+    switch (mState) {
+    case Preamble:
+        if (bit == 0 && mPreambleBits < mMinimumPreambleBits) {
+            //too few ones for a preamble, a noise pulse as long as a cell rather than a start bit.
+            mPreambleBits = 0;
+        } else if (bit == 0) {
+            //the first zero after the preamble is the start bit of the header.
+            mInPacket = true;
+            AddMarker(bit_starting_sample, AnalyzerResults::Start, QI_MARKER_PACKETS);
+            mByteStartingSample = bit_starting_sample;
+            mData = 0;
+            mBitCount = 0;
+            mOddOnes = false;
+            mState = DataBits;
+        } else if (++mPreambleBits >= QI_MAX_PREAMBLE_BITS) {
+            mState = HuntIdle;
+        }
+        break;
+
+    case StartBit:
+        mData = 0;
+        mBitCount = 0;
+        mOddOnes = false;
+        mState = DataBits;
+        break;
+
+    case DataBits: {
+        U64 value = (bit != 0) ? 1 : 0;
+        mOddOnes = mOddOnes != (value != 0);
+        if (mShiftOrder == AnalyzerEnums::LsbFirst) {
+            mData |= value << mBitCount;
+        } else {
+            mData = (mData << 1) | value;
+        }
+
+        if (++mBitCount == mBitsPerByte) {
+            mState = ParityBit;
+        }
+        break;
+    }
+
+    case ParityBit:
+        //odd parity: the data bits and the parity bit have an odd number of ones between them.
+        mByteFlags = (mOddOnes == (bit != 0)) ? PARITY_ERROR_FLAG : 0;
+        mState = StopBit;
+        break;
+
+    case StopBit:
+        if (bit != 1) {
+            mByteFlags |= FRAMING_ERROR_FLAG;
+        }
+        AddByte();
+        mState = ByteGap;
+        break;
+
+    default:
+        break;
+    }
+}
+
+void QiDecoder::AddByte()
+{
+    //a Qi packet is a header byte, a message whose size is given by the header, and a checksum byte.
+    QiDecodedByte byte;
+    byte.mStartingSample = mByteStartingSample;
+    byte.mEndingSample = mEdgeSample;
+    byte.mValue = U8(mData);
+    byte.mExpected = 0;
+    byte.mFlags = mByteFlags;
+    byte.mEndsPacket = false;
+    if (mByteFlags != 0) {
+        byte.mFlags |= DISPLAY_AS_ERROR_FLAG;
+    }
+
+    if (mPacketByteCount == 0) {
+        byte.mType = QiHeaderFrame;
+        mPacketSize = QiAnalyzerResults::GetMessageSize(byte.mValue) + 2;
+        mPacketChecksum = byte.mValue;
+    } else if (mPacketByteCount < mPacketSize - 1) {
+        byte.mType = QiMessageFrame;
+        mPacketChecksum ^= byte.mValue;
+    } else {
+        byte.mType = QiChecksumFrame;
+        byte.mExpected = mPacketChecksum;
+        if (byte.mValue != mPacketChecksum) {
+            byte.mFlags |= CHECKSUM_ERROR_FLAG | DISPLAY_AS_ERROR_FLAG;
+        }
+    }
+
+    //the previous byte is only released once we know it wasn't the last one of a truncated packet.
+    if (mBytePending == true) {
+        mBytes.push_back(mPendingByte);
+        mBytePending = false;
+    }
+
+    if (++mPacketByteCount == mPacketSize) {
+        byte.mEndsPacket = true;
+        mBytes.push_back(byte);
+        mPacketByteCount = 0;
+
+        mInPacket = false;
+        if ((byte.mFlags & (CHECKSUM_ERROR_FLAG | PARITY_ERROR_FLAG | FRAMING_ERROR_FLAG)) != 0) {
+            AddMarker(mEdgeSample, AnalyzerResults::ErrorX, QI_MARKER_PACKETS | QI_MARKER_ERRORS);
+        } else {
+            AddMarker(mEdgeSample, AnalyzerResults::Stop, QI_MARKER_PACKETS);
+        }
+    } else {
+        if (mByteFlags != 0) {
+            AddMarker(mEdgeSample, AnalyzerResults::ErrorX, QI_MARKER_ERRORS);
+        }
+        mPendingByte = byte;
+        mBytePending = true;
+    }
+}
+
+void QiDecoder::AddMarker(U64 sample, AnalyzerResults::MarkerType type, U32 categories)
+{
+    if ((categories & mMarkerCategories) == 0) {
+        mMarkerCounts.mSuppressed++;
+        return;
+    }
+
+    QiMarker marker = { sample, type };
+    mMarkers.push_back(marker);
+    mMarkerCounts.mEmitted++;
+}
+
+const std::vector<QiDecodedByte> &QiDecoder::GetBytes() const
+{
+    return mBytes;
+}
+
+const std::vector<QiMarker> &QiDecoder::GetMarkers() const
+{
+    return mMarkers;
+}
+
+const QiDecoderWork &QiDecoder::GetWork() const
+{
+    return mWork;
+}
+
+void QiDecoder::ClearOutput()
+{
+    mBytes.clear();
+    mMarkers.clear();
+    memset(&mMarkerCounts, 0, sizeof(mMarkerCounts));
+    memset(&mWork, 0, sizeof(mWork));
+}
@@ -0,0 +1,153 @@
+#ifndef Qi_DECODER_H
+#define Qi_DECODER_H
+
+#include <AnalyzerResults.h>
+#include <AnalyzerTypes.h>
+#include "AnalyzerInstrumentation.h"
+#include <vector>
+
+#define QI_CELL_FRACTION_BITS 8  //bit cell limits are kept in 24.8 fixed point samples
+#define QI_MIN_PREAMBLE_BITS 11     //one more than the longest run of ones inside a packet: a 0xFF byte, its parity and stop bits
+
+//marker categories, see QiDecoder::SetMarkerCategories
+#define QI_MARKER_BITS      ( 1 << 0 )  //a dot at the end of every bit
+#define QI_MARKER_PACKETS   ( 1 << 1 )  //start and end of every packet
+#define QI_MARKER_ERRORS    ( 1 << 2 )  //undecodable bit cells, parity and framing errors, truncated packets and bad checksums
+#define QI_MARKER_ALL       ( QI_MARKER_BITS | QI_MARKER_PACKETS | QI_MARKER_ERRORS )
+
+struct QiDecodedByte {
+    U64 mStartingSample;
+    U64 mEndingSample;
+    U8 mValue;
+    U8 mExpected;   //computed checksum, only used by the checksum byte
+    U8 mType;       //QiFrameType
+    U8 mFlags;
+    bool mEndsPacket;
+};
+
+struct QiMarker {
+    U64 mSample;
+    AnalyzerResults::MarkerType mType;
+};
+
+//markers of the output not yet cleared, for the error summary; suppressed ones are left out by the marker categories
+struct QiMarkerCounts {
+    U64 mEmitted;
+    U64 mSuppressed;
+};
+
+//work done for the output not yet cleared, for the instrumentation report; only counted with ANALYZER_INSTRUMENTATION defined
+struct QiDecoderWork {
+    U64 mBits;
+    U64 mResyncs;
+    U64 mResyncWidths;  //skipped while hunting for the next preamble
+};
+
+//Bi-phase bit, byte and packet decoder for the Qi ASK back channel.
+//It is fed the widths between consecutive edges and never touches the channel data itself,
+//so a whole chunk of edges can be classified in one tight loop.
+class QiDecoder
+{
+public:
+    QiDecoder();
+    ~QiDecoder();
+
+    void Init(U32 sample_rate_hz, U32 bit_rate, U32 tolerance_percent, U32 bits_per_byte, AnalyzerEnums::ShiftOrder shift_order);
+
+    //moves the bit cell limits to another bit rate, e.g. one estimated from the line (see QiBitRateEstimator).
+    void SetBitRate(U32 sample_rate_hz, U32 bit_rate, U32 tolerance_percent);
+
+    //ones a packet's start bit has to follow after an idle gap, QI_MIN_PREAMBLE_BITS unless set.
+    void SetMinimumPreambleBits(U32 bits);
+    void Reset(U64 starting_sample);
+
+    //puts the decoder in the state every decoder is in right after an idle gap ending at edge_sample,
+    //whatever came before it. This is what lets a capture be decoded in independent segments.
+    void ResumeAfterIdleGap(U64 edge_sample);
+
+    //edge i is at first_edge + deltas[0] + ... + deltas[i - 1]
+    void DecodeEdges(U64 first_edge, const U32 *deltas, U32 count);
+
+    //continues from the last edge decoded
+    void DecodeDeltas(const U32 *deltas, U32 count);
+
+    //one edge at a time, for edges whose width isn't measured in samples (see QiFskDemodulator).
+    void DecodeTransition(U64 edge_sample, U64 width);
+
+    //there has been no edge for width since the last one, up to sample. Ends the packet if that is already
+    //an idle gap, instead of waiting for the next edge, and returns the earliest sample that output
+    //still to come can start at. This is what lets the output of two decoders be merged in order.
+    U64 DecodeSilence(U64 width, U64 sample);
+
+    //only markers in one of these categories are emitted; the others are just counted.
+    void SetMarkerCategories(U32 categories);
+    const QiMarkerCounts &GetMarkerCounts() const;
+
+    U64 GetEdgeSample() const;     //the last edge decoded
+
+    S8 ClassifyCell(U64 width) const;
+    bool IsIdleGap(U64 width) const;
+    U64 GetIdleGapWidth() const;    //widths longer than this are idle gaps
+
+    const std::vector<QiDecodedByte> &GetBytes() const;
+    const std::vector<QiMarker> &GetMarkers() const;
+    const QiDecoderWork &GetWork() const;
+    void ClearOutput();
+
+protected:
+    enum State { HuntIdle, Preamble, StartBit, DataBits, ParityBit, StopBit, ByteGap, Resync };
+
+    void DecodeWidth(U64 width);
+    void AbandonPacket();
+    bool EndsPreamble(U64 width);
+    U32 ScanForPreamble(const U32 *deltas, U32 count);
+    U32 DecodePacketCells(const U32 *deltas, U32 count);
+    void EndIdleGap(U64 gap_start, U64 gap_end);
+    void EndBit(int bit);
+    void AddByte();
+    void AddMarker(U64 sample, AnalyzerResults::MarkerType type, U32 categories);
+
+    //bit cell limits, derived from the sample rate and bit rate
+    U64 mHalfCellMin;
+    U64 mHalfCellMax;
+    U64 mFullCellMin;
+    U64 mFullCellMax;
+    U64 mIdleGapMin;
+
+    U32 mBitsPerByte;
+    AnalyzerEnums::ShiftOrder mShiftOrder;
+    U32 mMinimumPreambleBits;
+
+    //bit state
+    State mState;
+    U64 mEdgeSample;
+    U64 mPreviousEdgeSample;
+    U64 mBitStartingSample;
+    bool mHalfCellSeen;
+    U32 mPreambleBits;
+    U32 mPreambleHalfCells;     //in a row, while resynchronizing
+
+    //byte state
+    U64 mByteStartingSample;
+    U64 mData;
+    U32 mBitCount;
+    bool mOddOnes;      //the data bits so far have an odd number of ones
+    U8 mByteFlags;      //PARITY_ERROR_FLAG and FRAMING_ERROR_FLAG of the byte
+    bool mBytePending;
+    QiDecodedByte mPendingByte;
+
+    //packet assembly
+    bool mInPacket;
+    U32 mPacketByteCount;
+    U32 mPacketSize;
+    U8 mPacketChecksum;
+
+    U32 mMarkerCategories;
+    QiMarkerCounts mMarkerCounts;
+
+    std::vector<QiDecodedByte> mBytes;
+    std::vector<QiMarker> mMarkers;
+    QiDecoderWork mWork;
+};
+
+#endif //Qi_DECODER_H
@@ -0,0 +1,105 @@
+#include "QiFskDemodulator.h"
+
+QiFskDemodulator::QiFskDemodulator()
+    :   mThreshold(2)
+{
+    Reset(0);
+}
+
+QiFskDemodulator::~QiFskDemodulator()
+{
+}
+
+void QiFskDemodulator::Init(U32 sample_rate_hz, U32 threshold_ns, U32 tolerance_percent, U32 bits_per_byte, AnalyzerEnums::ShiftOrder shift_order)
+{
+    //the decoder counts carrier periods instead of samples: a bit is 256 of them.
+    mDecoder.Init(QI_FSK_CYCLES_PER_BIT, 1, tolerance_percent, bits_per_byte, shift_order);
+    mDecoder.SetMinimumPreambleBits(QI_FSK_MIN_PREAMBLE_BITS);
+
+    //a period change of threshold_ns changes the window by QI_FSK_WINDOW_CYCLES times as much.
+    //below 2 samples the measurement would trip on the +-1 sample quantization of the edges.
+    mThreshold = U64(threshold_ns) * QI_FSK_WINDOW_CYCLES * sample_rate_hz / 1000000000ull;
+    if (mThreshold < 2) {
+        mThreshold = 2;
+    }
+}
+
+void QiFskDemodulator::Reset(U64 starting_sample)
+{
+    mDecoder.Reset(starting_sample);
+
+    for (U32 i = 0; i < QI_FSK_WINDOW_CYCLES; i++) {
+        mPeriodEdges[i] = starting_sample;
+    }
+    mPeriodCount = 0;
+    mOddEdge = false;
+
+    mLevel = 0;
+    mSettling = QI_FSK_WINDOW_CYCLES + 1;  //the first period starts at the first edge, not at starting_sample
+    mLastChangePeriod = 0;
+}
+
+void QiFskDemodulator::DecodeEdges(U64 first_edge, const U32 *deltas, U32 count)
+{
+    U64 edge = first_edge;
+    if (mOddEdge == false) {
+        DecodePeriod(edge);
+    }
+
+    for (U32 i = 0; i < count; i++) {
+        edge += deltas[i];
+        mOddEdge = !mOddEdge;
+        if (mOddEdge == false) {
+            DecodePeriod(edge);
+        }
+    }
+
+    mOddEdge = !mOddEdge;
+}
+
+void QiFskDemodulator::DecodePeriod(U64 edge)
+{
+    U32 slot = U32(mPeriodCount & (QI_FSK_WINDOW_CYCLES - 1));
+    U64 window = edge - mPeriodEdges[slot];
+    mPeriodEdges[slot] = edge;
+    mPeriodCount++;
+
+    if (mSettling != 0) {
+        if (--mSettling == 0) {
+            mLevel = window << 4;
+        }
+        return;
+    }
+
+    U64 level = mLevel >> 4;
+    U64 difference = (window > level) ? window - level : level - window;
+    if (difference <= mThreshold) {
+        //follows slow drift, e.g. the power control loop moving the operating frequency.
+        mLevel = mLevel - (mLevel >> 4) + window;
+        return;
+    }
+
+    //the window straddles the change; it is placed half a window back, which is the same for every change,
+    //so the widths between changes come out right.
+    U64 change_period = mPeriodCount - 1 - QI_FSK_WINDOW_CYCLES / 2;
+    mDecoder.DecodeTransition(mPeriodEdges[change_period & (QI_FSK_WINDOW_CYCLES - 1)], change_period - mLastChangePeriod);
+    mLastChangePeriod = change_period;
+    mSettling = QI_FSK_WINDOW_CYCLES;
+}
+
+U64 QiFskDemodulator::DecodeSilence()
+{
+    if (mPeriodCount < QI_FSK_WINDOW_CYCLES) {
+        return mDecoder.DecodeSilence(0, mPeriodEdges[0]);
+    }
+
+    //the next change is found at the next period at the earliest, and placed half a window before it.
+    U64 quiet_period = mPeriodCount - QI_FSK_WINDOW_CYCLES / 2;
+    U64 quiet_width = (quiet_period > mLastChangePeriod) ? quiet_period - mLastChangePeriod : 0;
+    return mDecoder.DecodeSilence(quiet_width, mPeriodEdges[quiet_period & (QI_FSK_WINDOW_CYCLES - 1)]);
+}
+
+QiDecoder &QiFskDemodulator::GetDecoder()
+{
+    return mDecoder;
+}
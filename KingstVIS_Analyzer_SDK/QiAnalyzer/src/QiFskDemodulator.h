@@ -0,0 +1,51 @@
+#ifndef Qi_FSK_DEMODULATOR_H
+#define Qi_FSK_DEMODULATOR_H
+
+#include "QiDecoder.h"
+
+#define QI_FSK_CYCLES_PER_BIT 256   //carrier periods per FSK bit
+#define QI_FSK_WINDOW_CYCLES  32    //carrier periods per frequency measurement, a power of two below half a bit
+#define QI_FSK_MIN_PREAMBLE_BITS 3  //the transmitter sends 4, and the first can go by while the measurement settles
+
+//FSK demodulator for the power transmitter to power receiver direction.
+//The transmitter shifts its operating frequency, and every frequency change is an edge of a
+//differential bi-phase signal whose bits are 256 carrier periods long. Frequency changes are found by
+//measuring the duration of the last QI_FSK_WINDOW_CYCLES carrier periods at every period, which only needs
+//the edges of one polarity and is exact to a sample however long the window is.
+//The changes are fed to a QiDecoder with widths in carrier periods, so bits, bytes and packets
+//are framed exactly as on the ASK side.
+class QiFskDemodulator
+{
+public:
+    QiFskDemodulator();
+    ~QiFskDemodulator();
+
+    //threshold_ns is the smallest change of the carrier period that counts as a frequency change.
+    void Init(U32 sample_rate_hz, U32 threshold_ns, U32 tolerance_percent, U32 bits_per_byte, AnalyzerEnums::ShiftOrder shift_order);
+    void Reset(U64 starting_sample);
+
+    //edge i of the carrier is at first_edge + deltas[0] + ... + deltas[i - 1], rising and falling edges alike.
+    void DecodeEdges(U64 first_edge, const U32 *deltas, U32 count);
+
+    //the earliest sample that output still to come can start at, see QiDecoder::DecodeSilence.
+    U64 DecodeSilence();
+
+    QiDecoder &GetDecoder();
+
+protected:
+    void DecodePeriod(U64 edge);
+
+    QiDecoder mDecoder;
+    U64 mThreshold;     //in samples per window
+
+    //the edges of the last QI_FSK_WINDOW_CYCLES periods, indexed by period number
+    U64 mPeriodEdges[QI_FSK_WINDOW_CYCLES];
+    U64 mPeriodCount;
+    bool mOddEdge;      //only every other edge starts a period
+
+    U64 mLevel;             //window duration of the current frequency, in 1/16 samples
+    U32 mSettling;          //periods until the window holds only the new frequency
+    U64 mLastChangePeriod;
+};
+
+#endif //Qi_FSK_DEMODULATOR_H
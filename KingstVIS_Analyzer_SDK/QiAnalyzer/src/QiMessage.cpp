@@ -0,0 +1,321 @@
+#include "QiMessage.h"
+#include "QiAnalyzerResults.h"
+#include <stdio.h>
+#include <string.h>
+
+void QiMessage::Decode(const U8 *bytes, U32 byte_count, U8 flags, U32 max_power_mw, QiPacketRecord &record)
+{
+    memset(&record, 0, sizeof(record));
+    record.mHeader = bytes[0];
+    record.mType = QiUnknownPacket;
+    record.mFlags = flags & (QI_PACKET_ERROR_FLAGS | TRANSMITTER_FRAME_FLAG);
+    record.mMessageSize = U8(byte_count - 1);
+
+    //a truncated packet is missing bytes, whatever its header says.
+    if ((flags & TRUNCATED_PACKET_FLAG) != 0 || byte_count != QiAnalyzerResults::GetMessageSize(bytes[0]) + 1) {
+        return;
+    }
+
+    const U8 *message = bytes + 1;
+
+    if ((flags & TRANSMITTER_FRAME_FLAG) != 0) {
+        switch (record.mHeader) {
+        case 0x30:
+            record.mType = QiTransmitterIdentificationPacket;
+            record.mIdentification.mMajorVersion = message[0] >> 4;
+            record.mIdentification.mMinorVersion = message[0] & 0x0F;
+            record.mIdentification.mManufacturer = U16((message[1] << 8) | message[2]);
+            break;
+
+        case 0x31:
+            record.mType = QiTransmitterCapabilityPacket;
+            record.mCapability.mPowerClass = message[0] >> 6;
+            record.mCapability.mGuaranteedPower = message[0] & 0x3F;
+            record.mCapability.mPotentialPower = message[1] & 0x3F;
+            record.mCapability.mWpid = (message[2] & 0x02) != 0;
+            record.mCapability.mNotResSens = (message[2] & 0x01) != 0;
+            break;
+
+        default:
+            break;
+        }
+        return;
+    }
+
+    switch (record.mHeader) {
+    case 0x01:
+        record.mType = QiSignalStrengthPacket;
+        record.mSignalStrength = message[0];
+        break;
+
+    case 0x02:
+        record.mType = QiEndPowerTransferPacket;
+        record.mEndPowerTransferCode = message[0];
+        break;
+
+    case 0x03:
+        record.mType = QiControlErrorPacket;
+        record.mControlError = S8(message[0]);
+        break;
+
+    case 0x04:
+        record.mType = QiReceivedPower8Packet;
+        record.mReceivedPower.mValue = message[0];
+        record.mReceivedPower.mMilliwatts = U32((U64(message[0]) * max_power_mw) / 128);
+        break;
+
+    case 0x05:
+        record.mType = QiChargeStatusPacket;
+        record.mChargeStatus = message[0];
+        break;
+
+    case 0x06:
+        record.mType = QiHoldOffPacket;
+        record.mHoldOffMs = message[0];
+        break;
+
+    case 0x31:
+        record.mType = QiReceivedPower24Packet;
+        record.mReceivedPower.mMode = message[0] & 0x07;
+        record.mReceivedPower.mValue = U16((message[1] << 8) | message[2]);
+        record.mReceivedPower.mMilliwatts = U32((U64(record.mReceivedPower.mValue) * max_power_mw) / 32768);
+        break;
+
+    case 0x51:
+        record.mType = QiConfigurationPacket;
+        record.mConfiguration.mPowerClass = message[0] >> 6;
+        record.mConfiguration.mMaximumPower = message[0] & 0x3F;
+        record.mConfiguration.mProp = (message[2] & 0x80) != 0;
+        record.mConfiguration.mCount = message[2] & 0x07;
+        record.mConfiguration.mWindowSize = message[3] >> 3;
+        record.mConfiguration.mWindowOffset = message[3] & 0x07;
+        record.mConfiguration.mNeg = (message[4] & 0x80) != 0;
+        record.mConfiguration.mPolarity = (message[4] & 0x40) != 0;
+        record.mConfiguration.mDepth = (message[4] >> 4) & 0x03;
+        break;
+
+    case 0x71:
+        record.mType = QiIdentificationPacket;
+        record.mIdentification.mMajorVersion = message[0] >> 4;
+        record.mIdentification.mMinorVersion = message[0] & 0x0F;
+        record.mIdentification.mManufacturer = U16((message[1] << 8) | message[2]);
+        record.mIdentification.mExtended = (message[3] & 0x80) != 0;
+        record.mIdentification.mDeviceId = (U32(message[3] & 0x7F) << 24) | (U32(message[4]) << 16) | (U32(message[5]) << 8) | message[6];
+        break;
+
+    default:
+        break;
+    }
+}
+
+const char *QiMessage::GetName(const QiPacketRecord &record)
+{
+    switch (record.mType) {
+    case QiSignalStrengthPacket:
+        return "Signal Strength";
+    case QiEndPowerTransferPacket:
+        return "End Power Transfer";
+    case QiControlErrorPacket:
+        return "Control Error";
+    case QiReceivedPower8Packet:
+    case QiReceivedPower24Packet:
+        return "Received Power";
+    case QiChargeStatusPacket:
+        return "Charge Status";
+    case QiHoldOffPacket:
+        return "Power Control Hold-off";
+    case QiConfigurationPacket:
+        return "Configuration";
+    case QiIdentificationPacket:
+        return "Identification";
+    case QiTransmitterIdentificationPacket:
+        return "Transmitter Identification";
+    case QiTransmitterCapabilityPacket:
+        return "Transmitter Capability";
+    default:
+        return "Packet";
+    }
+}
+
+const char *QiMessage::GetAbbreviation(const QiPacketRecord &record)
+{
+    switch (record.mType) {
+    case QiSignalStrengthPacket:
+        return "SS";
+    case QiEndPowerTransferPacket:
+        return "EPT";
+    case QiControlErrorPacket:
+        return "CE";
+    case QiReceivedPower8Packet:
+    case QiReceivedPower24Packet:
+        return "RP";
+    case QiChargeStatusPacket:
+        return "CHS";
+    case QiHoldOffPacket:
+        return "PCH";
+    case QiConfigurationPacket:
+        return "CFG";
+    case QiIdentificationPacket:
+        return "ID";
+    case QiTransmitterIdentificationPacket:
+        return "PTID";
+    case QiTransmitterCapabilityPacket:
+        return "CAP";
+    default:
+        return "?";
+    }
+}
+
+static const char *GetEndPowerTransferReason(U8 code)
+{
+    switch (code) {
+    case 0x00:
+        return "Unknown";
+    case 0x01:
+        return "Charge Complete";
+    case 0x02:
+        return "Internal Fault";
+    case 0x03:
+        return "Over Temperature";
+    case 0x04:
+        return "Over Voltage";
+    case 0x05:
+        return "Over Current";
+    case 0x06:
+        return "Battery Failure";
+    case 0x07:
+        return "Reconfigure";
+    case 0x08:
+        return "No Response";
+    case 0x0A:
+        return "Negotiation Failure";
+    case 0x0B:
+        return "Restart Power Transfer";
+    default:
+        return NULL;
+    }
+}
+
+void QiMessage::GetDetails(const QiPacketRecord &record, char *str, U32 max_length)
+{
+    if ((record.mFlags & TRUNCATED_PACKET_FLAG) != 0) {
+        snprintf(str, max_length, "header 0x%02X, truncated after %u bytes", record.mHeader, U32(record.mMessageSize));
+        return;
+    }
+
+    int length = 0;
+
+    switch (record.mType) {
+    case QiSignalStrengthPacket:
+        length = snprintf(str, max_length, "%u (%u%%)", U32(record.mSignalStrength), U32(record.mSignalStrength) * 100 / 256);
+        break;
+
+    case QiEndPowerTransferPacket: {
+        const char *reason = GetEndPowerTransferReason(record.mEndPowerTransferCode);
+        if (reason != NULL) {
+            length = snprintf(str, max_length, "%s", reason);
+        } else {
+            length = snprintf(str, max_length, "reserved code 0x%02X", U32(record.mEndPowerTransferCode));
+        }
+        break;
+    }
+
+    case QiControlErrorPacket:
+        length = snprintf(str, max_length, "%d", int(record.mControlError));
+        break;
+
+    case QiReceivedPower8Packet:
+    case QiReceivedPower24Packet:
+        length = snprintf(str, max_length, "%u", U32(record.mReceivedPower.mValue));
+        if (record.mReceivedPower.mMilliwatts != 0) {
+            length += snprintf(str + length, max_length - length, " (%.2f W)", record.mReceivedPower.mMilliwatts / 1000.0);
+        }
+        if (record.mType == QiReceivedPower24Packet) {
+            length += snprintf(str + length, max_length - length, ", mode %u", U32(record.mReceivedPower.mMode));
+        }
+        break;
+
+    case QiChargeStatusPacket:
+        if (record.mChargeStatus == 0xFF) {
+            length = snprintf(str, max_length, "unknown");
+        } else {
+            length = snprintf(str, max_length, "%u%%", U32(record.mChargeStatus));
+        }
+        break;
+
+    case QiHoldOffPacket:
+        length = snprintf(str, max_length, "%u ms", U32(record.mHoldOffMs));
+        break;
+
+    case QiConfigurationPacket:
+        length = snprintf(str, max_length, "class %u, max %.1f W, window %u ms at %u ms, count %u, prop %u, neg %u, polarity %u, depth %u",
+                          U32(record.mConfiguration.mPowerClass), GetMaximumPowerMilliwatts(record) / 1000.0,
+                          U32(record.mConfiguration.mWindowSize) * 4, U32(record.mConfiguration.mWindowOffset) * 4,
+                          U32(record.mConfiguration.mCount), U32(record.mConfiguration.mProp), U32(record.mConfiguration.mNeg),
+                          U32(record.mConfiguration.mPolarity), U32(record.mConfiguration.mDepth));
+        break;
+
+    case QiIdentificationPacket:
+        length = snprintf(str, max_length, "v%u.%u, manufacturer 0x%04X, device 0x%08X%s",
+                          U32(record.mIdentification.mMajorVersion), U32(record.mIdentification.mMinorVersion),
+                          U32(record.mIdentification.mManufacturer), record.mIdentification.mDeviceId,
+                          (record.mIdentification.mExtended == true) ? ", extended" : "");
+        break;
+
+    case QiTransmitterIdentificationPacket:
+        length = snprintf(str, max_length, "v%u.%u, manufacturer 0x%04X", U32(record.mIdentification.mMajorVersion),
+                          U32(record.mIdentification.mMinorVersion), U32(record.mIdentification.mManufacturer));
+        break;
+
+    case QiTransmitterCapabilityPacket:
+        length = snprintf(str, max_length, "class %u, guaranteed %.1f W, potential %.1f W, wpid %u, not res sens %u",
+                          U32(record.mCapability.mPowerClass), GetPowerMilliwatts(record.mCapability.mPowerClass, record.mCapability.mGuaranteedPower) / 1000.0,
+                          GetPowerMilliwatts(record.mCapability.mPowerClass, record.mCapability.mPotentialPower) / 1000.0,
+                          U32(record.mCapability.mWpid), U32(record.mCapability.mNotResSens));
+        break;
+
+    default:
+        length = snprintf(str, max_length, "header 0x%02X, %u bytes", record.mHeader, U32(record.mMessageSize));
+        break;
+    }
+
+    const char *error_str = NULL;
+    if ((record.mFlags & CHECKSUM_ERROR_FLAG) != 0) {
+        error_str = " (checksum error)";
+    } else if ((record.mFlags & FRAMING_ERROR_FLAG) != 0) {
+        error_str = " (framing error)";
+    } else if ((record.mFlags & PARITY_ERROR_FLAG) != 0) {
+        error_str = " (parity error)";
+    }
+
+    if (error_str != NULL && length >= 0 && U32(length) < max_length) {
+        snprintf(str + length, max_length - length, "%s", error_str);
+    }
+}
+
+void QiMessage::GetSummary(const QiPacketRecord &record, char *str, U32 max_length)
+{
+    int length = snprintf(str, max_length, "%s: ", GetName(record));
+    if (length >= 0 && U32(length) < max_length) {
+        GetDetails(record, str + length, max_length - length);
+    }
+}
+
+U32 QiMessage::GetMaximumPowerMilliwatts(const QiPacketRecord &record)
+{
+    if (record.mType != QiConfigurationPacket) {
+        return 0;
+    }
+
+    return GetPowerMilliwatts(record.mConfiguration.mPowerClass, record.mConfiguration.mMaximumPower);
+}
+
+U32 QiMessage::GetPowerMilliwatts(U8 power_class, U8 value)
+{
+    //value / 2 * 10^power_class W
+    U32 milliwatts = U32(value) * 500;
+    for (U32 i = 0; i < power_class; i++) {
+        milliwatts *= 10;
+    }
+    return milliwatts;
+}
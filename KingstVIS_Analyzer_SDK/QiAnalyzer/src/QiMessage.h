@@ -0,0 +1,102 @@
+#ifndef Qi_MESSAGE_H
+#define Qi_MESSAGE_H
+
+#include <AnalyzerTypes.h>
+
+enum QiPacketType {
+    QiNoPacket,                 //no record for this packet id
+    QiUnknownPacket,            //a header that isn't decoded below
+    QiSignalStrengthPacket,     //0x01
+    QiEndPowerTransferPacket,   //0x02
+    QiControlErrorPacket,       //0x03
+    QiReceivedPower8Packet,     //0x04
+    QiChargeStatusPacket,       //0x05
+    QiHoldOffPacket,            //0x06
+    QiReceivedPower24Packet,    //0x31
+    QiConfigurationPacket,      //0x51
+    QiIdentificationPacket,     //0x71
+    QiTransmitterIdentificationPacket,  //0x30 from the power transmitter
+    QiTransmitterCapabilityPacket,      //0x31 from the power transmitter
+    QiPacketTypeCount
+};
+
+//Typed contents of one packet, decoded once when the packet is committed.
+//Only the fields of mType are valid. A packet with a checksum error is still decoded, a truncated one is not.
+struct QiPacketRecord {
+    U8 mHeader;
+    U8 mType;           //QiPacketType
+    U8 mFlags;          //QI_PACKET_ERROR_FLAGS and TRANSMITTER_FRAME_FLAG of the packet
+    U8 mMessageSize;    //message bytes received, without header and checksum
+    U8 mGlitchCount;    //pulses the glitch filter took out of the packet, up to 255
+    U8 mCoil;           //multi-coil mode: the coil the packet was decoded from, 0 otherwise
+
+    union {
+        U8 mSignalStrength;         //0..255, full scale is 256
+        U8 mEndPowerTransferCode;
+        S8 mControlError;
+        U8 mChargeStatus;           //percent, 0xFF if the receiver doesn't know
+        U8 mHoldOffMs;
+
+        struct {
+            U16 mValue;             //full scale is 128 for the 8 bit packet, 32768 for the 24 bit one
+            U8 mMode;               //24 bit packet only
+            U32 mMilliwatts;        //0 when no configuration packet was seen before it
+        } mReceivedPower;
+
+        struct {
+            U8 mPowerClass;
+            U8 mMaximumPower;       //in units of 10^mPowerClass / 2 W
+            U8 mCount;              //optional configuration packets that follow
+            U8 mWindowSize;         //in units of 4 ms
+            U8 mWindowOffset;       //in units of 4 ms
+            U8 mDepth;
+            bool mProp;
+            bool mNeg;
+            bool mPolarity;
+        } mConfiguration;
+
+        struct {
+            U8 mMajorVersion;
+            U8 mMinorVersion;
+            U16 mManufacturer;
+            U32 mDeviceId;          //31 bit basic device identifier
+            bool mExtended;         //an extended identification packet follows
+        } mIdentification;          //also the transmitter's, which has no device identifier
+
+        struct {
+            U8 mPowerClass;
+            U8 mGuaranteedPower;    //in units of 10^mPowerClass / 2 W
+            U8 mPotentialPower;     //in units of 10^mPowerClass / 2 W
+            bool mWpid;
+            bool mNotResSens;
+        } mCapability;
+    };
+};
+
+//Decodes the message of the packets the power receiver sends during power transfer and negotiation,
+//and of the packets the power transmitter answers with, see the WPC communications interface.
+class QiMessage
+{
+public:
+    //bytes holds the packet from the header up to, not including, the checksum.
+    //TRANSMITTER_FRAME_FLAG in flags selects the power transmitter's headers.
+    //max_power_mw is the maximum power of the last configuration packet, used to scale received power.
+    static void Decode(const U8 *bytes, U32 byte_count, U8 flags, U32 max_power_mw, QiPacketRecord &record);
+
+    static const char *GetName(const QiPacketRecord &record);
+    static const char *GetAbbreviation(const QiPacketRecord &record);
+
+    //"-3", "Charge Complete", "v1.2, manufacturer 0x0042, ..." -- the decoded fields without the name.
+    static void GetDetails(const QiPacketRecord &record, char *str, U32 max_length);
+
+    //name and details, e.g. "Control Error: -3"
+    static void GetSummary(const QiPacketRecord &record, char *str, U32 max_length);
+
+    //maximum power of a configuration packet, 0 for any other packet
+    static U32 GetMaximumPowerMilliwatts(const QiPacketRecord &record);
+
+protected:
+    static U32 GetPowerMilliwatts(U8 power_class, U8 value);
+};
+
+#endif //Qi_MESSAGE_H
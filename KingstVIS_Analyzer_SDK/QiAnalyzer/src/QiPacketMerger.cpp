@@ -0,0 +1,91 @@
+#include "QiPacketMerger.h"
+
+QiPacketMerger::QiPacketMerger()
+{
+}
+
+QiPacketMerger::~QiPacketMerger()
+{
+}
+
+void QiPacketMerger::Init(U32 stream_count)
+{
+    mStreams.clear();
+    mStreams.resize(stream_count);
+
+    for (U32 i = 0; i < stream_count; i++) {
+        mStreams[i].mPacketCount = 0;
+        mStreams[i].mHorizon = 0;
+    }
+}
+
+void QiPacketMerger::AddBytes(U32 stream, const std::vector<QiDecodedByte> &bytes)
+{
+    Stream &s = mStreams[stream];
+    U32 byte_count = U32(bytes.size());
+    for (U32 i = 0; i < byte_count; i++) {
+        s.mBytes.push_back(bytes[i]);
+        if (bytes[i].mEndsPacket == true) {
+            s.mPacketCount++;
+        }
+    }
+}
+
+void QiPacketMerger::SetHorizon(U32 stream, U64 sample)
+{
+    mStreams[stream].mHorizon = sample;
+}
+
+U64 QiPacketMerger::GetEarliestStart(U32 stream) const
+{
+    const Stream &s = mStreams[stream];
+    if (s.mBytes.empty() == false && s.mBytes.front().mStartingSample < s.mHorizon) {
+        return s.mBytes.front().mStartingSample;
+    }
+    return s.mHorizon;
+}
+
+bool QiPacketMerger::GetNextPacket(U32 &stream, std::vector<QiDecodedByte> &bytes)
+{
+    U32 stream_count = U32(mStreams.size());
+
+    //the earliest complete packet; on a tie the lower stream goes first.
+    U32 next = stream_count;
+    for (U32 i = 0; i < stream_count; i++) {
+        if (mStreams[i].mPacketCount != 0 &&
+                (next == stream_count || mStreams[i].mBytes.front().mStartingSample < mStreams[next].mBytes.front().mStartingSample)) {
+            next = i;
+        }
+    }
+
+    if (next == stream_count) {
+        return false;
+    }
+
+    //it has to wait if any other stream may still add a packet that starts earlier.
+    U64 start = mStreams[next].mBytes.front().mStartingSample;
+    for (U32 i = 0; i < stream_count; i++) {
+        if (i == next) {
+            continue;
+        }
+
+        U64 earliest = GetEarliestStart(i);
+        if (earliest < start || (earliest == start && i < next)) {
+            return false;
+        }
+    }
+
+    Stream &s = mStreams[next];
+    bytes.clear();
+    for (; ;) {
+        bytes.push_back(s.mBytes.front());
+        s.mBytes.pop_front();
+        if (bytes.back().mEndsPacket == true) {
+            break;
+        }
+    }
+    s.mPacketCount--;
+
+    stream = next;
+    return true;
+}
@@ -0,0 +1,39 @@
+#ifndef Qi_PACKET_MERGER_H
+#define Qi_PACKET_MERGER_H
+
+#include "QiDecoder.h"
+#include <deque>
+
+//Merges the bytes of several decoders into one stream of whole packets, in the order the packets start.
+//Frames have to be added in time order, but each decoder only hands out a byte once it is complete, so a
+//packet is held until every other stream has moved past its start (see QiDecoder::DecodeSilence).
+//Packets of different streams that overlap in time are kept whole rather than interleaved.
+class QiPacketMerger
+{
+public:
+    QiPacketMerger();
+    ~QiPacketMerger();
+
+    void Init(U32 stream_count);
+
+    void AddBytes(U32 stream, const std::vector<QiDecodedByte> &bytes);
+
+    //nothing stream adds from now on starts before sample.
+    void SetHorizon(U32 stream, U64 sample);
+
+    //takes the next packet in order, once no stream can still add an earlier one.
+    bool GetNextPacket(U32 &stream, std::vector<QiDecodedByte> &bytes);
+
+protected:
+    struct Stream {
+        std::deque<QiDecodedByte> mBytes;
+        U32 mPacketCount;   //complete packets in mBytes
+        U64 mHorizon;
+    };
+
+    U64 GetEarliestStart(U32 stream) const;
+
+    std::vector<Stream> mStreams;
+};
+
+#endif //Qi_PACKET_MERGER_H
@@ -0,0 +1,110 @@
+#include "QiParallelDecoder.h"
+
+QiParallelDecoder::QiParallelDecoder()
+    :   mFirstDecoder(NULL),
+        mDeltas(NULL)
+{
+}
+
+QiParallelDecoder::~QiParallelDecoder()
+{
+}
+
+void QiParallelDecoder::Init(const QiDecoder &prototype, U32 thread_count)
+{
+    mPrototype = prototype;
+    mPrototype.ClearOutput();
+    mSegmentDecoders.clear();
+    mThreadPool.Start(thread_count);
+}
+
+U32 QiParallelDecoder::GetThreadCount() const
+{
+    return mThreadPool.GetThreadCount();
+}
+
+void QiParallelDecoder::DecodeEdges(QiDecoder &decoder, U64 first_edge, const U32 *deltas, U32 count)
+{
+    PrepareSegments(decoder, first_edge, deltas, count);
+    mThreadPool.Run(this, U32(mSegments.size()));
+}
+
+void QiParallelDecoder::StartDecodeEdges(QiDecoder &decoder, U64 first_edge, const U32 *deltas, U32 count)
+{
+    PrepareSegments(decoder, first_edge, deltas, count);
+    mThreadPool.Post(this, U32(mSegments.size()));
+}
+
+void QiParallelDecoder::FinishDecodeEdges()
+{
+    mThreadPool.Wait();
+}
+
+void QiParallelDecoder::PrepareSegments(QiDecoder &decoder, U64 first_edge, const U32 *deltas, U32 count)
+{
+    mFirstDecoder = &decoder;
+    mDeltas = deltas;
+
+    FindSegments(first_edge, deltas, count, decoder.GetIdleGapWidth());
+    while (mSegmentDecoders.size() < mSegments.size()) {
+        mSegmentDecoders.push_back(mPrototype);
+    }
+}
+
+void QiParallelDecoder::FindSegments(U64 first_edge, const U32 *deltas, U32 count, U64 idle_gap_width)
+{
+    mSegments.clear();
+
+    QiSegment segment;
+    segment.mFirstEdge = first_edge;
+    segment.mFirstDelta = 0;
+
+    U64 edge = first_edge;
+    for (U32 i = 0; i < count; i++) {
+        edge += deltas[i];
+
+        //the gap stays with the segment before it: that's where it closes off a truncated packet.
+        if (deltas[i] > idle_gap_width && i + 1 - segment.mFirstDelta >= QI_MIN_SEGMENT_EDGES) {
+            segment.mDeltaCount = i + 1 - segment.mFirstDelta;
+            mSegments.push_back(segment);
+
+            segment.mFirstEdge = edge;
+            segment.mFirstDelta = i + 1;
+        }
+    }
+
+    segment.mDeltaCount = count - segment.mFirstDelta;
+    mSegments.push_back(segment);
+}
+
+U32 QiParallelDecoder::GetSegmentCount() const
+{
+    return U32(mSegments.size());
+}
+
+QiDecoder &QiParallelDecoder::GetSegmentDecoder(U32 index)
+{
+    return (index == 0) ? *mFirstDecoder : mSegmentDecoders[index];
+}
+
+void QiParallelDecoder::CarryState(QiDecoder &decoder)
+{
+    U32 last = U32(mSegments.size()) - 1;
+    if (last != 0) {
+        mSegmentDecoders[last].ClearOutput();
+        decoder = mSegmentDecoders[last];
+    }
+}
+
+void QiParallelDecoder::RunTask(U32 task_index)
+{
+    const QiSegment &segment = mSegments[task_index];
+
+    if (task_index == 0) {
+        mFirstDecoder->DecodeEdges(segment.mFirstEdge, mDeltas, segment.mDeltaCount);
+    } else {
+        QiDecoder &decoder = mSegmentDecoders[task_index];
+        decoder.ResumeAfterIdleGap(segment.mFirstEdge);
+        decoder.DecodeDeltas(mDeltas + segment.mFirstDelta, segment.mDeltaCount);
+    }
+}
@@ -0,0 +1,58 @@
+#ifndef Qi_PARALLEL_DECODER_H
+#define Qi_PARALLEL_DECODER_H
+
+#include "QiDecoder.h"
+#include "QiThreadPool.h"
+
+#define QI_MIN_SEGMENT_EDGES 4096   //segments are at least this long, so a task outweighs the cost of handing it out
+
+struct QiSegment {
+    U64 mFirstEdge;
+    U32 mFirstDelta;
+    U32 mDeltaCount;
+};
+
+//Decodes a chunk of edges in segments that are split at idle gaps, on a thread pool.
+//An idle gap leaves every decoder in the same state (see QiDecoder::ResumeAfterIdleGap), so the segments
+//are independent, and their output read back in order is exactly what a single decoder would produce.
+class QiParallelDecoder : public QiThreadPoolJob
+{
+public:
+    QiParallelDecoder();
+    virtual ~QiParallelDecoder();
+
+    //prototype is an initialized decoder; its bit cell limits are used for every segment.
+    void Init(const QiDecoder &prototype, U32 thread_count);
+    U32 GetThreadCount() const;
+
+    //same as decoder.DecodeEdges. decoder carries the state of the previous chunk and decodes the first segment.
+    void DecodeEdges(QiDecoder &decoder, U64 first_edge, const U32 *deltas, U32 count);
+
+    //DecodeEdges in two halves: the chunk is decoded on the other threads until FinishDecodeEdges, which helps with
+    //what is left. Until then neither decoder nor deltas may be touched.
+    void StartDecodeEdges(QiDecoder &decoder, U64 first_edge, const U32 *deltas, U32 count);
+    void FinishDecodeEdges();
+
+    //segment 0 is the decoder passed to DecodeEdges
+    U32 GetSegmentCount() const;
+    QiDecoder &GetSegmentDecoder(U32 index);
+
+    //once the output has been taken, hands the state at the end of the chunk back to the decoder.
+    void CarryState(QiDecoder &decoder);
+
+    virtual void RunTask(U32 task_index);
+
+protected:
+    void PrepareSegments(QiDecoder &decoder, U64 first_edge, const U32 *deltas, U32 count);
+    void FindSegments(U64 first_edge, const U32 *deltas, U32 count, U64 idle_gap_width);
+
+    QiThreadPool mThreadPool;
+    QiDecoder mPrototype;
+    std::vector<QiSegment> mSegments;
+    std::vector<QiDecoder> mSegmentDecoders;
+
+    QiDecoder *mFirstDecoder;
+    const U32 *mDeltas;
+};
+
+#endif //Qi_PARALLEL_DECODER_H
@@ -1,5 +1,6 @@
 #include "QiSimulationDataGenerator.h"
 #include "QiAnalyzerSettings.h"
+#include "QiDecoder.h"
 
 QiSimulationDataGenerator::QiSimulationDataGenerator()
 {
@@ -14,7 +15,6 @@ void QiSimulationDataGenerator::Initialize(U32 simulation_sample_rate, QiAnalyze
     mSimulationSampleRateHz = simulation_sample_rate;
     mSettings = settings;
 
-    mClockGenerator.Init(mSettings->mBitRate, simulation_sample_rate);
     mQiSimulationData.SetChannel(mSettings->mInputChannel);
     mQiSimulationData.SetSampleRate(simulation_sample_rate);
 
@@ -26,27 +26,66 @@ void QiSimulationDataGenerator::Initialize(U32 simulation_sample_rate, QiAnalyze
         mBitHigh = BIT_LOW;
     }
 
-    mQiSimulationData.SetInitialBitState(mBitHigh);
-    mQiSimulationData.Advance(mClockGenerator.AdvanceByHalfPeriod(10.0));  //insert 10 bit-periods of idle
+    //the simulated transmitter's bit rate is off the nominal one by mSimulationDeviation tenths of a percent.
+    U64 bit_rate_permille = U64(mSettings->mBitRate) * U64(1000 + mSettings->mSimulationDeviation);
+    mHalfCell = ((U64(simulation_sample_rate) << QI_CELL_FRACTION_BITS) * 1000) / (bit_rate_permille * 2);
+    mJitter = mHalfCell * mSettings->mSimulationJitter / 100;
+    mRandom = QI_SIM_RANDOM_SEED;
 
-    mValue = 0;
+    BuildByteTemplates();
 
-    mMpModeAddressMask = 0;
-    mMpModeDataMask = 0;
-    mNumBitsMask = 0;
+    mPhase = QiSimPing;
+    mSession = 0;
+    mControlErrors = 0;
+    mControlError = 0;
+    mReceivedPower = 0;
 
+    mQiSimulationData.SetInitialBitState(mBitHigh);
+    mPosition = 0;
+    AppendIdle((mHalfCell * 20) >> QI_CELL_FRACTION_BITS);     //insert 10 bit-periods of idle
+}
+
+void QiSimulationDataGenerator::BuildByteTemplates()
+{
     U32 num_bits = mSettings->mBitsPerTransfer;
-    for (U32 i = 0; i < num_bits; i++) {
-        mNumBitsMask <<= 1;
-        mNumBitsMask |= 0x1;
+    if (mSettings->mQiMode != QiAnalyzerEnums::Normal) {
+        num_bits++;
+    }
+    if (num_bits > QI_SIM_MAX_BITS_PER_BYTE) {
+        num_bits = QI_SIM_MAX_BITS_PER_BYTE;
     }
 
-    if (mSettings->mQiMode == QiAnalyzerEnums::MpModeMsbOneMeansAddress) {
-        mMpModeAddressMask = 0x1ull << (mSettings->mBitsPerTransfer);
+    //bi-phase: an edge at the start of every bit, and one in the middle of a one.
+    for (U32 value = 0; value < 256; value++) {
+        U8 bits[QI_SIM_MAX_BITS_PER_BYTE + 3];
+        U32 bit_count = 0;
+        U32 ones = 0;
+
+        bits[bit_count++] = 0;
+        for (U32 i = 0; i < num_bits; i++) {
+            U32 shift = (mSettings->mShiftOrder == AnalyzerEnums::LsbFirst) ? i : num_bits - 1 - i;
+            U8 bit = (shift < 8) ? U8((value >> shift) & 0x1) : 0;
+            ones += bit;
+            bits[bit_count++] = bit;
+        }
+        bits[bit_count++] = ((ones & 0x1) == 0) ? 1 : 0;   //odd parity
+        bits[bit_count++] = 1;
+
+        QiByteTemplate &byte_template = mByteTemplates[value];
+        byte_template.mEdgeCount = 0;
+        for (U32 i = 0; i < bit_count; i++) {
+            if (bits[i] == 1) {
+                byte_template.mHalfCells[byte_template.mEdgeCount++] = 1;
+                byte_template.mHalfCells[byte_template.mEdgeCount++] = 1;
+            } else {
+                byte_template.mHalfCells[byte_template.mEdgeCount++] = 2;
+            }
+        }
     }
 
-    if (mSettings->mQiMode == QiAnalyzerEnums::MpModeMsbZeroMeansAddress) {
-        mMpModeDataMask = 0x1ull << (mSettings->mBitsPerTransfer);
+    mPreambleTemplate.mEdgeCount = 0;
+    for (U32 i = 0; i < QI_SIM_PREAMBLE_BITS * 2; i++) {
+        mPreambleTemplate.mHalfCells[mPreambleTemplate.mEdgeCount++] = 1;
     }
 }
 
@@ -55,32 +94,12 @@ U32 QiSimulationDataGenerator::GenerateSimulationData(U64 largest_sample_request
     U64 adjusted_largest_sample_requested = AnalyzerHelpers::AdjustSimulationTargetSample(largest_sample_requested, sample_rate, mSimulationSampleRateHz);
 
     while (mQiSimulationData.GetCurrentSampleNumber() < adjusted_largest_sample_requested) {
-        if (mSettings->mQiMode == QiAnalyzerEnums::Normal) {
-            CreateQiByte(mValue++);
+        U8 packet[QI_SIM_MAX_PACKET_BYTES];
+        U64 gap_ms;
+        U32 byte_count = BuildNextPacket(packet, gap_ms);
 
-            mQiSimulationData.Advance(mClockGenerator.AdvanceByHalfPeriod(10.0));     //insert 10 bit-periods of idle
-        } else {
-            U64 address = 0x1 | mMpModeAddressMask;
-            CreateQiByte(address);
-
-            for (U32 i = 0; i < 4; i++) {
-                mQiSimulationData.Advance(mClockGenerator.AdvanceByHalfPeriod(2.0));  //insert 2 bit-periods of idle
-                CreateQiByte((mValue++ & mNumBitsMask) | mMpModeDataMask);
-            };
-
-            mQiSimulationData.Advance(mClockGenerator.AdvanceByHalfPeriod(20.0));     //insert 20 bit-periods of idle
-
-            address = 0x2 | mMpModeAddressMask;
-            CreateQiByte(address);
-
-            for (U32 i = 0; i < 4; i++) {
-                mQiSimulationData.Advance(mClockGenerator.AdvanceByHalfPeriod(2.0));  //insert 2 bit-periods of idle
-                CreateQiByte((mValue++ & mNumBitsMask) | mMpModeDataMask);
-            };
-
-            mQiSimulationData.Advance(mClockGenerator.AdvanceByHalfPeriod(20.0));     //insert 20 bit-periods of idle
-
-        }
+        CreateQiPacket(packet, byte_count);
+        AppendIdle(gap_ms * mSimulationSampleRateHz / 1000);
     }
 
     *simulation_channels = &mQiSimulationData;
@@ -89,53 +108,133 @@ U32 QiSimulationDataGenerator::GenerateSimulationData(U64 largest_sample_request
     return 1;  // we are retuning the size of the SimulationChannelDescriptor array.  In our case, the "array" is length 1.
 }
 
-void QiSimulationDataGenerator::CreateQiByte(U64 value)
+U32 QiSimulationDataGenerator::BuildNextPacket(U8 *packet, U64 &gap_ms)
 {
-    //assume we start high
+    U32 size = 0;
+    gap_ms = QI_SIM_PACKET_GAP_MS;
+
+    switch (mPhase) {
+    case QiSimPing:
+        //the signal strength packet answers the transmitter's digital ping.
+        packet[size++] = 0x01;
+        packet[size++] = U8(0x80 + (NextRandom() & 0x3F));
+        mPhase = QiSimIdentification;
+        break;
+
+    case QiSimIdentification:
+        packet[size++] = 0x71;
+        packet[size++] = 0x12;          //version 1.2
+        packet[size++] = 0x00;          //manufacturer
+        packet[size++] = 0x2A;
+        packet[size++] = U8((mSession >> 24) & 0x7F);   //no extended identification
+        packet[size++] = U8(mSession >> 16);
+        packet[size++] = U8(mSession >> 8);
+        packet[size++] = U8(mSession);
+        mPhase = QiSimConfiguration;
+        break;
+
+    case QiSimConfiguration:
+        packet[size++] = 0x51;
+        packet[size++] = 0x0A;          //power class 0, 5 W
+        packet[size++] = 0x00;
+        packet[size++] = 0x00;          //no optional configuration packets
+        packet[size++] = 0x41;          //32 ms window, 4 ms offset
+        packet[size++] = 0x00;
+        mControlErrors = 0;
+        mControlError = 40 + S32(NextRandom() % 40);    //far off the operating point to start with
+        mPhase = QiSimPowerTransfer;
+        break;
+
+    case QiSimPowerTransfer:
+        gap_ms = QI_SIM_CONTROL_GAP_MS;
+        if (mControlErrors != 0 && (mControlErrors % QI_SIM_RECEIVED_POWER_INTERVAL) == 0 && mReceivedPower != 0) {
+            packet[size++] = 0x04;
+            packet[size++] = mReceivedPower;
+            mReceivedPower = 0;
+            break;
+        }
 
-    mQiSimulationData.Transition();  //low-going edge for start bit
-    mQiSimulationData.Advance(mClockGenerator.AdvanceByHalfPeriod());    //add start bit time
+        packet[size++] = 0x03;
+        packet[size++] = U8(S8(mControlError));
 
-    if (mSettings->mInverted == true) {
-        value = ~value;
-    }
+        //the control loop closes in on the operating point, and the received power with it.
+        mControlError -= mControlError / 4;
+        mControlError += S32(NextRandom() % 5) - 2;
+        if (mControlError > 127) {
+            mControlError = 127;
+        } else if (mControlError < -128) {
+            mControlError = -128;
+        }
 
-    U32 num_bits = mSettings->mBitsPerTransfer;
-    if (mSettings->mQiMode != QiAnalyzerEnums::Normal) {
-        num_bits++;
+        if (++mControlErrors == QI_SIM_CONTROL_ERRORS) {
+            mPhase = QiSimEndPowerTransfer;
+        } else if ((mControlErrors % QI_SIM_RECEIVED_POWER_INTERVAL) == 0) {
+            mReceivedPower = U8(96 - mControlError / 2 + S32(NextRandom() & 0x3));
+        }
+        break;
+
+    case QiSimEndPowerTransfer:
+    default:
+        packet[size++] = 0x02;
+        packet[size++] = 0x01;          //charge complete
+        gap_ms = QI_SIM_RESTART_MS;
+        mSession++;
+        mPhase = QiSimPing;
+        break;
     }
 
-    BitExtractor bit_extractor(value, mSettings->mShiftOrder, num_bits);
-
-    for (U32 i = 0; i < num_bits; i++) {
-        mQiSimulationData.TransitionIfNeeded(bit_extractor.GetNextBit());
-        mQiSimulationData.Advance(mClockGenerator.AdvanceByHalfPeriod());
+    U8 checksum = 0;
+    for (U32 i = 0; i < size; i++) {
+        checksum ^= packet[i];
     }
+    packet[size++] = checksum;
 
-    if (mSettings->mParity == AnalyzerEnums::Even) {
+    return size;
+}
 
-        if (AnalyzerHelpers::IsEven(AnalyzerHelpers::GetOnesCount(value)) == true) {
-            mQiSimulationData.TransitionIfNeeded(mBitLow);    //we want to add a zero bit
-        } else {
-            mQiSimulationData.TransitionIfNeeded(mBitHigh);    //we want to add a one bit
-        }
+U32 QiSimulationDataGenerator::NextRandom()
+{
+    //xorshift32, the same sequence on every run
+    mRandom ^= mRandom << 13;
+    mRandom ^= mRandom >> 17;
+    mRandom ^= mRandom << 5;
+    return mRandom;
+}
 
-        mQiSimulationData.Advance(mClockGenerator.AdvanceByHalfPeriod());
+void QiSimulationDataGenerator::CreateQiPacket(const U8 *packet, U32 byte_count)
+{
+    //the line is idle, the first edge starts the preamble.
+    mQiSimulationData.Transition();
 
-    } else if (mSettings->mParity == AnalyzerEnums::Odd) {
+    AppendHalfCells(mPreambleTemplate.mHalfCells, mPreambleTemplate.mEdgeCount);
+    for (U32 i = 0; i < byte_count; i++) {
+        const QiByteTemplate &byte_template = mByteTemplates[packet[i]];
+        AppendHalfCells(byte_template.mHalfCells, byte_template.mEdgeCount);
+    }
+}
 
-        if (AnalyzerHelpers::IsOdd(AnalyzerHelpers::GetOnesCount(value)) == true) {
-            mQiSimulationData.TransitionIfNeeded(mBitLow);    //we want to add a zero bit
-        } else {
-            mQiSimulationData.TransitionIfNeeded(mBitHigh);
-        }
+void QiSimulationDataGenerator::AppendHalfCells(const U8 *half_cells, U32 count)
+{
+    //jitter is at most a quarter of a half cell, so the edges stay in order.
+    for (U32 i = 0; i < count; i++) {
+        mPosition += half_cells[i] * mHalfCell;
 
-        mQiSimulationData.Advance(mClockGenerator.AdvanceByHalfPeriod());
+        U64 edge = mPosition;
+        if (mJitter != 0) {
+            edge = edge + NextRandom() % (mJitter * 2 + 1) - mJitter;
+        }
 
+        U64 sample = edge >> QI_CELL_FRACTION_BITS;
+        U64 current_sample = mQiSimulationData.GetCurrentSampleNumber();
+        if (sample > current_sample) {
+            mQiSimulationData.Advance(U32(sample - current_sample));
+        }
+        mQiSimulationData.Transition();
     }
+}
 
-    mQiSimulationData.TransitionIfNeeded(mBitHigh);   //we need to end high
-
-    //lets pad the end a bit for the stop bit:
-    mQiSimulationData.Advance(mClockGenerator.AdvanceByHalfPeriod(mSettings->mStopBits));
+void QiSimulationDataGenerator::AppendIdle(U64 samples)
+{
+    mPosition += samples << QI_CELL_FRACTION_BITS;
+    mQiSimulationData.Advance(U32((mPosition >> QI_CELL_FRACTION_BITS) - mQiSimulationData.GetCurrentSampleNumber()));
 }
@@ -3,8 +3,34 @@
 
 #include <AnalyzerHelpers.h>
 
+#define QI_SIM_PREAMBLE_BITS 16         //the spec allows 11 to 25
+#define QI_SIM_MAX_BITS_PER_BYTE 16     //data bits a byte template has room for
+#define QI_SIM_MAX_BYTE_EDGES ( 2 * ( QI_SIM_MAX_BITS_PER_BYTE + 3 ) )  //start, parity and stop bits, two edges per one bit
+#define QI_SIM_MAX_PACKET_BYTES 29      //header, the longest message and the checksum
+#define QI_SIM_RANDOM_SEED 0x2545F491   //of the xorshift32 behind the payloads and the jitter
+
+#define QI_SIM_PACKET_GAP_MS 10             //after every packet of the ping, identification and configuration phases
+#define QI_SIM_CONTROL_GAP_MS 20            //after every packet of the power transfer phase
+#define QI_SIM_RESTART_MS 500               //the power transmitter is off between two power transfers
+#define QI_SIM_CONTROL_ERRORS 200           //control error packets in one power transfer
+#define QI_SIM_RECEIVED_POWER_INTERVAL 8    //control error packets per received power packet
+
 class QiAnalyzerSettings;
 
+//what the simulated power receiver is doing; every phase sends its packets and moves on to the next one.
+enum QiSimulationPhase { QiSimPing, QiSimIdentification, QiSimConfiguration, QiSimPowerTransfer, QiSimEndPowerTransfer };
+
+//the edges of one byte: start bit, data bits, odd parity and stop bit, as half cells from each edge to the next.
+struct QiByteTemplate {
+    U8 mHalfCells[QI_SIM_MAX_BYTE_EDGES];
+    U8 mEdgeCount;
+};
+
+//Simulates a power receiver talking to its transmitter: a ping, identification and configuration, then
+//control error packets with a received power packet every few of them, until the receiver ends the power
+//transfer and the next ping starts over. The bits are bi-phase coded like the real back channel, with the
+//bit rate off by mSimulationDeviation and every edge shifted at random by up to mSimulationJitter.
+//The edges of every byte value are worked out once, so an hour of packets is only a few adds per edge.
 class QiSimulationDataGenerator
 {
 public:
@@ -19,17 +45,32 @@ protected:
     U32 mSimulationSampleRateHz;
     BitState mBitLow;
     BitState mBitHigh;
-    U64 mValue;
-
-    U64 mMpModeAddressMask;
-    U64 mMpModeDataMask;
-    U64 mNumBitsMask;
 
 protected: //Qi specific
 
-    void CreateQiByte(U64 value);
-    ClockGenerator mClockGenerator;
+    void BuildByteTemplates();
+    U32 BuildNextPacket(U8 *packet, U64 &gap_ms);
+    U32 NextRandom();
+
+    void CreateQiPacket(const U8 *packet, U32 byte_count);
+    void AppendHalfCells(const U8 *half_cells, U32 count);
+    void AppendIdle(U64 samples);
+
+    QiByteTemplate mByteTemplates[256];
+    QiByteTemplate mPreambleTemplate;
+
+    U64 mHalfCell;          //of the simulated transmitter, in 24.8 fixed point samples
+    U64 mJitter;            //largest random shift of an edge, in 24.8 fixed point samples
+    U64 mPosition;          //where the last edge would be without jitter, in 24.8 fixed point samples
+    U32 mRandom;
+
+    QiSimulationPhase mPhase;
+    U32 mSession;           //power transfers so far, it makes up the device identifier
+    U32 mControlErrors;     //sent in this power transfer
+    S32 mControlError;
+    U8 mReceivedPower;
+
     SimulationChannelDescriptor mQiSimulationData;  //if we had more than one channel to simulate, they would need to be in an array
 };
 
-#endif //UNIO_SIMULATION_DATA_GENERATOR
+#endif //Qi_SIMULATION_DATA_GENERATOR
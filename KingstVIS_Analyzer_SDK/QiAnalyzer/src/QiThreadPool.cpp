@@ -0,0 +1,197 @@
+#include "QiThreadPool.h"
+
+QiThreadPool::QiThreadPool()
+    :   mJob(NULL),
+        mTasksRemaining(0),
+        mGeneration(0),
+        mStopping(false)
+{
+}
+
+QiThreadPool::~QiThreadPool()
+{
+    Stop();
+}
+
+void QiThreadPool::Start(U32 thread_count)
+{
+    Stop();
+
+    if (thread_count == 0) {
+        thread_count = std::thread::hardware_concurrency();
+    }
+    if (thread_count == 0) {
+        thread_count = 1;
+    }
+
+    mStopping = false;
+    mTasksRemaining = 0;
+    for (U32 i = 0; i < thread_count; i++) {
+        mQueues.push_back(new TaskQueue());
+    }
+
+    for (U32 i = 1; i < thread_count; i++) {
+        mThreads.push_back(std::thread(&QiThreadPool::WorkerThread, this, i));
+    }
+}
+
+void QiThreadPool::Stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mStopping = true;
+    }
+    mWorkReady.notify_all();
+
+    for (U32 i = 0; i < mThreads.size(); i++) {
+        mThreads[i].join();
+    }
+    mThreads.clear();
+
+    for (U32 i = 0; i < mQueues.size(); i++) {
+        delete mQueues[i];
+    }
+    mQueues.clear();
+}
+
+U32 QiThreadPool::GetThreadCount() const
+{
+    return U32(mQueues.size());
+}
+
+void QiThreadPool::Run(QiThreadPoolJob *job, U32 task_count)
+{
+    if (task_count == 0) {
+        return;
+    }
+
+    if (mQueues.size() <= 1 || task_count == 1) {
+        for (U32 i = 0; i < task_count; i++) {
+            job->RunTask(i);
+        }
+        return;
+    }
+
+    QueueTasks(job, task_count, 0);
+    Wait();
+}
+
+void QiThreadPool::Post(QiThreadPoolJob *job, U32 task_count)
+{
+    if (task_count == 0) {
+        return;
+    }
+
+    //the calling thread's queue is left empty, since it is busy until Wait; it steals from the others then.
+    QueueTasks(job, task_count, (mQueues.size() > 1) ? 1 : 0);
+}
+
+void QiThreadPool::Wait()
+{
+    if (mQueues.empty() == true) {
+        return;
+    }
+
+    while (RunOneTask(0) == true) {
+    }
+
+    std::unique_lock<std::mutex> lock(mMutex);
+    while (mTasksRemaining != 0) {
+        mWorkDone.wait(lock);
+    }
+}
+
+void QiThreadPool::QueueTasks(QiThreadPoolJob *job, U32 task_count, U32 first_queue)
+{
+    //set before any task is queued: a worker still draining the previous run may pick one up straight away.
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mJob = job;
+        mTasksRemaining = task_count;
+    }
+
+    //neighbouring tasks go to the same thread, so a thread mostly walks through memory in order.
+    U32 queue_count = U32(mQueues.size()) - first_queue;
+    for (U32 i = 0; i < queue_count; i++) {
+        std::lock_guard<std::mutex> lock(mQueues[first_queue + i]->mMutex);
+        U32 first = U32(U64(task_count) * i / queue_count);
+        U32 last = U32(U64(task_count) * (i + 1) / queue_count);
+        for (U32 task = first; task < last; task++) {
+            mQueues[first_queue + i]->mTasks.push_back(task);
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mGeneration++;
+    }
+    mWorkReady.notify_all();
+}
+
+void QiThreadPool::WorkerThread(U32 queue_index)
+{
+    U64 generation = 0;
+
+    for (; ;) {
+        {
+            std::unique_lock<std::mutex> lock(mMutex);
+            while (mStopping == false && mGeneration == generation) {
+                mWorkReady.wait(lock);
+            }
+
+            if (mStopping == true) {
+                return;
+            }
+
+            generation = mGeneration;
+        }
+
+        while (RunOneTask(queue_index) == true) {
+        }
+    }
+}
+
+bool QiThreadPool::RunOneTask(U32 queue_index)
+{
+    U32 task_index;
+    if (TakeTask(queue_index, false, task_index) == false) {
+        U32 queue_count = U32(mQueues.size());
+        bool stolen = false;
+        for (U32 i = 1; i < queue_count && stolen == false; i++) {
+            stolen = TakeTask((queue_index + i) % queue_count, true, task_index);
+        }
+
+        if (stolen == false) {
+            return false;
+        }
+    }
+
+    mJob->RunTask(task_index);
+
+    std::lock_guard<std::mutex> lock(mMutex);
+    if (--mTasksRemaining == 0) {
+        mWorkDone.notify_all();
+    }
+
+    return true;
+}
+
+bool QiThreadPool::TakeTask(U32 queue_index, bool steal, U32 &task_index)
+{
+    TaskQueue *queue = mQueues[queue_index];
+    std::lock_guard<std::mutex> lock(queue->mMutex);
+    if (queue->mTasks.empty() == true) {
+        return false;
+    }
+
+    //the owner works front to back, thieves take from the far end.
+    if (steal == false) {
+        task_index = queue->mTasks.front();
+        queue->mTasks.pop_front();
+    } else {
+        task_index = queue->mTasks.back();
+        queue->mTasks.pop_back();
+    }
+
+    return true;
+}
@@ -0,0 +1,65 @@
+#ifndef Qi_THREAD_POOL_H
+#define Qi_THREAD_POOL_H
+
+#include <AnalyzerTypes.h>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+//work handed to QiThreadPool::Run; tasks must not touch the SDK, only their own data.
+class QiThreadPoolJob
+{
+public:
+    virtual ~QiThreadPoolJob() {}
+    virtual void RunTask(U32 task_index) = 0;
+};
+
+//Small work-stealing pool. Each thread starts on its own contiguous share of the tasks,
+//and steals from the back of the other queues once its own runs dry.
+class QiThreadPool
+{
+public:
+    QiThreadPool();
+    ~QiThreadPool();
+
+    //thread_count includes the calling thread; 0 uses one thread per core.
+    void Start(U32 thread_count);
+    void Stop();
+    U32 GetThreadCount() const;
+
+    //runs every task and returns once they have all finished; the calling thread works too.
+    void Run(QiThreadPoolJob *job, U32 task_count);
+
+    //hands the tasks to the other threads and returns at once, so the calling thread can get on with
+    //something of its own; Wait then works on what is left and returns once every task has finished.
+    //With a single thread, Wait runs them all.
+    void Post(QiThreadPoolJob *job, U32 task_count);
+    void Wait();
+
+protected:
+    void QueueTasks(QiThreadPoolJob *job, U32 task_count, U32 first_queue);
+
+    struct TaskQueue {
+        std::mutex mMutex;
+        std::deque<U32> mTasks;
+    };
+
+    void WorkerThread(U32 queue_index);
+    bool RunOneTask(U32 queue_index);
+    bool TakeTask(U32 queue_index, bool steal, U32 &task_index);
+
+    std::vector<std::thread> mThreads;
+    std::vector<TaskQueue *> mQueues;    //one per thread, the calling thread's first
+
+    std::mutex mMutex;
+    std::condition_variable mWorkReady;
+    std::condition_variable mWorkDone;
+    QiThreadPoolJob *mJob;
+    U32 mTasksRemaining;
+    U64 mGeneration;
+    bool mStopping;
+};
+
+#endif //Qi_THREAD_POOL_H
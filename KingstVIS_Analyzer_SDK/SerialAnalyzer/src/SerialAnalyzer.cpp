@@ -88,10 +88,18 @@ void SerialAnalyzer::WorkerThread()
         mSerial->AdvanceToNextEdge();
     }
 
+    mInstrumentation.Reset();
+    mCommitPolicy.Reset(this, mResults.get(), &mInstrumentation);
+    AnalyzerCommitPolicy::FlushOnExit flush_on_exit(mCommitPolicy);
+
     for (; ;) {
         //we're starting high.  (we'll assume that we're not in the middle of a byte.)
 
+        AnalyzerStage previous_stage = mInstrumentation.EnterStage(StageEdgeTraversal);
+        mCommitPolicy.FlushIfWaiting(mSerial);
         mSerial->AdvanceToNextEdge();
+        mInstrumentation.Count(CounterEdges);
+        mInstrumentation.EnterStage(StageBitDecode);
 
         //we're now at the beginning of the start bit.  We can start collecting the data.
         U64 frame_starting_sample = mSerial->GetSampleNumber();
@@ -106,12 +114,13 @@ void SerialAnalyzer::WorkerThread()
         U64 marker_location = frame_starting_sample;
 
         for (U32 i = 0; i < num_bits; i++) {
-            mSerial->Advance(mSampleOffsets[i]);
+            mInstrumentation.Count(CounterEdges, mSerial->Advance(mSampleOffsets[i]));
             data_builder.AddBit(mSerial->GetBitState());
 
             marker_location += mSampleOffsets[i];
-            mResults->AddMarker(marker_location, AnalyzerResults::Dot, mSettings->mInputChannel);
+            AddMarker(marker_location, AnalyzerResults::Dot);
         }
+        mInstrumentation.Count(CounterBits, num_bits);
         if (mSettings->mInverted == true) {
             data = (~data) & bit_mask;
         }
@@ -141,7 +150,8 @@ void SerialAnalyzer::WorkerThread()
         parity_error = false;
 
         if (mSettings->mParity != AnalyzerEnums::None) {
-            mSerial->Advance(mParityBitOffset);
+            mInstrumentation.Count(CounterEdges, mSerial->Advance(mParityBitOffset));
+            mInstrumentation.Count(CounterBits);
             bool is_even = AnalyzerHelpers::IsEven(AnalyzerHelpers::GetOnesCount(data));
 
             if (mSettings->mParity == AnalyzerEnums::Even) {
@@ -167,18 +177,19 @@ void SerialAnalyzer::WorkerThread()
             }
 
             marker_location += mParityBitOffset;
-            mResults->AddMarker(marker_location, AnalyzerResults::Square, mSettings->mInputChannel);
+            AddMarker(marker_location, AnalyzerResults::Square);
         }
 
         //now we must dermine if there is a framing error.
         framing_error = false;
 
-        mSerial->Advance(mStartOfStopBitOffset);
+        mInstrumentation.Count(CounterEdges, mSerial->Advance(mStartOfStopBitOffset));
 
         if (mSerial->GetBitState() != mBitHigh) {
             framing_error = true;
         } else {
             U32 num_edges = mSerial->Advance(mEndOfStopBitOffset);
+            mInstrumentation.Count(CounterEdges, num_edges);
             if (num_edges != 0) {
                 framing_error = true;
             }
@@ -186,11 +197,11 @@ void SerialAnalyzer::WorkerThread()
 
         if (framing_error == true) {
             marker_location += mStartOfStopBitOffset;
-            mResults->AddMarker(marker_location, AnalyzerResults::ErrorX, mSettings->mInputChannel);
+            AddMarker(marker_location, AnalyzerResults::ErrorX);
 
             if (mEndOfStopBitOffset != 0) {
                 marker_location += mEndOfStopBitOffset;
-                mResults->AddMarker(marker_location, AnalyzerResults::ErrorX, mSettings->mInputChannel);
+                AddMarker(marker_location, AnalyzerResults::ErrorX);
             }
         }
 
@@ -213,25 +224,42 @@ void SerialAnalyzer::WorkerThread()
             frame.mFlags |= MP_MODE_ADDRESS_FLAG;
         }
 
+        mInstrumentation.EnterStage(StageFrames);
         if (mp_is_address == true) {
             mResults->CommitPacketAndStartNewPacket();
         }
 
         mResults->AddFrame(frame);
+        mInstrumentation.Count(CounterFrames);
+        mInstrumentation.LeaveStage(previous_stage);
 
-        mResults->CommitResults();
-
-        ReportProgress(frame.mEndingSampleInclusive);
+        mCommitPolicy.ResultsAdded(frame.mEndingSampleInclusive);
         CheckIfThreadShouldExit();
 
         if (framing_error == true) { //if we're still low, let's fix that for the next round.
             if (mSerial->GetBitState() == mBitLow) {
+                AnalyzerInstrumentation::StageTimer resync_timer(mInstrumentation, StageResync);
                 mSerial->AdvanceToNextEdge();
+                mInstrumentation.Count(CounterResyncs);
+                mInstrumentation.Count(CounterEdges);
+                mInstrumentation.Count(CounterResyncEdges);
             }
         }
     }
 }
 
+void SerialAnalyzer::AddMarker(U64 sample_number, AnalyzerResults::MarkerType marker_type)
+{
+    AnalyzerInstrumentation::StageTimer marker_timer(mInstrumentation, StageMarkers);
+    mResults->AddMarker(sample_number, marker_type, mSettings->mInputChannel);
+    mInstrumentation.Count(CounterMarkers);
+}
+
+AnalyzerInstrumentation &SerialAnalyzer::GetInstrumentation()
+{
+    return mInstrumentation;
+}
+
 bool SerialAnalyzer::NeedsRerun()
 {
     if (mSettings->mUseAutobaud == false) {
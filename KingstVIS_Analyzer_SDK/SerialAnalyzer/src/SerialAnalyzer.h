@@ -4,6 +4,7 @@
 #include <Analyzer.h>
 #include "SerialAnalyzerResults.h"
 #include "SerialSimulationDataGenerator.h"
+#include "AnalyzerCommitPolicy.h"
 
 class SerialAnalyzerSettings;
 
@@ -21,12 +22,16 @@ public:
     virtual const char *GetAnalyzerName() const;
     virtual bool NeedsRerun();
 
+    //read by the instrumentation report export, see AnalyzerInstrumentation.h
+    AnalyzerInstrumentation &GetInstrumentation();
+
 
 #pragma warning( push )
 #pragma warning( disable : 4251 ) //warning C4251: 'SerialAnalyzer::<...>' : class <...> needs to have dll-interface to be used by clients of class
 
 protected: //functions
     void ComputeSampleOffsets();
+    void AddMarker(U64 sample_number, AnalyzerResults::MarkerType marker_type);
 
 protected: //vars
     std::auto_ptr< SerialAnalyzerSettings > mSettings;
@@ -45,6 +50,9 @@ protected: //vars
     BitState mBitLow;
     BitState mBitHigh;
 
+    AnalyzerCommitPolicy mCommitPolicy;
+    AnalyzerInstrumentation mInstrumentation;
+
 #pragma warning( pop )
 };
 
@@ -1,5 +1,7 @@
 #include "SerialAnalyzerResults.h"
 #include <AnalyzerHelpers.h>
+#include "AnalyzerBinaryExport.h"
+#include "AnalyzerExportWriter.h"
 #include "SerialAnalyzer.h"
 #include "SerialAnalyzerSettings.h"
 #include <iostream>
@@ -90,59 +92,67 @@ void SerialAnalyzerResults::GenerateBubbleText(U64 frame_index, Channel & /*chan
     }
 }
 
-void SerialAnalyzerResults::GenerateExportFile(const char *file, DisplayBase display_base, U32 /*export_type_user_id*/)
+void SerialAnalyzerResults::GenerateExportFile(const char *file, DisplayBase display_base, U32 export_type_user_id)
 {
-    //export_type_user_id is only important if we have more than one export type.
-    std::stringstream ss;
+    if (export_type_user_id == ANALYZER_BINARY_EXPORT_ID) {
+        AnalyzerBinaryExport::WriteFrames(this, file, mAnalyzer->GetSampleRate(), mAnalyzer->GetTriggerSample());
+        return;
+    }
+
+    if (export_type_user_id == ANALYZER_INSTRUMENTATION_EXPORT_ID) {
+        mAnalyzer->GetInstrumentation().WriteReport(file);
+        return;
+    }
+
+    //text/csv export
+    AnalyzerExportWriter writer;
 
     U64 trigger_sample = mAnalyzer->GetTriggerSample();
     U32 sample_rate = mAnalyzer->GetSampleRate();
     U64 num_frames = GetNumFrames();
 
-    void *f = AnalyzerHelpers::StartFile(file);
+    writer.Start(file);
+    writer.SetTimeBase(trigger_sample, sample_rate);
 
     if (mSettings->mSerialMode == SerialAnalyzerEnums::Normal) {
         //Normal case -- not MP mode.
-        ss << "Time [s],Value,Parity Error,Framing Error" << std::endl;
+        writer.Append("Time [s],Value,Parity Error,Framing Error\n");
 
         for (U32 i = 0; i < num_frames; i++) {
-            Frame frame = GetFrame(i);
-
-            //static void GetTimeString( U64 sample, U64 trigger_sample, U32 sample_rate_hz, char* result_string, U32 result_string_max_length );
-            char time_str[128];
-            AnalyzerHelpers::GetTimeString(frame.mStartingSampleInclusive, trigger_sample, sample_rate, time_str, 128);
+            if ((i % ANALYZER_EXPORT_CANCEL_INTERVAL) == 0 && UpdateExportProgressAndCheckForCancel(i, num_frames) == true) {
+                writer.End();
+                return;
+            }
 
-            char number_str[128];
-            AnalyzerHelpers::GetNumberString(frame.mData1, display_base, mSettings->mBitsPerTransfer, number_str, 128);
+            Frame frame = GetFrame(i);
 
-            ss << time_str << "," << number_str;
+            writer.AppendTime(frame.mStartingSampleInclusive);
+            writer.Append(',');
+            writer.AppendValue(frame.mData1, display_base, mSettings->mBitsPerTransfer);
 
             if ((frame.mFlags & PARITY_ERROR_FLAG) != 0) {
-                ss << ",Error,";
+                writer.Append(",Error,");
             } else {
-                ss << ",,";
+                writer.Append(",,");
             }
 
             if ((frame.mFlags & FRAMING_ERROR_FLAG) != 0) {
-                ss << "Error";
+                writer.Append("Error");
             }
 
-            ss << std::endl;
-
-            AnalyzerHelpers::AppendToFile((U8 *)ss.str().c_str(), ss.str().length(), f);
-            ss.str(std::string());
-
-            if (UpdateExportProgressAndCheckForCancel(i, num_frames) == true) {
-                AnalyzerHelpers::EndFile(f);
-                return;
-            }
+            writer.EndLine();
         }
     } else {
         //MP mode.
-        ss << "Time [s],Packet ID,Address,Data,Framing Error" << std::endl;
+        writer.Append("Time [s],Packet ID,Address,Data,Framing Error\n");
         U64 address = 0;
 
         for (U32 i = 0; i < num_frames; i++) {
+            if ((i % ANALYZER_EXPORT_CANCEL_INTERVAL) == 0 && UpdateExportProgressAndCheckForCancel(i, num_frames) == true) {
+                writer.End();
+                return;
+            }
+
             Frame frame = GetFrame(i);
 
             if ((frame.mFlags & MP_MODE_ADDRESS_FLAG) != 0) {
@@ -152,39 +162,27 @@ void SerialAnalyzerResults::GenerateExportFile(const char *file, DisplayBase dis
 
             U64 packet_id = GetPacketContainingFrameSequential(i);
 
-            //static void GetTimeString( U64 sample, U64 trigger_sample, U32 sample_rate_hz, char* result_string, U32 result_string_max_length );
-            char time_str[128];
-            AnalyzerHelpers::GetTimeString(frame.mStartingSampleInclusive, trigger_sample, sample_rate, time_str, 128);
-
-            char address_str[128];
-            AnalyzerHelpers::GetNumberString(address, display_base, mSettings->mBitsPerTransfer - 1, address_str, 128);
-
-            char number_str[128];
-            AnalyzerHelpers::GetNumberString(frame.mData1, display_base, mSettings->mBitsPerTransfer - 1, number_str, 128);
-            if (packet_id == INVALID_RESULT_INDEX) {
-                ss << time_str << "," << "" << "," << address_str << "," << number_str << ",";
-            } else {
-                ss << time_str << "," << packet_id << "," << address_str << "," << number_str << ",";
+            writer.AppendTime(frame.mStartingSampleInclusive);
+            writer.Append(',');
+            if (packet_id != INVALID_RESULT_INDEX) {
+                writer.AppendNumber(packet_id);
             }
+            writer.Append(',');
+            writer.AppendValue(address, display_base, mSettings->mBitsPerTransfer - 1);
+            writer.Append(',');
+            writer.AppendValue(frame.mData1, display_base, mSettings->mBitsPerTransfer - 1);
+            writer.Append(',');
 
             if ((frame.mFlags & FRAMING_ERROR_FLAG) != 0) {
-                ss << "Error";
+                writer.Append("Error");
             }
 
-            ss << std::endl;
-
-            AnalyzerHelpers::AppendToFile((U8 *)ss.str().c_str(), ss.str().length(), f);
-            ss.str(std::string());
-
-            if (UpdateExportProgressAndCheckForCancel(i, num_frames) == true) {
-                AnalyzerHelpers::EndFile(f);
-                return;
-            }
+            writer.EndLine();
         }
     }
 
     UpdateExportProgressAndCheckForCancel(num_frames, num_frames);
-    AnalyzerHelpers::EndFile(f);
+    writer.End();
 }
 
 void SerialAnalyzerResults::GenerateFrameTabularText(U64 frame_index, DisplayBase display_base)
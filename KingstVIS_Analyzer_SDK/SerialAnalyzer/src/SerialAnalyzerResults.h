@@ -12,6 +12,8 @@ class SerialAnalyzerSettings;
 
 class SerialAnalyzerResults : public AnalyzerResults
 {
+    friend class AnalyzerBinaryExport;   //for UpdateExportProgressAndCheckForCancel
+
 public:
     SerialAnalyzerResults(SerialAnalyzer *analyzer, SerialAnalyzerSettings *settings);
     virtual ~SerialAnalyzerResults();
@@ -23,8 +25,6 @@ public:
     virtual void GeneratePacketTabularText(U64 packet_id, DisplayBase display_base);
     virtual void GenerateTransactionTabularText(U64 transaction_id, DisplayBase display_base);
 
-protected: //functions
-
 protected:  //vars
     SerialAnalyzerSettings *mSettings;
     SerialAnalyzer *mAnalyzer;
@@ -56,7 +56,7 @@ U32 SerialSimulationDataGenerator::GenerateSimulationData(U64 largest_sample_req
 
     while (mSerialSimulationData.GetCurrentSampleNumber() < adjusted_largest_sample_requested) {
         if (mSettings->mSerialMode == SerialAnalyzerEnums::Normal) {
-            CreateSerialByte(mValue++);
+            CreateSerialByte(mValue++ & mNumBitsMask);   //the parity bit only covers the bits sent
 
             mSerialSimulationData.Advance(mClockGenerator.AdvanceByHalfPeriod(10.0));     //insert 10 bit-periods of idle
         } else {
@@ -40,6 +40,10 @@ void SpiAnalyzer::WorkerThread()
     mResults->CommitPacketAndStartNewPacket();
     mResults->CommitResults();
 
+    mInstrumentation.Reset();
+    mCommitPolicy.Reset(this, mResults.get(), &mInstrumentation);
+    AnalyzerCommitPolicy::FlushOnExit flush_on_exit(mCommitPolicy);
+
     if (mEnable != NULL) {
         if (mEnable->GetBitState() != mSettings->mEnableActiveState) {
             mEnable->AdvanceToNextEdge();
@@ -58,6 +62,7 @@ void SpiAnalyzer::WorkerThread()
     }
 
     for (; ;) {
+        mCommitPolicy.FlushIfWaiting(mClock->GetChannelData());
         GetWord();
         CheckIfThreadShouldExit();
     }
@@ -66,7 +71,6 @@ void SpiAnalyzer::WorkerThread()
 void SpiAnalyzer::AdvanceToActiveEnableEdgeWithCorrectClockPolarity()
 {
     mResults->CommitPacketAndStartNewPacket();
-    mResults->CommitResults();
 
     AdvanceToActiveEnableEdge();
 
@@ -100,21 +104,25 @@ void SpiAnalyzer::Setup()
     }
 
     if (mSettings->mMosiChannel != UNDEFINED_CHANNEL) {
-        mMosi = GetAnalyzerChannelData(mSettings->mMosiChannel);
+        mMosiCursor.Attach(GetAnalyzerChannelData(mSettings->mMosiChannel));
+        mMosi = &mMosiCursor;
     } else {
         mMosi = NULL;
     }
 
     if (mSettings->mMisoChannel != UNDEFINED_CHANNEL) {
-        mMiso = GetAnalyzerChannelData(mSettings->mMisoChannel);
+        mMisoCursor.Attach(GetAnalyzerChannelData(mSettings->mMisoChannel));
+        mMiso = &mMisoCursor;
     } else {
         mMiso = NULL;
     }
 
-    mClock = GetAnalyzerChannelData(mSettings->mClockChannel);
+    mClockCursor.Attach(GetAnalyzerChannelData(mSettings->mClockChannel));
+    mClock = &mClockCursor;
 
     if (mSettings->mEnableChannel != UNDEFINED_CHANNEL) {
-        mEnable = GetAnalyzerChannelData(mSettings->mEnableChannel);
+        mEnableCursor.Attach(GetAnalyzerChannelData(mSettings->mEnableChannel));
+        mEnable = &mEnableCursor;
     } else {
         mEnable = NULL;
     }
@@ -123,14 +131,17 @@ void SpiAnalyzer::Setup()
 void SpiAnalyzer::AdvanceToActiveEnableEdge()
 {
     if (mEnable != NULL) {
+        mCommitPolicy.FlushIfWaiting(mEnable->GetChannelData());
         if (mEnable->GetBitState() != mSettings->mEnableActiveState) {
             mEnable->AdvanceToNextEdge();
+            mInstrumentation.Count(CounterEdges);
         } else {
             mEnable->AdvanceToNextEdge();
             mEnable->AdvanceToNextEdge();
+            mInstrumentation.Count(CounterEdges, 2);
         }
         mCurrentSample = mEnable->GetSampleNumber();
-        mClock->AdvanceToAbsPosition(mCurrentSample);
+        mInstrumentation.Count(CounterEdges, mClock->AdvanceToAbsPosition(mCurrentSample));
     } else {
         mCurrentSample = mClock->GetSampleNumber();
     }
@@ -142,8 +153,9 @@ bool SpiAnalyzer::IsInitialClockPolarityCorrect()
         return true;
     }
 
+    mInstrumentation.Count(CounterResyncs);
     if (mSettings->mShowMarker) {
-        mResults->AddMarker(mCurrentSample, AnalyzerResults::ErrorSquare, mSettings->mClockChannel);
+        AddMarker(mCurrentSample, AnalyzerResults::ErrorSquare, mSettings->mClockChannel);
     }
 
     if (mEnable != NULL) {
@@ -155,18 +167,18 @@ bool SpiAnalyzer::IsInitialClockPolarityCorrect()
 
         error_frame.mEndingSampleInclusive = mCurrentSample;
         error_frame.mFlags = SPI_ERROR_FLAG | DISPLAY_AS_ERROR_FLAG;
-        mResults->AddFrame(error_frame);
-        mResults->CommitResults();
-        ReportProgress(error_frame.mEndingSampleInclusive);
+        AddFrame(error_frame);
+        mCommitPolicy.ResultsAdded(error_frame.mEndingSampleInclusive);
 
         //move to the next active-going enable edge
         mEnable->AdvanceToNextEdge();
         mCurrentSample = mEnable->GetSampleNumber();
-        mClock->AdvanceToAbsPosition(mCurrentSample);
+        mInstrumentation.Count(CounterEdges, 2 + mClock->AdvanceToAbsPosition(mCurrentSample));
 
         return false;
     } else {
         mClock->AdvanceToNextEdge();  //at least start with the clock in the idle state.
+        mInstrumentation.Count(CounterEdges);
         mCurrentSample = mClock->GetSampleNumber();
         return true;
     }
@@ -191,6 +203,7 @@ bool SpiAnalyzer::WouldAdvancingTheClockToggleEnable()
 void SpiAnalyzer::GetWord()
 {
     //we're assuming we come into this function with the clock in the idle state;
+    AnalyzerInstrumentation::StageTimer bit_timer(mInstrumentation, StageBitDecode);
 
     U32 bits_per_transfer = mSettings->mBitsPerTransfer;
 
@@ -206,18 +219,21 @@ void SpiAnalyzer::GetWord()
     bool need_reset = false;
 
     mArrowLocations.clear();
-    ReportProgress(mClock->GetSampleNumber());
 
     for (U32 i = 0; i < bits_per_transfer; i++) {
         //on every single edge, we need to check that enable doesn't toggle.
         //note that we can't just advance the enable line to the next edge, becuase there may not be another edge
 
         if (WouldAdvancingTheClockToggleEnable() == true) {
+            //before the first bit this is just the end of the transaction; any later, the word is cut short.
+            AnalyzerInstrumentation::StageTimer resync_timer(mInstrumentation, (i == 0) ? StageEdgeTraversal : StageResync);
+            mInstrumentation.Count(CounterResyncs, (i == 0) ? 0 : 1);
             AdvanceToActiveEnableEdgeWithCorrectClockPolarity();  //ok, we pretty much need to reset everything and return.
             return;
         }
 
         mClock->AdvanceToNextEdge();
+        mInstrumentation.Count(CounterEdges);
         if (i == 0) {
             first_sample = mClock->GetSampleNumber();
         }
@@ -225,11 +241,11 @@ void SpiAnalyzer::GetWord()
         if (mSettings->mDataValidEdge == AnalyzerEnums::LeadingEdge) {
             mCurrentSample = mClock->GetSampleNumber();
             if (mMosi != NULL) {
-                mMosi->AdvanceToAbsPosition(mCurrentSample);
+                mInstrumentation.Count(CounterEdges, mMosi->AdvanceToAbsPosition(mCurrentSample));
                 mosi_result.AddBit(mMosi->GetBitState());
             }
             if (mMiso != NULL) {
-                mMiso->AdvanceToAbsPosition(mCurrentSample);
+                mInstrumentation.Count(CounterEdges, mMiso->AdvanceToAbsPosition(mCurrentSample));
                 miso_result.AddBit(mMiso->GetBitState());
             }
             mArrowLocations.push_back(mCurrentSample);
@@ -247,25 +263,29 @@ void SpiAnalyzer::GetWord()
 
             //enable isn't going to go inactive, go ahead and advance the clock as usual.  Then we're done, jump out and record the frame.
             mClock->AdvanceToNextEdge();
+            mInstrumentation.Count(CounterEdges);
             break;
         }
 
         //this isn't the very last bit, etc, so proceed as normal
         if (WouldAdvancingTheClockToggleEnable() == true) {
+            AnalyzerInstrumentation::StageTimer resync_timer(mInstrumentation, StageResync);
+            mInstrumentation.Count(CounterResyncs);
             AdvanceToActiveEnableEdgeWithCorrectClockPolarity();  //ok, we pretty much need to reset everything and return.
             return;
         }
 
         mClock->AdvanceToNextEdge();
+        mInstrumentation.Count(CounterEdges);
 
         if (mSettings->mDataValidEdge == AnalyzerEnums::TrailingEdge) {
             mCurrentSample = mClock->GetSampleNumber();
             if (mMosi != NULL) {
-                mMosi->AdvanceToAbsPosition(mCurrentSample);
+                mInstrumentation.Count(CounterEdges, mMosi->AdvanceToAbsPosition(mCurrentSample));
                 mosi_result.AddBit(mMosi->GetBitState());
             }
             if (mMiso != NULL) {
-                mMiso->AdvanceToAbsPosition(mCurrentSample);
+                mInstrumentation.Count(CounterEdges, mMiso->AdvanceToAbsPosition(mCurrentSample));
                 miso_result.AddBit(mMiso->GetBitState());
             }
             mArrowLocations.push_back(mCurrentSample);
@@ -275,9 +295,10 @@ void SpiAnalyzer::GetWord()
 
     //save the resuls:
     U32 count = mArrowLocations.size();
+    mInstrumentation.Count(CounterBits, count);
     for (U32 i = 0; i < count; i++) {
         if (mSettings->mShowMarker) {
-            mResults->AddMarker(mArrowLocations[i], mArrowMarker, mSettings->mClockChannel);
+            AddMarker(mArrowLocations[i], mArrowMarker, mSettings->mClockChannel);
         }
     }
 
@@ -287,15 +308,35 @@ void SpiAnalyzer::GetWord()
     result_frame.mData1 = mosi_word;
     result_frame.mData2 = miso_word;
     result_frame.mFlags = 0;
-    mResults->AddFrame(result_frame);
+    AddFrame(result_frame);
 
-    mResults->CommitResults();
+    mCommitPolicy.ResultsAdded(result_frame.mEndingSampleInclusive);
 
     if (need_reset == true) {
+        AnalyzerInstrumentation::StageTimer traversal_timer(mInstrumentation, StageEdgeTraversal);
         AdvanceToActiveEnableEdgeWithCorrectClockPolarity();
     }
 }
 
+void SpiAnalyzer::AddMarker(U64 sample_number, AnalyzerResults::MarkerType marker_type, Channel &channel)
+{
+    AnalyzerInstrumentation::StageTimer marker_timer(mInstrumentation, StageMarkers);
+    mResults->AddMarker(sample_number, marker_type, channel);
+    mInstrumentation.Count(CounterMarkers);
+}
+
+void SpiAnalyzer::AddFrame(const Frame &frame)
+{
+    AnalyzerInstrumentation::StageTimer frame_timer(mInstrumentation, StageFrames);
+    mResults->AddFrame(frame);
+    mInstrumentation.Count(CounterFrames);
+}
+
+AnalyzerInstrumentation &SpiAnalyzer::GetInstrumentation()
+{
+    return mInstrumentation;
+}
+
 bool SpiAnalyzer::NeedsRerun()
 {
     return false;
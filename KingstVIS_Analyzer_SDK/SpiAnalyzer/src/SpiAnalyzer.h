@@ -4,6 +4,8 @@
 #include <Analyzer.h>
 #include "SpiAnalyzerResults.h"
 #include "SpiSimulationDataGenerator.h"
+#include "AnalyzerCommitPolicy.h"
+#include "AnalyzerEdgeCursor.h"
 
 class SpiAnalyzerSettings;
 
@@ -21,6 +23,9 @@ public:
     virtual const char *GetAnalyzerName() const;
     virtual bool NeedsRerun();
 
+    //read by the instrumentation report export, see AnalyzerInstrumentation.h
+    AnalyzerInstrumentation &GetInstrumentation();
+
 protected: //functions
     void Setup();
     void AdvanceToActiveEnableEdge();
@@ -28,6 +33,8 @@ protected: //functions
     void AdvanceToActiveEnableEdgeWithCorrectClockPolarity();
     bool WouldAdvancingTheClockToggleEnable();
     void GetWord();
+    void AddMarker(U64 sample_number, AnalyzerResults::MarkerType marker_type, Channel &channel);
+    void AddFrame(const Frame &frame);
 
 #pragma warning( push )
 #pragma warning( disable : 4251 ) //warning C4251: 'SerialAnalyzer::<...>' : class <...> needs to have dll-interface to be used by clients of class
@@ -37,15 +44,23 @@ protected:  //vars
     bool mSimulationInitilized;
     SpiSimulationDataGenerator mSimulationDataGenerator;
 
-    AnalyzerChannelData *mMosi;
-    AnalyzerChannelData *mMiso;
-    AnalyzerChannelData *mClock;
-    AnalyzerChannelData *mEnable;
+    //the lines are read through cursors, see AnalyzerEdgeCursor.h; NULL for a line that isn't used.
+    AnalyzerEdgeCursor *mMosi;
+    AnalyzerEdgeCursor *mMiso;
+    AnalyzerEdgeCursor *mClock;
+    AnalyzerEdgeCursor *mEnable;
+    AnalyzerEdgeCursor mMosiCursor;
+    AnalyzerEdgeCursor mMisoCursor;
+    AnalyzerEdgeCursor mClockCursor;
+    AnalyzerEdgeCursor mEnableCursor;
 
     U64 mCurrentSample;
     AnalyzerResults::MarkerType mArrowMarker;
     std::vector<U64> mArrowLocations;
 
+    AnalyzerCommitPolicy mCommitPolicy;
+    AnalyzerInstrumentation mInstrumentation;
+
 #pragma warning( pop )
 };
 
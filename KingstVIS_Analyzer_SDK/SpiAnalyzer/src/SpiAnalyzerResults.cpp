@@ -1,5 +1,7 @@
 #include "SpiAnalyzerResults.h"
 #include <AnalyzerHelpers.h>
+#include "AnalyzerBinaryExport.h"
+#include "AnalyzerExportWriter.h"
 #include "SpiAnalyzer.h"
 #include "SpiAnalyzerSettings.h"
 #include <iostream>
@@ -40,17 +42,27 @@ void SpiAnalyzerResults::GenerateBubbleText(U64 frame_index, Channel &channel, D
     }
 }
 
-void SpiAnalyzerResults::GenerateExportFile(const char *file, DisplayBase display_base, U32 /*export_type_user_id*/)
+void SpiAnalyzerResults::GenerateExportFile(const char *file, DisplayBase display_base, U32 export_type_user_id)
 {
-    //export_type_user_id is only important if we have more than one export type.
+    if (export_type_user_id == ANALYZER_BINARY_EXPORT_ID) {
+        AnalyzerBinaryExport::WriteFrames(this, file, mAnalyzer->GetSampleRate(), mAnalyzer->GetTriggerSample());
+        return;
+    }
 
-    std::stringstream ss;
-    void *f = AnalyzerHelpers::StartFile(file);
+    if (export_type_user_id == ANALYZER_INSTRUMENTATION_EXPORT_ID) {
+        mAnalyzer->GetInstrumentation().WriteReport(file);
+        return;
+    }
 
+    //text/csv export
     U64 trigger_sample = mAnalyzer->GetTriggerSample();
     U32 sample_rate = mAnalyzer->GetSampleRate();
 
-    ss << "Time [s],Packet ID,MOSI,MISO" << std::endl;
+    AnalyzerExportWriter writer;
+    writer.Start(file);
+    writer.SetTimeBase(trigger_sample, sample_rate);
+
+    writer.Append("Time [s],Packet ID,MOSI,MISO\n");
 
     bool mosi_used = true;
     bool miso_used = true;
@@ -65,43 +77,36 @@ void SpiAnalyzerResults::GenerateExportFile(const char *file, DisplayBase displa
 
     U64 num_frames = GetNumFrames();
     for (U32 i = 0; i < num_frames; i++) {
+        if ((i % ANALYZER_EXPORT_CANCEL_INTERVAL) == 0 && UpdateExportProgressAndCheckForCancel(i, num_frames) == true) {
+            writer.End();
+            return;
+        }
+
         Frame frame = GetFrame(i);
 
         if ((frame.mFlags & SPI_ERROR_FLAG) != 0) {
             continue;
         }
 
-        char time_str[128];
-        AnalyzerHelpers::GetTimeString(frame.mStartingSampleInclusive, trigger_sample, sample_rate, time_str, 128);
-
-        char mosi_str[128] = "";
+        U64 packet_id = GetPacketContainingFrameSequential(i);
+        writer.AppendTime(frame.mStartingSampleInclusive);
+        writer.Append(',');
+        if (packet_id != INVALID_RESULT_INDEX) {    //it's ok for a frame not to be included in a packet.
+            writer.AppendNumber(packet_id);
+        }
+        writer.Append(',');
         if (mosi_used == true) {
-            AnalyzerHelpers::GetNumberString(frame.mData1, display_base, mSettings->mBitsPerTransfer, mosi_str, 128);
+            writer.AppendValue(frame.mData1, display_base, mSettings->mBitsPerTransfer);
         }
-
-        char miso_str[128] = "";
+        writer.Append(',');
         if (miso_used == true) {
-            AnalyzerHelpers::GetNumberString(frame.mData2, display_base, mSettings->mBitsPerTransfer, miso_str, 128);
-        }
-
-        U64 packet_id = GetPacketContainingFrameSequential(i);
-        if (packet_id != INVALID_RESULT_INDEX) {
-            ss << time_str << "," << packet_id << "," << mosi_str << "," << miso_str << std::endl;
-        } else {
-            ss << time_str << ",," << mosi_str << "," << miso_str << std::endl;    //it's ok for a frame not to be included in a packet.
-        }
-
-        AnalyzerHelpers::AppendToFile((U8 *)ss.str().c_str(), ss.str().length(), f);
-        ss.str(std::string());
-
-        if (UpdateExportProgressAndCheckForCancel(i, num_frames) == true) {
-            AnalyzerHelpers::EndFile(f);
-            return;
+            writer.AppendValue(frame.mData2, display_base, mSettings->mBitsPerTransfer);
         }
+        writer.EndLine();
     }
 
     UpdateExportProgressAndCheckForCancel(num_frames, num_frames);
-    AnalyzerHelpers::EndFile(f);
+    writer.End();
 }
 
 void SpiAnalyzerResults::GenerateFrameTabularText(U64 frame_index, DisplayBase display_base)
@@ -10,6 +10,8 @@ class SpiAnalyzerSettings;
 
 class SpiAnalyzerResults : public AnalyzerResults
 {
+    friend class AnalyzerBinaryExport;   //for UpdateExportProgressAndCheckForCancel
+
 public:
     SpiAnalyzerResults(SpiAnalyzer *analyzer, SpiAnalyzerSettings *settings);
     virtual ~SpiAnalyzerResults();
@@ -21,8 +23,6 @@ public:
     virtual void GeneratePacketTabularText(U64 packet_id, DisplayBase display_base);
     virtual void GenerateTransactionTabularText(U64 transaction_id, DisplayBase display_base);
 
-protected: //functions
-
 protected: //vars
     SpiAnalyzerSettings *mSettings;
     SpiAnalyzer *mAnalyzer;
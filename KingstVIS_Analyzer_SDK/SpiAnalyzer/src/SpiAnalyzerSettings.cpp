@@ -1,6 +1,8 @@
 #include "SpiAnalyzerSettings.h"
 
 #include <AnalyzerHelpers.h>
+#include "AnalyzerBinaryExport.h"
+#include "AnalyzerInstrumentation.h"
 #include <sstream>
 #include <cstring>
 
@@ -96,6 +98,15 @@ SpiAnalyzerSettings::SpiAnalyzerSettings()
     AddExportExtension(0, "Text file", "txt");
     AddExportExtension(0, "CSV file", "csv");
 
+    AddExportOption(ANALYZER_BINARY_EXPORT_ID, "Export as columnar binary file");
+    AddExportExtension(ANALYZER_BINARY_EXPORT_ID, "Binary file", "bin");
+
+#ifdef ANALYZER_INSTRUMENTATION
+    AddExportOption(ANALYZER_INSTRUMENTATION_EXPORT_ID, "Export instrumentation report as text/csv file");
+    AddExportExtension(ANALYZER_INSTRUMENTATION_EXPORT_ID, "Text file", "txt");
+    AddExportExtension(ANALYZER_INSTRUMENTATION_EXPORT_ID, "CSV file", "csv");
+#endif
+
     ClearChannels();
     AddChannel(mMosiChannel, "MOSI", false);
     AddChannel(mMisoChannel, "MISO", false);
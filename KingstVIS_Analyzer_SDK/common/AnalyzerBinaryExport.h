@@ -0,0 +1,223 @@
+#ifndef ANALYZER_BINARY_EXPORT_H
+#define ANALYZER_BINARY_EXPORT_H
+
+#include <AnalyzerResults.h>
+#include "AnalyzerExportWriter.h"
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+
+#define ANALYZER_BINARY_EXPORT_ID       1       //export_type_user_id of the binary export option
+#define ANALYZER_BINARY_EXPORT_VERSION  1
+#define ANALYZER_BINARY_EXPORT_BLOCK    65536   //frames buffered per column before a write
+
+//Columnar binary export file. It is written in host byte order, which is little endian on every KingstVIS platform:
+//
+//  header      AnalyzerBinaryExportHeader
+//  columns     one array per column, mFrameCount entries long, starting at mColumnOffsets[ column ]
+//
+//Every column starts on an 8 byte boundary, so the file can be mapped and the columns used as plain arrays.
+//A frame that isn't in a packet has a packet id of INVALID_RESULT_INDEX.
+enum AnalyzerBinaryExportColumn {
+    BinaryStartingSample,   //U64
+    BinaryEndingSample,     //U64
+    BinaryData1,            //U64
+    BinaryData2,            //U64
+    BinaryPacketId,         //U64
+    BinaryType,             //U8
+    BinaryFlags,            //U8
+    BinaryColumnCount
+};
+
+struct AnalyzerBinaryExportHeader {
+    char mMagic[8];         //"KVISCOL" and a terminating zero
+    U32 mVersion;
+    U32 mHeaderSize;
+    U64 mFrameCount;
+    U64 mTriggerSample;
+    U32 mSampleRate;
+    U32 mColumnCount;
+    U64 mColumnOffsets[BinaryColumnCount];
+};
+
+//Writes the columns from a single pass over the frames: each column is buffered in blocks
+//and a full block is written straight to its place in the file.
+//Once a write fails, nothing more is written and End leaves the frame count of 0 Start wrote, so a short file on
+//a full disk never claims frames it doesn't hold.
+class AnalyzerBinaryExport
+{
+public:
+    AnalyzerBinaryExport()
+        :   mFile(NULL),
+            mFrameCapacity(0),
+            mFramesWritten(0),
+            mBlockCount(0),
+            mWriteFailed(false)
+    {
+        memset(&mHeader, 0, sizeof(mHeader));
+    }
+
+    ~AnalyzerBinaryExport()
+    {
+        End();
+    }
+
+    //frame_count sizes the columns; End records how many frames were actually added.
+    bool Start(const char *file, U32 sample_rate, U64 trigger_sample, U64 frame_count)
+    {
+        mFile = fopen(file, "wb");
+        if (mFile == NULL) {
+            return false;
+        }
+
+        memset(&mHeader, 0, sizeof(mHeader));
+        memcpy(mHeader.mMagic, "KVISCOL", 8);
+        mHeader.mVersion = ANALYZER_BINARY_EXPORT_VERSION;
+        mHeader.mHeaderSize = sizeof(AnalyzerBinaryExportHeader);
+        mHeader.mTriggerSample = trigger_sample;
+        mHeader.mSampleRate = sample_rate;
+        mHeader.mColumnCount = BinaryColumnCount;
+
+        U64 offset = sizeof(AnalyzerBinaryExportHeader);
+        for (U32 i = 0; i < BinaryColumnCount; i++) {
+            mHeader.mColumnOffsets[i] = offset;
+            offset += (GetColumnSize(i) * frame_count + 7) & ~7ull;
+        }
+
+        mFrameCapacity = frame_count;
+        mFramesWritten = 0;
+        mBlockCount = 0;
+        mWriteFailed = false;
+        mWide.resize(ANALYZER_BINARY_EXPORT_BLOCK * (BinaryPacketId + 1));
+        mNarrow.resize(ANALYZER_BINARY_EXPORT_BLOCK * (BinaryColumnCount - BinaryType));
+
+        return WriteAt(0, &mHeader, sizeof(mHeader));
+    }
+
+    void AddFrame(const Frame &frame, U64 packet_id)
+    {
+        if (mFile == NULL || mFramesWritten + mBlockCount >= mFrameCapacity) {
+            return;
+        }
+
+        U64 *wide = &mWide[mBlockCount];
+        wide[BinaryStartingSample * ANALYZER_BINARY_EXPORT_BLOCK] = frame.mStartingSampleInclusive;
+        wide[BinaryEndingSample * ANALYZER_BINARY_EXPORT_BLOCK] = frame.mEndingSampleInclusive;
+        wide[BinaryData1 * ANALYZER_BINARY_EXPORT_BLOCK] = frame.mData1;
+        wide[BinaryData2 * ANALYZER_BINARY_EXPORT_BLOCK] = frame.mData2;
+        wide[BinaryPacketId * ANALYZER_BINARY_EXPORT_BLOCK] = packet_id;
+
+        U8 *narrow = &mNarrow[mBlockCount];
+        narrow[0] = frame.mType;
+        narrow[ANALYZER_BINARY_EXPORT_BLOCK] = frame.mFlags;
+
+        mBlockCount++;
+        if (mBlockCount == ANALYZER_BINARY_EXPORT_BLOCK) {
+            FlushBlock();
+        }
+    }
+
+    //The whole binary export of an analyzer: every frame of results in one pass, checking for a cancel every
+    //ANALYZER_EXPORT_CANCEL_INTERVAL frames. Results declares AnalyzerBinaryExport a friend, since
+    //UpdateExportProgressAndCheckForCancel is protected. Returns false if the file couldn't be written.
+    template <class Results>
+    static bool WriteFrames(Results *results, const char *file, U32 sample_rate, U64 trigger_sample)
+    {
+        U64 num_frames = results->GetNumFrames();
+
+        AnalyzerBinaryExport binary_file;
+        if (binary_file.Start(file, sample_rate, trigger_sample, num_frames) == false) {
+            return false;
+        }
+
+        for (U64 i = 0; i < num_frames; i++) {
+            binary_file.AddFrame(results->GetFrame(i), results->GetPacketContainingFrameSequential(i));
+
+            if ((i % ANALYZER_EXPORT_CANCEL_INTERVAL) == 0 && results->UpdateExportProgressAndCheckForCancel(i, num_frames) == true) {
+                break;
+            }
+        }
+
+        return binary_file.End();
+    }
+
+    //also called by the destructor, so an export that is cancelled part way still gets a valid header.
+    //returns false if any write failed.
+    bool End()
+    {
+        if (mFile == NULL) {
+            return mWriteFailed == false;
+        }
+
+        FlushBlock();
+        if (mWriteFailed == false && fflush(mFile) != 0) {
+            mWriteFailed = true;
+        }
+        if (mWriteFailed == false) {
+            mHeader.mFrameCount = mFramesWritten;
+            WriteAt(0, &mHeader, sizeof(mHeader));
+        }
+
+        if (fclose(mFile) != 0) {
+            mWriteFailed = true;
+        }
+        mFile = NULL;
+        return mWriteFailed == false;
+    }
+
+protected:
+    static U32 GetColumnSize(U32 column)
+    {
+        return (column < BinaryType) ? sizeof(U64) : sizeof(U8);
+    }
+
+    void FlushBlock()
+    {
+        if (mBlockCount == 0 || mWriteFailed == true) {
+            mBlockCount = 0;
+            return;
+        }
+
+        for (U32 i = 0; i < BinaryColumnCount; i++) {
+            U32 size = GetColumnSize(i);
+            const void *data;
+            if (i < BinaryType) {
+                data = &mWide[i * ANALYZER_BINARY_EXPORT_BLOCK];
+            } else {
+                data = &mNarrow[(i - BinaryType) * ANALYZER_BINARY_EXPORT_BLOCK];
+            }
+            WriteAt(mHeader.mColumnOffsets[i] + mFramesWritten * size, data, mBlockCount * size);
+        }
+
+        mFramesWritten += mBlockCount;
+        mBlockCount = 0;
+    }
+
+    bool WriteAt(U64 offset, const void *data, size_t size)
+    {
+#ifdef _WIN32
+        if (_fseeki64(mFile, S64(offset), SEEK_SET) != 0) {
+#else
+        if (fseeko(mFile, off_t(offset), SEEK_SET) != 0) {
+#endif
+            mWriteFailed = true;
+            return false;
+        }
+
+        if (fwrite(data, 1, size, mFile) != size) {
+            mWriteFailed = true;
+        }
+        return mWriteFailed == false;
+    }
+
+    FILE *mFile;
+    AnalyzerBinaryExportHeader mHeader;
+    U64 mFrameCapacity;
+    U64 mFramesWritten;
+    U32 mBlockCount;
+    std::vector<U64> mWide;     //the U64 columns, one block each
+    std::vector<U8> mNarrow;    //the U8 columns, one block each
+    bool mWriteFailed;
+};
+
+#endif //ANALYZER_BINARY_EXPORT_H
@@ -0,0 +1,161 @@
+#ifndef ANALYZER_COMMIT_POLICY_H
+#define ANALYZER_COMMIT_POLICY_H
+
+#include <Analyzer.h>
+#include <AnalyzerResults.h>
+#include <AnalyzerChannelData.h>
+#include "AnalyzerInstrumentation.h"
+#include <chrono>
+
+#define ANALYZER_COMMIT_MAX_RESULTS      4096    //commit at least every this many frames and markers
+#define ANALYZER_COMMIT_MAX_MS           50      //and at least this often while results are pending
+#define ANALYZER_COMMIT_CLOCK_INTERVAL   64      //results between clock reads
+
+//Batches CommitResults and ReportProgress for a worker thread.
+//Both calls go into the host library (and CommitResults takes a lock shared with the GUI),
+//so instead of once per frame they are made once every ANALYZER_COMMIT_MAX_RESULTS frames and markers
+//or ANALYZER_COMMIT_MAX_MS milliseconds, whichever comes first.
+//Pending results are also flushed before the worker waits for more data, and on thread exit through FlushOnExit.
+//With an AnalyzerInstrumentation, every commit publishes the commit count and the time since Reset for its report,
+//and with ANALYZER_INSTRUMENTATION compiled in the commits are timed too.
+class AnalyzerCommitPolicy
+{
+public:
+    AnalyzerCommitPolicy()
+        :   mAnalyzer(NULL),
+            mResults(NULL),
+            mInstrumentation(NULL),
+            mMaxPendingResults(ANALYZER_COMMIT_MAX_RESULTS),
+            mMaxPendingTime(std::chrono::milliseconds(ANALYZER_COMMIT_MAX_MS))
+    {
+        Reset(NULL, NULL);
+    }
+
+    void Reset(Analyzer *analyzer, AnalyzerResults *results, AnalyzerInstrumentation *instrumentation = NULL)
+    {
+        mAnalyzer = analyzer;
+        mResults = results;
+        mInstrumentation = instrumentation;
+        mPendingResults = 0;
+        mNextClockCheck = ANALYZER_COMMIT_CLOCK_INTERVAL;
+        mProgressSample = 0;
+        mProgressPending = false;
+        mCommitCount = 0;
+        mStartTime = std::chrono::steady_clock::now();
+        mLastCommitTime = mStartTime;
+        if (mInstrumentation != NULL) {
+            mInstrumentation->PublishCommits(0, 0);
+        }
+    }
+
+    //call after adding frames or markers; commits once either limit is reached.
+    void ResultsAdded(U64 progress_sample, U32 result_count = 1)
+    {
+        mProgressSample = progress_sample;
+        mProgressPending = true;
+        mPendingResults += result_count;
+
+        if (mPendingResults >= mMaxPendingResults) {
+            Commit();
+            return;
+        }
+
+        if (mPendingResults >= mNextClockCheck) {
+            mNextClockCheck = mPendingResults + ANALYZER_COMMIT_CLOCK_INTERVAL;
+            if (std::chrono::steady_clock::now() - mLastCommitTime >= mMaxPendingTime) {
+                Commit();
+            }
+        }
+    }
+
+    //progress without new results, e.g. a chunk of edges that held no complete frame.
+    void ProgressMade(U64 progress_sample)
+    {
+        mProgressSample = progress_sample;
+        mProgressPending = true;
+
+        if (std::chrono::steady_clock::now() - mLastCommitTime >= mMaxPendingTime) {
+            Commit();
+        }
+    }
+
+    //commits before the worker blocks waiting for the rest of a live capture, so results never sit pending.
+    void FlushIfWaiting(AnalyzerChannelData *channel)
+    {
+        if (mProgressPending == true && channel->DoMoreTransitionsExistInCurrentData() == false) {
+            Commit();
+        }
+    }
+
+    void Flush()
+    {
+        if (mProgressPending == true) {
+            Commit();
+        } else if (mInstrumentation != NULL) {
+            mInstrumentation->Publish();
+        }
+    }
+
+    //flushes when the worker thread leaves, including by the exception the host uses to cancel it.
+    //A destructor can't throw, so whatever the host throws from the flush, cancelled again, is dropped.
+    class FlushOnExit
+    {
+    public:
+        FlushOnExit(AnalyzerCommitPolicy &policy) : mPolicy(policy) {}
+        ~FlushOnExit()
+        {
+            try {
+                mPolicy.Flush();
+            } catch (...) {
+            }
+        }
+
+    protected:
+        FlushOnExit &operator=(const FlushOnExit &);
+        AnalyzerCommitPolicy &mPolicy;
+    };
+
+protected:
+    void Commit()
+    {
+        AnalyzerStage previous_stage = StageOther;
+        if (mInstrumentation != NULL) {
+            previous_stage = mInstrumentation->EnterStage(StageCommit);
+        }
+
+        if (mPendingResults != 0) {
+            mResults->CommitResults();
+            mCommitCount++;
+        }
+        mAnalyzer->ReportProgress(mProgressSample);
+        mLastCommitTime = std::chrono::steady_clock::now();
+
+        if (mInstrumentation != NULL) {
+            mInstrumentation->PublishCommits(mCommitCount, std::chrono::duration_cast<std::chrono::nanoseconds>(mLastCommitTime - mStartTime).count());
+            mInstrumentation->LeaveStage(previous_stage);
+            mInstrumentation->Publish();
+        }
+
+        mPendingResults = 0;
+        mNextClockCheck = ANALYZER_COMMIT_CLOCK_INTERVAL;
+        mProgressPending = false;
+    }
+
+    Analyzer *mAnalyzer;
+    AnalyzerResults *mResults;
+    AnalyzerInstrumentation *mInstrumentation;
+
+    U32 mMaxPendingResults;
+    std::chrono::steady_clock::duration mMaxPendingTime;
+
+    U32 mPendingResults;
+    U32 mNextClockCheck;
+    U64 mProgressSample;
+    bool mProgressPending;
+
+    U64 mCommitCount;
+    std::chrono::steady_clock::time_point mStartTime;
+    std::chrono::steady_clock::time_point mLastCommitTime;
+};
+
+#endif //ANALYZER_COMMIT_POLICY_H
@@ -0,0 +1,172 @@
+#ifndef ANALYZER_EDGE_CURSOR_H
+#define ANALYZER_EDGE_CURSOR_H
+
+#include <AnalyzerChannelData.h>
+
+//A channel's position, bit state and next edge, kept on the analyzer's side of the host library.
+//Every AnalyzerChannelData call goes into the host, which finds its place in the capture again each time, so a data
+//or enable line looked at on every clock edge pays that for the many moves and look aheads that pass no edge at all.
+//Once the next edge is known, those are a compare: the line is only moved in the host when a move passes an edge,
+//and the host's position lagging behind until then changes nothing, since no edge lies in between.
+//The next edge is asked for after a move that passed none, the line looks quiet, and only when it is already in the
+//captured data; asking for one that isn't blocks the worker until it comes, and a busy line would pay the extra call
+//on every move. The methods are the AnalyzerChannelData ones the analyzers use, with the same results.
+//Built with ANALYZER_NO_EDGE_CURSOR defined, every method goes straight to the host instead, for measuring what the
+//cursor saves (the replay makefile builds libSPINoCursor.so so, for analyzer-bench).
+#ifdef ANALYZER_NO_EDGE_CURSOR
+class AnalyzerEdgeCursor
+{
+public:
+    AnalyzerEdgeCursor() : mChannel(NULL) {}
+
+    void Attach(AnalyzerChannelData *channel)
+    {
+        mChannel = channel;
+    }
+
+    AnalyzerChannelData *GetChannelData()
+    {
+        return mChannel;
+    }
+
+    U64 GetSampleNumber()
+    {
+        return mChannel->GetSampleNumber();
+    }
+
+    BitState GetBitState()
+    {
+        return mChannel->GetBitState();
+    }
+
+    U32 AdvanceToAbsPosition(U64 sample_number)
+    {
+        return mChannel->AdvanceToAbsPosition(sample_number);
+    }
+
+    void AdvanceToNextEdge()
+    {
+        mChannel->AdvanceToNextEdge();
+    }
+
+    U64 GetSampleOfNextEdge()
+    {
+        return mChannel->GetSampleOfNextEdge();
+    }
+
+    bool WouldAdvancingToAbsPositionCauseTransition(U64 sample_number)
+    {
+        return mChannel->WouldAdvancingToAbsPositionCauseTransition(sample_number);
+    }
+
+protected:
+    AnalyzerChannelData *mChannel;
+};
+#else
+class AnalyzerEdgeCursor
+{
+public:
+    AnalyzerEdgeCursor()
+        :   mChannel(NULL),
+            mSampleNumber(0),
+            mBitState(BIT_LOW),
+            mNextEdge(0),
+            mNextEdgeKnown(false)
+    {
+    }
+
+    void Attach(AnalyzerChannelData *channel)
+    {
+        mChannel = channel;
+        mSampleNumber = channel->GetSampleNumber();
+        mBitState = channel->GetBitState();
+        mNextEdgeKnown = false;
+    }
+
+    //for the calls that need the host's channel, DoMoreTransitionsExistInCurrentData and the like
+    AnalyzerChannelData *GetChannelData()
+    {
+        return mChannel;
+    }
+
+    U64 GetSampleNumber()
+    {
+        return mSampleNumber;
+    }
+
+    BitState GetBitState()
+    {
+        return mBitState;
+    }
+
+    U32 AdvanceToAbsPosition(U64 sample_number)
+    {
+        if (sample_number <= mSampleNumber) {
+            return 0;
+        }
+
+        if (mNextEdgeKnown == true && sample_number < mNextEdge) {
+            mSampleNumber = sample_number;
+            return 0;
+        }
+
+        U32 transitions = mChannel->AdvanceToAbsPosition(sample_number);
+        mSampleNumber = sample_number;
+        if ((transitions & 0x1) != 0) {
+            mBitState = (mBitState == BIT_LOW) ? BIT_HIGH : BIT_LOW;
+        }
+
+        mNextEdgeKnown = false;
+        if (transitions == 0) {
+            FindNextEdgeIfCaptured();
+        }
+        return transitions;
+    }
+
+    void AdvanceToNextEdge()
+    {
+        mChannel->AdvanceToNextEdge();
+        mSampleNumber = (mNextEdgeKnown == true) ? mNextEdge : mChannel->GetSampleNumber();
+        mBitState = (mBitState == BIT_LOW) ? BIT_HIGH : BIT_LOW;
+        mNextEdgeKnown = false;
+    }
+
+    U64 GetSampleOfNextEdge()
+    {
+        if (mNextEdgeKnown == false) {
+            mNextEdge = mChannel->GetSampleOfNextEdge();
+            mNextEdgeKnown = true;
+        }
+
+        return mNextEdge;
+    }
+
+    bool WouldAdvancingToAbsPositionCauseTransition(U64 sample_number)
+    {
+        if (mNextEdgeKnown == false && FindNextEdgeIfCaptured() == false) {
+            return mChannel->WouldAdvancingToAbsPositionCauseTransition(sample_number);
+        }
+
+        return mNextEdge <= sample_number;
+    }
+
+protected:
+    bool FindNextEdgeIfCaptured()
+    {
+        if (mChannel->DoMoreTransitionsExistInCurrentData() == true) {
+            mNextEdge = mChannel->GetSampleOfNextEdge();
+            mNextEdgeKnown = true;
+        }
+
+        return mNextEdgeKnown;
+    }
+
+    AnalyzerChannelData *mChannel;
+    U64 mSampleNumber;
+    BitState mBitState;
+    U64 mNextEdge;          //first edge after mSampleNumber, when mNextEdgeKnown
+    bool mNextEdgeKnown;
+};
+#endif
+
+#endif //ANALYZER_EDGE_CURSOR_H
@@ -0,0 +1,293 @@
+#ifndef ANALYZER_EXPORT_WRITER_H
+#define ANALYZER_EXPORT_WRITER_H
+
+#include <AnalyzerHelpers.h>
+#include <string.h>
+#include <vector>
+
+#define ANALYZER_EXPORT_BUFFER_SIZE     ( 1 << 20 ) //bytes collected before each AppendToFile
+#define ANALYZER_EXPORT_CANCEL_INTERVAL 1024        //rows between UpdateExportProgressAndCheckForCancel calls
+
+//Buffered writer for the text/csv exports.
+//Rows are formatted straight into one reusable buffer, which goes to AppendToFile a block at a time,
+//instead of building a stringstream and making an AppendToFile call for every row.
+class AnalyzerExportWriter
+{
+public:
+    AnalyzerExportWriter()
+        :   mFile(NULL),
+            mLength(0),
+            mTriggerSample(0),
+            mSampleRate(0),
+            mFastTime(false),
+            mTimeDecimals(0),
+            mTimeScale(1),
+            mTimeUnit(1),
+            mValueBase(Hexadecimal),
+            mValueBits(0xFFFFFFFF),
+            mFastValue(false)
+    {
+    }
+
+    ~AnalyzerExportWriter()
+    {
+        End();
+    }
+
+    void Start(const char *file)
+    {
+        mBuffer.resize(ANALYZER_EXPORT_BUFFER_SIZE);
+        mLength = 0;
+        mFile = AnalyzerHelpers::StartFile(file);
+    }
+
+    void Append(const char *str, U32 length)
+    {
+        if (mLength + length > ANALYZER_EXPORT_BUFFER_SIZE) {
+            Flush();
+            if (length > ANALYZER_EXPORT_BUFFER_SIZE) {
+                AnalyzerHelpers::AppendToFile((const U8 *)str, length, mFile);
+                return;
+            }
+        }
+
+        memcpy(&mBuffer[mLength], str, length);
+        mLength += length;
+    }
+
+    void Append(const char *str)
+    {
+        Append(str, U32(strlen(str)));
+    }
+
+    void Append(char c)
+    {
+        if (mLength == ANALYZER_EXPORT_BUFFER_SIZE) {
+            Flush();
+        }
+
+        mBuffer[mLength++] = c;
+    }
+
+    //decimal, the same digits as streaming a U64 into a stringstream.
+    void AppendNumber(U64 number)
+    {
+        char digits[20];
+        U32 count = 0;
+        do {
+            digits[count++] = char('0' + number % 10);
+            number /= 10;
+        } while (number != 0);
+
+        if (mLength + count > ANALYZER_EXPORT_BUFFER_SIZE) {
+            Flush();
+        }
+
+        while (count != 0) {
+            mBuffer[mLength++] = digits[--count];
+        }
+    }
+
+    void EndLine()
+    {
+        Append('\n');
+    }
+
+    //times are formatted with integer math when that is known to give exactly what GetTimeString gives:
+    //the sample rate has to divide the time resolution GetTimeString uses, and a few test samples have to match.
+    void SetTimeBase(U64 trigger_sample, U32 sample_rate)
+    {
+        mTriggerSample = trigger_sample;
+        mSampleRate = sample_rate;
+        mFastTime = false;
+
+        char reference[128];
+        AnalyzerHelpers::GetTimeString(trigger_sample, trigger_sample, sample_rate, reference, sizeof(reference));
+        const char *point = strchr(reference, '.');
+        mTimeDecimals = (point != NULL) ? U32(strlen(point + 1)) : 0;
+        if (sample_rate == 0 || mTimeDecimals > 12) {
+            return;
+        }
+
+        mTimeUnit = 1;
+        for (U32 i = 0; i < mTimeDecimals; i++) {
+            mTimeUnit *= 10;
+        }
+        if (mTimeUnit % sample_rate != 0) {
+            return;
+        }
+        mTimeScale = mTimeUnit / sample_rate;
+
+        U64 test_offsets[] = { 0, 1, 7, sample_rate - 1ull, sample_rate, sample_rate * 3600ull + 12345 };
+        mFastTime = true;
+        for (U32 i = 0; i < sizeof(test_offsets) / sizeof(test_offsets[0]) && mFastTime == true; i++) {
+            mFastTime = IsTimeFormatMatching(trigger_sample + test_offsets[i]);
+            if (mFastTime == true && trigger_sample >= test_offsets[i]) {
+                mFastTime = IsTimeFormatMatching(trigger_sample - test_offsets[i]);
+            }
+        }
+    }
+
+    void AppendTime(U64 sample)
+    {
+        char time_str[128];
+        if (mFastTime == false || FormatTime(sample, time_str) == false) {
+            AnalyzerHelpers::GetTimeString(sample, mTriggerSample, mSampleRate, time_str, sizeof(time_str));
+        }
+        Append(time_str);
+    }
+
+    //hexadecimal and decimal values are formatted here in the same way, once test values match GetNumberString.
+    void AppendValue(U64 number, DisplayBase display_base, U32 num_data_bits)
+    {
+        if (display_base != mValueBase || num_data_bits != mValueBits) {
+            SetValueFormat(display_base, num_data_bits);
+        }
+
+        char number_str[128];
+        if (mFastValue == true) {
+            FormatValue(number, number_str);
+        } else {
+            AnalyzerHelpers::GetNumberString(number, display_base, num_data_bits, number_str, sizeof(number_str));
+        }
+        Append(number_str);
+    }
+
+    void End()
+    {
+        if (mFile == NULL) {
+            return;
+        }
+
+        Flush();
+        AnalyzerHelpers::EndFile(mFile);
+        mFile = NULL;
+    }
+
+protected:
+    //seconds from the trigger, with mTimeDecimals decimals.
+    //false past 2^53 time units, where GetTimeString's double no longer holds every unit.
+    bool FormatTime(U64 sample, char *time_str)
+    {
+        U64 samples = (sample >= mTriggerSample) ? sample - mTriggerSample : mTriggerSample - sample;
+        if (samples > (1ull << 53) / mTimeScale) {
+            return false;
+        }
+
+        if (sample < mTriggerSample) {
+            *time_str++ = '-';
+        }
+
+        U64 units = samples * mTimeScale;
+        U64 seconds = units / mTimeUnit;
+        U64 fraction = units % mTimeUnit;
+
+        char digits[20];
+        U32 count = 0;
+        do {
+            digits[count++] = char('0' + seconds % 10);
+            seconds /= 10;
+        } while (seconds != 0);
+        while (count != 0) {
+            *time_str++ = digits[--count];
+        }
+
+        if (mTimeDecimals != 0) {
+            *time_str++ = '.';
+            for (U32 i = mTimeDecimals; i != 0; i--) {
+                time_str[i - 1] = char('0' + fraction % 10);
+                fraction /= 10;
+            }
+            time_str += mTimeDecimals;
+        }
+
+        *time_str = 0;
+        return true;
+    }
+
+    bool IsTimeFormatMatching(U64 sample)
+    {
+        char expected[128];
+        char formatted[128];
+        AnalyzerHelpers::GetTimeString(sample, mTriggerSample, mSampleRate, expected, sizeof(expected));
+        return FormatTime(sample, formatted) == true && strcmp(expected, formatted) == 0;
+    }
+
+    void SetValueFormat(DisplayBase display_base, U32 num_data_bits)
+    {
+        mValueBase = display_base;
+        mValueBits = num_data_bits;
+        mFastValue = false;
+        if ((display_base != Hexadecimal && display_base != Decimal) || num_data_bits == 0 || num_data_bits > 64) {
+            return;
+        }
+
+        U64 mask = (num_data_bits < 64) ? (1ull << num_data_bits) - 1 : ~0ull;
+        U64 test_values[] = { 0, 1, 9, 10, 0xA5, mask >> 1, mask, mask + 1, ~0ull };
+        mFastValue = true;
+        for (U32 i = 0; i < sizeof(test_values) / sizeof(test_values[0]) && mFastValue == true; i++) {
+            char expected[128];
+            char formatted[128];
+            AnalyzerHelpers::GetNumberString(test_values[i], display_base, num_data_bits, expected, sizeof(expected));
+            FormatValue(test_values[i], formatted);
+            mFastValue = strcmp(expected, formatted) == 0;
+        }
+    }
+
+    //the value masked to mValueBits; hex is zero padded to whole nibbles.
+    void FormatValue(U64 number, char *number_str)
+    {
+        if (mValueBits < 64) {
+            number &= (1ull << mValueBits) - 1;
+        }
+
+        if (mValueBase == Hexadecimal) {
+            static const char hex_digits[] = "0123456789ABCDEF";
+            U32 count = (mValueBits + 3) / 4;
+            *number_str++ = '0';
+            *number_str++ = 'x';
+            for (U32 i = count; i != 0; i--) {
+                number_str[i - 1] = hex_digits[number & 0xF];
+                number >>= 4;
+            }
+            number_str[count] = 0;
+            return;
+        }
+
+        char digits[20];
+        U32 count = 0;
+        do {
+            digits[count++] = char('0' + number % 10);
+            number /= 10;
+        } while (number != 0);
+        while (count != 0) {
+            *number_str++ = digits[--count];
+        }
+        *number_str = 0;
+    }
+
+    void Flush()
+    {
+        if (mLength != 0) {
+            AnalyzerHelpers::AppendToFile((const U8 *)&mBuffer[0], mLength, mFile);
+            mLength = 0;
+        }
+    }
+
+    void *mFile;
+    std::vector<char> mBuffer;
+    U32 mLength;
+
+    U64 mTriggerSample;
+    U32 mSampleRate;
+    bool mFastTime;
+    U32 mTimeDecimals;
+    U64 mTimeScale;     //time units per sample
+    U64 mTimeUnit;      //time units per second
+
+    DisplayBase mValueBase;
+    U32 mValueBits;
+    bool mFastValue;
+};
+
+#endif //ANALYZER_EXPORT_WRITER_H
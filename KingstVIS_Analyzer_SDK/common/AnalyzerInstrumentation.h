@@ -0,0 +1,225 @@
+#ifndef ANALYZER_INSTRUMENTATION_H
+#define ANALYZER_INSTRUMENTATION_H
+
+#include <AnalyzerHelpers.h>
+#include "AnalyzerExportWriter.h"
+#include <chrono>
+#include <mutex>
+#include <stdio.h>
+#include <string.h>
+
+#define ANALYZER_INSTRUMENTATION_EXPORT_ID 16   //export_type_user_id of the report, clear of the analyzers' own export ids
+
+//Counters and stage timers for a worker thread's hot path, to tell from a single run of a slow capture
+//where the decode spends its time. They are only compiled in with ANALYZER_INSTRUMENTATION defined
+//(make INSTRUMENT=1); otherwise every call below but PublishCommits is an empty inline function and the report says so.
+//
+//Stages are exclusive: entering one stops the clock of the stage it was entered from, and leaving it
+//starts that clock again, so nested stages never count the same time twice and the stages add up to
+//the whole run. Time outside every stage, host calls included, goes to StageOther.
+enum AnalyzerStage {
+    StageOther,
+    StageEdgeTraversal,     //Qi: pulling edge chunks; Serial and SPI: moving to the start of the next frame, waiting for capture data included
+    StageBitDecode,         //classifying bits and building words, including the edges walked to sample them
+    StageMarkers,           //AddMarker
+    StageFrames,            //AddFrame, CommitPacketAndStartNewPacket and their bookkeeping
+    StageCommit,            //CommitResults and ReportProgress, see AnalyzerCommitPolicy
+    StageResync,            //Serial and SPI: finding the next frame after an error; the Qi decoder does it during StageBitDecode
+    StageCount
+};
+
+enum AnalyzerCounter {
+    CounterEdges,           //visited on the channels decoded
+    CounterBits,
+    CounterResyncs,
+    CounterResyncEdges,     //skipped while resynchronizing
+    CounterMarkers,
+    CounterFrames,
+    CounterCount
+};
+
+//what the worker has counted so far, as published for the export
+struct AnalyzerInstrumentationReport {
+    U64 mCounts[CounterCount];
+    U64 mStageNs[StageCount];
+    U64 mRunNs;
+    U64 mCommits;           //published by AnalyzerCommitPolicy, with or without ANALYZER_INSTRUMENTATION
+    U64 mCommitRunNs;       //since the policy's Reset, at its last commit
+};
+
+#ifdef ANALYZER_INSTRUMENTATION
+#define ANALYZER_INSTRUMENT(statement) statement    //for counts kept outside AnalyzerInstrumentation, e.g. by a decoder
+#else
+#define ANALYZER_INSTRUMENT(statement)
+#endif
+
+//Counted by the worker thread alone; Publish copies the counts under a lock for the export, which runs on the GUI thread.
+class AnalyzerInstrumentation
+{
+public:
+    AnalyzerInstrumentation()
+    {
+        memset(&mReport, 0, sizeof(mReport));
+#ifdef ANALYZER_INSTRUMENTATION
+        Reset();
+#endif
+    }
+
+#ifdef ANALYZER_INSTRUMENTATION
+    void Reset()
+    {
+        memset(mCounts, 0, sizeof(mCounts));
+        for (U32 i = 0; i < StageCount; i++) {
+            mStageTimes[i] = std::chrono::steady_clock::duration::zero();
+        }
+        mStage = StageOther;
+        mStartTime = std::chrono::steady_clock::now();
+        mLastSwitch = mStartTime;
+        Publish();
+    }
+
+    void Count(AnalyzerCounter counter, U64 count = 1)
+    {
+        mCounts[counter] += count;
+    }
+
+    //returns the stage left, for LeaveStage.
+    AnalyzerStage EnterStage(AnalyzerStage stage)
+    {
+        AnalyzerStage previous_stage = mStage;
+        SwitchStage(stage);
+        return previous_stage;
+    }
+
+    void LeaveStage(AnalyzerStage previous_stage)
+    {
+        SwitchStage(previous_stage);
+    }
+
+    void Publish()
+    {
+        SwitchStage(mStage);
+
+        std::lock_guard<std::mutex> lock(mReportMutex);
+        memcpy(mReport.mCounts, mCounts, sizeof(mCounts));
+        for (U32 i = 0; i < StageCount; i++) {
+            mReport.mStageNs[i] = std::chrono::duration_cast<std::chrono::nanoseconds>(mStageTimes[i]).count();
+        }
+        mReport.mRunNs = std::chrono::duration_cast<std::chrono::nanoseconds>(mLastSwitch - mStartTime).count();
+    }
+#else
+    void Reset() {}
+    void Count(AnalyzerCounter /*counter*/, U64 /*count*/ = 1) {}
+    AnalyzerStage EnterStage(AnalyzerStage /*stage*/)
+    {
+        return StageOther;
+    }
+    void LeaveStage(AnalyzerStage /*previous_stage*/) {}
+    void Publish() {}
+#endif
+
+    //the commit policy's own count, kept in every build since it costs one lock per commit.
+    void PublishCommits(U64 commit_count, U64 elapsed_ns)
+    {
+        std::lock_guard<std::mutex> lock(mReportMutex);
+        mReport.mCommits = commit_count;
+        mReport.mCommitRunNs = elapsed_ns;
+    }
+
+    void GetReport(AnalyzerInstrumentationReport &report)
+    {
+        std::lock_guard<std::mutex> lock(mReportMutex);
+        report = mReport;
+    }
+
+    //the commits and their rate, then the last published counts, one row each, then the time of every stage.
+    void WriteReport(const char *file)
+    {
+        AnalyzerInstrumentationReport report;
+        GetReport(report);
+
+        AnalyzerExportWriter writer;
+        writer.Start(file);
+
+        char row[128];
+        double commit_seconds = double(report.mCommitRunNs) / 1e9;
+        snprintf(row, sizeof(row), "Commits,%llu\nCommits per second,%.1f", (unsigned long long)report.mCommits,
+                 (commit_seconds > 0.0) ? double(report.mCommits) / commit_seconds : 0.0);
+        writer.Append(row);
+        writer.EndLine();
+
+#ifndef ANALYZER_INSTRUMENTATION
+        writer.Append("Instrumentation is not compiled in, rebuild with ANALYZER_INSTRUMENTATION defined for the counters and stage times\n");
+#else
+        writer.Append("Counter,Count\n");
+        const char *counter_names[] = { "Edges visited", "Bits decoded", "Resyncs", "Edges skipped resynchronizing",
+                                        "Markers emitted", "Frames added"
+                                      };
+        for (U32 i = 0; i < CounterCount; i++) {
+            writer.Append(counter_names[i]);
+            writer.Append(',');
+            writer.AppendNumber(report.mCounts[i]);
+            writer.EndLine();
+        }
+
+        writer.Append("Stage,Time [ns],Share [%],Per edge [ns]\n");
+        const char *stage_names[] = { "Other", "Edge traversal", "Bit decode", "AddMarker", "AddFrame", "CommitResults", "Resync" };
+        for (U32 i = 0; i < StageCount; i++) {
+            double share = (report.mRunNs != 0) ? double(report.mStageNs[i]) * 100.0 / double(report.mRunNs) : 0.0;
+            double per_edge = (report.mCounts[CounterEdges] != 0) ? double(report.mStageNs[i]) / double(report.mCounts[CounterEdges]) : 0.0;
+            snprintf(row, sizeof(row), "%s,%llu,%.1f,%.2f", stage_names[i], (unsigned long long)report.mStageNs[i], share, per_edge);
+            writer.Append(row);
+            writer.EndLine();
+        }
+
+        writer.Append("Run,");
+        writer.AppendNumber(report.mRunNs);
+        writer.EndLine();
+#endif
+
+        writer.End();
+    }
+
+    //times the scope it is in as stage.
+    class StageTimer
+    {
+    public:
+        StageTimer(AnalyzerInstrumentation &instrumentation, AnalyzerStage stage)
+            :   mInstrumentation(instrumentation),
+                mPreviousStage(instrumentation.EnterStage(stage))
+        {
+        }
+
+        ~StageTimer()
+        {
+            mInstrumentation.LeaveStage(mPreviousStage);
+        }
+
+    protected:
+        StageTimer &operator=(const StageTimer &);
+        AnalyzerInstrumentation &mInstrumentation;
+        AnalyzerStage mPreviousStage;
+    };
+
+protected:
+#ifdef ANALYZER_INSTRUMENTATION
+    void SwitchStage(AnalyzerStage stage)
+    {
+        std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+        mStageTimes[mStage] += now - mLastSwitch;
+        mLastSwitch = now;
+        mStage = stage;
+    }
+
+    U64 mCounts[CounterCount];
+    std::chrono::steady_clock::duration mStageTimes[StageCount];
+    AnalyzerStage mStage;
+    std::chrono::steady_clock::time_point mStartTime;
+    std::chrono::steady_clock::time_point mLastSwitch;
+#endif
+
+    std::mutex mReportMutex;
+    AnalyzerInstrumentationReport mReport;
+};
+
+#endif //ANALYZER_INSTRUMENTATION_H